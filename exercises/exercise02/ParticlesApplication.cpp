@@ -3,6 +3,7 @@
 #include <ituGL/shader/Shader.h>
 #include <ituGL/geometry/VertexAttribute.h>
 #include <cassert>
+#include <cstddef>
 #include <array>
 #include <fstream>
 #include <sstream>
@@ -33,11 +34,11 @@ const std::array<VertexAttribute, 6> s_vertexAttributes =
 
 ParticlesApplication::ParticlesApplication()
     : Application(1024, 1024, "Particles demo")
+    , m_particles(sizeof(Particle), 2048)  // You can change the capacity here to have more particles
+    , m_cpuParticles(1 << 18)
     , m_currentTimeUniform(0)
     , m_gravityUniform(0)
     , m_mousePosition(0)
-    , m_particleCount(0)
-    , m_particleCapacity(2048)  // You can change the capacity here to have more particles
 {
 }
 
@@ -47,6 +48,10 @@ void ParticlesApplication::Initialize()
 
     InitializeShaders();
 
+    InitializeGpuParticles();
+
+    InitializeCpuParticles();
+
     // Initialize the mouse position with the current position of the mouse
     m_mousePosition = GetMainWindow().GetMousePosition(true);
 
@@ -87,6 +92,39 @@ void ParticlesApplication::Update()
         EmitParticle(mousePosition, size, duration, color, velocity);
     }
 
+    // Emit a burst of GPU particles while the right button is pressed
+    if (m_gpuParticles && window.IsMouseButtonPressed(Window::MouseButton::Right))
+    {
+        GpuParticleSystem::Emitter emitter;
+        emitter.position = glm::vec3(mousePosition, 0.0f);
+        emitter.radius = 0.02f;
+        emitter.velocity = glm::vec3(0.5f * (mousePosition - m_mousePosition) / GetDeltaTime(), 0.0f);
+        emitter.velocitySpread = 1.0f;
+        emitter.minLifetime = 1.0f;
+        emitter.maxLifetime = 2.0f;
+        emitter.minSize = 2.0f;
+        emitter.maxSize = 6.0f;
+        emitter.color = RandomColor();
+        m_gpuParticles->Emit(emitter, 2000);
+    }
+
+    // Emit a burst of CPU particles while the middle button is pressed
+    if (window.IsMouseButtonPressed(Window::MouseButton::Middle))
+    {
+        ParticleSystem::Emitter emitter;
+        emitter.position = glm::vec3(mousePosition, 0.0f);
+        emitter.radius = 0.02f;
+        emitter.velocity = glm::vec3(0.5f * (mousePosition - m_mousePosition) / GetDeltaTime(), 0.0f);
+        emitter.velocitySpread = 1.0f;
+        emitter.minLifetime = 1.0f;
+        emitter.maxLifetime = 2.0f;
+        emitter.minSize = 2.0f;
+        emitter.maxSize = 6.0f;
+        emitter.color = RandomColor();
+        m_cpuParticles.Emit(emitter, 2000, GetRandom().NextUInt());
+    }
+    m_cpuParticles.Update(GetDeltaTime());
+
     // save the mouse position (to compare next frame and obtain velocity)
     m_mousePosition = mousePosition;
 }
@@ -105,11 +143,32 @@ void ParticlesApplication::Render()
     // Set Gravity uniform
     m_shaderProgram.SetUniform(m_gravityUniform, -9.8f);
 
+    // Copy the particles emitted this frame to the VBO, all at once
+    m_particles.Flush();
+
     // Bind the particle system VAO
     m_vao.Bind();
 
     // Draw points. The amount of points can't exceed the capacity
-    glDrawArrays(GL_POINTS, 0, std::min(m_particleCount, m_particleCapacity));
+    glDrawArrays(GL_POINTS, 0, m_particles.GetParticleCount());
+
+    // Simulate and draw the GPU particles. The number of points comes from the simulation, without reading it back
+    if (m_gpuParticles)
+    {
+        m_gpuParticles->Update(GetDeltaTime());
+        m_gpuShaderProgram.Use();
+        m_gpuParticles->Draw();
+    }
+
+    // Stream and draw the CPU particles
+    unsigned int cpuParticleCount = m_cpuParticles.UpdateVertexBuffer(m_cpuVertexBuffer);
+    if (cpuParticleCount > 0)
+    {
+        m_cpuShaderProgram.Use();
+        m_cpuVao.Bind();
+        glDrawArrays(GL_POINTS, 0, cpuParticleCount);
+        VertexArrayObject::Unbind();
+    }
 
     Application::Render();
 }
@@ -118,11 +177,8 @@ void ParticlesApplication::Render()
 // Change s_vertexAttributes and the Particle struct to add new vertex attributes
 void ParticlesApplication::InitializeGeometry()
 {
-    m_vbo.Bind();
-
-    // Allocate enough data for all the particles
-    // Notice the DynamicDraw usage, because we will update the buffer every time we emit a particle
-    m_vbo.AllocateData(m_particleCapacity * sizeof(Particle), BufferObject::Usage::DynamicDraw);
+    // The particle buffer already allocated enough data for all the particles
+    m_particles.GetVertexBuffer().Bind();
 
     m_vao.Bind();
 
@@ -160,6 +216,60 @@ void ParticlesApplication::InitializeShaders()
     }
 }
 
+void ParticlesApplication::InitializeGpuParticles()
+{
+    // Compute shaders and shader storage buffers need OpenGL 4.3
+    if (!GLAD_GL_VERSION_4_3)
+    {
+        return;
+    }
+
+    m_gpuParticles = std::make_unique<GpuParticleSystem>(1 << 20);
+    m_gpuParticles->SetGravity(glm::vec3(0.0f, -9.8f, 0.0f));
+    m_gpuParticles->SetDrag(0.5f);
+
+    // Same fragment shader as the other particles
+    Shader vertexShader(Shader::VertexShader);
+    LoadAndCompileShader(vertexShader, "shaders/gpu_particles.vert");
+
+    Shader fragmentShader(Shader::FragmentShader);
+    LoadAndCompileShader(fragmentShader, "shaders/particles.frag");
+
+    if (!m_gpuShaderProgram.Build(vertexShader, fragmentShader))
+    {
+        std::cout << "Error linking GPU particle shaders" << std::endl;
+    }
+}
+
+void ParticlesApplication::InitializeCpuParticles()
+{
+    m_cpuParticles.SetThreadPool(&m_threadPool);
+    m_cpuParticles.SetGravity(glm::vec3(0.0f, -9.8f, 0.0f));
+    m_cpuParticles.SetDrag(0.5f);
+
+    // Attributes of ParticleSystem::Vertex. The buffer is reallocated every frame, but the VAO keeps pointing to it
+    m_cpuVertexBuffer.Bind();
+    m_cpuVao.Bind();
+    GLsizei stride = sizeof(ParticleSystem::Vertex);
+    m_cpuVao.SetAttribute(0, VertexAttribute(Data::Type::Float, 3), offsetof(ParticleSystem::Vertex, position), stride);
+    m_cpuVao.SetAttribute(1, VertexAttribute(Data::Type::Float, 1), offsetof(ParticleSystem::Vertex, size), stride);
+    m_cpuVao.SetAttribute(2, VertexAttribute(Data::Type::Float, 4), offsetof(ParticleSystem::Vertex, color), stride);
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+
+    // Same fragment shader as the other particles
+    Shader vertexShader(Shader::VertexShader);
+    LoadAndCompileShader(vertexShader, "shaders/cpu_particles.vert");
+
+    Shader fragmentShader(Shader::FragmentShader);
+    LoadAndCompileShader(fragmentShader, "shaders/particles.frag");
+
+    if (!m_cpuShaderProgram.Build(vertexShader, fragmentShader))
+    {
+        std::cout << "Error linking CPU particle shaders" << std::endl;
+    }
+}
+
 void ParticlesApplication::EmitParticle(const glm::vec2& position, float size, float duration, const Color& color, const glm::vec2& velocity)
 {
     // Initialize the particle
@@ -171,21 +281,8 @@ void ParticlesApplication::EmitParticle(const glm::vec2& position, float size, f
     particle.color = color;
     particle.velocity = velocity;
 
-    // Get the index in the circular buffer
-    unsigned int particleIndex = m_particleCount % m_particleCapacity;
-
-    // Bind the VBO before updating data
-    m_vbo.Bind();
-
-    // Update the particle data in the VBO
-    int offset = particleIndex * sizeof(Particle);
-    m_vbo.UpdateData(std::span(&particle, 1), offset);
-
-    // Unbind the VBO
-    VertexBufferObject::Unbind();
-
-    // Increment the particle count
-    m_particleCount++;
+    // Add it to the particle buffer. It will be copied to the VBO with the other particles of this frame, in Render
+    m_particles.Emit(particle);
 }
 
 void ParticlesApplication::LoadAndCompileShader(Shader& shader, const char* path)
@@ -217,22 +314,20 @@ void ParticlesApplication::LoadAndCompileShader(Shader& shader, const char* path
     }
 }
 
-float ParticlesApplication::Random01()
-{
-    return static_cast<float>(rand()) / RAND_MAX;
-}
-
 float ParticlesApplication::RandomRange(float from, float to)
 {
-    return Random01() * (to - from) + from;
+    return GetRandom().NextRange(from, to);
 }
 
 glm::vec2 ParticlesApplication::RandomDirection()
 {
-    return glm::normalize(glm::vec2(Random01() - 0.5f, Random01() - 0.5f));
+    Random& random = GetRandom();
+    float x = random.Next01() - 0.5f;
+    float y = random.Next01() - 0.5f;
+    return glm::normalize(glm::vec2(x, y));
 }
 
 Color ParticlesApplication::RandomColor()
 {
-    return Color(Random01(), Random01(), Random01());
+    return GetRandom().NextColor();
 }
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <ituGL/application/Application.h>
-#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/particles/ParticleEmitterBuffer.h>
+#include <ituGL/particles/GpuParticleSystem.h>
+#include <ituGL/particles/ParticleSystem.h>
+#include <ituGL/core/ThreadPool.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/shader/ShaderProgram.h>
 
@@ -22,21 +25,26 @@ private:
     // Load, compile and link shaders
     void InitializeShaders();
 
+    // Create the GPU particle system, if compute shaders are supported
+    void InitializeGpuParticles();
+
+    // Set up the VAO and shader program of the CPU particle system
+    void InitializeCpuParticles();
+
     // Helper function to encapsulate loading and compiling a shader
     void LoadAndCompileShader(Shader& shader, const char* path);
 
     // Emit a new particle
     void EmitParticle(const glm::vec2& position, float size, float duration, const Color& color, const glm::vec2& velocity);
 
-    // Helper methods for random values
-    static float Random01();
-    static float RandomRange(float from, float to);
-    static glm::vec2 RandomDirection();
-    static Color RandomColor();
+    // Helper methods for random values, from the generator of the application
+    float RandomRange(float from, float to);
+    glm::vec2 RandomDirection();
+    Color RandomColor();
 
 private:
-    // All particles stored in a single VBO with interleaved attributes
-    VertexBufferObject m_vbo;
+    // All particles stored in a single VBO with interleaved attributes, used as a circular buffer
+    ParticleEmitterBuffer m_particles;
 
     // VAO that represents the particle system
     VertexArrayObject m_vao;
@@ -44,6 +52,21 @@ private:
     // Particles shader program
     ShaderProgram m_shaderProgram;
 
+    // Particles simulated in compute shaders, emitted with the right button. Null without OpenGL 4.3
+    std::unique_ptr<GpuParticleSystem> m_gpuParticles;
+
+    // Shader program that draws the GPU particles
+    ShaderProgram m_gpuShaderProgram;
+
+    // Particles simulated on the CPU with the thread pool, emitted with the middle button
+    ThreadPool m_threadPool;
+    ParticleSystem m_cpuParticles;
+
+    // Vertices of the live CPU particles, streamed every frame, and the VAO and shader program that draw them
+    VertexBufferObject m_cpuVertexBuffer;
+    VertexArrayObject m_cpuVao;
+    ShaderProgram m_cpuShaderProgram;
+
     // Location of the "CurrentTime" uniform
     ShaderProgram::Location m_currentTimeUniform;
 
@@ -52,10 +75,4 @@ private:
 
     // Mouse position during this frame
     glm::vec2 m_mousePosition;
-
-    // Total number of particles created
-    unsigned int m_particleCount;
-
-    // Max number of particles that can exist at the same time
-    const unsigned int m_particleCapacity;
 };
@@ -0,0 +1,15 @@
+#version 330 core
+
+// Vertices of ParticleSystem, simulated on the CPU and streamed every frame
+layout (location = 0) in vec3 ParticlePosition;
+layout (location = 1) in float ParticleSize;
+layout (location = 2) in vec4 ParticleColor;
+
+out vec4 Color;
+
+void main()
+{
+	Color = ParticleColor;
+	gl_PointSize = ParticleSize;
+	gl_Position = vec4(ParticlePosition.xy, 0.0, 1.0);
+}
@@ -0,0 +1,34 @@
+#version 430 core
+
+// Particles of GpuParticleSystem. There are no vertex attributes, the particle comes from the buffers of the simulation
+struct Particle
+{
+	vec3 Position;
+	float Age;
+	vec3 Velocity;
+	float Lifetime;
+	vec4 Color;
+	float Size;
+};
+
+layout (std430, binding = 0) readonly buffer ParticleBuffer
+{
+	Particle Particles[];
+};
+
+layout (std430, binding = 2) readonly buffer AliveListBuffer
+{
+	uint AliveIndices[];
+};
+
+out vec4 Color;
+
+void main()
+{
+	Particle particle = Particles[AliveIndices[gl_VertexID]];
+
+	// Fade out during the lifetime
+	Color = vec4(particle.Color.rgb, particle.Color.a * (1.0f - particle.Age / particle.Lifetime));
+	gl_PointSize = particle.Size;
+	gl_Position = vec4(particle.Position.xy, 0.0, 1.0);
+}
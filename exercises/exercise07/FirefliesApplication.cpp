@@ -3,22 +3,31 @@
 #include <ituGL/asset/ShaderLoader.h>
 #include <ituGL/asset/ModelLoader.h>
 #include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/geometry/GeometryPool.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/renderer/ForwardRenderPass.h>
 #include <ituGL/renderer/GBufferRenderPass.h>
 #include <ituGL/renderer/DeferredRenderPass.h>
+#include <ituGL/renderer/UpscaleRenderPass.h>
 #include <glm/gtx/transform.hpp>
 #include <imgui.h>
 
 FirefliesApplication::FirefliesApplication()
     : Application(1024, 1024, "Fireflies demo")
     , m_renderMode(RenderMode::Deferred)
-    , m_renderer(GetDevice())
     , m_mouseClicked(false)
     , m_ambientColor(0.0f)
     , m_lightColor(0.0f)
     , m_lightIntensity(0.0f)
     , m_useRandomColor(false)
+    , m_updateLightColor(0.0f)
+    , m_updateLightIntensity(0.0f)
+    , m_updateUseRandomColor(false)
+    , m_renderer(GetDevice())
+    , m_deferredRenderPass(nullptr)
+    , m_forwardRenderPass(nullptr)
+    , m_upscaleRenderPass(nullptr)
+    , m_dynamicResolutionEnabled(false)
 {
 }
 
@@ -31,6 +40,7 @@ void FirefliesApplication::Initialize()
 
     InitializeForwardMaterials();
     InitializeDeferredMaterials();
+    InitializeTiledDeferredMaterials();
     InitializeModels();
     InitializeCamera();
     InitializeLights();
@@ -48,8 +58,20 @@ void FirefliesApplication::Update()
     // Update fireflies and send them to renderer
     UpdateFireflies();
 
-    // Set current camera
+    // Set current camera and time
     m_renderer.SetCurrentCamera(m_camera);
+    m_renderer.SetFrameTime(GetCurrentTime(), GetDeltaTime());
+}
+
+void FirefliesApplication::SubmitFrame()
+{
+    Application::SubmitFrame();
+
+    m_renderer.SubmitFrame();
+
+    m_updateLightColor = m_lightColor;
+    m_updateLightIntensity = m_lightIntensity;
+    m_updateUseRandomColor = m_useRandomColor;
 }
 
 void FirefliesApplication::Render()
@@ -59,6 +81,9 @@ void FirefliesApplication::Render()
     // Clear color and depth
     GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
 
+    // Pick the render scale from the GPU time of the previous frames
+    m_renderer.SetRenderScale(m_dynamicResolutionEnabled ? m_dynamicResolution.Update(m_renderer.GetPassTimer()) : 1.0f);
+
     m_renderer.Render();
 
     // Render the debug user interface
@@ -119,37 +144,49 @@ Renderer::UpdateLightsFunction FirefliesApplication::GetUpdateLightsFunction(std
 
 void FirefliesApplication::InitializeForwardMaterials()
 {
+    // With OpenGL 4.3, all the lights are read from the light buffer and shaded in a single pass
+    bool lightArray = GLAD_GL_VERSION_4_3;
+
     // Load and build shader
     std::vector<const char*> vertexShaderPaths;
-    vertexShaderPaths.push_back("shaders/version330.glsl");
+    vertexShaderPaths.push_back(lightArray ? "shaders/version430.glsl" : "shaders/version330.glsl");
+    vertexShaderPaths.push_back("shaders/frame.glsl");
+    vertexShaderPaths.push_back("shaders/instancing.glsl");
     vertexShaderPaths.push_back("shaders/lit.vert");
     Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
     std::vector<const char*> fragmentShaderPaths;
-    fragmentShaderPaths.push_back("shaders/version330.glsl");
-    fragmentShaderPaths.push_back("shaders/utils.glsl");
-    fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
-    fragmentShaderPaths.push_back("shaders/lighting.glsl");
+    if (lightArray)
+    {
+        fragmentShaderPaths.push_back("shaders/version430.glsl");
+        fragmentShaderPaths.push_back("shaders/light_array.glsl");
+        fragmentShaderPaths.push_back("shaders/frame.glsl");
+        fragmentShaderPaths.push_back("shaders/utils.glsl");
+        fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
+        fragmentShaderPaths.push_back("shaders/lights.glsl");
+        fragmentShaderPaths.push_back("shaders/lighting_array.glsl");
+    }
+    else
+    {
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/frame.glsl");
+        fragmentShaderPaths.push_back("shaders/utils.glsl");
+        fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
+        fragmentShaderPaths.push_back("shaders/lighting.glsl");
+    }
     fragmentShaderPaths.push_back("shaders/lit.frag");
     Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
 
     std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
     shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-    // Get transform related uniform locations
-    ShaderProgram::Location cameraPositionLocation = shaderProgramPtr->GetUniformLocation("CameraPosition");
+    // Get transform related uniform locations. The camera is in the frame block
     ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
-    ShaderProgram::Location viewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("ViewProjMatrix");
 
     // Register shader with renderer
     m_renderer.RegisterShaderProgram(shaderProgramPtr,
         [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
         {
-            if (cameraChanged)
-            {
-                shaderProgram.SetUniform(cameraPositionLocation, camera.ExtractTranslation());
-                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
-            }
             shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
         },
         GetUpdateLightsFunction(shaderProgramPtr)
@@ -158,15 +195,17 @@ void FirefliesApplication::InitializeForwardMaterials()
     // Filter out uniforms that are not material properties
     ShaderUniformCollection::NameSet filteredUniforms;
     filteredUniforms.insert("WorldMatrix");
-    filteredUniforms.insert("ViewProjMatrix");
     filteredUniforms.insert("AmbientColor");
     filteredUniforms.insert("LightColor");
     filteredUniforms.insert("LightPosition");
     filteredUniforms.insert("LightDirection");
     filteredUniforms.insert("LightAttenuation");
+    filteredUniforms.insert("LightCount");
+    filteredUniforms.insert("LightIndices[0]");
 
-    // Create reference material
+    // Create reference material. lit.vert computes the position like the depth pre-pass
     m_forwardMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+    m_forwardMaterial->SetDepthPrePass(true);
 }
 
 void FirefliesApplication::InitializeDeferredMaterials()
@@ -176,6 +215,8 @@ void FirefliesApplication::InitializeDeferredMaterials()
         // Load and build shader
         std::vector<const char*> vertexShaderPaths;
         vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/frame.glsl");
+        vertexShaderPaths.push_back("shaders/instancing.glsl");
         vertexShaderPaths.push_back("shaders/gbuffer.vert");
         Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
@@ -187,24 +228,21 @@ void FirefliesApplication::InitializeDeferredMaterials()
         std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
         shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-        // Get transform related uniform locations
-        ShaderProgram::Location worldViewMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
+        // Get transform related uniform locations. The camera is in the frame block
+        ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
 
         // Register shader with renderer
         m_renderer.RegisterShaderProgram(shaderProgramPtr,
             [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
             {
-                shaderProgram.SetUniform(worldViewMatrixLocation, camera.GetViewMatrix() * worldMatrix);
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
+                shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
             },
             nullptr
         );
 
         // Filter out uniforms that are not material properties
         ShaderUniformCollection::NameSet filteredUniforms;
-        filteredUniforms.insert("WorldViewMatrix");
-        filteredUniforms.insert("WorldViewProjMatrix");
+        filteredUniforms.insert("WorldMatrix");
 
         // Create material
         m_gbufferMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
@@ -214,11 +252,13 @@ void FirefliesApplication::InitializeDeferredMaterials()
     {
         std::vector<const char*> vertexShaderPaths;
         vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/frame.glsl");
         vertexShaderPaths.push_back("shaders/deferred.vert");
         Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
         std::vector<const char*> fragmentShaderPaths;
         fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/frame.glsl");
         fragmentShaderPaths.push_back("shaders/utils.glsl");
         fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
         fragmentShaderPaths.push_back("shaders/lighting.glsl");
@@ -230,24 +270,16 @@ void FirefliesApplication::InitializeDeferredMaterials()
 
         // Filter out uniforms that are not material properties
         ShaderUniformCollection::NameSet filteredUniforms;
-        filteredUniforms.insert("InvProjMatrix");
-        filteredUniforms.insert("WorldViewProjMatrix");
+        filteredUniforms.insert("WorldMatrix");
 
-        // Get transform related uniform locations
-        ShaderProgram::Location invViewMatrixLocation = shaderProgramPtr->GetUniformLocation("InvViewMatrix");
-        ShaderProgram::Location invProjMatrixLocation = shaderProgramPtr->GetUniformLocation("InvProjMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
+        // Get transform related uniform locations. The camera is in the frame block
+        ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
 
         // Register shader with renderer
         m_renderer.RegisterShaderProgram(shaderProgramPtr,
             [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
             {
-                if (cameraChanged)
-                {
-                    shaderProgram.SetUniform(invViewMatrixLocation, glm::inverse(camera.GetViewMatrix()));
-                    shaderProgram.SetUniform(invProjMatrixLocation, glm::inverse(camera.GetProjectionMatrix()));
-                }
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
+                shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
             },
             GetUpdateLightsFunction(shaderProgramPtr)
         );
@@ -257,6 +289,70 @@ void FirefliesApplication::InitializeDeferredMaterials()
     }
 }
 
+void FirefliesApplication::InitializeTiledDeferredMaterials()
+{
+    // Compute shaders and shader storage buffers need OpenGL 4.3
+    if (!GLAD_GL_VERSION_4_3)
+    {
+        return;
+    }
+
+    // Light culling program
+    {
+        std::vector<const char*> computeShaderPaths;
+        computeShaderPaths.push_back("shaders/version430.glsl");
+        computeShaderPaths.push_back("shaders/lights.glsl");
+        computeShaderPaths.push_back("shaders/light_culling.comp");
+        Shader computeShader = ShaderLoader(Shader::ComputeShader).Load(computeShaderPaths);
+
+        m_lightCullingProgram = std::make_shared<ShaderProgram>();
+        m_lightCullingProgram->Build(computeShader);
+    }
+
+    // Tiled deferred material
+    {
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version430.glsl");
+        vertexShaderPaths.push_back("shaders/frame.glsl");
+        vertexShaderPaths.push_back("shaders/deferred.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version430.glsl");
+        fragmentShaderPaths.push_back("shaders/frame.glsl");
+        fragmentShaderPaths.push_back("shaders/utils.glsl");
+        fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
+        fragmentShaderPaths.push_back("shaders/lights.glsl");
+        fragmentShaderPaths.push_back("shaders/lighting_array.glsl");
+        fragmentShaderPaths.push_back("shaders/deferred_tiled.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        // Filter out uniforms that are not material properties
+        ShaderUniformCollection::NameSet filteredUniforms;
+        filteredUniforms.insert("WorldMatrix");
+        filteredUniforms.insert("TileCountX");
+
+        // Get transform related uniform locations. The camera is in the frame block
+        ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
+
+        // Register shader with renderer. The lights come from the light buffer, the update function only sets the ambient
+        m_renderer.RegisterShaderProgram(shaderProgramPtr,
+            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
+            {
+                shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
+            },
+            GetUpdateLightsFunction(shaderProgramPtr)
+        );
+
+        // Create material
+        m_tiledDeferredMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+        m_tiledDeferredMaterial->SetUniformValue("ShowTileOverflow", 0u);
+    }
+}
+
 void FirefliesApplication::InitializeModels()
 {
     std::shared_ptr<Material> material = m_renderMode == RenderMode::Forward ? m_forwardMaterial : m_gbufferMaterial;
@@ -277,9 +373,16 @@ void FirefliesApplication::InitializeModels()
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseTexture, "ColorTexture");
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::SpecularExponent, "SpecularExponent");
 
+    // Share vertex and element buffers between all the loaded models
+    loader.SetGeometryPool(std::make_shared<GeometryPool>());
+
     // Load models
     m_fireflyModel = loader.Load("models/firefly/firefly.obj");
     m_floorModel = loader.Load("models/floor/floor.obj");
+
+    // The lit and gbuffer shaders read the world matrix per instance
+    m_renderer.SetupInstancing(m_fireflyModel.GetMesh());
+    m_renderer.SetupInstancing(m_floorModel.GetMesh());
 }
 
 void FirefliesApplication::InitializeCamera()
@@ -298,6 +401,9 @@ void FirefliesApplication::InitializeLights()
     m_ambientColor = glm::vec3(0.25f);
     m_lightColor = glm::vec3(1.0f, 0.8f, 0.3f);
     m_lightIntensity = 1.0f;
+
+    m_updateLightColor = m_lightColor;
+    m_updateLightIntensity = m_lightIntensity;
 }
 
 void FirefliesApplication::InitializeRenderer()
@@ -305,8 +411,13 @@ void FirefliesApplication::InitializeRenderer()
     switch (m_renderMode)
     {
     case RenderMode::Forward:
-        m_renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
-        break;
+        {
+            std::unique_ptr<ForwardRenderPass> forwardRenderPass(std::make_unique<ForwardRenderPass>());
+            forwardRenderPass->LoadFrameBlock("shaders/frame.glsl");
+            m_forwardRenderPass = forwardRenderPass.get();
+            m_renderer.AddRenderPass(std::move(forwardRenderPass));
+            break;
+        }
     case RenderMode::Deferred:
         {
             // Set up deferred passes
@@ -314,15 +425,42 @@ void FirefliesApplication::InitializeRenderer()
             GetMainWindow().GetDimensions(width, height);
             std::unique_ptr<GBufferRenderPass> gbufferRenderPass(std::make_unique<GBufferRenderPass>(width, height));
 
-            // Set the g-buffer textures as properties of the deferred material
-            m_deferredMaterial->SetUniformValue("DepthTexture", gbufferRenderPass->GetDepthTexture());
-            m_deferredMaterial->SetUniformValue("AlbedoTexture", gbufferRenderPass->GetAlbedoTexture());
-            m_deferredMaterial->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
-            m_deferredMaterial->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
+            // The targets have the size of the window, the scene is drawn in the render viewport
+            m_renderer.SetRenderSize(width, height);
+
+            // The g-buffer textures come from the render graph every frame, set them as properties of the deferred material
+            std::unique_ptr<DeferredRenderPass> deferredRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial));
+            deferredRenderPass->AddInputTexture(GBufferRenderPass::DepthTextureName, m_deferredMaterial, "DepthTexture");
+            deferredRenderPass->AddInputTexture(GBufferRenderPass::AlbedoTextureName, m_deferredMaterial, "AlbedoTexture");
+            deferredRenderPass->AddInputTexture(GBufferRenderPass::NormalTextureName, m_deferredMaterial, "NormalTexture");
+            deferredRenderPass->AddInputTexture(GBufferRenderPass::OthersTextureName, m_deferredMaterial, "OthersTexture");
+
+            // Shade only the pixels in range of each firefly, when not using tiled lighting
+            deferredRenderPass->SetLightVolumes(gbufferRenderPass->GetFramebuffer(), width, height);
+
+            // Set up tiled lighting, if supported
+            if (m_tiledDeferredMaterial)
+            {
+                deferredRenderPass->AddInputTexture(GBufferRenderPass::DepthTextureName, m_tiledDeferredMaterial, "DepthTexture");
+                deferredRenderPass->AddInputTexture(GBufferRenderPass::AlbedoTextureName, m_tiledDeferredMaterial, "AlbedoTexture");
+                deferredRenderPass->AddInputTexture(GBufferRenderPass::NormalTextureName, m_tiledDeferredMaterial, "NormalTexture");
+                deferredRenderPass->AddInputTexture(GBufferRenderPass::OthersTextureName, m_tiledDeferredMaterial, "OthersTexture");
+
+                deferredRenderPass->SetTiledLighting(m_tiledDeferredMaterial, m_lightCullingProgram,
+                    GBufferRenderPass::DepthTextureName, width, height);
+                deferredRenderPass->SetLightingMode(DeferredRenderPass::LightingMode::Tiled);
+            }
+            m_deferredRenderPass = deferredRenderPass.get();
+
+            // Light to a texture, then scale the render viewport up to the window
+            deferredRenderPass->SetOutputTexture("SceneColor", width, height);
+            std::unique_ptr<UpscaleRenderPass> upscaleRenderPass(std::make_unique<UpscaleRenderPass>("SceneColor", width, height));
+            m_upscaleRenderPass = upscaleRenderPass.get();
 
             // Add the render passes
             m_renderer.AddRenderPass(std::move(gbufferRenderPass));
-            m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial));
+            m_renderer.AddRenderPass(std::move(deferredRenderPass));
+            m_renderer.AddRenderPass(std::move(upscaleRenderPass));
             break;
         }
     }
@@ -338,6 +476,110 @@ void FirefliesApplication::RenderGUI()
     ImGui::ColorEdit3("Light color", &m_lightColor[0]);
     ImGui::DragFloat("Light intensity", &m_lightIntensity, 0.05f, 0.0f, 100.0f);
     ImGui::Checkbox("Use random color", &m_useRandomColor);
+    ImGui::Separator();
+    ImGui::Text("Skipped binds: %u", m_renderer.GetSkippedBindCount());
+    ImGui::Text("Drawcalls: %u", m_renderer.GetDrawcallCount());
+    bool instancingEnabled = m_renderer.GetInstancingEnabled();
+    if (ImGui::Checkbox("Instancing", &instancingEnabled))
+    {
+        m_renderer.SetInstancingEnabled(instancingEnabled);
+    }
+    if (GLAD_GL_VERSION_4_3)
+    {
+        bool multiDrawEnabled = m_renderer.GetMultiDrawEnabled();
+        if (ImGui::Checkbox("Multi-draw", &multiDrawEnabled))
+        {
+            m_renderer.SetMultiDrawEnabled(multiDrawEnabled);
+        }
+    }
+    if (m_forwardRenderPass)
+    {
+        bool depthPrePassEnabled = m_forwardRenderPass->GetDepthPrePassEnabled();
+        if (ImGui::Checkbox("Depth pre-pass", &depthPrePassEnabled))
+        {
+            m_forwardRenderPass->SetDepthPrePassEnabled(depthPrePassEnabled);
+        }
+    }
+    if (m_forwardRenderPass && m_renderer.HasLightArray(m_forwardMaterial->GetShaderProgram()))
+    {
+        int maxLightsPerObject = static_cast<int>(m_forwardRenderPass->GetMaxLightsPerObject());
+        if (ImGui::SliderInt("Max lights per object", &maxLightsPerObject, 1, 32))
+        {
+            m_forwardRenderPass->SetMaxLightsPerObject(maxLightsPerObject);
+        }
+    }
+    if (m_deferredRenderPass && m_tiledDeferredMaterial)
+    {
+        bool tiledLighting = m_deferredRenderPass->GetLightingMode() == DeferredRenderPass::LightingMode::Tiled;
+        if (ImGui::Checkbox("Tiled lighting", &tiledLighting))
+        {
+            m_deferredRenderPass->SetLightingMode(tiledLighting ? DeferredRenderPass::LightingMode::Tiled : DeferredRenderPass::LightingMode::PerLight);
+        }
+        if (tiledLighting)
+        {
+            // Tiles with more than DeferredRenderPass::MaxLightsPerTile lights drop the extra ones
+            bool showTileOverflow = m_tiledDeferredMaterial->GetUniformValue<unsigned int>("ShowTileOverflow") != 0;
+            if (ImGui::Checkbox("Show tile overflow", &showTileOverflow))
+            {
+                m_tiledDeferredMaterial->SetUniformValue("ShowTileOverflow", showTileOverflow ? 1u : 0u);
+            }
+        }
+    }
+    if (m_deferredRenderPass && m_deferredRenderPass->GetLightingMode() == DeferredRenderPass::LightingMode::PerLight)
+    {
+        bool lightVolumes = m_deferredRenderPass->GetLightVolumesEnabled();
+        if (ImGui::Checkbox("Light volumes", &lightVolumes))
+        {
+            m_deferredRenderPass->SetLightVolumesEnabled(lightVolumes);
+        }
+    }
+    if (m_upscaleRenderPass)
+    {
+        if (ImGui::Checkbox("Dynamic resolution", &m_dynamicResolutionEnabled))
+        {
+            m_dynamicResolution.Reset();
+        }
+        if (m_dynamicResolutionEnabled)
+        {
+            float targetFrameTime = m_dynamicResolution.GetTargetFrameTime();
+            if (ImGui::DragFloat("Target GPU time (ms)", &targetFrameTime, 0.1f, 1.0f, 100.0f))
+            {
+                m_dynamicResolution.SetTargetFrameTime(targetFrameTime);
+            }
+            float scaleRange[2] = { m_dynamicResolution.GetMinScale(), m_dynamicResolution.GetMaxScale() };
+            if (ImGui::DragFloat2("Scale range", scaleRange, 0.01f, 0.25f, 1.0f))
+            {
+                m_dynamicResolution.SetScaleRange(std::min(scaleRange[0], scaleRange[1]), scaleRange[1]);
+            }
+        }
+        int width, height;
+        m_renderer.GetRenderViewport(width, height);
+        ImGui::Text("Render scale: %.3f (%dx%d)", m_renderer.GetRenderScale(), width, height);
+
+        int filter = static_cast<int>(m_upscaleRenderPass->GetFilter());
+        if (ImGui::Combo("Upscale filter", &filter, "Bilinear\0Edge-aware\0"))
+        {
+            m_upscaleRenderPass->SetFilter(static_cast<UpscaleRenderPass::Filter>(filter));
+        }
+        if (m_upscaleRenderPass->GetFilter() == UpscaleRenderPass::Filter::EdgeAware)
+        {
+            float sharpness = m_upscaleRenderPass->GetSharpness();
+            if (ImGui::SliderFloat("Sharpness", &sharpness, 0.0f, 1.0f))
+            {
+                m_upscaleRenderPass->SetSharpness(sharpness);
+            }
+        }
+    }
+    bool pipelineEnabled = GetPipelineEnabled();
+    if (ImGui::Checkbox("Pipelined update", &pipelineEnabled))
+    {
+        SetPipelineEnabled(pipelineEnabled);
+    }
+    const TexturePool& texturePool = m_renderer.GetTexturePool();
+    ImGui::Text("Render targets: %u (%.1f MB)", texturePool.GetTextureCount(), texturePool.GetMemorySize() / (1024.0f * 1024.0f));
+
+    // GPU time of each render pass
+    m_renderer.GetPassTimer().DrawGUI(m_imGui);
 
     m_imGui.EndFrame();
 }
@@ -387,8 +629,8 @@ void FirefliesApplication::AddFirefly(glm::vec2 position2D)
 
     PointLight& pointLight = firefly.pointLight;
     pointLight.SetPosition(position3D);
-    pointLight.SetColor(m_useRandomColor ? glm::vec3(RandomColor()) : m_lightColor);
-    pointLight.SetIntensity(m_lightIntensity);
+    pointLight.SetColor(m_updateUseRandomColor ? glm::vec3(RandomColor()) : m_updateLightColor);
+    pointLight.SetIntensity(m_updateLightIntensity);
     pointLight.SetDistanceAttenuation(glm::vec2(1.0f, 2.0f));
 
     firefly.worldMatrix = glm::translate(position3D) * glm::rotate(RandomRange(-3.1416f, 3.1416f), glm::vec3(0, 1, 0)) * glm::scale(glm::vec3(0.25f));
@@ -396,17 +638,12 @@ void FirefliesApplication::AddFirefly(glm::vec2 position2D)
     firefly.rotationSpeed = 0.0f;
 }
 
-float FirefliesApplication::Random01()
-{
-    return static_cast<float>(rand()) / RAND_MAX;
-}
-
 float FirefliesApplication::RandomRange(float from, float to)
 {
-    return Random01() * (to - from) + from;
+    return GetRandom().NextRange(from, to);
 }
 
 Color FirefliesApplication::RandomColor()
 {
-    return Color(Random01(), Random01(), Random01());
+    return GetRandom().NextColor();
 }
@@ -6,11 +6,15 @@
 #include <ituGL/geometry/Model.h>
 #include <ituGL/lighting/PointLight.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/DynamicResolution.h>
 #include <ituGL/utils/DearImGui.h>
 #include <vector>
 
 class Texture2DObject;
 class Light;
+class DeferredRenderPass;
+class ForwardRenderPass;
+class UpscaleRenderPass;
 
 class FirefliesApplication : public Application
 {
@@ -20,12 +24,14 @@ public:
 protected:
     void Initialize() override;
     void Update() override;
+    void SubmitFrame() override;
     void Render() override;
     void Cleanup() override;
 
 private:
     void InitializeForwardMaterials();
     void InitializeDeferredMaterials();
+    void InitializeTiledDeferredMaterials();
     void InitializeModels();
     void InitializeCamera();
     void InitializeLights();
@@ -37,7 +43,7 @@ private:
 
     void AddFirefly(glm::vec2 position);
 
-    float Random01();
+    // Random values from the generator of the application, so runs with the same seed are the same
     float RandomRange(float from, float to);
     Color RandomColor();
 
@@ -61,6 +67,8 @@ private:
     std::shared_ptr<Material> m_forwardMaterial;
     std::shared_ptr<Material> m_gbufferMaterial;
     std::shared_ptr<Material> m_deferredMaterial;
+    std::shared_ptr<Material> m_tiledDeferredMaterial;
+    std::shared_ptr<ShaderProgram> m_lightCullingProgram;
 
     // Loaded models
     Model m_floorModel;
@@ -84,6 +92,25 @@ private:
     float m_lightIntensity;
     bool m_useRandomColor;
 
+    // Light variables used by Update for the new fireflies. Copied in SubmitFrame, because in pipelined mode
+    // the GUI changes them while Update runs
+    glm::vec3 m_updateLightColor;
+    float m_updateLightIntensity;
+    bool m_updateUseRandomColor;
+
     // Renderer
     Renderer m_renderer;
+
+    // Deferred lighting pass, owned by the renderer. Null in forward mode
+    DeferredRenderPass* m_deferredRenderPass;
+
+    // Forward pass, owned by the renderer. Null in deferred mode
+    ForwardRenderPass* m_forwardRenderPass;
+
+    // Final pass to the window, owned by the renderer. Null in forward mode
+    UpscaleRenderPass* m_upscaleRenderPass;
+
+    // Render scale of the deferred passes, to keep the GPU time under a target
+    DynamicResolution m_dynamicResolution;
+    bool m_dynamicResolutionEnabled;
 };
@@ -1,6 +1,3 @@
-//Inputs
-in vec2 TexCoord;
-
 //Outputs
 out vec4 FragColor;
 
@@ -9,13 +6,14 @@ uniform sampler2D DepthTexture;
 uniform sampler2D AlbedoTexture;
 uniform sampler2D NormalTexture;
 uniform sampler2D OthersTexture;
-uniform mat4 InvViewMatrix;
-uniform mat4 InvProjMatrix;
 
 void main()
 {
+	// Screen texture coordinates. Interpolated coordinates are not valid when drawing light volumes instead of the fullscreen triangle
+	vec2 TexCoord = gl_FragCoord.xy / vec2(textureSize(DepthTexture, 0));
+
 	// Extract information from g-buffers
-	vec3 position = ReconstructViewPosition(DepthTexture, TexCoord, InvProjMatrix);
+	vec3 position = ReconstructViewPosition(DepthTexture, TexCoord, RenderScale, InvProjMatrix);
 	vec3 albedo = texture(AlbedoTexture, TexCoord).rgb;
 	vec3 normal = GetImplicitNormal(texture(NormalTexture, TexCoord).xy);
 	vec4 others = texture(OthersTexture, TexCoord);
@@ -0,0 +1,74 @@
+// Must match light_culling.comp
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 255u
+
+//Inputs
+in vec2 TexCoord;
+
+//Outputs
+out vec4 FragColor;
+
+// For each tile, the number of lights followed by MAX_LIGHTS_PER_TILE light indices.
+// The number is larger than MAX_LIGHTS_PER_TILE if the tile overflowed, only the first lights are stored
+layout (std430, binding = 1) readonly buffer TileLightBuffer
+{
+	uint TileLights[];
+};
+
+//Uniforms
+uniform sampler2D DepthTexture;
+uniform sampler2D AlbedoTexture;
+uniform sampler2D NormalTexture;
+uniform sampler2D OthersTexture;
+uniform uint TileCountX;
+
+// Debug view: if not 0, the tiles that dropped lights are tinted red
+uniform uint ShowTileOverflow;
+
+void main()
+{
+	// The fullscreen triangle covers the render viewport, that is only a part of the g-buffers with dynamic resolution
+	vec2 texCoord = TexCoord * RenderScale;
+
+	// Extract information from g-buffers
+	vec3 position = ReconstructViewPosition(DepthTexture, texCoord, RenderScale, InvProjMatrix);
+	vec3 albedo = texture(AlbedoTexture, texCoord).rgb;
+	vec3 normal = GetImplicitNormal(texture(NormalTexture, texCoord).xy);
+	vec4 others = texture(OthersTexture, texCoord);
+
+	// Compute view vector en view space
+	vec3 viewDir = GetDirection(position, vec3(0));
+
+	// Convert position, normal and view vector to world space
+	position = (InvViewMatrix * vec4(position, 1)).xyz;
+	normal = (InvViewMatrix * vec4(normal, 0)).xyz;
+	viewDir = (InvViewMatrix * vec4(viewDir, 0)).xyz;
+
+	// Set surface material data
+	SurfaceData data;
+	data.normal = normal;
+	data.reflectionColor = albedo;
+	data.ambientReflectance = others.x;
+	data.diffuseReflectance = others.y;
+	data.specularReflectance = others.z;
+	data.specularExponent = (1.0f / others.w) - 1.0f;
+
+	// Compute lighting, only with the lights of the tile of this pixel
+	vec3 lighting = ComputeIndirectLighting(data, viewDir);
+
+	uvec2 tile = uvec2(gl_FragCoord.xy) / uint(TILE_SIZE);
+	uint tileOffset = (tile.y * TileCountX + tile.x) * (MAX_LIGHTS_PER_TILE + 1u);
+	uint tileLightCount = TileLights[tileOffset];
+	uint lightCount = min(tileLightCount, MAX_LIGHTS_PER_TILE);
+	for (uint i = 0u; i < lightCount; ++i)
+	{
+		lighting += ComputeLight(Lights[TileLights[tileOffset + 1u + i]], data, viewDir, position);
+	}
+
+	if (ShowTileOverflow != 0u && tileLightCount > MAX_LIGHTS_PER_TILE)
+	{
+		lighting = mix(lighting, vec3(1.0f, 0.0f, 0.0f), 0.5f);
+	}
+
+	FragColor = vec4(lighting, 1.0f);
+}
@@ -0,0 +1,15 @@
+
+// Per-frame data, filled once per frame by the renderer. Must match Renderer::FrameData
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	mat4 InvViewMatrix;
+	mat4 InvProjMatrix;
+	vec3 CameraPosition;
+	float Time;
+	float DeltaTime;
+	// Part of the render targets with the scene, see Renderer::SetRenderScale
+	vec2 RenderScale;
+};
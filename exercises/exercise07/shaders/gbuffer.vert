@@ -2,23 +2,34 @@
 layout (location = 0) in vec3 VertexPosition;
 layout (location = 1) in vec3 VertexNormal;
 layout (location = 2) in vec2 VertexTexCoord;
+#ifdef INSTANCING
+layout (location = 3) in mat4 InstanceWorldMatrix;
+#endif
 
 //Outputs
 out vec3 ViewNormal;
 out vec2 TexCoord;
 
 //Uniforms
-uniform mat4 WorldViewMatrix;
-uniform mat4 WorldViewProjMatrix;
+uniform mat4 WorldMatrix;
 
 void main()
 {
+	// world matrix from the instance attribute, if instanced, or from the uniform, combined with the camera
+#ifdef INSTANCING
+	mat4 worldMatrix = InstanceWorldMatrix;
+#else
+	mat4 worldMatrix = WorldMatrix;
+#endif
+	mat4 worldViewMatrix = ViewMatrix * worldMatrix;
+	mat4 worldViewProjMatrix = ViewProjMatrix * worldMatrix;
+
 	// normal in view space (for lighting computation)
-	ViewNormal = normalize((WorldViewMatrix * vec4(VertexNormal, 0.0)).xyz);
+	ViewNormal = normalize((worldViewMatrix * vec4(VertexNormal, 0.0)).xyz);
 
 	// texture coordinates
 	TexCoord = VertexTexCoord;
 
 	// final vertex position (for opengl rendering, not for lighting)
-	gl_Position = WorldViewProjMatrix * vec4(VertexPosition, 1.0);
+	gl_Position = worldViewProjMatrix * vec4(VertexPosition, 1.0);
 }
@@ -0,0 +1 @@
+#define INSTANCING
@@ -0,0 +1,2 @@
+#define LIGHT_ARRAY
+#define MAX_LIGHTS_PER_OBJECT 32
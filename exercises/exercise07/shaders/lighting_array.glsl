@@ -0,0 +1,54 @@
+
+// Same as lighting.glsl, but the light properties are read from the Light struct instead of uniforms
+
+float ComputeDistanceAttenuation(Light light, vec3 position)
+{
+	// Compute distance attenuation, reading the range from attenuation.x (fade start) and attenuation.y (fade end)
+	return smoothstep(light.attenuation.y, light.attenuation.x, distance(position, light.position.xyz));
+}
+
+float ComputeAngularAttenuation(Light light, vec3 lightDir)
+{
+	float angle = acos(dot(light.direction.xyz, lightDir));
+	vec2 attAngle = light.attenuation.zw;
+	return smoothstep(attAngle.y, attAngle.x, angle);
+}
+
+float ComputeAttenuation(Light light, vec3 position, vec3 lightDir)
+{
+	float attenuation = 1.0f;
+	if (light.attenuation.y > 0)
+	{
+		attenuation *= ComputeDistanceAttenuation(light, position);
+	}
+	if (light.attenuation.w > 0)
+	{
+		attenuation *= ComputeAngularAttenuation(light, lightDir);
+	}
+	return attenuation;
+}
+
+vec3 ComputeLightDirection(Light light, vec3 position)
+{
+	return light.attenuation.y >= 0 ? GetDirection(position, light.position.xyz) : light.direction.xyz;
+}
+
+vec3 ComputeLight(Light light, SurfaceData data, vec3 viewDir, vec3 position)
+{
+	vec3 lightDir = ComputeLightDirection(light, position);
+
+	vec3 lighting = vec3(0);
+	lighting += ComputeDiffuseLighting(data, lightDir);
+	lighting += ComputeSpecularLighting(data, lightDir, viewDir);
+
+	float attenuation = ComputeAttenuation(light, position, lightDir);
+	return lighting * light.color.rgb * attenuation;
+}
+
+vec3 ComputeIndirectLighting(SurfaceData data, vec3 viewDir)
+{
+	vec3 lighting = vec3(0);
+	lighting += ComputeDiffuseIndirectLighting(data);
+	lighting += ComputeSpecularIndirectLighting(data, viewDir);
+	return lighting;
+}
@@ -0,0 +1,21 @@
+
+// Light properties, with the same layout as the light buffer filled by the renderer
+struct Light
+{
+	vec4 color;
+	vec4 position;
+	vec4 direction;
+	vec4 attenuation;
+};
+
+// All the lights of the frame
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+	Light Lights[];
+};
+
+// Light range, for point and spot lights. Negative for directional lights, and 0 if the light has no range limit
+float GetLightRange(Light light)
+{
+	return light.attenuation.y;
+}
@@ -15,7 +15,11 @@ uniform float DiffuseReflectance;
 uniform float SpecularReflectance;
 uniform float SpecularExponent;
 
-uniform vec3 CameraPosition;
+#ifdef LIGHT_ARRAY
+// Lights that affect this object, as indices in the light buffer
+uniform int LightCount;
+uniform int LightIndices[MAX_LIGHTS_PER_OBJECT];
+#endif
 
 void main()
 {
@@ -29,6 +33,14 @@ void main()
 
 	vec3 position = WorldPosition;
 	vec3 viewDir = GetDirection(position, CameraPosition);
+#ifdef LIGHT_ARRAY
+	vec3 color = ComputeIndirectLighting(data, viewDir);
+	for (int i = 0; i < LightCount; ++i)
+	{
+		color += ComputeLight(Lights[LightIndices[i]], data, viewDir, position);
+	}
+#else
 	vec3 color = ComputeLighting(position, data, viewDir, true);
+#endif
 	FragColor = vec4(color.rgb, 1);
 }
@@ -2,23 +2,35 @@
 layout (location = 0) in vec3 VertexPosition;
 layout (location = 1) in vec3 VertexNormal;
 layout (location = 2) in vec2 VertexTexCoord;
+#ifdef INSTANCING
+layout (location = 3) in mat4 InstanceWorldMatrix;
+#endif
 
 //Outputs
 out vec3 WorldPosition;
 out vec3 WorldNormal;
 out vec2 TexCoord;
 
+// same position as the depth pre-pass, required by its GL_EQUAL depth test
+invariant gl_Position;
+
 //Uniforms
 uniform mat4 WorldMatrix;
-uniform mat4 ViewProjMatrix;
 
 void main()
 {
+	// world matrix from the instance attribute, if instanced, or from the uniform
+#ifdef INSTANCING
+	mat4 worldMatrix = InstanceWorldMatrix;
+#else
+	mat4 worldMatrix = WorldMatrix;
+#endif
+
 	// vertex position in world space (for lighting computation)
-	WorldPosition = (WorldMatrix * vec4(VertexPosition, 1.0)).xyz;
+	WorldPosition = (worldMatrix * vec4(VertexPosition, 1.0)).xyz;
 
 	// normal in world space (for lighting computation)
-	WorldNormal = normalize((WorldMatrix * vec4(VertexNormal, 0.0)).xyz);
+	WorldNormal = normalize((worldMatrix * vec4(VertexNormal, 0.0)).xyz);
 
 	// texture coordinates
 	TexCoord = VertexTexCoord;
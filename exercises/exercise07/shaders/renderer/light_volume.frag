@@ -0,0 +1,6 @@
+#version 330 core
+
+void main()
+{
+	// Nothing to do, only the stencil buffer is written
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+
+//Uniforms
+uniform mat4 WorldViewProjMatrix;
+
+void main()
+{
+	// Only the position is needed, to mark the light volume in the stencil buffer
+	gl_Position = WorldViewProjMatrix * vec4(VertexPosition, 1.0);
+}
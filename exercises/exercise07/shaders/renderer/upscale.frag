@@ -0,0 +1,39 @@
+#version 330 core
+
+//Inputs
+in vec2 TexCoord;
+
+//Outputs
+out vec4 FragColor;
+
+//Uniforms
+uniform sampler2D SourceTexture;
+uniform vec2 SourceScale;
+uniform float Sharpness;
+
+void main()
+{
+	// The scene is in the bottom-left part of the texture. Stay half a texel inside, so the filter doesn't read outside of it
+	vec2 texelSize = 1.0f / vec2(textureSize(SourceTexture, 0));
+	vec2 minCoord = 0.5f * texelSize;
+	vec2 maxCoord = SourceScale - 0.5f * texelSize;
+	vec2 texCoord = clamp(TexCoord * SourceScale, minCoord, maxCoord);
+
+	vec3 color = texture(SourceTexture, texCoord).rgb;
+	if (Sharpness > 0.0f)
+	{
+		// Neighbors, one source texel away
+		vec3 left = texture(SourceTexture, clamp(texCoord - vec2(texelSize.x, 0.0f), minCoord, maxCoord)).rgb;
+		vec3 right = texture(SourceTexture, clamp(texCoord + vec2(texelSize.x, 0.0f), minCoord, maxCoord)).rgb;
+		vec3 down = texture(SourceTexture, clamp(texCoord - vec2(0.0f, texelSize.y), minCoord, maxCoord)).rgb;
+		vec3 up = texture(SourceTexture, clamp(texCoord + vec2(0.0f, texelSize.y), minCoord, maxCoord)).rgb;
+
+		// Unsharp mask, clamped to the neighbors so the edges are sharpened without halos
+		vec3 minColor = min(color, min(min(left, right), min(down, up)));
+		vec3 maxColor = max(color, max(max(left, right), max(down, up)));
+		vec3 blurred = (left + right + down + up) * 0.25f;
+		color = clamp(color + Sharpness * (color - blurred), minColor, maxColor);
+	}
+
+	FragColor = vec4(color, 1.0f);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+
+//Outputs
+out vec2 TexCoord;
+
+void main()
+{
+	// Fullscreen triangle, directly in clip coordinates
+	gl_Position = vec4(VertexPosition.xy, 0.0f, 1.0f);
+
+	// Texture coordinates of the output, from 0 to 1 on the screen
+	TexCoord = VertexPosition.xy * 0.5f + 0.5f;
+}
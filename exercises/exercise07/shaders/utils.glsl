@@ -42,3 +42,12 @@ vec3 ReconstructViewPosition(sampler2D depthTexture, vec2 texCoord, mat4 invProj
 	return viewPosition.xyz / viewPosition.w;
 }
 
+// Same, when the scene is only in a part of the depth buffer, with dynamic resolution
+vec3 ReconstructViewPosition(sampler2D depthTexture, vec2 texCoord, vec2 renderScale, mat4 invProjMatrix)
+{
+	float depth = texture(depthTexture, texCoord).r;
+	vec3 clipPosition = vec3(texCoord / renderScale, depth) * 2.0f - vec3(1.0f);
+	vec4 viewPosition = invProjMatrix * vec4(clipPosition, 1.0f);
+	return viewPosition.xyz / viewPosition.w;
+}
+
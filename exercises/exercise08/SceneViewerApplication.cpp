@@ -16,9 +16,11 @@
 #include <ituGL/geometry/Model.h>
 #include <ituGL/scene/SceneModel.h>
 
+#include <ituGL/renderer/ShadowMapRenderPass.h>
 #include <ituGL/renderer/SkyboxRenderPass.h>
 #include <ituGL/renderer/ForwardRenderPass.h>
 #include <ituGL/scene/RendererSceneVisitor.h>
+#include <ituGL/core/Profiler.h>
 
 #include <ituGL/scene/ImGuiSceneVisitor.h>
 #include <imgui.h>
@@ -26,6 +28,11 @@
 SceneViewerApplication::SceneViewerApplication()
     : Application(1024, 1024, "Scene Viewer demo")
     , m_renderer(GetDevice())
+    , m_frustumCullingEnabled(true)
+    , m_visibleModelCount(0)
+    , m_culledModelCount(0)
+    , m_multithreadingEnabled(true)
+    , m_shadowMapRenderPass(nullptr)
 {
 }
 
@@ -52,7 +59,24 @@ void SceneViewerApplication::Update()
 
     // Add the scene nodes to the renderer
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
+    rendererSceneVisitor.SetFrustumCullingEnabled(m_frustumCullingEnabled);
+    rendererSceneVisitor.SetShadowCastersEnabled(true);
+    rendererSceneVisitor.SetThreadPool(m_multithreadingEnabled ? &m_threadPool : nullptr);
     m_scene.AcceptVisitor(rendererSceneVisitor);
+
+    // Once the camera is known, add only the models inside its frustum
+    rendererSceneVisitor.SubmitModels();
+    m_visibleModelCount = rendererSceneVisitor.GetVisibleModelCount();
+    m_culledModelCount = rendererSceneVisitor.GetCulledModelCount();
+
+    m_renderer.SetFrameTime(GetCurrentTime(), GetDeltaTime());
+}
+
+void SceneViewerApplication::SubmitFrame()
+{
+    Application::SubmitFrame();
+
+    m_renderer.SubmitFrame();
 }
 
 void SceneViewerApplication::Render()
@@ -113,12 +137,15 @@ void SceneViewerApplication::InitializeMaterial()
     // Load and build shader
     std::vector<const char*> vertexShaderPaths;
     vertexShaderPaths.push_back("shaders/version330.glsl");
+    vertexShaderPaths.push_back("shaders/frame.glsl");
     vertexShaderPaths.push_back("shaders/default.vert");
     Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
     std::vector<const char*> fragmentShaderPaths;
     fragmentShaderPaths.push_back("shaders/version330.glsl");
+    fragmentShaderPaths.push_back("shaders/frame.glsl");
     fragmentShaderPaths.push_back("shaders/utils.glsl");
+    fragmentShaderPaths.push_back("shaders/shadows.glsl");
     fragmentShaderPaths.push_back("shaders/lambert-ggx.glsl");
     fragmentShaderPaths.push_back("shaders/lighting.glsl");
     fragmentShaderPaths.push_back("shaders/default_pbr.frag");
@@ -127,20 +154,16 @@ void SceneViewerApplication::InitializeMaterial()
     std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
     shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-    // Get transform related uniform locations
-    ShaderProgram::Location cameraPositionLocation = shaderProgramPtr->GetUniformLocation("CameraPosition");
+    // Shadow data is in its own block, filled by the shadow pass
+    shaderProgramPtr->SetUniformBlockBinding("ShadowBlock", ShadowMapRenderPass::ShadowBlockBinding);
+
+    // Get transform related uniform locations. The camera is in the frame block
     ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
-    ShaderProgram::Location viewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("ViewProjMatrix");
 
     // Register shader with renderer
     m_renderer.RegisterShaderProgram(shaderProgramPtr,
         [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
         {
-            if (cameraChanged)
-            {
-                shaderProgram.SetUniform(cameraPositionLocation, camera.ExtractTranslation());
-                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
-            }
             shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
         },
         m_renderer.GetDefaultUpdateLightsFunction(*shaderProgramPtr)
@@ -148,9 +171,7 @@ void SceneViewerApplication::InitializeMaterial()
 
     // Filter out uniforms that are not material properties
     ShaderUniformCollection::NameSet filteredUniforms;
-    filteredUniforms.insert("CameraPosition");
     filteredUniforms.insert("WorldMatrix");
-    filteredUniforms.insert("ViewProjMatrix");
     filteredUniforms.insert("LightIndirect");
     filteredUniforms.insert("LightColor");
     filteredUniforms.insert("LightPosition");
@@ -160,6 +181,12 @@ void SceneViewerApplication::InitializeMaterial()
     // Create reference material
     assert(shaderProgramPtr);
     m_defaultMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+
+    // The shadow pass is created here, so the material copies of the models get its shadow map. It is the first pass
+    std::unique_ptr<ShadowMapRenderPass> shadowMapRenderPass = std::make_unique<ShadowMapRenderPass>();
+    m_shadowMapRenderPass = shadowMapRenderPass.get();
+    m_renderer.AddRenderPass(std::move(shadowMapRenderPass));
+    m_defaultMaterial->SetUniformValue("ShadowMap", m_shadowMapRenderPass->GetShadowMap());
 }
 
 void SceneViewerApplication::InitializeModels()
@@ -230,5 +257,41 @@ void SceneViewerApplication::RenderGUI()
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
 
+    // Draw GUI for frustum culling
+    if (auto window = m_imGui.UseWindow("Culling"))
+    {
+        ImGui::Checkbox("Frustum culling", &m_frustumCullingEnabled);
+        ImGui::Text("Visible models: %u", m_visibleModelCount);
+        ImGui::Text("Culled models: %u", m_culledModelCount);
+        ImGui::Checkbox("Multithreaded", &m_multithreadingEnabled);
+        ImGui::Text("Threads: %u", m_threadPool.GetThreadCount());
+    }
+
+    // Draw GUI for the shadow cache
+    if (auto window = m_imGui.UseWindow("Shadows"))
+    {
+        bool cachingEnabled = m_shadowMapRenderPass->GetCachingEnabled();
+        if (ImGui::Checkbox("Cache static casters", &cachingEnabled))
+        {
+            m_shadowMapRenderPass->SetCachingEnabled(cachingEnabled);
+        }
+        ImGui::Text("Shadow tiles: %u", m_shadowMapRenderPass->GetActiveTileCount());
+        ImGui::Text("Static tiles rendered: %u", m_shadowMapRenderPass->GetStaticRenderCount());
+    }
+
+    // Draw GUI for the GPU time of each render pass
+    m_renderer.GetPassTimer().DrawGUI(m_imGui);
+
+#ifdef ITUGL_PROFILING
+    // Write the CPU zones recorded since the last save
+    if (auto window = m_imGui.UseWindow("CPU profiler"))
+    {
+        if (ImGui::Button("Save Chrome trace"))
+        {
+            Profiler::WriteChromeTrace("cpu_trace.json");
+        }
+    }
+#endif
+
     m_imGui.EndFrame();
 }
@@ -4,11 +4,13 @@
 
 #include <ituGL/scene/Scene.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/core/ThreadPool.h>
 #include <ituGL/camera/CameraController.h>
 #include <ituGL/utils/DearImGui.h>
 
 class TextureCubemapObject;
 class Material;
+class ShadowMapRenderPass;
 
 class SceneViewerApplication : public Application
 {
@@ -18,6 +20,7 @@ public:
 protected:
     void Initialize() override;
     void Update() override;
+    void SubmitFrame() override;
     void Render() override;
     void Cleanup() override;
 
@@ -43,6 +46,18 @@ private:
     // Renderer
     Renderer m_renderer;
 
+    // Frustum culling results of the last frame
+    bool m_frustumCullingEnabled;
+    unsigned int m_visibleModelCount;
+    unsigned int m_culledModelCount;
+
+    // Worker threads to cull and record the models in parallel, if enabled
+    ThreadPool m_threadPool;
+    bool m_multithreadingEnabled;
+
+    // Shadow pass, owned by the renderer
+    ShadowMapRenderPass* m_shadowMapRenderPass;
+
     // Skybox texture
     std::shared_ptr<TextureCubemapObject> m_skyboxTexture;
 
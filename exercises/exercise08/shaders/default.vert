@@ -14,7 +14,6 @@ out vec2 TexCoord;
 
 //Uniforms
 uniform mat4 WorldMatrix;
-uniform mat4 ViewProjMatrix;
 
 void main()
 {
@@ -14,8 +14,6 @@ uniform sampler2D ColorTexture;
 uniform sampler2D NormalTexture;
 uniform sampler2D SpecularTexture;
 
-uniform vec3 CameraPosition;
-
 void main()
 {
 	SurfaceData data;
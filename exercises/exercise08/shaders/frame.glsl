@@ -0,0 +1,13 @@
+
+// Per-frame data, filled once per frame by the renderer. Must match Renderer::FrameData
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	mat4 InvViewMatrix;
+	mat4 InvProjMatrix;
+	vec3 CameraPosition;
+	float Time;
+	float DeltaTime;
+};
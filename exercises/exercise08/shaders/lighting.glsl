@@ -46,6 +46,13 @@ vec3 ComputeLight(SurfaceData data, vec3 viewDir, vec3 position)
 	vec3 light = CombineLighting(diffuse, specular, data, lightDir, viewDir);
 
 	float attenuation = ComputeAttenuation(position, lightDir);
+#ifdef SHADOWS
+	// Directional lights have negative attenuation, spot lights have an angle
+	if (LightAttenuation.y < 0 || LightAttenuation.w > 0)
+	{
+		attenuation *= ComputeShadow(position, LightPosition, LightAttenuation.y < 0);
+	}
+#endif
 	return light * LightColor * attenuation;
 }
 
@@ -0,0 +1,75 @@
+
+// Shadow data, filled once per frame by ShadowMapRenderPass. Must match ShadowMapRenderPass::ShadowData
+layout (std140) uniform ShadowBlock
+{
+	mat4 ShadowCascadeMatrices[4];
+	vec4 ShadowCascadeTiles[4];
+	mat4 ShadowSpotLightMatrices[4];
+	vec4 ShadowSpotLightTiles[4];
+	vec4 ShadowSpotLightPositions[4];
+	vec4 ShadowCascadeSplits;
+	int ShadowCascadeCount;
+	int ShadowSpotLightCount;
+};
+
+// Shadow atlas, with depth comparison enabled
+uniform sampler2DShadow ShadowMap;
+
+// Lighting multiplies the attenuation by the shadow
+#define SHADOWS
+
+// Returns the fraction of the light that reaches the position, filtering 3x3 samples inside the tile
+float SampleShadow(mat4 shadowMatrix, vec4 tile, vec3 position)
+{
+	vec4 shadowPosition = shadowMatrix * vec4(position, 1.0f);
+	vec3 coords = shadowPosition.xyz / shadowPosition.w * 0.5f + 0.5f;
+
+	// Outside of the tile there is no shadow
+	if (any(lessThan(coords.xy, vec2(0.0f))) || any(greaterThan(coords.xy, vec2(1.0f))) || coords.z > 1.0f)
+	{
+		return 1.0f;
+	}
+
+	vec2 texelSize = 1.0f / vec2(textureSize(ShadowMap, 0));
+	vec2 tileMin = tile.xy + texelSize * 0.5f;
+	vec2 tileMax = tile.xy + tile.zw - texelSize * 0.5f;
+	vec2 center = tile.xy + coords.xy * tile.zw;
+
+	float shadow = 0.0f;
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			vec2 uv = clamp(center + vec2(x, y) * texelSize, tileMin, tileMax);
+			shadow += texture(ShadowMap, vec3(uv, coords.z));
+		}
+	}
+	return shadow / 9.0f;
+}
+
+// Shadow of the current light at the position. Directional lights use the cascades, spot lights are matched by position
+float ComputeShadow(vec3 position, vec3 lightPosition, bool directional)
+{
+	if (directional)
+	{
+		float viewDepth = -(ViewMatrix * vec4(position, 1.0f)).z;
+		for (int i = 0; i < ShadowCascadeCount; ++i)
+		{
+			if (viewDepth <= ShadowCascadeSplits[i])
+			{
+				return SampleShadow(ShadowCascadeMatrices[i], ShadowCascadeTiles[i], position);
+			}
+		}
+	}
+	else
+	{
+		for (int i = 0; i < ShadowSpotLightCount; ++i)
+		{
+			if (distance(ShadowSpotLightPositions[i].xyz, lightPosition) < 0.001f)
+			{
+				return SampleShadow(ShadowSpotLightMatrices[i], ShadowSpotLightTiles[i], position);
+			}
+		}
+	}
+	return 1.0f;
+}
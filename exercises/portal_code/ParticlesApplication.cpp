@@ -81,11 +81,10 @@ const std::array<VertexAttribute, 6> s_vertexAttributes =
 
 ParticlesApplication::ParticlesApplication()
     : Application(1024, 1024, "Particles demo")
+    , m_particles(sizeof(Particle), 4000)
     , m_currentTimeUniform(0)
     , m_gravityUniform(0)
     , m_mousePosition(0)
-    , m_particleCount(0)
-    , m_particleCapacity(4000)
 {
 }
 
@@ -225,14 +224,18 @@ void ParticlesApplication::Render()
     // Disable stencil test to draw particles on top of the image
     glDisable(GL_STENCIL_TEST);
 
+    // The code above uses raw GL calls, so the states cached by the device are not valid anymore
+    GetDevice().InvalidateState();
+
     
 
     m_shaderProgram.Use();
     m_shaderProgram.SetUniform(m_currentTimeUniform, GetCurrentTime());
     m_shaderProgram.SetUniform(m_gravityUniform, 0.0f);
+    m_particles.Flush();
     m_vao.Bind();
 
-    glDrawArrays(GL_POINTS, 0, std::min(m_particleCount, m_particleCapacity));
+    glDrawArrays(GL_POINTS, 0, m_particles.GetParticleCount());
 
 
     // UI section
@@ -249,8 +252,7 @@ void ParticlesApplication::Render()
 
 void ParticlesApplication::InitializeGeometry()
 {
-    m_vbo.Bind();
-    m_vbo.AllocateData(m_particleCapacity * sizeof(Particle), BufferObject::Usage::DynamicDraw);
+    m_particles.GetVertexBuffer().Bind();
     m_vao.Bind();
 
     GLsizei stride = sizeof(Particle);
@@ -318,15 +320,7 @@ void ParticlesApplication::EmitParticle(const glm::vec2& position, float size, f
     particle.color = color;
     particle.velocity = velocity;
 
-    unsigned int particleIndex = m_particleCount % m_particleCapacity;
-
-    m_vbo.Bind();
-    int offset = particleIndex * sizeof(Particle);
-    m_vbo.UpdateData(std::span(&particle, 1), offset);
-
-    VertexBufferObject::Unbind();
-
-    m_particleCount++;
+    m_particles.Emit(particle);
 }
 
 void ParticlesApplication::LoadAndCompileShader(Shader& shader, const char* path)
@@ -370,19 +364,17 @@ float ParticlesApplication::RandomB()
     return CurrentCol.b;
 }
 
-float ParticlesApplication::RandomNum()
-{
-    return static_cast<float>(rand()) / RAND_MAX;
-}
-
 float ParticlesApplication::RandomRange(float from, float to)
 {
-    return RandomNum() * (to - from) + from;
+    return GetRandom().NextRange(from, to);
 }
 
 glm::vec2 ParticlesApplication::RandomDirection()
 {
-    return glm::normalize(glm::vec2(RandomNum() - 0.5f, RandomNum() - 0.5f));
+    Random& random = GetRandom();
+    float x = random.Next01() - 0.5f;
+    float y = random.Next01() - 0.5f;
+    return glm::normalize(glm::vec2(x, y));
 }
 
 Color ParticlesApplication::RandomColor()
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <ituGL/application/Application.h>
-#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/particles/ParticleEmitterBuffer.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/shader/ShaderProgram.h>
 #include <ituGL/asset/TextureCubemapLoader.h>
@@ -37,10 +37,10 @@ private:
     static float RandomR();
     static float RandomG();
     static float RandomB();
-    static float RandomNum();
 
-    static float RandomRange(float from, float to);
-    static glm::vec2 RandomDirection();
+    // From the generator of the application
+    float RandomRange(float from, float to);
+    glm::vec2 RandomDirection();
     static Color RandomColor();
     GLuint LoadTexture(const char* filename, glm::vec3& SceneCol);
     void RenderPortalBackground();
@@ -51,8 +51,8 @@ private:
 
 
 private:
-    // All particles stored in a single VBO with interleaved attributes
-    VertexBufferObject m_vbo;
+    // All particles stored in a single VBO with interleaved attributes, used as a circular buffer
+    ParticleEmitterBuffer m_particles;
 
     // VAO that represents the particle system
     VertexArrayObject m_vao;
@@ -91,10 +91,4 @@ private:
 
     // Mouse position during this frame
     glm::vec2 m_mousePosition;
-
-    // Total number of particles created
-    unsigned int m_particleCount;
-
-    // Max number of particles that can exist at the same time
-    const unsigned int m_particleCapacity;
 };
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "BenchmarkSuite.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace
+{
+    // Calibration stops growing the iterations when a run takes this long, and extrapolates from there
+    constexpr double CalibrationTime = 0.01;
+
+    const void* volatile g_escapedValue = nullptr;
+
+    // Brand string of the CPU, from CPUID on x86. "unknown" on other architectures
+    std::string GetCpuName()
+    {
+        unsigned int brand[12] = {};
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int registers[4];
+        __cpuid(registers, 0x80000000);
+        if (static_cast<unsigned int>(registers[0]) >= 0x80000004)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                __cpuid(reinterpret_cast<int*>(brand + 4 * i), 0x80000002 + i);
+            }
+        }
+#elif defined(__x86_64__) || defined(__i386__)
+        if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004)
+        {
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                __get_cpuid(0x80000002 + i, &brand[4 * i], &brand[4 * i + 1], &brand[4 * i + 2], &brand[4 * i + 3]);
+            }
+        }
+#endif
+        char text[sizeof(brand) + 1] = {};
+        std::memcpy(text, brand, sizeof(brand));
+
+        // The brand is padded with spaces
+        std::string name(text);
+        name.erase(0, name.find_first_not_of(' '));
+        name.erase(name.find_last_not_of(' ') + 1);
+        return name.empty() ? "unknown" : name;
+    }
+
+    // Context strings are written as JSON strings, and read back without unescaping
+    std::string RemoveQuotes(std::string text)
+    {
+        std::erase_if(text, [](char c) { return c == '"' || c == '\\'; });
+        return text;
+    }
+
+    // Value of a string key, searched between begin and end. Empty if not found
+    std::string FindString(const std::string& text, const char* key, std::size_t begin, std::size_t end)
+    {
+        std::size_t keyPosition = text.find(key, begin);
+        if (keyPosition >= end)
+        {
+            return std::string();
+        }
+        std::size_t valueBegin = text.find('"', text.find(':', keyPosition) + 1);
+        std::size_t valueEnd = text.find('"', valueBegin + 1);
+        return valueEnd < end ? text.substr(valueBegin + 1, valueEnd - valueBegin - 1) : std::string();
+    }
+}
+
+void EscapeValue(const void* value)
+{
+    g_escapedValue = value;
+}
+
+BenchmarkSuite::Context BenchmarkSuite::Context::GetCurrent()
+{
+    Context context;
+    context.cpu = GetCpuName();
+    context.threadCount = std::thread::hardware_concurrency();
+#if defined(__clang__)
+    context.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    context.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    context.compiler = "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    context.compiler = "unknown";
+#endif
+#ifdef NDEBUG
+    context.build = "release";
+#else
+    context.build = "debug";
+#endif
+    return context;
+}
+
+double BenchmarkSuite::Thresholds::GetPercent(const std::string& name) const
+{
+    double percent = defaultPercent;
+    std::size_t prefixLength = 0;
+    for (const auto& [prefix, prefixPercent] : prefixPercents)
+    {
+        if (name.starts_with(prefix) && prefix.size() >= prefixLength)
+        {
+            percent = prefixPercent;
+            prefixLength = prefix.size();
+        }
+    }
+    return percent;
+}
+
+void BenchmarkSuite::Add(const char* name, double itemsPerIteration, SetupFunction setup)
+{
+    m_benchmarks.push_back(Benchmark{ name, itemsPerIteration, std::move(setup) });
+}
+
+void BenchmarkSuite::List() const
+{
+    for (const Benchmark& benchmark : m_benchmarks)
+    {
+        std::printf("%s\n", benchmark.name.c_str());
+    }
+}
+
+std::vector<BenchmarkSuite::Result> BenchmarkSuite::Run(const Settings& settings) const
+{
+    std::printf("%-40s %14s %14s %14s %16s\n", "Benchmark", "Iterations", "ns/iter", "min ns/iter", "items/s");
+
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : m_benchmarks)
+    {
+        if (benchmark.name.find(settings.filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        const Result& result = results.emplace_back(Run(benchmark, settings));
+        std::printf("%-40s %14zu %14.2f %14.2f %16.4g\n", result.name.c_str(), result.iterations,
+            result.nsPerIteration, result.minNsPerIteration, result.itemsPerSecond);
+        std::fflush(stdout);
+    }
+    return results;
+}
+
+double BenchmarkSuite::Measure(const RunFunction& run, std::size_t iterations)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    run(iterations);
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    return duration.count();
+}
+
+BenchmarkSuite::Result BenchmarkSuite::Run(const Benchmark& benchmark, const Settings& settings)
+{
+    RunFunction run = benchmark.setup();
+
+    // The first run warms up the caches, and is not used
+    std::size_t iterations = 1;
+    double time = Measure(run, iterations);
+
+    // Grow the iterations until the time is long enough to be measured, then scale it up to the minimum time
+    while (time < CalibrationTime)
+    {
+        iterations *= 10;
+        time = Measure(run, iterations);
+    }
+    if (time < settings.minTime)
+    {
+        iterations = static_cast<std::size_t>(std::ceil(iterations * settings.minTime / time));
+    }
+
+    std::vector<double> times(std::max(settings.repetitions, 1u));
+    for (double& repetitionTime : times)
+    {
+        repetitionTime = Measure(run, iterations) / iterations;
+    }
+    std::sort(times.begin(), times.end());
+
+    Result result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.nsPerIteration = times[times.size() / 2] * 1e9;
+    result.minNsPerIteration = times.front() * 1e9;
+    result.itemsPerSecond = benchmark.itemsPerIteration / times[times.size() / 2];
+    return result;
+}
+
+bool BenchmarkSuite::WriteJson(const char* path, const Context& context, std::span<const Result> results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "{\n  \"context\": {\"cpu\": \"" << RemoveQuotes(context.cpu) << "\", \"threads\": " << context.threadCount
+        << ", \"compiler\": \"" << RemoveQuotes(context.compiler) << "\", \"build\": \"" << RemoveQuotes(context.build) << "\"},\n";
+
+    // One benchmark per line, so the files are easy to diff
+    file << "  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        char line[512];
+        std::snprintf(line, sizeof(line),
+            "    {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_iteration\": %.4f, \"min_ns_per_iteration\": %.4f, \"items_per_second\": %.6g}%s\n",
+            result.name.c_str(), result.iterations, result.nsPerIteration, result.minNsPerIteration, result.itemsPerSecond,
+            i + 1 < results.size() ? "," : "");
+        file << line;
+    }
+    file << "  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+bool BenchmarkSuite::ReadJson(const char* path, Context& context, std::vector<Result>& results)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Not a full JSON parser: it looks for each name, and the times that follow it. Names never need escaping
+    const std::string nameKey = "\"name\"";
+    std::size_t position = text.find(nameKey);
+
+    // The context comes before the first benchmark
+    std::size_t contextEnd = std::min(text.find('}'), position);
+    context.cpu = FindString(text, "\"cpu\"", 0, contextEnd);
+    context.compiler = FindString(text, "\"compiler\"", 0, contextEnd);
+    context.build = FindString(text, "\"build\"", 0, contextEnd);
+    std::size_t threadsPosition = text.find("\"threads\"");
+    context.threadCount = threadsPosition < contextEnd
+        ? static_cast<unsigned int>(std::strtoul(text.c_str() + text.find(':', threadsPosition) + 1, nullptr, 10)) : 0;
+
+    while (position != std::string::npos)
+    {
+        std::size_t nameBegin = text.find('"', text.find(':', position + nameKey.size()) + 1);
+        std::size_t nameEnd = text.find('"', nameBegin + 1);
+        if (nameBegin == std::string::npos || nameEnd == std::string::npos)
+        {
+            return false;
+        }
+
+        Result& result = results.emplace_back();
+        result.name = text.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+
+        std::size_t nextPosition = text.find(nameKey, nameEnd);
+        auto readNumber = [&](const char* key, double& value)
+            {
+                std::size_t keyPosition = text.find(key, nameEnd);
+                if (keyPosition < nextPosition)
+                {
+                    value = std::strtod(text.c_str() + text.find(':', keyPosition) + 1, nullptr);
+                }
+            };
+        double iterations = 0.0;
+        readNumber("\"iterations\"", iterations);
+        result.iterations = static_cast<std::size_t>(iterations);
+        readNumber("\"ns_per_iteration\"", result.nsPerIteration);
+        readNumber("\"min_ns_per_iteration\"", result.minNsPerIteration);
+        readNumber("\"items_per_second\"", result.itemsPerSecond);
+
+        position = nextPosition;
+    }
+    return true;
+}
+
+unsigned int BenchmarkSuite::Compare(std::span<const Result> results, std::span<const Result> baseline, const Thresholds& thresholds,
+    const Context& context, const Context& baselineContext)
+{
+    // Times from another machine or build say little about regressions, but the comparison still runs
+    std::printf("\nBaseline: %s, %u threads, %s, %s\n", baselineContext.cpu.empty() ? "unknown machine" : baselineContext.cpu.c_str(),
+        baselineContext.threadCount, baselineContext.compiler.c_str(), baselineContext.build.c_str());
+    std::printf("Current:  %s, %u threads, %s, %s\n", context.cpu.c_str(), context.threadCount, context.compiler.c_str(), context.build.c_str());
+    if (baselineContext.cpu != context.cpu || baselineContext.threadCount != context.threadCount
+        || baselineContext.compiler != context.compiler || baselineContext.build != context.build)
+    {
+        std::printf("Warning: the baseline was measured on another machine or build, generate a local one with --json\n");
+    }
+
+    std::printf("\n%-40s %14s %14s %10s %10s\n", "Benchmark", "Baseline ns", "Current ns", "Change", "Threshold");
+
+    unsigned int regressionCount = 0;
+    for (const Result& result : results)
+    {
+        auto itBaseline = std::find_if(baseline.begin(), baseline.end(), [&](const Result& r) { return r.name == result.name; });
+        if (itBaseline == baseline.end() || itBaseline->nsPerIteration <= 0.0)
+        {
+            std::printf("%-40s %14s %14.2f %10s %10s\n", result.name.c_str(), "-", result.nsPerIteration, "new", "-");
+            continue;
+        }
+
+        double change = (result.nsPerIteration / itBaseline->nsPerIteration - 1.0) * 100.0;
+        double threshold = thresholds.GetPercent(result.name);
+        bool regression = change > threshold;
+        regressionCount += regression ? 1 : 0;
+
+        std::printf("%-40s %14.2f %14.2f %+9.1f%% %9.1f%%%s\n", result.name.c_str(), itBaseline->nsPerIteration,
+            result.nsPerIteration, change, threshold, regression ? "  REGRESSION" : "");
+    }
+
+    std::printf("\n%u regression(s)\n", regressionCount);
+    return regressionCount;
+}
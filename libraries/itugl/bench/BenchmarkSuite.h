@@ -0,0 +1,117 @@
+#pragma once
+
+#include <functional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Keep the compiler from removing a computation because its result is never used
+void EscapeValue(const void* value);
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    EscapeValue(&value);
+#endif
+}
+
+// Collection of micro-benchmarks. Each one is measured in repetitions of a fixed number of iterations,
+// chosen so a repetition takes at least the minimum time, and the result is the median of the repetitions.
+// Results are written to JSON, and compared with a previous JSON file to find the regressions
+class BenchmarkSuite
+{
+public:
+    // Run the measured code a number of iterations
+    using RunFunction = std::function<void(std::size_t iterations)>;
+
+    // Prepare the data of a benchmark, out of the measured time, and return the function to measure
+    using SetupFunction = std::function<RunFunction()>;
+
+    struct Settings
+    {
+        // Only run the benchmarks whose name contains this text
+        std::string filter;
+        // Minimum time of each repetition, in seconds
+        double minTime = 0.1;
+        unsigned int repetitions = 5;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::size_t iterations = 0;
+        // Median and fastest time of the repetitions, per iteration
+        double nsPerIteration = 0.0;
+        double minNsPerIteration = 0.0;
+        // Items processed per second, from the median time
+        double itemsPerSecond = 0.0;
+    };
+
+    // Machine and build that measured the results. Times are only comparable between files with the same context
+    struct Context
+    {
+        std::string cpu;
+        unsigned int threadCount = 0;
+        std::string compiler;
+        std::string build;
+
+        // Context of this executable, on this machine
+        static Context GetCurrent();
+    };
+
+    // Allowed slowdown against the baseline, in percent. The longest prefix that matches the name is used
+    struct Thresholds
+    {
+        double defaultPercent = 5.0;
+        std::vector<std::pair<std::string, double>> prefixPercents;
+
+        double GetPercent(const std::string& name) const;
+    };
+
+public:
+    // Items are what one iteration processes: pairs of bounds, particles... They only affect items per second
+    void Add(const char* name, double itemsPerIteration, SetupFunction setup);
+
+    // Print the names of all the benchmarks
+    void List() const;
+
+    // Run the benchmarks that match the filter, printing each result when it finishes
+    std::vector<Result> Run(const Settings& settings) const;
+
+    // Write the context and the results as JSON. Returns false if the file can't be written
+    static bool WriteJson(const char* path, const Context& context, std::span<const Result> results);
+
+    // Read the context, names and times of a file written by WriteJson. Returns false if the file can't be read.
+    // Files without context leave it empty
+    static bool ReadJson(const char* path, Context& context, std::vector<Result>& results);
+
+    // Print the change of each result against the baseline, and return the number of results slower than the threshold.
+    // Benchmarks missing in the baseline are not regressions. Warns if the baseline was measured in another context
+    static unsigned int Compare(std::span<const Result> results, std::span<const Result> baseline, const Thresholds& thresholds,
+        const Context& context, const Context& baselineContext);
+
+private:
+    struct Benchmark
+    {
+        std::string name;
+        double itemsPerIteration;
+        SetupFunction setup;
+    };
+
+    // Time in seconds of running the given number of iterations
+    static double Measure(const RunFunction& run, std::size_t iterations);
+
+    static Result Run(const Benchmark& benchmark, const Settings& settings);
+
+private:
+    std::vector<Benchmark> m_benchmarks;
+};
+
+// Registration of the benchmarks of each module
+void AddSceneBenchmarks(BenchmarkSuite& suite);
+void AddGeometryBenchmarks(BenchmarkSuite& suite);
+void AddShaderBenchmarks(BenchmarkSuite& suite);
+void AddParticleBenchmarks(BenchmarkSuite& suite);
@@ -0,0 +1,83 @@
+#include "BenchmarkSuite.h"
+
+#include <ituGL/asset/ModelLoader.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // Vertex count of the CopyBuffer benchmarks, a large mesh
+    constexpr unsigned int VertexCount = 65536;
+
+    // Format of a typical loaded mesh
+    std::shared_ptr<VertexFormat> CreateVertexFormat()
+    {
+        std::shared_ptr<VertexFormat> vertexFormat = std::make_shared<VertexFormat>();
+        vertexFormat->AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+        vertexFormat->AddVertexAttribute<float>(3, VertexAttribute::Semantic::Normal);
+        vertexFormat->AddVertexAttribute<float>(3, VertexAttribute::Semantic::Tangent);
+        vertexFormat->AddVertexAttribute<float>(3, VertexAttribute::Semantic::Bitangent);
+        vertexFormat->AddVertexAttribute<float>(2, VertexAttribute::Semantic::TexCoord0);
+        vertexFormat->AddVertexAttribute<unsigned char>(4, true, VertexAttribute::Semantic::Color0);
+        return vertexFormat;
+    }
+
+    void AddLayoutIteratorBenchmark(BenchmarkSuite& suite, const char* name, bool interleaved)
+    {
+        suite.Add(name, CreateVertexFormat()->GetAttributeCount(), [interleaved]() -> BenchmarkSuite::RunFunction
+            {
+                std::shared_ptr<VertexFormat> vertexFormat = CreateVertexFormat();
+                return [vertexFormat, interleaved](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            // Same loop as setting the attributes of a VAO
+                            GLint offsetSum = 0;
+                            for (auto it = vertexFormat->LayoutBegin(VertexCount, interleaved), itEnd = vertexFormat->LayoutEnd(); it != itEnd; it++)
+                            {
+                                offsetSum += it->GetOffset() + it->GetStride();
+                            }
+                            DoNotOptimize(offsetSum);
+                        }
+                    };
+            });
+    }
+
+    // Copy one attribute of size bytes per vertex between buffers with the given strides
+    void AddCopyBufferBenchmark(BenchmarkSuite& suite, const char* name, std::size_t dstStride, std::size_t srcStride, std::size_t size)
+    {
+        suite.Add(name, VertexCount, [=]() -> BenchmarkSuite::RunFunction
+            {
+                auto dstBuffer = std::make_shared<std::vector<unsigned char>>(VertexCount * std::max(dstStride, size));
+                auto srcBuffer = std::make_shared<std::vector<unsigned char>>(VertexCount * srcStride);
+                for (std::size_t i = 0; i < srcBuffer->size(); ++i)
+                {
+                    (*srcBuffer)[i] = static_cast<unsigned char>(i);
+                }
+
+                return [=](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            ModelLoader::CopyBuffer(dstBuffer->data(), dstStride, srcBuffer->data(), srcStride, VertexCount, size);
+                            DoNotOptimize(*dstBuffer->data());
+                        }
+                    };
+            });
+    }
+}
+
+void AddGeometryBenchmarks(BenchmarkSuite& suite)
+{
+    AddLayoutIteratorBenchmark(suite, "vertex_format/layout_interleaved", true);
+    AddLayoutIteratorBenchmark(suite, "vertex_format/layout_planar", false);
+
+    // Packed positions, a single memcpy
+    AddCopyBufferBenchmark(suite, "model_loader/copy_buffer_packed", 12, 12, 12);
+    // Positions of the aiMesh arrays into the interleaved vertex of the format above (60 bytes)
+    AddCopyBufferBenchmark(suite, "model_loader/copy_buffer_interleave", 60, 12, 12);
+    // Texture coordinates out of an interleaved source, vec3 in assimp, vec2 in the vertex
+    AddCopyBufferBenchmark(suite, "model_loader/copy_buffer_strided", 60, 12, 8);
+}
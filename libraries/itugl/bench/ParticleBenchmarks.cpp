@@ -0,0 +1,89 @@
+#include "BenchmarkSuite.h"
+
+#include <ituGL/core/ThreadPool.h>
+#include <ituGL/particles/ParticleSystem.h>
+#include <memory>
+
+namespace
+{
+    constexpr unsigned int ParticleCount = 1000000;
+
+    ParticleSystem::Emitter CreateEmitter()
+    {
+        // The particles never die, so every step simulates all of them
+        ParticleSystem::Emitter emitter;
+        emitter.position = glm::vec3(0.0f);
+        emitter.radius = 10.0f;
+        emitter.velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+        emitter.velocitySpread = 2.0f;
+        emitter.minLifetime = 1e9f;
+        emitter.maxLifetime = 1e9f;
+        emitter.minSize = 1.0f;
+        emitter.maxSize = 4.0f;
+        emitter.color = Color(1.0f, 0.5f, 0.2f);
+        return emitter;
+    }
+
+    // Keep the thread pool alive as long as the particle system that uses it
+    struct ParticleScene
+    {
+        std::unique_ptr<ThreadPool> threadPool;
+        ParticleSystem particleSystem;
+
+        ParticleScene(bool threaded) : particleSystem(ParticleCount)
+        {
+            if (threaded)
+            {
+                threadPool = std::make_unique<ThreadPool>();
+                particleSystem.SetThreadPool(threadPool.get());
+            }
+            particleSystem.SetGravity(glm::vec3(0.0f, -9.8f, 0.0f));
+            particleSystem.SetDrag(0.1f);
+            particleSystem.AddAttractor(ParticleSystem::Attractor{ glm::vec3(5.0f, 0.0f, 0.0f), 20.0f });
+            particleSystem.AddAttractor(ParticleSystem::Attractor{ glm::vec3(-5.0f, 0.0f, 0.0f), 20.0f });
+        }
+    };
+
+    void AddUpdateBenchmark(BenchmarkSuite& suite, const char* name, bool threaded)
+    {
+        suite.Add(name, ParticleCount, [threaded]() -> BenchmarkSuite::RunFunction
+            {
+                auto scene = std::make_shared<ParticleScene>(threaded);
+                scene->particleSystem.Emit(CreateEmitter(), ParticleCount, 1u);
+                return [scene](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            scene->particleSystem.Update(1.0f / 60.0f);
+                        }
+                        DoNotOptimize(scene->particleSystem.GetParticleCount());
+                    };
+            });
+    }
+
+    void AddEmitBenchmark(BenchmarkSuite& suite, const char* name, bool threaded)
+    {
+        suite.Add(name, ParticleCount, [threaded]() -> BenchmarkSuite::RunFunction
+            {
+                auto scene = std::make_shared<ParticleScene>(threaded);
+                return [scene](std::size_t iterations)
+                    {
+                        ParticleSystem::Emitter emitter = CreateEmitter();
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            scene->particleSystem.Clear();
+                            scene->particleSystem.Emit(emitter, ParticleCount, static_cast<unsigned int>(iteration));
+                        }
+                        DoNotOptimize(scene->particleSystem.GetParticleCount());
+                    };
+            });
+    }
+}
+
+void AddParticleBenchmarks(BenchmarkSuite& suite)
+{
+    AddUpdateBenchmark(suite, "particles/update_1m", false);
+    AddUpdateBenchmark(suite, "particles/update_1m_threaded", true);
+    AddEmitBenchmark(suite, "particles/emit_1m", false);
+    AddEmitBenchmark(suite, "particles/emit_1m_threaded", true);
+}
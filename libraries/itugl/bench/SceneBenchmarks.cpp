@@ -0,0 +1,337 @@
+#include "BenchmarkSuite.h"
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/core/Random.h>
+#include <ituGL/scene/Bounds.h>
+#include <ituGL/scene/OcclusionCuller.h>
+#include <ituGL/scene/Transform.h>
+#include <glm/gtx/transform.hpp>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // Number of pairs tested in each iteration of the bounds benchmarks
+    constexpr unsigned int PairCount = 1024;
+
+    // Number of cameras in each iteration of the camera benchmark
+    constexpr unsigned int CameraCount = 1024;
+
+    glm::vec3 RandomVector(Random& random, float from, float to)
+    {
+        float x = random.NextRange(from, to);
+        float y = random.NextRange(from, to);
+        float z = random.NextRange(from, to);
+        return glm::vec3(x, y, z);
+    }
+
+    glm::mat3 RandomRotation(Random& random)
+    {
+        glm::vec3 axis = glm::normalize(RandomVector(random, -1.0f, 1.0f) + glm::vec3(0.0f, 0.001f, 0.0f));
+        return glm::mat3(glm::rotate(random.NextRange(-3.1416f, 3.1416f), axis));
+    }
+
+    // Centers and sizes are chosen so about half of the pairs intersect, and branches can't be predicted
+    SphereBounds RandomSphere(Random& random)
+    {
+        glm::vec3 center = RandomVector(random, -10.0f, 10.0f);
+        return SphereBounds(center, random.NextRange(0.5f, 5.0f));
+    }
+
+    AabbBounds RandomAabb(Random& random)
+    {
+        glm::vec3 center = RandomVector(random, -10.0f, 10.0f);
+        return AabbBounds(center, RandomVector(random, 0.5f, 5.0f));
+    }
+
+    BoxBounds RandomBox(Random& random)
+    {
+        glm::vec3 center = RandomVector(random, -10.0f, 10.0f);
+        glm::mat3 rotation = RandomRotation(random);
+        return BoxBounds(center, rotation, RandomVector(random, 0.5f, 5.0f));
+    }
+
+    FrustumBounds RandomFrustum(Random& random)
+    {
+        glm::vec3 position = RandomVector(random, -20.0f, 20.0f);
+        glm::vec3 lookAt = RandomVector(random, -5.0f, 5.0f);
+        Camera camera;
+        camera.SetViewMatrix(position, lookAt);
+        camera.SetPerspectiveProjectionMatrix(1.0f, 1.5f, 0.1f, 20.0f);
+        return FrustumBounds(camera);
+    }
+
+    // Benchmark of the specialized Intersects for a pair of types
+    template<typename TA, typename TB, typename FA, typename FB>
+    void AddIntersectsBenchmark(BenchmarkSuite& suite, const char* name, FA randomA, FB randomB)
+    {
+        suite.Add(name, PairCount, [=]() -> BenchmarkSuite::RunFunction
+            {
+                Random random;
+                auto boundsA = std::make_shared<std::vector<TA>>();
+                auto boundsB = std::make_shared<std::vector<TB>>();
+                for (unsigned int i = 0; i < PairCount; ++i)
+                {
+                    boundsA->push_back(randomA(random));
+                    boundsB->push_back(randomB(random));
+                }
+
+                return [boundsA, boundsB](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            unsigned int hitCount = 0;
+                            for (unsigned int i = 0; i < PairCount; ++i)
+                            {
+                                hitCount += Bounds::Intersects((*boundsA)[i], (*boundsB)[i]) ? 1 : 0;
+                            }
+                            DoNotOptimize(hitCount);
+                        }
+                    };
+            });
+    }
+
+    void AddBoundsBenchmarks(BenchmarkSuite& suite)
+    {
+        AddIntersectsBenchmark<SphereBounds, SphereBounds>(suite, "bounds/sphere_sphere", RandomSphere, RandomSphere);
+        AddIntersectsBenchmark<AabbBounds, SphereBounds>(suite, "bounds/aabb_sphere", RandomAabb, RandomSphere);
+        AddIntersectsBenchmark<AabbBounds, AabbBounds>(suite, "bounds/aabb_aabb", RandomAabb, RandomAabb);
+        AddIntersectsBenchmark<BoxBounds, SphereBounds>(suite, "bounds/box_sphere", RandomBox, RandomSphere);
+        AddIntersectsBenchmark<BoxBounds, AabbBounds>(suite, "bounds/box_aabb", RandomBox, RandomAabb);
+        AddIntersectsBenchmark<BoxBounds, BoxBounds>(suite, "bounds/box_box", RandomBox, RandomBox);
+        AddIntersectsBenchmark<FrustumBounds, SphereBounds>(suite, "bounds/frustum_sphere", RandomFrustum, RandomSphere);
+        AddIntersectsBenchmark<FrustumBounds, AabbBounds>(suite, "bounds/frustum_aabb", RandomFrustum, RandomAabb);
+        AddIntersectsBenchmark<FrustumBounds, BoxBounds>(suite, "bounds/frustum_box", RandomFrustum, RandomBox);
+
+        // Same tests through the base class, when the types are only known at runtime
+        suite.Add("bounds/mixed_dispatch", PairCount, []() -> BenchmarkSuite::RunFunction
+            {
+                Random random;
+                auto bounds = std::make_shared<std::vector<std::unique_ptr<Bounds>>>();
+                for (unsigned int i = 0; i < PairCount * 2; ++i)
+                {
+                    switch (random.NextUInt() % 3)
+                    {
+                    case 0:
+                        bounds->push_back(std::make_unique<SphereBounds>(RandomSphere(random)));
+                        break;
+                    case 1:
+                        bounds->push_back(std::make_unique<AabbBounds>(RandomAabb(random)));
+                        break;
+                    default:
+                        bounds->push_back(std::make_unique<BoxBounds>(RandomBox(random)));
+                        break;
+                    }
+                }
+
+                return [bounds](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            unsigned int hitCount = 0;
+                            for (unsigned int i = 0; i < PairCount; ++i)
+                            {
+                                hitCount += Bounds::Intersects(*(*bounds)[i * 2], *(*bounds)[i * 2 + 1]) ? 1 : 0;
+                            }
+                            DoNotOptimize(hitCount);
+                        }
+                    };
+            });
+    }
+
+    // A chain of transforms, each one the parent of the next. Returns the last one
+    std::shared_ptr<Transform> CreateHierarchy(unsigned int depth, std::shared_ptr<Transform>& root)
+    {
+        Random random;
+        std::shared_ptr<Transform> parent;
+        for (unsigned int i = 0; i < depth; ++i)
+        {
+            std::shared_ptr<Transform> transform = std::make_shared<Transform>();
+            transform->SetTranslation(RandomVector(random, -1.0f, 1.0f));
+            transform->SetRotation(RandomVector(random, -0.5f, 0.5f));
+            transform->SetParent(parent);
+            if (!parent)
+            {
+                root = transform;
+            }
+            parent = transform;
+        }
+        return parent;
+    }
+
+    void AddTransformBenchmarks(BenchmarkSuite& suite, unsigned int depth)
+    {
+        std::string depthName = std::to_string(depth);
+
+        // Nothing changed, but the leaf still checks every ancestor to know it
+        suite.Add(("transform/hierarchy_" + depthName + "_clean").c_str(), 1, [depth]() -> BenchmarkSuite::RunFunction
+            {
+                std::shared_ptr<Transform> root;
+                std::shared_ptr<Transform> leaf = CreateHierarchy(depth, root);
+                leaf->GetTransformMatrix();
+
+                return [root, leaf](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            glm::mat4 matrix = leaf->GetTransformMatrix();
+                            DoNotOptimize(matrix);
+                        }
+                    };
+            });
+
+        // The root moves every frame, so every matrix of the chain is computed again
+        suite.Add(("transform/hierarchy_" + depthName + "_dirty_root").c_str(), depth, [depth]() -> BenchmarkSuite::RunFunction
+            {
+                std::shared_ptr<Transform> root;
+                std::shared_ptr<Transform> leaf = CreateHierarchy(depth, root);
+
+                return [root, leaf](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            root->SetRotation(glm::vec3(0.0f, static_cast<float>(iteration & 255) * 0.01f, 0.0f));
+                            glm::mat4 matrix = leaf->GetTransformMatrix();
+                            DoNotOptimize(matrix);
+                        }
+                    };
+            });
+    }
+
+    void AddCameraBenchmarks(BenchmarkSuite& suite)
+    {
+        suite.Add("camera/extract_vectors", CameraCount, []() -> BenchmarkSuite::RunFunction
+            {
+                Random random;
+                auto cameras = std::make_shared<std::vector<Camera>>(CameraCount);
+                for (Camera& camera : *cameras)
+                {
+                    glm::vec3 position = RandomVector(random, -20.0f, 20.0f);
+                    glm::vec3 lookAt = RandomVector(random, -5.0f, 5.0f);
+                    camera.SetViewMatrix(position, lookAt);
+                }
+
+                return [cameras](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            for (const Camera& camera : *cameras)
+                            {
+                                glm::vec3 right, up, forward;
+                                camera.ExtractVectors(right, up, forward);
+                                DoNotOptimize(right);
+                                DoNotOptimize(up);
+                                DoNotOptimize(forward);
+                            }
+                        }
+                    };
+            });
+    }
+
+    // A street: walls on both sides and across, and 10k boxes scattered behind and between them
+    struct OcclusionScene
+    {
+        static constexpr unsigned int BoxCount = 10000;
+
+        OcclusionCuller culler;
+        glm::mat4 viewProjMatrix;
+        std::vector<glm::mat4> occluders;
+        std::vector<glm::vec3> centers;
+        std::vector<glm::vec3> sizes;
+
+        OcclusionScene()
+        {
+            Camera camera;
+            camera.SetViewMatrix(glm::vec3(0.0f, 1.7f, 0.0f), glm::vec3(0.0f, 1.7f, 1.0f));
+            camera.SetPerspectiveProjectionMatrix(1.0f, 2.0f, 0.1f, 200.0f);
+            viewProjMatrix = camera.GetViewProjectionMatrix();
+
+            // Unit boxes, scaled and placed by their world matrix
+            for (int i = 0; i < 8; ++i)
+            {
+                float z = 10.0f + i * 12.0f;
+                occluders.push_back(glm::translate(glm::vec3(-6.0f, 4.0f, z)) * glm::scale(glm::vec3(0.5f, 4.0f, 5.0f)));
+                occluders.push_back(glm::translate(glm::vec3(6.0f, 4.0f, z)) * glm::scale(glm::vec3(0.5f, 4.0f, 5.0f)));
+            }
+            occluders.push_back(glm::translate(glm::vec3(0.0f, 5.0f, 110.0f)) * glm::scale(glm::vec3(20.0f, 5.0f, 0.5f)));
+
+            Random random;
+            for (unsigned int i = 0; i < BoxCount; ++i)
+            {
+                float x = random.NextRange(-60.0f, 60.0f);
+                float y = random.NextRange(0.0f, 6.0f);
+                float z = random.NextRange(2.0f, 190.0f);
+                centers.push_back(glm::vec3(x, y, z));
+                sizes.push_back(RandomVector(random, 0.2f, 1.0f));
+            }
+        }
+
+        void Rasterize()
+        {
+            culler.Begin(viewProjMatrix);
+            for (const glm::mat4& occluder : occluders)
+            {
+                culler.AddOccluderBox(glm::vec3(-1.0f), glm::vec3(1.0f), occluder);
+            }
+            culler.End();
+        }
+    };
+
+    void AddOcclusionBenchmarks(BenchmarkSuite& suite)
+    {
+        suite.Add("occlusion/rasterize_occluders", 1, []() -> BenchmarkSuite::RunFunction
+            {
+                auto scene = std::make_shared<OcclusionScene>();
+                return [scene](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            scene->Rasterize();
+                        }
+                        DoNotOptimize(scene->culler);
+                    };
+            });
+
+        // Same scene without SIMD, to measure its speedup
+        suite.Add("occlusion/rasterize_occluders_scalar", 1, []() -> BenchmarkSuite::RunFunction
+            {
+                auto scene = std::make_shared<OcclusionScene>();
+                scene->culler.SetSimdEnabled(false);
+                return [scene](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            scene->Rasterize();
+                        }
+                        DoNotOptimize(scene->culler);
+                    };
+            });
+
+        suite.Add("occlusion/is_visible_10k", OcclusionScene::BoxCount, []() -> BenchmarkSuite::RunFunction
+            {
+                auto scene = std::make_shared<OcclusionScene>();
+                scene->Rasterize();
+                return [scene](std::size_t iterations)
+                    {
+                        for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                        {
+                            unsigned int visibleCount = 0;
+                            for (unsigned int i = 0; i < OcclusionScene::BoxCount; ++i)
+                            {
+                                visibleCount += scene->culler.IsVisible(scene->centers[i], scene->sizes[i]) ? 1 : 0;
+                            }
+                            DoNotOptimize(visibleCount);
+                        }
+                    };
+            });
+    }
+}
+
+void AddSceneBenchmarks(BenchmarkSuite& suite)
+{
+    AddBoundsBenchmarks(suite);
+    AddTransformBenchmarks(suite, 8);
+    AddTransformBenchmarks(suite, 64);
+    AddCameraBenchmarks(suite);
+    AddOcclusionBenchmarks(suite);
+}
@@ -0,0 +1,224 @@
+#include "BenchmarkSuite.h"
+
+#include <ituGL/shader/ShaderUniformCollection.h>
+#include <ituGL/core/DeviceGL.h>
+#include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// The shader program is mocked by replacing the OpenGL functions it calls, so the benchmarks run without a context.
+// Only the functions used by ShaderProgram and ShaderUniformCollection are replaced
+namespace MockGL
+{
+    struct Uniform
+    {
+        const char* name;
+        GLenum type;
+        GLint size;
+    };
+
+    // Uniforms of a typical lit material. The location of each uniform is its index
+    const std::array<Uniform, 14> Uniforms =
+    { {
+        { "WorldMatrix", GL_FLOAT_MAT4, 1 },
+        { "ViewProjMatrix", GL_FLOAT_MAT4, 1 },
+        { "NormalMatrix", GL_FLOAT_MAT3, 1 },
+        { "CameraPosition", GL_FLOAT_VEC3, 1 },
+        { "Color", GL_FLOAT_VEC3, 1 },
+        { "AmbientColor", GL_FLOAT_VEC3, 1 },
+        { "Roughness", GL_FLOAT, 1 },
+        { "Metalness", GL_FLOAT, 1 },
+        { "Time", GL_FLOAT, 1 },
+        { "LightCount", GL_INT, 1 },
+        { "LightPositions[0]", GL_FLOAT_VEC4, 8 },
+        { "LightColors[0]", GL_FLOAT_VEC3, 8 },
+        { "ShadowMask", GL_UNSIGNED_INT, 1 },
+        { "ColorTexture", GL_SAMPLER_2D, 1 },
+    } };
+
+    // Number of uniform values sent, so the calls are not optimized away
+    std::size_t g_uniformValueCount = 0;
+
+    GLuint APIENTRY CreateProgram()
+    {
+        return 1;
+    }
+
+    void APIENTRY DeleteProgram(GLuint)
+    {
+    }
+
+    void APIENTRY UseProgram(GLuint)
+    {
+    }
+
+    GLenum APIENTRY GetError()
+    {
+        return GL_NO_ERROR;
+    }
+
+    void APIENTRY GetProgramiv(GLuint, GLenum pname, GLint* params)
+    {
+        switch (pname)
+        {
+        case GL_LINK_STATUS:
+            *params = GL_TRUE;
+            break;
+        case GL_ACTIVE_UNIFORMS:
+            *params = static_cast<GLint>(Uniforms.size());
+            break;
+        default:
+            *params = 0;
+            break;
+        }
+    }
+
+    void APIENTRY GetActiveUniform(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+    {
+        const Uniform& uniform = Uniforms[index];
+        std::size_t nameLength = std::min(std::strlen(uniform.name), static_cast<std::size_t>(bufSize - 1));
+        std::memcpy(name, uniform.name, nameLength);
+        name[nameLength] = '\0';
+        if (length)
+        {
+            *length = static_cast<GLsizei>(nameLength);
+        }
+        *size = uniform.size;
+        *type = uniform.type;
+    }
+
+    GLint APIENTRY GetUniformLocation(GLuint, const GLchar* name)
+    {
+        for (std::size_t i = 0; i < Uniforms.size(); ++i)
+        {
+            if (std::strcmp(Uniforms[i].name, name) == 0)
+            {
+                return static_cast<GLint>(i);
+            }
+        }
+        return -1;
+    }
+
+    template<typename T>
+    void APIENTRY SetUniformVector(GLint, GLsizei count, const T*)
+    {
+        g_uniformValueCount += count;
+    }
+
+    void APIENTRY SetUniformMatrix(GLint, GLsizei count, GLboolean, const GLfloat*)
+    {
+        g_uniformValueCount += count;
+    }
+
+    void Install()
+    {
+        glad_glCreateProgram = CreateProgram;
+        glad_glDeleteProgram = DeleteProgram;
+        glad_glUseProgram = UseProgram;
+        glad_glGetError = GetError;
+        glad_glGetProgramiv = GetProgramiv;
+        glad_glGetActiveUniform = GetActiveUniform;
+        glad_glGetUniformLocation = GetUniformLocation;
+
+        glad_glUniform1iv = SetUniformVector<GLint>;
+        glad_glUniform2iv = SetUniformVector<GLint>;
+        glad_glUniform3iv = SetUniformVector<GLint>;
+        glad_glUniform4iv = SetUniformVector<GLint>;
+        glad_glUniform1uiv = SetUniformVector<GLuint>;
+        glad_glUniform2uiv = SetUniformVector<GLuint>;
+        glad_glUniform3uiv = SetUniformVector<GLuint>;
+        glad_glUniform4uiv = SetUniformVector<GLuint>;
+        glad_glUniform1fv = SetUniformVector<GLfloat>;
+        glad_glUniform2fv = SetUniformVector<GLfloat>;
+        glad_glUniform3fv = SetUniformVector<GLfloat>;
+        glad_glUniform4fv = SetUniformVector<GLfloat>;
+        glad_glUniform1dv = SetUniformVector<GLdouble>;
+        glad_glUniform2dv = SetUniformVector<GLdouble>;
+        glad_glUniform3dv = SetUniformVector<GLdouble>;
+        glad_glUniform4dv = SetUniformVector<GLdouble>;
+
+        glad_glUniformMatrix2fv = SetUniformMatrix;
+        glad_glUniformMatrix2x3fv = SetUniformMatrix;
+        glad_glUniformMatrix2x4fv = SetUniformMatrix;
+        glad_glUniformMatrix3x2fv = SetUniformMatrix;
+        glad_glUniformMatrix3fv = SetUniformMatrix;
+        glad_glUniformMatrix3x4fv = SetUniformMatrix;
+        glad_glUniformMatrix4x2fv = SetUniformMatrix;
+        glad_glUniformMatrix4x3fv = SetUniformMatrix;
+        glad_glUniformMatrix4fv = SetUniformMatrix;
+    }
+}
+
+namespace
+{
+    // The program is in use, so the values can be sent. Using a program goes through the device, with no context loaded
+    std::shared_ptr<ShaderProgram> CreateMockProgram()
+    {
+        MockGL::Install();
+        static DeviceGL device;
+
+        std::shared_ptr<ShaderProgram> shaderProgram = std::make_shared<ShaderProgram>();
+        shaderProgram->Use();
+        return shaderProgram;
+    }
+}
+
+void AddShaderBenchmarks(BenchmarkSuite& suite)
+{
+    // Reading the uniforms of the program, done once per material
+    suite.Add("shader_uniforms/extract", MockGL::Uniforms.size(), []() -> BenchmarkSuite::RunFunction
+        {
+            std::shared_ptr<ShaderProgram> shaderProgram = CreateMockProgram();
+            return [shaderProgram](std::size_t iterations)
+                {
+                    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                    {
+                        ShaderUniformCollection uniforms(shaderProgram);
+                        DoNotOptimize(uniforms);
+                    }
+                };
+        });
+
+    // Per object values set and read back by location, as the renderer does every draw.
+    // Six operations per iteration: three sets and three gets
+    suite.Add("shader_uniforms/set_get_by_location", 6, []() -> BenchmarkSuite::RunFunction
+        {
+            auto uniforms = std::make_shared<ShaderUniformCollection>(CreateMockProgram());
+            ShaderProgram::Location worldMatrixLocation = uniforms->GetUniformLocation("WorldMatrix");
+            ShaderProgram::Location colorLocation = uniforms->GetUniformLocation("Color");
+            ShaderProgram::Location timeLocation = uniforms->GetUniformLocation("Time");
+
+            return [=](std::size_t iterations)
+                {
+                    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                    {
+                        float value = static_cast<float>(iteration & 1023);
+                        uniforms->SetUniformValue(worldMatrixLocation, glm::translate(glm::vec3(value)));
+                        uniforms->SetUniformValue(colorLocation, glm::vec3(value));
+                        uniforms->SetUniformValue(timeLocation, value);
+
+                        glm::mat4 worldMatrix = uniforms->GetUniformValue<glm::mat4>(worldMatrixLocation);
+                        glm::vec3 color = uniforms->GetUniformValue<glm::vec3>(colorLocation);
+                        float time = uniforms->GetUniformValue<float>(timeLocation);
+                        DoNotOptimize(worldMatrix);
+                        DoNotOptimize(color);
+                        DoNotOptimize(time);
+                    }
+                };
+        });
+
+    // Send all the values to the program, once per material and draw
+    suite.Add("shader_uniforms/set_uniforms", MockGL::Uniforms.size(), []() -> BenchmarkSuite::RunFunction
+        {
+            auto uniforms = std::make_shared<ShaderUniformCollection>(CreateMockProgram());
+            return [uniforms](std::size_t iterations)
+                {
+                    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+                    {
+                        uniforms->SetUniforms();
+                    }
+                    DoNotOptimize(MockGL::g_uniformValueCount);
+                };
+        });
+}
@@ -0,0 +1,127 @@
+#include "BenchmarkSuite.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::printf(
+            "Usage: itugl_bench [options]\n"
+            "  --list                       Print the names of the benchmarks and exit\n"
+            "  --filter <text>              Only run the benchmarks whose name contains the text\n"
+            "  --min-time <seconds>         Minimum time of each repetition (default 0.1)\n"
+            "  --repetitions <count>        Repetitions of each benchmark, the median is reported (default 5)\n"
+            "  --json <path>                Write the results as JSON, with the CPU and compiler that measured them\n"
+            "  --baseline <path>            Compare with the JSON of a previous run, exit with 1 if there are regressions\n"
+            "  --threshold <percent>        Allowed slowdown against the baseline (default 5)\n"
+            "  --threshold <prefix>=<pct>   Allowed slowdown for the benchmarks whose name starts with the prefix\n");
+    }
+}
+
+// Exit code is 0 if everything ran and there were no regressions, 1 with regressions, 2 with wrong arguments or files
+int main(int argc, char* argv[])
+{
+    BenchmarkSuite suite;
+    AddSceneBenchmarks(suite);
+    AddGeometryBenchmarks(suite);
+    AddShaderBenchmarks(suite);
+    AddParticleBenchmarks(suite);
+
+    BenchmarkSuite::Settings settings;
+    BenchmarkSuite::Thresholds thresholds;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* argument = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool hasValue = true;
+
+        if (std::strcmp(argument, "--list") == 0)
+        {
+            suite.List();
+            return 0;
+        }
+        else if (std::strcmp(argument, "--help") == 0)
+        {
+            PrintUsage();
+            return 0;
+        }
+        else if (!value)
+        {
+            hasValue = false;
+        }
+        else if (std::strcmp(argument, "--filter") == 0)
+        {
+            settings.filter = value;
+        }
+        else if (std::strcmp(argument, "--min-time") == 0)
+        {
+            settings.minTime = std::atof(value);
+        }
+        else if (std::strcmp(argument, "--repetitions") == 0)
+        {
+            settings.repetitions = static_cast<unsigned int>(std::atoi(value));
+        }
+        else if (std::strcmp(argument, "--json") == 0)
+        {
+            jsonPath = value;
+        }
+        else if (std::strcmp(argument, "--baseline") == 0)
+        {
+            baselinePath = value;
+        }
+        else if (std::strcmp(argument, "--threshold") == 0)
+        {
+            if (const char* separator = std::strchr(value, '='))
+            {
+                thresholds.prefixPercents.emplace_back(std::string(value, separator), std::atof(separator + 1));
+            }
+            else
+            {
+                thresholds.defaultPercent = std::atof(value);
+            }
+        }
+        else
+        {
+            hasValue = false;
+        }
+
+        if (!hasValue)
+        {
+            std::printf("Unknown option or missing value: %s\n", argument);
+            PrintUsage();
+            return 2;
+        }
+        ++i;
+    }
+
+    // Read the baseline first, so a wrong path doesn't waste a whole run
+    BenchmarkSuite::Context baselineContext;
+    std::vector<BenchmarkSuite::Result> baseline;
+    if (baselinePath && !BenchmarkSuite::ReadJson(baselinePath, baselineContext, baseline))
+    {
+        std::printf("Error: failed to read the baseline %s\n", baselinePath);
+        return 2;
+    }
+
+    BenchmarkSuite::Context context = BenchmarkSuite::Context::GetCurrent();
+    std::vector<BenchmarkSuite::Result> results = suite.Run(settings);
+
+    if (jsonPath && !BenchmarkSuite::WriteJson(jsonPath, context, results))
+    {
+        std::printf("Error: failed to write %s\n", jsonPath);
+        return 2;
+    }
+
+    if (baselinePath && BenchmarkSuite::Compare(results, baseline, thresholds, context, baselineContext) > 0)
+    {
+        return 1;
+    }
+    return 0;
+}
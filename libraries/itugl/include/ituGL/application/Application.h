@@ -2,10 +2,37 @@
 
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/application/Window.h>
+#include <ituGL/application/InputLog.h>
+#include <ituGL/core/Random.h>
+#include <memory>
 #include <string>
-
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class FramebufferObject;
+class Texture2DObject;
+
+// In headless mode, the window is not visible and the frames are rendered to an offscreen framebuffer.
+// The application closes after a fixed number of frames and prints the frame times, for benchmarks on machines without a display.
+// It is enabled with the environment variable ITUGL_HEADLESS=<frame count>, or with SetHeadless before constructing the application.
+// ITUGL_HEADLESS_CONTEXT=egl or ITUGL_HEADLESS_CONTEXT=osmesa creates the context with EGL or OSMesa.
+// Without any display server, build GLFW with GLFW_USE_OSMESA, so it doesn't need one at all.
+//
+// For runs that can be repeated exactly, ITUGL_FIXED_DELTA_TIME=<seconds> advances the time by a fixed step each frame,
+// and ITUGL_SEED=<number> seeds the generator returned by GetRandom. ITUGL_RECORD_INPUT=<path> records the keys,
+// mouse buttons and mouse position of each frame, and ITUGL_REPLAY_INPUT=<path> replays them, and closes at the end of the log.
+// Recording uses a fixed time step, DefaultFixedDeltaTime if none was set, and replay takes the seed and time step of the log
 class Application
 {
+public:
+    // Frames rendered in headless mode, if ITUGL_HEADLESS is not a number
+    static constexpr unsigned int DefaultHeadlessFrameCount = 600;
+
+    // Time step used when recording input without a fixed time step
+    static constexpr float DefaultFixedDeltaTime = 1.0f / 60.0f;
+
 public:
     // Construct the application specifying the dimensions of the window and its title
     Application(int width, int height, const char* title);
@@ -16,6 +43,9 @@ public:
     // Start the application
     int Run();
 
+    // Enable the headless mode for the applications constructed after this call, instead of reading ITUGL_HEADLESS
+    static void SetHeadless(bool headless, unsigned int frameCount = DefaultHeadlessFrameCount);
+
 protected:
     // (C++) 1
     // Get the OpenGL device
@@ -33,18 +63,41 @@ protected:
     // Get time in seconds of the current frame
     float GetDeltaTime() const { return m_deltaTime; }
 
+    // If greater than 0, each frame advances the time this many seconds, no matter how long it really took. Default: 0
+    float GetFixedDeltaTime() const { return m_fixedDeltaTime; }
+    void SetFixedDeltaTime(float fixedDeltaTime) { m_fixedDeltaTime = fixedDeltaTime; }
+
+    // Random generator of the application, seeded with ITUGL_SEED. Use it instead of rand(), so runs can be repeated
+    // Not thread-safe: in pipelined mode, only Update should use it
+    Random& GetRandom() { return m_random; }
+
     // Test if the application is currently running
     bool IsRunning() const;
 
     // Request the application to stop running
     void Close() { Terminate(0); }
 
+    // Test if the application renders offscreen, and closes after a fixed number of frames
+    bool IsHeadless() const { return m_headlessFrameCount > 0; }
+
+    // If enabled, Update of the next frame runs in a simulation thread while Render draws the current one,
+    // so the frame takes as long as the slowest of them, instead of both. The threads meet once per frame,
+    // where events are polled and SubmitFrame is called. Update must not touch what Render reads, and the other way around,
+    // other than through SubmitFrame. The window answers the input queries of Update with the input read at that point,
+    // and applies its cursor changes there too. Default: false
+    bool GetPipelineEnabled() const { return m_pipelineEnabled; }
+    void SetPipelineEnabled(bool pipelineEnabled) { m_pipelineEnabled = pipelineEnabled; }
+
     // Load initial resources and initialize data before the main loop
     virtual void Initialize();
 
     // Update the application logic for the current frame
     virtual void Update();
 
+    // Hand the data written by Update to Render, like Renderer::SubmitFrame. Called after each Update,
+    // while neither Update nor Render are running
+    virtual void SubmitFrame();
+
     // Render the current frame
     virtual void Render();
 
@@ -60,20 +113,84 @@ private:
     // Set the new current time and compute the delta since the last time
     void UpdateTime(float newCurrentTime);
 
+    // Start Update in the simulation thread, creating it the first time, and wait for it to finish
+    void BeginSimulationUpdate();
+    void EndSimulationUpdate();
+
+    // Stop the simulation thread, if it was created
+    void StopSimulationThread();
+
+    void SimulationLoop();
+
+    // Start recording or replaying the input, if requested with the environment variables
+    void InitializeInputLog();
+
+    // Read the input of this frame, record it or replay it, and make the window answer with it until the next frame.
+    // Called after polling the events, in the main thread, while Update is not running
+    void UpdateInput();
+
+    // Read the headless settings, from SetHeadless or the environment variables
+    static unsigned int GetHeadlessFrameCount();
+    static Window::ContextAPI GetHeadlessContextAPI();
+
+    // Create the offscreen framebuffer, the size of the window, and make it the default one
+    void InitializeHeadless();
+
+    // Add the time of the frame, and close the application after the last one
+    void EndHeadlessFrame(float frameTime);
+
+    // Print the frame time statistics of the headless run
+    void PrintHeadlessStatistics(float totalTime) const;
+
 private:
     // OpenGL device
     DeviceGL m_device;
 
+    // Frames to render before closing, or 0 if not headless. Declared before the window, that depends on it
+    unsigned int m_headlessFrameCount;
+
     // Main window
     Window m_mainWindow;
 
+    // Offscreen framebuffer of the headless mode. Declared after the window, so they are deleted while the context is alive
+    std::unique_ptr<Texture2DObject> m_offscreenColorTexture;
+    std::unique_ptr<Texture2DObject> m_offscreenDepthTexture;
+    std::unique_ptr<FramebufferObject> m_offscreenFramebuffer;
+
+    // Time in seconds of each headless frame
+    std::vector<float> m_headlessFrameTimes;
+
     // Time in seconds from the start of the application
     float m_currentTime;
     // Time in seconds of the current frame
     float m_deltaTime;
+    // Time step of each frame, if greater than 0
+    float m_fixedDeltaTime;
+
+    // Random generator, see GetRandom
+    Random m_random;
+
+    // Input of the main window, recorded or replayed
+    InputLog m_inputLog;
+
+    // Input of the frame read by Update, see UpdateInput
+    Window::InputState m_inputState;
+
+    // Pipelined update and render, see SetPipelineEnabled
+    bool m_pipelineEnabled;
+
+    // Simulation thread, running Update when requested
+    std::thread m_simulationThread;
+    std::mutex m_simulationMutex;
+    std::condition_variable m_simulationCondition;
+    bool m_simulationUpdateRequested;
+    bool m_simulationStopping;
 
     // Exit code
     int m_exitCode;
     // Error message to display on exit
     std::string m_errorMessage;
+
+    // Set by SetHeadless. Negative to read the environment variable
+    static int s_headlessFrameCount;
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <ituGL/application/Window.h>
+#include <cstdint>
+#include <fstream>
+
+// Records the input of a window once per frame to a binary file, and replays it later, frame by frame.
+// Only the changes are stored, so a frame without input takes one byte.
+// The header keeps the seed and the time step of the recording, to run the same frames again when replaying
+class InputLog
+{
+public:
+    // Settings of the recorded run
+    struct Header
+    {
+        std::uint64_t seed;
+        float deltaTime;
+    };
+
+public:
+    InputLog();
+
+    inline bool IsRecording() const { return m_output.is_open(); }
+    inline bool IsReplaying() const { return m_input.is_open(); }
+
+    // Number of frames recorded or replayed so far
+    inline unsigned int GetFrameCount() const { return m_frameCount; }
+
+    // Create the file and write the header. Returns false if the file can't be created
+    bool StartRecording(const char* path, const Header& header);
+
+    // Open the file and read its header. Returns false if the file can't be opened, or it is not an input log
+    bool StartReplay(const char* path, Header& header);
+
+    // Close the file. The window must not be replaying the state of this log anymore
+    void Stop();
+
+    // Record the input state as the next frame. The window size of the state is not recorded
+    void RecordFrame(const Window::InputState& inputState);
+
+    // Copy the input of the next frame to the state, or the last one if there are no frames left, and return false.
+    // The window size of the state is not recorded, it is left as it is
+    bool ReplayFrame(Window::InputState& inputState);
+
+private:
+    // Each change is one byte with the type, followed by the key code, the button or the position
+    enum class EventType : std::uint8_t
+    {
+        KeyReleased,
+        KeyPressed,
+        MouseButtonReleased,
+        MouseButtonPressed,
+        MouseMoved,
+    };
+
+    template<typename T>
+    void Write(const T& value);
+
+    template<typename T>
+    bool Read(T& value);
+
+    // Read the changes of the next frame into the last state. Returns false if there are no frames left
+    bool ReadFrame();
+
+    // Counts are written with 7 bits per byte, so small counts take one byte
+    void WriteCount(unsigned int count);
+    bool ReadCount(unsigned int& count);
+
+private:
+    std::ofstream m_output;
+    std::ifstream m_input;
+
+    // Last state recorded or replayed
+    Window::InputState m_state;
+
+    unsigned int m_frameCount;
+};
@@ -2,11 +2,22 @@
 
 #include <GLFW/glfw3.h>
 #include <glm/vec2.hpp>
+#include <bitset>
 
 class Window
 {
 public:
-    Window(int width, int height, const char* title);
+    // API used to create the OpenGL context. EGL and OSMesa can create contexts without a display
+    enum class ContextAPI
+    {
+        Native = GLFW_NATIVE_CONTEXT_API,
+        EGL = GLFW_EGL_CONTEXT_API,
+        OSMesa = GLFW_OSMESA_CONTEXT_API,
+    };
+
+public:
+    // A window that is not visible is only there for its OpenGL context, to render offscreen
+    Window(int width, int height, const char* title, bool visible = true, ContextAPI contextAPI = ContextAPI::Native);
     ~Window();
 
     // (C++) 1
@@ -64,18 +75,55 @@ public:
     bool IsMouseButtonPressed(MouseButton button) const { return GetMouseButtonState(button) == PressedState::Pressed; }
     bool IsMouseButtonReleased(MouseButton button) const { return GetMouseButtonState(button) == PressedState::Released; }
 
-    // Get if the mouse is visible
+    // Get if the mouse is visible, including the changes not applied yet
     bool IsMouseVisible() const;
-    // Set if the mouse is visible
+    // Set if the mouse is visible. While replaying an input state, it is applied by ApplyInputChanges
     void SetMouseVisible(bool visible) const;
 
     // Get the mouse position, in pixels or in NDC coordinates
     glm::vec2 GetMousePosition(bool normalized = false) const;
-    // Set the mouse position, in pixels or in NDC coordinates
+    // Set the mouse position, in pixels or in NDC coordinates. While replaying an input state, it is applied by
+    // ApplyInputChanges, and the replayed position doesn't change
     void SetMousePosition(glm::vec2 mousePosition, bool normalized = false) const;
 
+public:
+    // Keys, mouse buttons and mouse position at some moment, to record the input and replay it
+    struct InputState
+    {
+        std::bitset<GLFW_KEY_LAST + 1> keys;
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> mouseButtons;
+        glm::vec2 mousePosition = glm::vec2(0.0f);
+
+        // Size of the window, to normalize the mouse position. Not part of the recorded input
+        int width = 0;
+        int height = 0;
+    };
+
+    // Read the real input of the window, even while replaying
+    void GetInputState(InputState& inputState) const;
+
+    // Make the key, mouse button, mouse position and dimensions queries return this state instead of the real input,
+    // or nullptr to go back to the real input. The state must stay alive while it is replayed.
+    // GLFW can only be used from the main thread: Application replays a state read at the start of each frame,
+    // so Update can query the input from the simulation thread
+    inline void SetReplayInputState(const InputState* inputState) { m_replayInputState = inputState; }
+    inline bool IsReplayingInput() const { return m_replayInputState != nullptr; }
+
+    // Apply the cursor changes made while replaying an input state. Call it from the main thread
+    void ApplyInputChanges() const;
 
 private:
     // Pointer to a GLFW window object. Its lifetime should match the lifetime of this object
     GLFWwindow* m_window;
+
+    // Input returned by the queries, if not null
+    const InputState* m_replayInputState;
+
+    // Cursor mode requested with SetMouseVisible, and if it still has to be applied
+    mutable int m_cursorMode;
+    mutable bool m_cursorModeChanged;
+
+    // Mouse position requested with SetMousePosition, in pixels, if it still has to be applied
+    mutable glm::vec2 m_cursorPosition;
+    mutable bool m_cursorPositionChanged;
 };
@@ -27,6 +27,10 @@ public:
     bool GetCreateMaterials() const;
     void SetCreateMaterials(bool createMaterials);
 
+    // If set, the vertices and elements of the loaded meshes are suballocated from the pool, instead of having their own buffers
+    std::shared_ptr<GeometryPool> GetGeometryPool() const;
+    void SetGeometryPool(std::shared_ptr<GeometryPool> geometryPool);
+
     Texture2DLoader& GetTexture2DLoader();
     const Texture2DLoader& GetTexture2DLoader() const;
 
@@ -39,6 +43,9 @@ public:
     // Maps a material property to a uniform in the shader program used by the material
     bool SetMaterialProperty(MaterialProperty materialProperty, const char* uniformName);
 
+    // Copy one buffer to another preserving the stride
+    static void CopyBuffer(void* dstBuffer, size_t dstStride, const void* srcBuffer, size_t srcStride, size_t count, size_t size);
+
 private:
     // Generate a submesh from the loaded mesh data
     void GenerateSubmesh(Mesh& mesh, const aiMesh& meshData);
@@ -53,16 +60,13 @@ private:
     // Build the vertex data from the mesh data
     static std::vector<GLubyte> CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved);
 
-    // Build the element data from the mesh data
+    // Build the element data from the mesh data. If elementType is None, it is set to the smallest type for the vertex count
     static std::vector<GLubyte> CollectElementData(const aiMesh& meshData, Data::Type& elementType,
         std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts);
 
     // Get the correct vertex data pointer for a specific semantic
     static const void* GetVertexDataPointer(const aiMesh& meshData, VertexAttribute::Semantic semantic, int& stride);
 
-    // Copy one buffer to another preserving the stride
-    static void CopyBuffer(void* dstBuffer, size_t dstStride, const void* srcBuffer, size_t srcStride, size_t count, size_t size);
-
     // Get the type of primitive depending on the number of elements
     static Drawcall::Primitive GetPrimitiveType(int elementCount);
 
@@ -82,6 +86,9 @@ private:
     // Should create new materials for each submesh or use the reference material
     bool m_createMaterials;
 
+    // Optional pool where the mesh data is allocated
+    std::shared_ptr<GeometryPool> m_geometryPool;
+
     // Texture loader to cache already loaded shared textures
     mutable Texture2DLoader m_textureLoader;
 };
@@ -13,6 +13,16 @@ public:
         ArrayBuffer = GL_ARRAY_BUFFER,
         // Element Buffer Object
         ElementArrayBuffer = GL_ELEMENT_ARRAY_BUFFER,
+        // Shader Storage Buffer Object
+        ShaderStorageBuffer = GL_SHADER_STORAGE_BUFFER,
+        // Uniform Buffer Object
+        UniformBuffer = GL_UNIFORM_BUFFER,
+        // Draw Indirect Buffer Object
+        DrawIndirectBuffer = GL_DRAW_INDIRECT_BUFFER,
+        // Parameters of indirect compute dispatches
+        DispatchIndirectBuffer = GL_DISPATCH_INDIRECT_BUFFER,
+        // Atomic counters, incremented and decremented by shaders
+        AtomicCounterBuffer = GL_ATOMIC_COUNTER_BUFFER,
         // TODO: There are more types, add them when they are supported
     };
 
@@ -55,9 +65,28 @@ public:
     void AllocateData(size_t size, Usage usage);
     void AllocateData(std::span<const std::byte> data, Usage usage);
 
+    // Allocate immutable storage, that can't be reallocated. The flags are GL_MAP_WRITE_BIT, GL_MAP_PERSISTENT_BIT...
+    // Requires OpenGL 4.4
+    void AllocateStorage(size_t size, GLbitfield flags);
+
+    // Map a range of the buffer to CPU memory, with the GL_MAP_* access flags. Persistent mappings stay valid while drawing
+    void* MapRange(size_t offset, size_t size, GLbitfield access);
+    void Unmap();
+
     // Modify the contents of the buffer, starting at offset
     void UpdateData(std::span<const std::byte> data, size_t offset = 0);
 
+    // Copy size bytes between two buffers on the GPU. The buffers don't need to be bound
+    static void CopyData(const BufferObject& srcBuffer, size_t srcOffset, BufferObject& dstBuffer, size_t dstOffset, size_t size);
+
+    // Bind the buffer to an indexed binding point of its target. Only for indexed targets, like ShaderStorageBuffer
+    // It also binds the buffer to the target, as Bind() would do
+    void BindBase(GLuint index) const;
+
+    // Bind the buffer to an indexed binding point of a different target. Useful when shaders write a buffer that is
+    // used later in another way, like an atomic counter that is the vertex count of an indirect draw
+    void BindBase(Target target, GLuint index) const;
+
 protected:
     // Bind the specific target. Used by the Bind() method in derived classes
     void Bind(Target target) const;
@@ -20,6 +20,8 @@ public:
         UShort = GL_UNSIGNED_SHORT,
         Int = GL_INT,
         UInt = GL_UNSIGNED_INT,
+        // Packed types
+        UInt24_8 = GL_UNSIGNED_INT_24_8,
         // And more...
     };
 
@@ -2,6 +2,10 @@
 
 #include <ituGL/core/Color.h>
 #include <glad/glad.h>
+#include <glm/vec4.hpp>
+#include <unordered_map>
+#include <optional>
+#include <array>
 
 class Window;
 struct GLFWwindow;
@@ -28,6 +32,8 @@ public:
 
     // Set the dimensions of the viewport
     void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    // Get the current viewport
+    void GetViewport(GLint& x, GLint& y, GLsizei& width, GLsizei& height) const;
 
     // Poll the events in the window event queue
     void PollEvents();
@@ -52,10 +58,101 @@ public:
     // enable / disable v-sync
     void SetVSyncEnabled(bool enabled);
 
+    // The following methods keep a copy of the GL state and skip the GL call if the value is already set
+
+    // Set the shader program in use
+    void UseShaderProgram(GLuint shaderProgram);
+    // Bind a vertex array. It also changes the element array buffer binding
+    void BindVertexArray(GLuint vertexArray);
+    // Bind a buffer to the target
+    void BindBuffer(GLenum target, GLuint buffer);
+    // Bind a buffer to an indexed binding point of the target. It also changes the binding of the target
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    // Set the active texture unit, as an index starting at 0
+    void SetActiveTextureUnit(GLint textureUnit);
+    // Bind a texture to the target of the active texture unit
+    void BindTexture(GLenum target, GLuint texture);
+
+    // Set the depth test function
+    void SetDepthFunction(GLenum function);
+    // Enable / disable writing to the depth buffer
+    void SetDepthWrite(bool depthWrite);
+
+    // Enable / disable writing to the color buffer, all components at once
+    void SetColorWrite(bool colorWrite);
+
+    // Set the faces culled when GL_CULL_FACE is enabled: GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+    void SetCullFace(GLenum face);
+
+    // Set the stencil test function. Face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+    void SetStencilFunction(GLenum face, GLenum function, GLint refValue, GLuint mask);
+    // Set the stencil operations. Face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+    void SetStencilOperations(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+
+    // Set the blend equations for color and alpha
+    void SetBlendEquation(GLenum equationColor, GLenum equationAlpha);
+    // Set the blend parameters, same for color and alpha
+    inline void SetBlendFunction(GLenum source, GLenum dest) { SetBlendFunction(source, dest, source, dest); }
+    // Set the blend parameters, different for color and alpha
+    void SetBlendFunction(GLenum sourceColor, GLenum destColor, GLenum sourceAlpha, GLenum destAlpha);
+    // Set the color used by the constant color and constant alpha blend parameters
+    void SetBlendColor(const Color& color);
+
+    // Forget all the cached states, so the next calls will reach GL
+    // Required after changing any of these states with raw GL calls
+    void InvalidateState();
+
+    // Remove the object from the cached bindings when deleted, as GL can reuse its name
+    void ForgetShaderProgram(GLuint shaderProgram);
+    void ForgetVertexArray(GLuint vertexArray);
+    void ForgetBuffer(GLuint buffer);
+    void ForgetTexture(GLuint texture);
+
 private:
     // Has a context been loaded? We use the context of the current window
     bool m_contextLoaded;
 
+    // Cached GL state. Empty values are unknown and will always be set
+    struct StencilFunction
+    {
+        GLenum function;
+        GLint refValue;
+        GLuint mask;
+        bool operator == (const StencilFunction&) const = default;
+    };
+    struct StencilOperations
+    {
+        GLenum stencilFail;
+        GLenum depthFail;
+        GLenum depthPass;
+        bool operator == (const StencilOperations&) const = default;
+    };
+
+    std::optional<GLuint> m_shaderProgram;
+    std::optional<GLuint> m_vertexArray;
+    std::unordered_map<GLenum, GLuint> m_buffers;
+    // Buffer bound to each indexed binding point. The key is (index << 32 | target)
+    std::unordered_map<unsigned long long, GLuint> m_indexedBuffers;
+    std::optional<GLint> m_activeTextureUnit;
+    // Texture bound to each texture unit and target. The key is (unit << 32 | target)
+    std::unordered_map<unsigned long long, GLuint> m_textures;
+
+    std::unordered_map<GLenum, bool> m_features;
+
+    std::optional<GLenum> m_depthFunction;
+    std::optional<bool> m_depthWrite;
+
+    std::optional<bool> m_colorWrite;
+    std::optional<GLenum> m_cullFace;
+
+    // Front and back
+    std::array<std::optional<StencilFunction>, 2> m_stencilFunctions;
+    std::array<std::optional<StencilOperations>, 2> m_stencilOperations;
+
+    std::optional<std::array<GLenum, 2>> m_blendEquations;
+    std::optional<std::array<GLenum, 4>> m_blendFunction;
+    std::optional<glm::vec4> m_blendColor;
+
 private:
     // Singleton instance
     static DeviceGL* m_instance;
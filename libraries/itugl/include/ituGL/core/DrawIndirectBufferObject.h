@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Draw Indirect Buffer Object is a BufferObject that holds the parameters of drawcalls, so many can be executed at once
+// Keep it bound while calling Drawcall::MultiDrawIndirect()
+class DrawIndirectBufferObject : public BufferObjectBase<BufferObject::DrawIndirectBuffer>
+{
+public:
+    DrawIndirectBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData template method for any type of data span
+    template<typename T>
+    void AllocateData(std::span<const T> data, Usage usage = Usage::DynamicDraw);
+    template<typename T>
+    inline void AllocateData(std::span<T> data, Usage usage = Usage::DynamicDraw) { AllocateData(std::span<const T>(data), usage); }
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData template method for any type of data span
+    template<typename T>
+    void UpdateData(std::span<const T> data, size_t offsetBytes = 0);
+    template<typename T>
+    inline void UpdateData(std::span<T> data, size_t offsetBytes = 0) { UpdateData(std::span<const T>(data), offsetBytes); }
+};
+
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void DrawIndirectBufferObject::AllocateData(std::span<const T> data, Usage usage)
+{
+    AllocateData(Data::GetBytes(data), usage);
+}
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void DrawIndirectBufferObject::UpdateData(std::span<const T> data, size_t offsetBytes)
+{
+    UpdateData(Data::GetBytes(data), offsetBytes);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+// CPU profiling zones, exported as Chrome trace events (open the file in chrome://tracing or https://ui.perfetto.dev).
+// ITUGL_ZONE("name") measures the time until the end of the current scope. The name must outlive the profiler,
+// like a string literal, or come from InternName. Each thread writes its zones to its own ring buffer without locks, the oldest ones are
+// overwritten if they are not written to a file in time.
+// Zones are only compiled if ITUGL_PROFILING is defined (CMake option ITUGL_PROFILING), otherwise they cost nothing
+class Profiler
+{
+public:
+    // Scoped zone, use it through the ITUGL_ZONE macro
+    class Zone
+    {
+    public:
+        inline Zone(const char* name) : m_name(IsEnabled() ? name : nullptr), m_start(m_name ? GetTime() : 0) {}
+        inline ~Zone() { if (m_name) AddEvent(m_name, m_start, GetTime()); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator = (const Zone&) = delete;
+
+    private:
+        const char* m_name;
+        unsigned long long m_start;
+    };
+
+    // Number of zones kept per thread until they are written
+    static constexpr unsigned int ThreadCapacity = 1 << 16;
+
+public:
+    // Profiler class is static
+    Profiler() = delete;
+
+    // Zones are recorded only while enabled. Default: true
+    static inline bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled);
+
+    // Name of the calling thread in the trace
+    static void SetThreadName(const char* name);
+
+    // Copy of the name that lives until the end of the program, for zones named at runtime. Each name is stored once,
+    // so it can be called every time the zone runs
+    static const char* InternName(std::string_view name);
+
+    // Write the zones recorded since the last call in Chrome trace event JSON format, and remove them from the buffers.
+    // Returns false if the file can't be written
+    static bool WriteChromeTrace(const char* path);
+
+    // Nanoseconds since the profiler started
+    static unsigned long long GetTime();
+
+private:
+    static void AddEvent(const char* name, unsigned long long start, unsigned long long end);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+#ifdef ITUGL_PROFILING
+#define ITUGL_ZONE_CONCAT_INNER(a, b) a##b
+#define ITUGL_ZONE_CONCAT(a, b) ITUGL_ZONE_CONCAT_INNER(a, b)
+#define ITUGL_ZONE(name) Profiler::Zone ITUGL_ZONE_CONCAT(itugl_zone_, __LINE__)(name)
+#else
+#define ITUGL_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ituGL/core/Object.h>
+
+// Query Object asks the GPU for information about the commands between Begin and End, like the time they took.
+// The result is written when the GPU executes the commands, so it should be read a few frames later
+class QueryObject : public Object
+{
+public:
+    // Query target: What information the query measures
+    enum Target : GLenum
+    {
+        // Time in nanoseconds taken by the commands
+        TimeElapsed = GL_TIME_ELAPSED,
+        // Number of samples that passed the depth test
+        SamplesPassed = GL_SAMPLES_PASSED,
+        // If any sample passed the depth test
+        AnySamplesPassed = GL_ANY_SAMPLES_PASSED,
+        // Number of primitives written by the geometry stage
+        PrimitivesGenerated = GL_PRIMITIVES_GENERATED,
+    };
+
+public:
+    QueryObject();
+    virtual ~QueryObject();
+
+    // (C++) 8
+    // Move semantics
+    QueryObject(QueryObject&& queryObject) noexcept;
+    QueryObject& operator = (QueryObject&& queryObject) noexcept;
+
+    // Queries are not bound, they are started with Begin
+    void Bind() const override;
+
+    // Start measuring the commands. Only one query of each target can be active at a time
+    void Begin(Target target);
+
+    // Stop measuring the active query of the target
+    static void End(Target target);
+
+    // Check if the result is ready, without waiting for it
+    bool IsResultAvailable() const;
+
+    // Get the result. If it is not available, it waits until the GPU finishes the commands
+    GLuint64 GetResult() const;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ituGL/core/Color.h>
+#include <cstdint>
+
+// Pseudo-random number generator with an explicit seed, so the same seed always gives the same sequence.
+// Unlike rand(), each generator has its own state, and the sequence is the same on every platform.
+// It is a PCG32 generator: small, fast, and good enough for anything but cryptography
+class Random
+{
+public:
+    static constexpr std::uint64_t DefaultSeed = 0x853c49e6748fea9bull;
+
+public:
+    Random(std::uint64_t seed = DefaultSeed);
+
+    // Seed of the sequence. Setting it starts the sequence again
+    inline std::uint64_t GetSeed() const { return m_seed; }
+    void SetSeed(std::uint64_t seed);
+
+    // Random integer, with all the 32 bits random
+    std::uint32_t NextUInt();
+
+    // Random float in [0, 1)
+    float Next01();
+
+    // Random float in [from, to)
+    inline float NextRange(float from, float to) { return Next01() * (to - from) + from; }
+
+    // Random opaque color, each component in [0, 1)
+    Color NextColor();
+
+private:
+    std::uint64_t m_seed;
+    std::uint64_t m_state;
+};
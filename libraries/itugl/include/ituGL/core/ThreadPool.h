@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Pool of worker threads that run the tasks of a job in parallel.
+// The thread calling Run also executes tasks, and waits until all of them are finished
+class ThreadPool
+{
+public:
+    using TaskFunction = std::function<void(unsigned int taskIndex)>;
+    using RangeFunction = std::function<void(unsigned int taskIndex, unsigned int begin, unsigned int end)>;
+
+public:
+    // Zero worker threads means one less than the number of hardware threads
+    ThreadPool(unsigned int workerCount = 0);
+    ~ThreadPool();
+
+    // Not copyable, the workers keep a pointer to the pool
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that can run tasks, including the calling thread
+    inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+    // Run taskCount tasks, with indices from 0 to taskCount - 1, and wait for them to finish
+    void Run(unsigned int taskCount, const TaskFunction& task);
+
+    // Split the range [0, count) in at most GetThreadCount() contiguous ranges of at least minRangeSize elements,
+    // and run one task for each range. Returns the number of tasks
+    unsigned int ParallelFor(unsigned int count, unsigned int minRangeSize, const RangeFunction& function);
+
+private:
+    void WorkerLoop();
+
+    // Run tasks of the job until there are none left
+    void RunTasks(const TaskFunction& task, unsigned int taskCount);
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobCondition;
+    std::condition_variable m_doneCondition;
+
+    // Current job. The generation changes every time a new job starts
+    const TaskFunction* m_task;
+    unsigned int m_taskCount;
+    unsigned int m_generation;
+    bool m_stopping;
+
+    // Workers inside RunTasks. The job is not finished until all of them are out
+    unsigned int m_activeWorkerCount;
+
+    std::atomic<unsigned int> m_nextTask;
+    std::atomic<unsigned int> m_finishedTaskCount;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Uniform Buffer Object (UBO) is a BufferObject that holds the values of a uniform block, shared by many shader programs
+// Bind it with BindBase() to the binding index assigned to the block with ShaderProgram::SetUniformBlockBinding()
+// The data must follow the std140 layout: vec3 and vec4 are aligned to 16 bytes, matrices are arrays of vec4 columns
+class UniformBufferObject : public BufferObjectBase<BufferObject::UniformBuffer>
+{
+public:
+    UniformBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData template method for any type of data span
+    template<typename T>
+    void AllocateData(std::span<const T> data, Usage usage = Usage::DynamicDraw);
+    template<typename T>
+    inline void AllocateData(std::span<T> data, Usage usage = Usage::DynamicDraw) { AllocateData(std::span<const T>(data), usage); }
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData template method for any type of data span
+    template<typename T>
+    void UpdateData(std::span<const T> data, size_t offsetBytes = 0);
+    template<typename T>
+    inline void UpdateData(std::span<T> data, size_t offsetBytes = 0) { UpdateData(std::span<const T>(data), offsetBytes); }
+};
+
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void UniformBufferObject::AllocateData(std::span<const T> data, Usage usage)
+{
+    AllocateData(Data::GetBytes(data), usage);
+}
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void UniformBufferObject::UpdateData(std::span<const T> data, size_t offsetBytes)
+{
+    UpdateData(Data::GetBytes(data), offsetBytes);
+}
@@ -23,10 +23,20 @@ public:
         Patches = GL_PATCHES
     };
 
+    // Parameters of an indexed drawcall, as read by OpenGL from a draw indirect buffer
+    struct ElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
 public:
     Drawcall();
     Drawcall(Primitive primitive, GLsizei count, GLint first = 0);
-    Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first = 0);
+    Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first = 0, GLint baseVertex = 0);
 
     // Check if the drawcall is valid
     inline bool IsValid() const { return m_primitive != Primitive::Invalid && m_count > 0; }
@@ -34,11 +44,28 @@ public:
     // Execute the drawcall
     void Draw() const;
 
+    // Execute the drawcall, rendering instanceCount instances of the geometry.
+    // Per-instance attributes start at baseInstance (requires OpenGL 4.2 if it is not 0)
+    void DrawInstanced(GLsizei instanceCount, GLuint baseInstance = 0) const;
+
+    // Check if the drawcall uses an EBO, needed for the indirect commands
+    inline bool HasElements() const { return m_eboType != Data::Type::None; }
+
+    // Check if both drawcalls can be executed in the same multi-draw: same primitive and element type
+    inline bool IsMultiDrawCompatible(const Drawcall& other) const { return m_primitive == other.m_primitive && m_eboType == other.m_eboType; }
+
+    // Get the indirect command that executes this drawcall. Requires an EBO
+    ElementsIndirectCommand GetIndirectCommand(GLuint instanceCount, GLuint baseInstance) const;
+
+    // Execute drawCount commands from the bound draw indirect buffer, starting at offsetBytes,
+    // with the primitive and element type of this drawcall (requires OpenGL 4.3)
+    void MultiDrawIndirect(size_t offsetBytes, GLsizei drawCount) const;
+
 private:
     // Type of primitive to be rendered
     Primitive m_primitive;
 
-    // Position of the first vertex or element that we want to render
+    // Position of the first vertex that we want to render, or offset in bytes of the first element in the EBO
     GLint m_first;
 
     // Number of vertices or elements that we want to render
@@ -46,4 +73,7 @@ private:
 
     // Data type of the elements in the EBO (int, uint, short, byte, etc.). A value of None means no EBO
     Data::Type m_eboType;
+
+    // Value added to the elements before reading the vertices. Lets many meshes share the same buffers
+    GLint m_baseVertex;
 };
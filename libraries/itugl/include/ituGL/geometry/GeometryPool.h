@@ -0,0 +1,136 @@
+#pragma once
+
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/geometry/ElementBufferObject.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// Suballocates the vertices and elements of many meshes from a few large buffers
+// There is one VBO, EBO and VAO for each vertex format, shared by all the meshes with that format,
+// so their drawcalls don't need to change the VAO and can be merged in multi-draws.
+// Elements are relative to the first vertex of their allocation, and are drawn with base vertex drawcalls
+class GeometryPool
+{
+public:
+    // Identifies an allocation. Stays valid when the data is moved
+    using Handle = unsigned int;
+    static constexpr Handle InvalidHandle = ~0u;
+
+    // Maps vertex attribute semantics with their location on a shader program (same as Mesh::SemanticMap)
+    using SemanticMap = std::unordered_map<VertexAttribute::Semantic, ShaderProgram::Location>;
+
+public:
+    // All the elements are stored with elementType. Buffers start with capacity for vertexCapacity and elementCapacity,
+    // and grow when they are full
+    GeometryPool(Data::Type elementType = Data::Type::UInt, unsigned int vertexCapacity = 1 << 16, unsigned int elementCapacity = 1 << 18);
+
+    inline Data::Type GetElementType() const { return m_elementType; }
+
+    // Copy the vertices, interleaved with vertexFormat, and the elements, of elementType, to the buffers of the format
+    Handle Allocate(const VertexFormat& vertexFormat, const SemanticMap& locations,
+        std::span<const std::byte> vertices, std::span<const std::byte> elements);
+
+    // Release the ranges of the allocation, so they can be reused
+    void Free(Handle handle);
+
+    // VAO used to draw the allocation
+    const VertexArrayObject& GetVertexArray(Handle handle) const;
+
+    // Buffers that hold the data of the allocation. They are replaced when the generation changes
+    const VertexBufferObject& GetVertexBuffer(Handle handle) const;
+    const ElementBufferObject& GetElementBuffer(Handle handle) const;
+
+    // Base vertex drawcall for elementCount elements of the allocation, starting at firstElement. Zero count means all
+    Drawcall GetDrawcall(Handle handle, Drawcall::Primitive primitive, unsigned int firstElement = 0, unsigned int elementCount = 0) const;
+
+    // Move all the allocations together at the start of the buffers, so the free space is in a single range
+    void Defragment();
+
+    // Incremented each time allocations are moved. Drawcalls created before must be created again
+    inline unsigned int GetGeneration() const { return m_generation; }
+
+    // Number of vertex formats, each one with its own buffers
+    inline unsigned int GetBufferSetCount() const { return static_cast<unsigned int>(m_bufferSets.size()); }
+
+    // Read a per-instance mat4 at location from the instance buffer, in the VAOs of all the vertex formats,
+    // including the ones added later. The buffer must outlive the pool
+    void SetInstanceAttribute(GLuint location, const VertexBufferObject& instanceBuffer);
+
+private:
+    // Range of vertices or elements inside the buffers
+    struct Range
+    {
+        unsigned int first;
+        unsigned int count;
+    };
+
+    // Buffers for all the data with the same vertex format and attribute locations
+    struct BufferSet
+    {
+        VertexFormat vertexFormat;
+        SemanticMap locations;
+
+        VertexBufferObject vbo;
+        ElementBufferObject ebo;
+        VertexArrayObject vao;
+
+        unsigned int vertexCapacity;
+        unsigned int elementCapacity;
+
+        // Free ranges, sorted by first and never adjacent
+        std::vector<Range> freeVertices;
+        std::vector<Range> freeElements;
+    };
+
+    struct Allocation
+    {
+        unsigned int bufferSetIndex;
+        Range vertices;
+        Range elements;
+        bool used;
+    };
+
+private:
+    // Find the buffer set for the vertex format and locations, or create a new one
+    unsigned int GetBufferSet(const VertexFormat& vertexFormat, const SemanticMap& locations);
+
+    // Allocate new buffers, with the allocations copied together at the start, and point the VAO to them
+    void RebuildBufferSet(unsigned int bufferSetIndex, unsigned int vertexCapacity, unsigned int elementCapacity);
+
+    // Set the attributes and the EBO of the VAO of the buffer set
+    void SetupVertexArray(BufferSet& bufferSet);
+
+    // Set the instance attribute in the VAO of the buffer set, if there is one
+    void SetupInstanceAttribute(BufferSet& bufferSet);
+
+    // First-fit allocation from the free list. Returns false if there is no range large enough
+    static bool AllocateRange(std::vector<Range>& freeList, unsigned int count, unsigned int& first);
+
+    // Return the range to the free list, merging it with the adjacent free ranges
+    static void FreeRange(std::vector<Range>& freeList, Range range);
+
+    static bool IsSameFormat(const VertexFormat& a, const VertexFormat& b);
+
+private:
+    Data::Type m_elementType;
+
+    unsigned int m_initialVertexCapacity;
+    unsigned int m_initialElementCapacity;
+
+    // Pointers, so the VAO references stay valid when adding buffer sets
+    std::vector<std::unique_ptr<BufferSet>> m_bufferSets;
+
+    std::vector<Allocation> m_allocations;
+    std::vector<Handle> m_freeHandles;
+
+    unsigned int m_generation;
+
+    // Per-instance attribute of all the VAOs, see SetInstanceAttribute. Negative location if there is none
+    GLint m_instanceLocation;
+    const VertexBufferObject* m_instanceBuffer;
+};
@@ -5,9 +5,11 @@
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/VertexAttribute.h>
 #include <ituGL/geometry/Drawcall.h>
+#include <ituGL/geometry/GeometryPool.h>
 #include <ituGL/shader/ShaderProgram.h>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 
 // Class that groups several VBO, EBO and VAO that are part of the same object
 // Can contain several drawcalls using the data in those objects
@@ -19,6 +21,9 @@ public:
 
 public:
     Mesh();
+    ~Mesh();
+
+    Mesh(Mesh&& mesh) = default;
 
     // Adds a new VBO with uninitialized data
     unsigned int AddVertexData(size_t size);
@@ -46,6 +51,18 @@ public:
     template<typename TIterator>
     unsigned int AddVertexArray(std::span<unsigned int> vboIndices, TIterator& it, const TIterator itEnd, const SemanticMap& locations = SemanticMap());
 
+    // Copies the vertices and elements to the geometry pool, instead of creating new buffers. All the pool data of a mesh
+    // must come from the same pool. The mesh owns the allocation, and releases it when destroyed
+    GeometryPool::Handle AddPoolData(std::shared_ptr<GeometryPool> geometryPool, const VertexFormat& vertexFormat, const SemanticMap& locations,
+        std::span<const std::byte> vertices, std::span<const std::byte> elements);
+
+    // Adds a new submesh that draws elementCount elements of the pool data, starting at firstElement, with the VAO of the pool
+    unsigned int AddPoolSubmesh(GeometryPool::Handle handle, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount);
+
+    // Recreate the drawcalls of the pool submeshes if the pool moved the data since they were created.
+    // GetSubmeshDrawcall calls it, so call it first from a single thread before reading the drawcalls from several threads
+    void UpdatePoolDrawcalls() const;
+
     // Adds a new submesh, with the index of the VAO to be bound, and the Drawcall parameters
     unsigned int AddSubmesh(unsigned int vaoIndex, const Drawcall& drawcall);
 
@@ -110,12 +127,25 @@ public:
     inline const VertexArrayObject& GetVertexArray(unsigned int vaoIndex) const { return m_vaos[vaoIndex]; }
 
     inline unsigned int GetSubmeshCount() const { return static_cast<unsigned int>(m_submeshes.size()); }
-    inline const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const { return m_vaos[m_submeshes[submeshIndex].vaoIndex]; }
-    inline const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].drawcall; }
+    const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const;
+    const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const;
 
     // Draws a submesh
     void DrawSubmesh(int submeshIndex) const;
 
+    // Read a per-instance mat4 at location from the instance buffer, in all the VAOs of the mesh and its geometry pool.
+    // Set it once after adding the submeshes. The attribute starts at the beginning of the buffer, so instanced
+    // drawcalls select their first matrix with the base instance
+    void SetInstanceAttribute(GLuint location, const VertexBufferObject& instanceBuffer);
+
+    // Local space bounds of all the submeshes, as min and max corners. Only valid if HasBounds() is true
+    inline bool HasBounds() const { return m_boundsMin.x <= m_boundsMax.x; }
+    inline const glm::vec3& GetBoundsMin() const { return m_boundsMin; }
+    inline const glm::vec3& GetBoundsMax() const { return m_boundsMax; }
+
+    // Grow the bounds to contain the box between min and max corners
+    void AddBounds(const glm::vec3& min, const glm::vec3& max);
+
 private:
 
     // Helper structure that contains a drawcall and its VAO to be bound
@@ -123,6 +153,12 @@ private:
     {
         unsigned int vaoIndex;
         Drawcall drawcall;
+
+        // Allocation in the geometry pool and parameters to recreate the drawcall when the pool moves the data
+        GeometryPool::Handle poolHandle;
+        Drawcall::Primitive primitive;
+        unsigned int firstElement;
+        unsigned int elementCount;
     };
 
 private:
@@ -149,8 +185,18 @@ private:
     // All the VAOs used in this mesh
     std::vector<VertexArrayObject> m_vaos;
 
-    // Submeshes contained in this mesh
-    std::vector<Submesh> m_submeshes;
+    // Submeshes contained in this mesh. Mutable to update the drawcalls of the pool submeshes
+    mutable std::vector<Submesh> m_submeshes;
+
+    // Pool where the pool data is allocated, the allocations owned by this mesh,
+    // and the pool generation when the drawcalls were created
+    std::shared_ptr<GeometryPool> m_geometryPool;
+    std::vector<GeometryPool::Handle> m_poolHandles;
+    mutable unsigned int m_poolGeneration;
+
+    // Local space bounds. Min is larger than max while empty
+    glm::vec3 m_boundsMin;
+    glm::vec3 m_boundsMax;
 };
 
 template<typename T>
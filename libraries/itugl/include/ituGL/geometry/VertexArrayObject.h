@@ -27,6 +27,12 @@ public:
     // stride: how far each element is from the previous one. Default value 0 will use the attribute size
     void SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride = 0);
 
+    // Sets how often the attribute in location advances: 0 per vertex (default), N every N instances
+    void SetAttributeDivisor(GLuint location, GLuint divisor);
+
+    // Sets a mat4 attribute that advances once per instance, with one vec4 column in each location starting at location
+    void SetInstanceMatrixAttribute(GLuint location, GLint offset = 0);
+
 #ifndef NDEBUG
     // Check if there is any VertexArrayObject currently bound
     inline static bool IsAnyBound() { return s_boundHandle != Object::NullHandle; }
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <ituGL/particles/ParticleSystem.h>
+#include <ituGL/shader/ComputeDispatch.h>
+#include <ituGL/core/ShaderStorageBufferObject.h>
+#include <ituGL/core/DrawIndirectBufferObject.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <array>
+#include <memory>
+
+// Particle simulation that runs completely on the GPU. Emission, simulation and the dead list are compute shaders
+// over shader storage buffers, and the number of live particles goes from an atomic counter to an indirect draw.
+// The CPU only sets uniforms, so the cost per frame doesn't depend on the number of particles.
+// Uses "shaders/particles/gpu_begin.comp", "shaders/particles/gpu_emit.comp" and "shaders/particles/gpu_simulate.comp".
+// Requires OpenGL 4.3
+class GpuParticleSystem
+{
+public:
+    using Emitter = ParticleSystem::Emitter;
+
+    // Binding points of the shader storage buffers, the same in all the shaders
+    static constexpr GLuint ParticleBinding = 0;
+    static constexpr GLuint DeadListBinding = 1;
+    static constexpr GLuint AliveListBinding = 2;
+    static constexpr GLuint NextAliveListBinding = 3;
+    static constexpr GLuint StateBinding = 4;
+    static constexpr GLuint DrawBinding = 5;
+
+    // Binding point of the atomic counter with the live particles. It is the vertex count of the draw command
+    static constexpr GLuint DrawCounterBinding = 0;
+
+    // Particle in the shader storage buffer, with std430 layout
+    struct Particle
+    {
+        glm::vec3 position;
+        float age;
+        glm::vec3 velocity;
+        float lifetime;
+        glm::vec4 color;
+        float size;
+        float padding[3];
+    };
+
+public:
+    // Max number of particles alive at the same time
+    GpuParticleSystem(unsigned int capacity);
+
+    inline unsigned int GetCapacity() const { return m_capacity; }
+
+    // Constant acceleration
+    inline const glm::vec3& GetGravity() const { return m_gravity; }
+    inline void SetGravity(const glm::vec3& gravity) { m_gravity = gravity; }
+
+    // Fraction of the velocity lost per second, from 0 to 1
+    inline float GetDrag() const { return m_drag; }
+    inline void SetDrag(float drag) { m_drag = drag; }
+
+    // Spawn count particles in the next Update, or less if there are not enough dead ones.
+    // There is one emitter per update, calling it again replaces the emitter and adds to the count
+    void Emit(const Emitter& emitter, unsigned int count);
+
+    // Emit the new particles, then simulate all of them and move the dead ones to the dead list
+    void Update(float deltaTime);
+
+    // Draw the live particles as points, with the shader program in use. The vertex shader gets the particle from the
+    // buffers at ParticleBinding and AliveListBinding, using gl_VertexID
+    void Draw() const;
+
+private:
+    void InitializeBuffers();
+    void InitializePrograms();
+
+private:
+    unsigned int m_capacity;
+
+    glm::vec3 m_gravity;
+    float m_drag;
+
+    // Emission of the next update
+    Emitter m_emitter;
+    unsigned int m_emitCount;
+    unsigned int m_seed;
+
+    ShaderStorageBufferObject m_particleBuffer;
+    ShaderStorageBufferObject m_deadListBuffer;
+    std::array<ShaderStorageBufferObject, 2> m_aliveListBuffers;
+    unsigned int m_aliveListIndex;
+
+    // Counts of the live and emitted particles, and the work groups of the simulation
+    ShaderStorageBufferObject m_stateBuffer;
+
+    // Draw command, written by the shaders
+    DrawIndirectBufferObject m_drawBuffer;
+
+    // Attributes come from the shader storage buffers, but a VAO has to be bound to draw
+    VertexArrayObject m_vao;
+
+    std::unique_ptr<ComputeDispatch> m_beginDispatch;
+    std::unique_ptr<ComputeDispatch> m_emitDispatch;
+    std::unique_ptr<ComputeDispatch> m_simulateDispatch;
+
+    ShaderProgram::Location m_emitRequestLocation;
+    ShaderProgram::Location m_seedLocation;
+    ShaderProgram::Location m_emitterPositionLocation;
+    ShaderProgram::Location m_emitterRadiusLocation;
+    ShaderProgram::Location m_emitterVelocityLocation;
+    ShaderProgram::Location m_velocitySpreadLocation;
+    ShaderProgram::Location m_lifetimeRangeLocation;
+    ShaderProgram::Location m_sizeRangeLocation;
+    ShaderProgram::Location m_emitterColorLocation;
+    ShaderProgram::Location m_deltaTimeLocation;
+    ShaderProgram::Location m_gravityLocation;
+    ShaderProgram::Location m_dragLocation;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// Vertex buffer with the particles of a particle system, used as a circular buffer: new particles replace the oldest ones.
+// Particles are emitted to CPU memory during the update, and copied to the vertex buffer once per frame with Flush.
+// With OpenGL 4.4, they go through a persistently mapped staging ring, with a fence per frame so the CPU never writes
+// to a part still used by the GPU. Otherwise, they are uploaded with one UpdateData per frame (two when wrapping around)
+class ParticleEmitterBuffer
+{
+public:
+    // Frames that can be in flight before Flush has to wait for the GPU
+    static constexpr unsigned int FrameCount = 3;
+
+public:
+    // Size in bytes of each particle, and number of particles that can exist at the same time
+    ParticleEmitterBuffer(size_t particleSize, unsigned int capacity);
+    ~ParticleEmitterBuffer();
+
+    // The buffer is mapped and has fences, so it can't be copied or moved
+    ParticleEmitterBuffer(const ParticleEmitterBuffer&) = delete;
+    ParticleEmitterBuffer& operator = (const ParticleEmitterBuffer&) = delete;
+
+    // Vertex buffer with the particles, to set up the vertex attributes of a VAO
+    inline const VertexBufferObject& GetVertexBuffer() const { return m_vertexBuffer; }
+
+    inline size_t GetParticleSize() const { return m_particleSize; }
+    inline unsigned int GetCapacity() const { return m_capacity; }
+
+    // Particles in the vertex buffer, to draw. It doesn't include the ones waiting for Flush
+    unsigned int GetParticleCount() const;
+
+    // Total particles emitted, including the ones already replaced
+    inline unsigned long long GetEmittedCount() const { return m_emittedCount; }
+
+    // Particles emitted since the last Flush
+    inline unsigned int GetPendingCount() const { return static_cast<unsigned int>(m_pendingData.size() / m_particleSize); }
+
+    // True if the particles are copied through the persistently mapped ring
+    inline bool IsPersistentlyMapped() const { return m_mappedData != nullptr; }
+
+    // Add a particle, copied to the vertex buffer in the next Flush. Doesn't call OpenGL
+    void Emit(std::span<const std::byte> particle);
+    template<typename T>
+    void Emit(const T& particle);
+
+    // Copy the particles emitted since the last Flush to the vertex buffer. Call it once per frame, before drawing.
+    // Emit and Flush must not run at the same time
+    void Flush();
+
+private:
+    void InitializeStagingBuffer();
+
+    // Wait until the GPU is done with the part of the staging ring of a frame
+    void WaitFrame(unsigned int frameIndex);
+
+    // Copy count particles, from an offset in the data of this Flush, to the vertex buffer at a particle index
+    void CopyParticles(const std::byte* data, size_t dataOffset, unsigned int index, unsigned int count);
+
+private:
+    size_t m_particleSize;
+    unsigned int m_capacity;
+
+    VertexBufferObject m_vertexBuffer;
+
+    // Total particles copied to the vertex buffer. The next one goes to m_emittedCount % m_capacity
+    unsigned long long m_emittedCount;
+
+    // Particles emitted since the last Flush
+    std::vector<std::byte> m_pendingData;
+
+    // Staging ring, with a part of m_capacity particles for each frame in flight
+    VertexBufferObject m_stagingBuffer;
+    std::byte* m_mappedData;
+    std::array<GLsync, FrameCount> m_fences;
+    unsigned int m_frameIndex;
+};
+
+template<typename T>
+void ParticleEmitterBuffer::Emit(const T& particle)
+{
+    assert(sizeof(T) == m_particleSize);
+    Emit(std::span<const std::byte>(reinterpret_cast<const std::byte*>(&particle), sizeof(T)));
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <ituGL/core/Color.h>
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+class VertexBufferObject;
+
+// CPU particle simulation. Particles are stored as structure of arrays, so the kernels that integrate forces,
+// lifetime and compaction go through contiguous floats, SimdWidth particles at a time.
+// Work is split in ranges for the thread pool, if there is one.
+// Live particles are always packed at the beginning of the arrays, in no particular order
+class ParticleSystem
+{
+public:
+    // Particles processed together by the kernels. Forces are integrated with AVX (CMake option ITUGL_AVX2) or SSE2
+    // intrinsics, and the other inner loops have this fixed size, so the compiler can vectorize them
+    static constexpr unsigned int SimdWidth = 8;
+
+    // Added to the squared distance to the attractors, so the force stays finite at the center
+    static constexpr float AttractorSoftening = 0.01f;
+
+    // Point that pulls the particles with an inverse square force. Negative strength pushes them away
+    struct Attractor
+    {
+        glm::vec3 position;
+        float strength;
+    };
+
+    // Spawn parameters of Emit. Each particle gets random values in the ranges
+    struct Emitter
+    {
+        // Particles spawn inside a sphere
+        glm::vec3 position = glm::vec3(0.0f);
+        float radius = 0.0f;
+
+        // Initial velocity, plus a random velocity of up to velocitySpread in any direction
+        glm::vec3 velocity = glm::vec3(0.0f);
+        float velocitySpread = 0.0f;
+
+        // Lifetime in seconds, and size
+        float minLifetime = 1.0f;
+        float maxLifetime = 1.0f;
+        float minSize = 1.0f;
+        float maxSize = 1.0f;
+
+        Color color;
+    };
+
+    // Vertex of a live particle, written by UpdateVertexBuffer
+    struct Vertex
+    {
+        glm::vec3 position;
+        float size;
+        Color color;
+    };
+
+public:
+    // Max number of particles alive at the same time
+    ParticleSystem(unsigned int capacity);
+
+    inline unsigned int GetCapacity() const { return m_capacity; }
+    inline unsigned int GetParticleCount() const { return m_particleCount; }
+
+    // Optional thread pool to split the work of large systems. Not owned
+    inline ThreadPool* GetThreadPool() const { return m_threadPool; }
+    inline void SetThreadPool(ThreadPool* threadPool) { m_threadPool = threadPool; }
+
+    // Constant acceleration
+    inline const glm::vec3& GetGravity() const { return m_gravity; }
+    inline void SetGravity(const glm::vec3& gravity) { m_gravity = gravity; }
+
+    // Fraction of the velocity lost per second, from 0 to 1
+    inline float GetDrag() const { return m_drag; }
+    inline void SetDrag(float drag) { m_drag = drag; }
+
+    inline std::span<const Attractor> GetAttractors() const { return m_attractors; }
+    inline void AddAttractor(const Attractor& attractor) { m_attractors.push_back(attractor); }
+    inline void ClearAttractors() { m_attractors.clear(); }
+
+    // Spawn count particles, or less if the system is full. The random values are the same for the same seed,
+    // no matter how the work is split. Returns the number of particles spawned
+    unsigned int Emit(const Emitter& emitter, unsigned int count, unsigned int seed);
+
+    // Apply forces, integrate positions and age the particles, then remove the dead ones
+    void Update(float deltaTime);
+
+    // Remove all the particles
+    void Clear();
+
+    // Write the vertices of the live particles, returns the number of vertices. The span must fit all of them
+    unsigned int WriteVertices(std::span<Vertex> vertices) const;
+
+    // Stream the live particles to the vertex buffer, reallocating it with the vertices of this frame.
+    // Returns the number of vertices to draw
+    unsigned int UpdateVertexBuffer(VertexBufferObject& vertexBuffer);
+
+    // Read access to the arrays, for debugging and custom kernels
+    inline std::span<const float> GetPositionsX() const { return std::span(m_positionX).first(m_particleCount); }
+    inline std::span<const float> GetPositionsY() const { return std::span(m_positionY).first(m_particleCount); }
+    inline std::span<const float> GetPositionsZ() const { return std::span(m_positionZ).first(m_particleCount); }
+    inline std::span<const float> GetAges() const { return std::span(m_age).first(m_particleCount); }
+    inline std::span<const float> GetLifetimes() const { return std::span(m_lifetime).first(m_particleCount); }
+
+private:
+    // Run the function on [0, count) with the thread pool, or directly without it.
+    // Ranges are multiples of SimdWidth, except the last one
+    template<typename F>
+    unsigned int ForEachRange(unsigned int count, F&& function) const;
+
+    // Kernels, on the particles in [begin, end)
+    void IntegrateRange(unsigned int begin, unsigned int end, float deltaTime);
+    unsigned int CompactRange(unsigned int begin, unsigned int end);
+    void EmitRange(const Emitter& emitter, unsigned int first, unsigned int begin, unsigned int end, unsigned int seed);
+    void WriteVerticesRange(std::span<Vertex> vertices, unsigned int begin, unsigned int end) const;
+
+    // Move a block of particles to a lower index. The ranges can overlap
+    void MoveParticles(unsigned int source, unsigned int destination, unsigned int count);
+
+private:
+    unsigned int m_capacity;
+    unsigned int m_particleCount;
+
+    ThreadPool* m_threadPool;
+
+    glm::vec3 m_gravity;
+    float m_drag;
+    std::vector<Attractor> m_attractors;
+
+    // Particle arrays, all of size m_capacity
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_positionZ;
+    std::vector<float> m_velocityX;
+    std::vector<float> m_velocityY;
+    std::vector<float> m_velocityZ;
+    std::vector<float> m_age;
+    std::vector<float> m_lifetime;
+    std::vector<float> m_size;
+    std::vector<Color> m_color;
+
+    // Live particles of each range after compaction, before packing the ranges together
+    struct Range
+    {
+        unsigned int begin;
+        unsigned int count;
+    };
+    std::vector<Range> m_ranges;
+
+    // Vertices of the last UpdateVertexBuffer
+    std::vector<Vertex> m_vertices;
+};
@@ -3,22 +3,124 @@
 #include <ituGL/renderer/RenderPass.h>
 
 #include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/core/ShaderStorageBufferObject.h>
+#include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/geometry/Mesh.h>
+#include <glm/vec4.hpp>
 #include <memory>
+#include <vector>
+#include <string>
 
 class Texture2DObject;
 class Material;
+class Light;
 
 class DeferredRenderPass: public RenderPass
 {
+public:
+    enum class LightingMode
+    {
+        // Draw the fullscreen triangle once per light, with additive blending
+        PerLight,
+        // Bin the lights in screen tiles with a compute shader, then shade all the lights in a single draw
+        Tiled
+    };
+
+    // Size in pixels of the screen tiles, must match the work group size of the light culling shader
+    static constexpr unsigned int TileSize = 16;
+
+    // Max number of lights that can affect a tile, must match the light culling shader.
+    // The extra lights are dropped, but the tile keeps the full count so the tiled material can show the overflow
+    static constexpr unsigned int MaxLightsPerTile = 255;
+
 public:
     DeferredRenderPass(std::shared_ptr<Material> material);
 
+    // Tiled lighting requires OpenGL 4.3. If not available, the pass always uses PerLight mode
+    LightingMode GetLightingMode() const;
+    void SetLightingMode(LightingMode lightingMode);
+
+    // Set up the resources for the Tiled mode:
+    // - tiledMaterial: shades all the lights of the tile of each pixel, reading them from the shader storage buffers
+    // - lightCullingProgram: compute shader that writes the lights affecting each tile
+    // - depthTextureName: render graph texture with the depth of the g-buffer, used to compute the depth bounds of each tile
+    void SetTiledLighting(std::shared_ptr<Material> tiledMaterial, std::shared_ptr<ShaderProgram> lightCullingProgram,
+        const std::string& depthTextureName, int width, int height);
+
+    // In PerLight mode, point and spot lights can draw a mesh that covers only their range, instead of the full screen
+    // The pixels inside the mesh are marked with a stencil pass, so the scene depth needs to be in the current framebuffer
+    // - depthStencilFramebuffer: framebuffer with the scene depth, like the g-buffer. It is copied before lighting
+    // The stencil pass uses "shaders/renderer/light_volume.vert" and "shaders/renderer/light_volume.frag"
+    void SetLightVolumes(const FramebufferObject& depthStencilFramebuffer, int width, int height);
+
+    // Light volumes are used only after calling SetLightVolumes. Default: true
+    bool GetLightVolumesEnabled() const;
+    void SetLightVolumesEnabled(bool enabled);
+
+    // Draw to a transient texture of the render graph, instead of the current framebuffer, with a depth-stencil texture
+    // for the light volumes. The scene is in the render viewport, see Renderer::SetRenderScale. Empty name to disable
+    void SetOutputTexture(const std::string& outputTextureName, int width, int height);
+
+    void Setup(RenderGraph::PassBuilder& builder) override;
+
     void Render() override;
 
 private:
+    // Get the output textures of the current frame from the render graph, and attach them if they changed
+    void UpdateOutputFramebuffer();
+
     void InitializeMeshes();
 
+    // Get the mesh and world matrix that cover the range of the light. Returns false if it needs to cover the full screen
+    bool GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix) const;
+
+    // Mark in the stencil buffer the pixels where the scene is inside the light volume
+    void RenderLightVolumeStencil(const Mesh& mesh, const glm::mat4& worldViewProjMatrix);
+
+    void RenderPerLight();
+    void RenderTiled();
+
 private:
     std::shared_ptr<Material> m_material;
+
+    LightingMode m_lightingMode;
+
+    // Light volume resources
+    Mesh m_sphereMesh;
+    Mesh m_coneMesh;
+    bool m_lightVolumesEnabled;
+    const FramebufferObject* m_depthStencilFramebuffer;
+    int m_width;
+    int m_height;
+    ShaderProgram m_stencilProgram;
+    ShaderProgram::Location m_stencilWorldViewProjMatrixLocation;
+
+    // Tiled mode resources
+    std::shared_ptr<Material> m_tiledMaterial;
+    std::shared_ptr<ShaderProgram> m_lightCullingProgram;
+    std::string m_depthTextureName;
+    unsigned int m_tileCountX;
+    unsigned int m_tileCountY;
+
+    // Uniform locations of the tiled mode shaders
+    ShaderProgram::Location m_cullingDepthTextureLocation;
+    ShaderProgram::Location m_cullingViewMatrixLocation;
+    ShaderProgram::Location m_cullingInvProjMatrixLocation;
+    ShaderProgram::Location m_cullingLightCountLocation;
+    ShaderProgram::Location m_cullingViewportSizeLocation;
+    ShaderProgram::Location m_tileCountXLocation;
+
+    // The lights of the frame are in the renderer light buffer, at Renderer::LightBufferBinding
+    // For each tile, the number of lights followed by MaxLightsPerTile light indices, at binding 1.
+    // The number is not clamped, it is larger than MaxLightsPerTile if the tile overflowed
+    ShaderStorageBufferObject m_tileLightBuffer;
+
+    // Output textures, if set, and the framebuffer with them attached
+    std::string m_outputTextureName;
+    std::string m_outputDepthTextureName;
+    int m_outputWidth;
+    int m_outputHeight;
+    std::shared_ptr<Texture2DObject> m_outputTexture;
+    std::shared_ptr<Texture2DObject> m_outputDepthTexture;
+    FramebufferObject m_outputFramebuffer;
 };
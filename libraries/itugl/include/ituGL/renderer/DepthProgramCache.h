@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <string>
+
+// Depth-only shader programs, generated for the vertex layout of each material shader program. They read
+// "VertexPosition", and "InstanceWorldMatrix" if the material has it, at the same attribute locations,
+// so they can draw the VAOs and instances set up for the material
+class DepthProgramCache
+{
+public:
+    struct DepthProgram
+    {
+        std::shared_ptr<ShaderProgram> shaderProgram;
+        ShaderProgram::Location worldMatrixLocation;
+        ShaderProgram::Location instanceWorldMatrixLocation;
+
+        // Only with viewProjUniform, -1 otherwise
+        ShaderProgram::Location viewProjMatrixLocation;
+    };
+
+public:
+    // By default, the camera is read from the frame block (see LoadFrameBlock and Renderer::FrameData). If viewProjUniform,
+    // it is read from a "ViewProjMatrix" uniform instead, to render from other points of view, like a light
+    DepthProgramCache(bool viewProjUniform = false);
+
+    // GLSL file with the "FrameBlock" uniform block, the same one included by the material shaders.
+    // Required to read the camera from the frame block. Returns false if the file can't be read
+    bool LoadFrameBlock(const char* path);
+
+    // Depth program for the vertex layout of the material shader program. Null if it has no "VertexPosition" attribute,
+    // or if the frame block is required and not loaded
+    const DepthProgram* GetDepthProgram(const ShaderProgram& materialShaderProgram);
+
+private:
+    // Build a depth program that reads the position and, if not negative, the instance world matrix at these locations
+    DepthProgram CreateDepthProgram(ShaderProgram::Location positionLocation, ShaderProgram::Location instanceWorldMatrixLocation) const;
+
+private:
+    bool m_viewProjUniform;
+
+    // Source of the frame block, included after the version and the inputs
+    std::string m_frameBlockSource;
+
+    // Depth programs by position and instance world matrix locations, and the one used by each material shader program
+    std::map<std::pair<ShaderProgram::Location, ShaderProgram::Location>, DepthProgram> m_depthPrograms;
+    std::unordered_map<const ShaderProgram*, const DepthProgram*> m_materialDepthPrograms;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+class RenderPassTimer;
+
+// Picks the render scale that keeps the GPU frame time close to a target, with a PID controller.
+// The controller works on the scaled area, that is roughly proportional to the GPU time of the scene passes.
+// When the load goes up the scale drops in a few frames, and it goes back up when the load is gone
+class DynamicResolution
+{
+public:
+    // Target frame time in milliseconds, and range of the scale
+    DynamicResolution(float targetFrameTime = 16.0f, float minScale = 0.5f, float maxScale = 1.0f);
+
+    // Target GPU frame time, in milliseconds
+    inline float GetTargetFrameTime() const { return m_targetFrameTime; }
+    void SetTargetFrameTime(float targetFrameTime);
+
+    // Range of the scale. The scale is clamped to it
+    inline float GetMinScale() const { return m_minScale; }
+    inline float GetMaxScale() const { return m_maxScale; }
+    void SetScaleRange(float minScale, float maxScale);
+
+    // Gains of the controller. The error is relative to the target frame time. Default: 0.15, 0.1, 0
+    void SetGains(float proportional, float integral, float derivative);
+
+    // Current scale, rounded to multiples of 1/64 so small corrections don't change the viewport every frame
+    float GetScale() const;
+
+    // Update the scale with the GPU time of a frame, in milliseconds. Returns the new scale
+    float Update(float frameTime);
+
+    // Update the scale with the last frame read by the timer, if it is a new one. Returns the new scale
+    float Update(const RenderPassTimer& timer);
+
+    // Back to the max scale, forgetting the previous errors
+    void Reset();
+
+private:
+    float m_targetFrameTime;
+    float m_minScale;
+    float m_maxScale;
+
+    float m_proportionalGain;
+    float m_integralGain;
+    float m_derivativeGain;
+
+    // Scaled area, the controlled variable, and the errors of the last two frames
+    float m_area;
+    float m_lastError;
+    float m_lastLastError;
+
+    // Frames of the timer already used
+    unsigned int m_readFrameCount;
+};
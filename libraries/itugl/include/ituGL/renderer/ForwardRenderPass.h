@@ -1,6 +1,9 @@
 #pragma once
 
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/DepthProgramCache.h>
+#include <vector>
 
 class ForwardRenderPass : public RenderPass
 {
@@ -8,8 +11,48 @@ public:
     ForwardRenderPass();
     ForwardRenderPass(int drawcallCollectionIndex);
 
+    // Shader programs with a light array (see Renderer::HasLightArray) are shaded in a single draw,
+    // with the lights that reach the bounds of the drawcall. If there are more, only the closest ones are kept.
+    // The limit is also capped by the size of the array in the shader. Default: 32
+    unsigned int GetMaxLightsPerObject() const;
+    void SetMaxLightsPerObject(unsigned int maxLightsPerObject);
+
+    // If enabled, opaque drawcalls are first rendered to depth only, with a simple shader program, and then shaded
+    // with GL_EQUAL depth test and depth writes off, so each pixel runs the lighting shader only once. Default: false
+    // Only the materials with Material::GetDepthPrePass are pre-passed, because GL_EQUAL needs the exact same depth:
+    // their vertex shader must compute gl_Position = ViewProjMatrix * vec4((WorldMatrix * vec4(VertexPosition, 1.0)).xyz, 1.0),
+    // with InstanceWorldMatrix if instanced, read ViewProjMatrix from the frame block, and declare "invariant gl_Position".
+    // The other drawcalls are shaded without pre-pass, with GL_LEQUAL against the pre-pass depth.
+    // The frame block must be loaded with LoadFrameBlock, otherwise nothing is pre-passed
+    bool GetDepthPrePassEnabled() const;
+    void SetDepthPrePassEnabled(bool depthPrePassEnabled);
+
+    // GLSL file with the "FrameBlock" uniform block of the material shaders, included in the depth programs of the pre-pass
+    bool LoadFrameBlock(const char* path);
+
     void Render() override;
 
+private:
+    // Render the depth of the opaque drawcalls. Fills m_depthPrePassed with the drawcalls that were rendered
+    void RenderDepthPrePass();
+
+    // Fill m_lightIndices with the lights that affect the drawcall
+    void SelectLights(const Renderer::DrawcallInfo& drawcallInfo, unsigned int maxLightCount);
+
 private:
     int m_drawcallCollectionIndex;
+
+    unsigned int m_maxLightsPerObject;
+
+    bool m_depthPrePassEnabled;
+
+    // Depth-only shader programs of the pre-pass, for the vertex layout of each material
+    DepthProgramCache m_depthPrograms;
+
+    // For each drawcall of the collection, if its depth was rendered in the pre-pass
+    std::vector<bool> m_depthPrePassed;
+
+    // Lights selected for the current drawcall, and their distance to its bounds
+    std::vector<int> m_lightIndices;
+    std::vector<std::pair<float, int>> m_lightDistances;
 };
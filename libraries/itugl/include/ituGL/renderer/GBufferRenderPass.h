@@ -8,23 +8,44 @@
 
 class GBufferRenderPass : public RenderPass
 {
+public:
+    // Names of the g-buffer textures in the render graph
+    static constexpr const char* DepthTextureName = "GBufferDepth";
+    static constexpr const char* AlbedoTextureName = "GBufferAlbedo";
+    static constexpr const char* NormalTextureName = "GBufferNormal";
+    static constexpr const char* OthersTextureName = "GBufferOthers";
+
 public:
     GBufferRenderPass(int width, int height, int drawcallCollectionIndex = 0);
 
+    // Size of the g-buffer textures. It can change every frame, the textures come from the texture pool
+    void SetSize(int width, int height);
+
+    // The g-buffer textures are transient resources of the render graph, the pass is culled if nobody reads them
+    void Setup(RenderGraph::PassBuilder& builder) override;
+
     void Render() override;
 
+    // Textures of the current frame. They can be different every frame, read them through the render graph
     const std::shared_ptr<Texture2DObject> GetDepthTexture() const { return m_depthTexture; }
     const std::shared_ptr<Texture2DObject> GetAlbedoTexture() const { return m_albedoTexture; }
     const std::shared_ptr<Texture2DObject> GetNormalTexture() const { return m_normalTexture; }
     const std::shared_ptr<Texture2DObject> GetOthersTexture() const { return m_othersTexture; }
 
+    // Framebuffer with the g-buffer textures attached. The depth texture is attached as depth-stencil
+    const FramebufferObject& GetFramebuffer() const { return m_framebuffer; }
+
 private:
-    void InitTextures(int width, int height);
+    // Get the textures of the current frame from the render graph, and attach them if they changed
+    void UpdateTextures();
     void InitFramebuffer();
 
 private:
     int m_drawcallCollectionIndex;
 
+    int m_width;
+    int m_height;
+
     std::shared_ptr<Texture2DObject> m_depthTexture;
     std::shared_ptr<Texture2DObject> m_albedoTexture;
     std::shared_ptr<Texture2DObject> m_normalTexture;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ituGL/renderer/Renderer.h>
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+class Camera;
+class Model;
+
+// Drawcalls recorded by one thread, to be merged in the renderer with Renderer::MergeCommandLists.
+// Each thread must write to its own command list, but they can be filled at the same time
+class RenderCommandList
+{
+public:
+    RenderCommandList();
+
+    // Same as Renderer::AddModel, but without touching the renderer
+    void AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic = false);
+
+    // Same as Renderer::AddShadowCaster
+    void AddShadowCaster(const Model& model, const glm::mat4& worldMatrix, bool dynamic = false);
+
+    inline bool IsEmpty() const { return m_drawcalls.empty() && m_shadowCasterDrawcalls.empty(); }
+
+private:
+    friend class Renderer;
+
+    // Clear the recorded drawcalls. If the camera is known, the view depth of each model is computed while recording
+    void Reset(const Camera* camera);
+
+    // Add the world matrix of the model, and its drawcalls to the given list
+    void AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic, std::vector<Renderer::DrawcallInfo>& drawcalls);
+
+private:
+    const Camera* m_camera;
+
+    // World matrices, with their world space bounds, view depth (negative if the camera is unknown) and dynamic flag
+    std::vector<glm::mat4> m_worldMatrices;
+    std::vector<Renderer::WorldBounds> m_worldBounds;
+    std::vector<float> m_worldDepths;
+    std::vector<bool> m_worldDynamic;
+
+    // Drawcalls, with worldMatrixIndex relative to the world matrices of this list
+    std::vector<Renderer::DrawcallInfo> m_drawcalls;
+
+    // Same, for the drawcalls that only go to the shadow caster collection
+    std::vector<Renderer::DrawcallInfo> m_shadowCasterDrawcalls;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <ituGL/renderer/TexturePool.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+class RenderPass;
+
+// Passes of a frame, with the textures each one reads and writes.
+// The graph is built again every frame: passes are added in execution order and declare their resources,
+// then Compile culls the passes whose outputs are not used, and assigns textures from the pool to the
+// transient resources. Transient resources whose lifetimes don't overlap can share the same texture
+class RenderGraph
+{
+public:
+    using ResourceId = int;
+    static constexpr ResourceId InvalidResource = -1;
+
+    using TextureDesc = TexturePool::TextureDesc;
+
+    // Used by a pass to declare its resources, in RenderPass::Setup
+    class PassBuilder
+    {
+    public:
+        // Create a transient texture, written by this pass. Its content is only valid until its last reader
+        ResourceId CreateTexture(const std::string& name, const TextureDesc& desc);
+
+        // Same as RenderGraph::ImportTexture, for passes that own a persistent texture. The pass still has to Read or Write it
+        ResourceId ImportTexture(const std::string& name, std::shared_ptr<Texture2DObject> texture);
+
+        // The pass reads the resource, created by a previous pass or imported. Returns InvalidResource if not found
+        ResourceId Read(const std::string& name);
+
+        // The pass writes the resource, created by a previous pass or imported. Returns InvalidResource if not found
+        ResourceId Write(const std::string& name);
+
+        // The pass has effects outside of the graph, like drawing to the default framebuffer, so it is never culled
+        void SetSideEffect();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, unsigned int passIndex);
+
+    private:
+        RenderGraph& m_graph;
+        unsigned int m_passIndex;
+    };
+
+public:
+    RenderGraph(TexturePool& texturePool);
+    ~RenderGraph();
+
+    // Clear the passes and resources of the previous frame. The textures go back to the pool
+    void Reset();
+
+    // Add a texture that lives outside of the graph. It is never aliased, and writing to it keeps the writer alive
+    ResourceId ImportTexture(const std::string& name, std::shared_ptr<Texture2DObject> texture);
+
+    // Add the pass after the previous ones, and return the builder to declare its resources
+    PassBuilder AddPass(RenderPass& pass);
+
+    // The resource is used after the graph, so its writers are never culled
+    void MarkOutput(const std::string& name);
+
+    // Cull the unused passes and assign the textures of the transient resources
+    void Compile();
+
+    inline unsigned int GetPassCount() const { return static_cast<unsigned int>(m_passes.size()); }
+    inline RenderPass& GetPass(unsigned int passIndex) const { return *m_passes[passIndex].pass; }
+
+    // If the pass was culled in Compile, it doesn't need to be rendered
+    inline bool IsPassCulled(unsigned int passIndex) const { return m_passes[passIndex].culled; }
+
+    ResourceId FindResource(const std::string& name) const;
+
+    // Texture assigned to the resource in Compile, or the imported one. Null if no pass uses it
+    std::shared_ptr<Texture2DObject> GetTexture(ResourceId resourceId) const;
+    std::shared_ptr<Texture2DObject> GetTexture(const std::string& name) const;
+
+    // Number of transient resources and distinct textures used for them in the last Compile
+    inline unsigned int GetTransientResourceCount() const { return m_transientResourceCount; }
+    inline unsigned int GetTransientTextureCount() const { return m_transientTextureCount; }
+
+private:
+    struct Resource
+    {
+        std::string name;
+        TextureDesc desc;
+        bool imported;
+        bool output;
+        std::shared_ptr<Texture2DObject> texture;
+
+        // Compile data: passes that use it, and the range of non-culled passes that use it
+        unsigned int readerCount;
+        int firstPass;
+        int lastPass;
+    };
+
+    struct Pass
+    {
+        RenderPass* pass;
+        std::vector<ResourceId> reads;
+        std::vector<ResourceId> writes;
+        std::vector<ResourceId> creates;
+        bool sideEffect;
+
+        // Compile data: number of used resources written, and if the pass is not needed
+        unsigned int referenceCount;
+        bool culled;
+    };
+
+    void CullPasses();
+    void ComputeLifetimes();
+    void AssignTextures();
+
+private:
+    TexturePool& m_texturePool;
+
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+
+    unsigned int m_transientResourceCount;
+    unsigned int m_transientTextureCount;
+};
@@ -1,23 +1,64 @@
 #pragma once
 
+#include <ituGL/renderer/RenderGraph.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <string>
+#include <vector>
+#include <memory>
+
 class Renderer;
+class Material;
 
 class RenderPass
 {
 public:
-    RenderPass();
+    RenderPass(const std::string& name = "RenderPass");
     virtual ~RenderPass();
 
+    // Name of the pass, shown in the GPU timings
+    inline const std::string& GetName() const { return m_name; }
+    void SetName(const std::string& name);
+
+    // Declare the resources of the pass in the render graph of the frame.
+    // By default, the pass draws to the current framebuffer, so it is never culled
+    virtual void Setup(RenderGraph::PassBuilder& builder);
+
     virtual void Render() = 0;
 
+    // Read a texture of the render graph, and set it to the material uniform before rendering, every frame
+    void AddInputTexture(const std::string& resourceName, std::shared_ptr<Material> material, const char* uniformName);
+
 protected:
     Renderer& GetRenderer();
     const Renderer& GetRenderer() const;
 
+    // Texture of the resource in the render graph of the current frame
+    std::shared_ptr<Texture2DObject> GetGraphTexture(const std::string& resourceName) const;
+
 private:
     friend class Renderer;
     void SetRenderer(Renderer* renderer);
 
+    // Interned copy of the name for the profiler zone of the pass, set when the pass is added to the renderer
+    inline const char* GetZoneName() const { return m_zoneName; }
+
+    // Declare the input textures as read by the pass
+    void SetupInputTextures(RenderGraph::PassBuilder& builder);
+
+    // Set the input textures of the current frame to their material uniforms
+    void BindInputTextures();
+
 private:
     Renderer* m_renderer;
+
+    std::string m_name;
+    const char* m_zoneName;
+
+    struct InputTexture
+    {
+        std::string resourceName;
+        std::shared_ptr<Material> material;
+        ShaderProgram::Location location;
+    };
+    std::vector<InputTexture> m_inputTextures;
 };
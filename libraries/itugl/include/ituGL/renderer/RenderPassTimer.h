@@ -0,0 +1,91 @@
+#pragma once
+
+#include <ituGL/core/QueryObject.h>
+#include <string>
+#include <vector>
+#include <array>
+
+class DearImGui;
+
+// Measures the GPU time of each render pass with GL_TIME_ELAPSED queries.
+// The queries of a frame are read FrameLatency frames later, when the GPU has finished them, so reading never stalls.
+// The statistics are computed over the last samples of each pass
+class RenderPassTimer
+{
+public:
+    // Number of frames in flight, each one with its own queries
+    static constexpr unsigned int FrameLatency = 3;
+
+    struct Statistics
+    {
+        // Times in milliseconds
+        float min;
+        float avg;
+        float p99;
+        float last;
+        unsigned int sampleCount;
+    };
+
+public:
+    RenderPassTimer(unsigned int windowSize = 240);
+
+    // Number of samples kept for each pass
+    inline unsigned int GetWindowSize() const { return m_windowSize; }
+    void SetWindowSize(unsigned int windowSize);
+
+    // Read the results of the previous frames that are available, and start a new frame
+    void BeginFrame();
+
+    // Measure the commands between BeginPass and EndPass. Passes can't be nested
+    void BeginPass(unsigned int passIndex, const std::string& name);
+    void EndPass();
+
+    // Passes measured so far, indexed by the pass index given in BeginPass
+    inline unsigned int GetPassCount() const { return static_cast<unsigned int>(m_passes.size()); }
+    const std::string& GetPassName(unsigned int passIndex) const;
+    Statistics GetStatistics(unsigned int passIndex) const;
+
+    // Frames whose results were not ready after FrameLatency frames, and were discarded
+    inline unsigned int GetDroppedFrameCount() const { return m_droppedFrameCount; }
+
+    // Time in milliseconds of all the passes of the last frame that was read, and how many frames have been read.
+    // The frame is FrameLatency frames old, at most
+    inline float GetLastFrameTime() const { return m_lastFrameTime; }
+    inline unsigned int GetReadFrameCount() const { return m_readFrameCount; }
+
+    // Write one line per pass with its statistics. Returns false if the file can't be written
+    bool WriteCsv(const char* path) const;
+
+    // Window with the statistics of each pass, and a button to save them to a CSV file
+    void DrawGUI(DearImGui& imGui, const char* csvPath = "gpu_timings.csv");
+
+private:
+    void ReadResults(unsigned int frameIndex);
+
+private:
+    struct PassSamples
+    {
+        std::string name;
+        // Ring buffer of the last times, in milliseconds
+        std::vector<float> samples;
+        unsigned int nextSample;
+    };
+    std::vector<PassSamples> m_passes;
+
+    // Queries of each frame in flight, and the pass measured by each one
+    struct Frame
+    {
+        std::vector<QueryObject> queries;
+        std::vector<unsigned int> passIndices;
+        unsigned int queryCount;
+        bool pending;
+    };
+    std::array<Frame, FrameLatency> m_frames;
+    unsigned int m_currentFrame;
+
+    unsigned int m_windowSize;
+    unsigned int m_droppedFrameCount;
+    float m_lastFrameTime;
+    unsigned int m_readFrameCount;
+    bool m_passActive;
+};
@@ -2,8 +2,19 @@
 
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/RenderGraph.h>
+#include <ituGL/renderer/TexturePool.h>
+#include <ituGL/renderer/RenderPassTimer.h>
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/core/ShaderStorageBufferObject.h>
+#include <ituGL/core/UniformBufferObject.h>
+#include <ituGL/core/DrawIndirectBufferObject.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/lighting/PointLight.h>
+#include <ituGL/lighting/SpotLight.h>
 #include <glm/mat4x4.hpp>
 #include <vector>
 #include <unordered_map>
@@ -11,13 +22,12 @@
 #include <span>
 #include <functional>
 
-class Camera;
-class Light;
 class ShaderProgram;
 class Material;
 class VertexArrayObject;
 class Drawcall;
 class Model;
+class RenderCommandList;
 
 class Renderer
 {
@@ -25,79 +35,401 @@ public:
     struct DrawcallInfo
     {
         DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall)
+            : DrawcallInfo(material, worldMatrixIndex, vao, drawcall, 0, 0)
+        {
+        }
+
+        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall,
+            unsigned int firstInstance, unsigned int instanceCount)
+            : DrawcallInfo(material, worldMatrixIndex, vao, drawcall, firstInstance, instanceCount, 0, 0)
+        {
+        }
+
+        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall,
+            unsigned int firstInstance, unsigned int instanceCount, unsigned int firstCommand, unsigned int commandCount)
             : material(material), worldMatrixIndex(worldMatrixIndex), vao(vao), drawcall(drawcall)
+            , firstInstance(firstInstance), instanceCount(instanceCount)
+            , firstCommand(firstCommand), commandCount(commandCount)
         {
         }
 
+        // Execute the drawcall, with the indirect commands or instanced if needed
+        inline void Draw() const
+        {
+            if (commandCount > 0)
+                drawcall.MultiDrawIndirect(firstCommand * sizeof(Drawcall::ElementsIndirectCommand), commandCount);
+            else if (instanceCount > 0)
+                drawcall.DrawInstanced(instanceCount, firstInstance);
+            else
+                drawcall.Draw();
+        }
+
         const Material& material;
         unsigned int worldMatrixIndex;
         const VertexArrayObject& vao;
         const Drawcall& drawcall;
+
+        // First world matrix in the instance buffer and number of instances. Zero instances means not instanced.
+        // The first instance is the base instance of the draw
+        unsigned int firstInstance;
+        unsigned int instanceCount;
+
+        // First command in the draw indirect buffer and number of commands. Zero commands means not indirect.
+        // The commands draw different drawcalls of the VAO, each one with its own base instance
+        unsigned int firstCommand;
+        unsigned int commandCount;
     };
 
     using DrawcallCollection = std::vector<DrawcallInfo>;
 
+    // Collection with the drawcalls of all the models, including the ones culled against the camera (see AddShadowCaster),
+    // for passes that draw the scene from another point of view, like ShadowMapRenderPass. Camera passes read collection 0
+    static constexpr unsigned int ShadowCasterCollectionIndex = 1;
+
+    // World space bounds of a model. Empty (min > max) if the mesh has no bounds
+    struct WorldBounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Light data in the light buffer, as read by the shaders (std430 layout)
+    struct LightData
+    {
+        glm::vec4 color;
+        glm::vec4 position;
+        glm::vec4 direction;
+        glm::vec4 attenuation;
+    };
+
+    // Binding index of the light buffer, with all the lights of the frame (requires OpenGL 4.3)
+    static constexpr GLuint LightBufferBinding = 0;
+
+    // Per-frame camera and time data, as read by the shaders in the "FrameBlock" uniform block (std140 layout)
+    struct FrameData
+    {
+        glm::mat4 viewMatrix;
+        glm::mat4 projMatrix;
+        glm::mat4 viewProjMatrix;
+        glm::mat4 invViewMatrix;
+        glm::mat4 invProjMatrix;
+        glm::vec3 cameraPosition;
+        float time;
+        float deltaTime;
+        float padding;
+        // Render viewport divided by the render size, see SetRenderScale
+        glm::vec2 renderScale;
+    };
+
+    // Uniform buffer binding index of the frame block, assigned to all the registered shader programs
+    static constexpr GLuint FrameBlockBinding = 0;
+
     using UpdateTransformsFunction = std::function<void(const ShaderProgram&, const glm::mat4&, const Camera&, bool)>;
     using UpdateLightsFunction = std::function<bool(const ShaderProgram&, std::span<const Light* const>, unsigned int&)>;
 
 public:
     Renderer(DeviceGL& device);
+    ~Renderer();
 
     const DeviceGL& GetDevice() const { return m_device; }
     DeviceGL& GetDevice() { return m_device; }
 
     int AddRenderPass(std::unique_ptr<RenderPass> renderPass);
 
+    // Graph with the passes and textures of the current frame, built in Render from the Setup of each pass.
+    // Passes whose outputs are not used are skipped, and their transient textures come from the texture pool
+    const RenderGraph& GetRenderGraph() const;
+
+    // Pool of the transient render targets, shared by all the frames
+    const TexturePool& GetTexturePool() const;
+    TexturePool& GetTexturePool();
+
+    // GPU time of each render pass, measured in Render if enabled. Default: true
+    bool GetPassTimingEnabled() const;
+    void SetPassTimingEnabled(bool passTimingEnabled);
+    const RenderPassTimer& GetPassTimer() const;
+    RenderPassTimer& GetPassTimer();
+
+    // Time in seconds of the frame, available to the shaders in the frame block. Submitted with the models
+    void SetFrameTime(float time, float deltaTime);
+
+    // Size of the targets of the scene passes. Zero if the passes draw with the current viewport. Default: 0x0
+    void GetRenderSize(int& width, int& height) const;
+    void SetRenderSize(int width, int height);
+
+    // Dynamic resolution: the scene passes draw only to the bottom-left part of their targets, the render size scaled,
+    // and a later pass upscales it, like UpscaleRenderPass. The targets keep their size, so they are not reallocated
+    // when the scale changes. Clamped to (0, 1]. Default: 1
+    float GetRenderScale() const;
+    void SetRenderScale(float renderScale);
+
+    // Render size scaled by the render scale, rounded up
+    void GetRenderViewport(int& width, int& height) const;
+
+    // Set the device viewport to the render viewport. Passes that draw the scene call it after binding their framebuffer.
+    // It does nothing if the render size is not set
+    void SetRenderViewport();
+
+    // Camera and lights of the frame being rendered
     bool HasCamera() const;
     const Camera& GetCurrentCamera() const;
-    void SetCurrentCamera(const Camera& camera);
-
     std::span<const Light* const> GetLights() const;
+
+    // Camera of the frame being submitted, for culling and command lists
+    bool HasSubmittedCamera() const;
+    const Camera& GetSubmittedCamera() const;
+
+    void SetCurrentCamera(const Camera& camera);
     void AddLight(const Light& light);
 
+    // Hand the frame submitted so far (camera, lights, time and models) to Render, and start submitting the next one
+    // in the other buffer. The camera and lights are copied, so the scene can change while the frame renders.
+    // Call it when neither Render nor the submission are running. Until it is called, Render draws the frame being submitted
+    void SubmitFrame();
+
     std::span<const DrawcallInfo> GetDrawcalls(unsigned int collectionIndex) const;
-    void AddModel(const Model& model, const glm::mat4& worldMatrix);
+
+    // Dynamic models are expected to move every frame, like the fireflies. Passes that cache their results
+    // between frames, like ShadowMapRenderPass, draw them apart. Instanced drawcalls never mix dynamic and static models
+    void AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic = false);
+
+    // Add a model that is not visible from the camera, but can still cast shadows into the view.
+    // It only goes to the shadow caster collection
+    void AddShadowCaster(const Model& model, const glm::mat4& worldMatrix, bool dynamic = false);
+
+    // Clear count command lists, so they can be filled from different threads with RenderCommandList::AddModel.
+    // Set the camera first, so the lists can compute the view depths too
+    void BeginCommandLists(unsigned int count);
+    RenderCommandList& GetCommandList(unsigned int index);
+
+    // Append the drawcalls of the command lists to the renderer, in order of the lists. Call it from the render thread
+    void MergeCommandLists();
+
+    // World space bounds of the drawcall, including all its instances. Returns false if the mesh has no bounds
+    bool GetDrawcallBounds(const DrawcallInfo& drawcallInfo, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+
+    // World space bounds of each instance of the drawcall, or only one if not instanced
+    std::span<const WorldBounds> GetDrawcallWorldBounds(const DrawcallInfo& drawcallInfo) const;
+
+    // World matrices of the drawcall, one per instance, or only one if not instanced
+    std::span<const glm::mat4> GetDrawcallWorldMatrices(const DrawcallInfo& drawcallInfo) const;
+
+    // If the models of the drawcall were added as dynamic
+    bool IsDrawcallDynamic(const DrawcallInfo& drawcallInfo) const;
 
     const Mesh& GetFullscreenMesh() const;
 
+    // Shader programs with a "FrameBlock" uniform block read the camera from the frame buffer,
+    // so their update transforms function only needs to set the world matrix
     void RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shaderProgramPtr,
         const UpdateTransformsFunction& updateTransformFunction,
         const UpdateLightsFunction& updateLightsFunction);
 
+    // Point the "InstanceWorldMatrix" attribute of the VAOs of the mesh to the instance buffer. Call it once for the meshes
+    // drawn with shader programs that support instancing, after registering the programs. Those programs must all have
+    // the attribute at the same location. Instanced drawcalls with a first instance require OpenGL 4.2
+    void SetupInstancing(Mesh& mesh) const;
+
     void UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged = true) const;
     void UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged = true) const;
 
     UpdateLightsFunction GetDefaultUpdateLightsFunction(const ShaderProgram& shaderProgram);
     bool UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const;
 
+    // Shader programs with "LightCount" and "LightIndices" uniforms read the lights from the light buffer,
+    // so all the lights of a drawcall can be shaded in a single draw
+    bool HasLightArray(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const;
+
+    // Max number of lights that fit in the "LightIndices" array of the shader program
+    unsigned int GetLightArraySize(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const;
+
+    // Set the lights, as indices in the light buffer, used by the next drawcall. Extra lights are ignored
+    void SetLightArray(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const int> lightIndices) const;
+
+    // Set the material, transforms and VAO of the drawcall, skipping the ones that are already set
     void PrepareDrawcall(const DrawcallInfo& drawcallInfo);
 
+    // Set the transforms and VAO of the drawcall for a shader program that ignores the material, like a depth-only program.
+    // The world matrix goes to the uniform at worldMatrixLocation, or to the attribute at instanceWorldMatrixLocation if instanced
+    void PrepareDrawcall(const DrawcallInfo& drawcallInfo, const ShaderProgram& shaderProgram,
+        GLint worldMatrixLocation, GLint instanceWorldMatrixLocation);
+
+    // Forget the states cached by PrepareDrawcall. Needed if they are modified outside of PrepareDrawcall
+    void InvalidateDrawcallStates();
+
+    // Number of program, material, transform and VAO binds skipped by PrepareDrawcall during the last frame
+    unsigned int GetSkippedBindCount() const;
+
+    // If enabled, drawcalls with the same material, VAO and drawcall are merged in one instanced drawcall,
+    // if the shader program supports it. Default: true
+    bool GetInstancingEnabled() const;
+    void SetInstancingEnabled(bool instancingEnabled);
+
+    // If enabled, consecutive instanced drawcalls with the same material and VAO are merged in one multi-draw,
+    // reading the parameters of each drawcall from a draw indirect buffer. Requires OpenGL 4.3. Default: true
+    bool GetMultiDrawEnabled() const;
+    void SetMultiDrawEnabled(bool multiDrawEnabled);
+
+    // Number of drawcalls rendered in each pass during the last frame, after merging instances and multi-draws
+    unsigned int GetDrawcallCount() const;
+
+    // If enabled, drawcall collections are sorted by state and depth before rendering. Default: true
+    bool GetSortDrawcalls() const;
+    void SetSortDrawcalls(bool sortDrawcalls);
+
     void SetLightingRenderStates(bool firstPass);
 
     void Render();
 
 private:
+    friend class RenderCommandList;
+
     void Reset();
 
+    // Build the render graph of the frame from the render passes, and compile it
+    void BuildRenderGraph();
+
     void InitializeFullscreenMesh();
 
+    // Add the world matrix of the model and its drawcalls, to all the collections or only to the shadow casters
+    void AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic, bool shadowCasterOnly);
+
+    // Copy the lights to the light buffer and bind it
+    void UpdateLightBuffer();
+
+    // Copy the camera and time to the frame buffer and bind it
+    void UpdateFrameBuffer();
+
+    // Sort each drawcall collection by its sort key, see ComputeSortKey
+    void SortDrawcalls();
+
+    // Transform the local bounds of the mesh to a world space AABB
+    static WorldBounds ComputeWorldBounds(const Mesh& mesh, const glm::mat4& worldMatrix);
+
+    // View space depth of the origin of the world matrix, used to sort the drawcalls
+    static float ComputeViewDepth(const Camera& camera, const glm::mat4& worldMatrix);
+
+    // Convert the drawcalls of shader programs that support instancing into instanced drawcalls, and upload the world matrices
+    void BuildInstances();
+
+    // Merge runs of instanced drawcalls that share material and VAO in multi-draws, and upload their indirect commands
+    void BuildMultiDraws();
+
+#ifndef NDEBUG
+    // Check that the bound VAO was set up by SetupInstancing
+    bool IsInstancingSetup(GLint location) const;
+#endif
+
+    // Pack the collection, shader program, material, VAO and depth in a 64-bit key.
+    // Translucent drawcalls go last, sorted back to front
+    static unsigned long long ComputeSortKey(unsigned int collectionIndex, bool translucent, unsigned int shaderProgramId,
+        unsigned int materialId, unsigned int vaoId, float depth);
+
 private:
     DeviceGL& m_device;
 
-    const Camera *m_currentCamera;
+    // Data submitted for a frame. Render reads m_renderFrame, and the submission writes m_submitFrame.
+    // They are the same frame until SubmitFrame is called, and then alternate between the two frames
+    struct FrameSubmission
+    {
+        const Camera* camera;
+        std::vector<const Light*> lights;
+
+        float time;
+        float deltaTime;
+
+        std::vector<glm::mat4> worldMatrices;
+
+        // World space bounds of the models, for each world matrix
+        std::vector<WorldBounds> worldBounds;
+
+        // View depth of each world matrix, if it was computed when the model was added. Negative otherwise
+        std::vector<float> worldDepths;
+
+        // If the model of each world matrix is dynamic, see AddModel
+        std::vector<bool> worldDynamic;
+
+        std::vector<DrawcallCollection> drawcallCollections;
 
-    std::shared_ptr<const Material> m_currentMaterial;
+        // Make a copy of the camera and lights, and point the frame to them
+        void CopyCameraAndLights();
 
-    std::vector<const Light*> m_lights;
+        // Copies of the camera and lights, made by SubmitFrame. Reused every frame to keep their memory
+        Camera cameraCopy;
+        std::vector<DirectionalLight> directionalLightCopies;
+        std::vector<PointLight> pointLightCopies;
+        std::vector<SpotLight> spotLightCopies;
+    };
+    FrameSubmission m_frames[2];
+    FrameSubmission* m_submitFrame;
+    FrameSubmission* m_renderFrame;
+
+    // Camera and time of the frame, at FrameBlockBinding
+    UniformBufferObject m_frameBuffer;
+
+    // States currently set by PrepareDrawcall
+    const Material* m_currentMaterial;
+    const ShaderProgram* m_currentShaderProgram;
+    const VertexArrayObject* m_currentVao;
+    unsigned int m_currentWorldMatrixIndex;
 
-    std::vector<glm::mat4> m_worldMatrices;
+    // Binds skipped during the current and the last frame
+    unsigned int m_skippedBindCount;
+    unsigned int m_lastSkippedBindCount;
 
-    std::vector<DrawcallCollection> m_drawcallCollections;
+    bool m_sortDrawcalls;
+
+    // Command lists started with BeginCommandLists, and the ones kept from previous frames to reuse their memory
+    std::vector<std::unique_ptr<RenderCommandList>> m_commandLists;
+    unsigned int m_commandListCount;
 
     std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateTransformsFunction> m_updateTransformsFunctions;
     std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateLightsFunction> m_updateLightsFunctions;
 
+    // Location of the "InstanceWorldMatrix" attribute, for the shader programs that support instancing
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, GLint> m_instanceWorldMatrixLocations;
+
+    // World matrices of the instanced drawcalls, and the buffer where they are uploaded
+    std::vector<glm::mat4> m_instanceWorldMatrices;
+    std::vector<WorldBounds> m_instanceBounds;
+    VertexBufferObject m_instanceBuffer;
+
+    // "LightCount" and "LightIndices" uniform locations and array size, for the shader programs with a light array
+    struct LightArrayInfo
+    {
+        GLint lightCountLocation;
+        GLint lightIndicesLocation;
+        unsigned int size;
+    };
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, LightArrayInfo> m_lightArrays;
+
+    // Lights of the frame, at LightBufferBinding
+    std::vector<LightData> m_lightData;
+    ShaderStorageBufferObject m_lightBuffer;
+
+    bool m_instancingEnabled;
+
+    // Indirect commands of the multi-draws, and the buffer where they are uploaded
+    std::vector<Drawcall::ElementsIndirectCommand> m_indirectCommands;
+    DrawIndirectBufferObject m_indirectBuffer;
+
+    bool m_multiDrawEnabled;
+
+    unsigned int m_lastDrawcallCount;
+
     Mesh m_fullscreenMesh;
 
     std::vector<std::unique_ptr<RenderPass>> m_passes;
+
+    // The pool must outlive the graph
+    TexturePool m_texturePool;
+    RenderGraph m_renderGraph;
+
+    RenderPassTimer m_passTimer;
+    bool m_passTimingEnabled;
+
+    // Dynamic resolution, see SetRenderScale
+    int m_renderWidth;
+    int m_renderHeight;
+    float m_renderScale;
 };
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/DepthProgramCache.h>
+#include <ituGL/core/UniformBufferObject.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <memory>
+
+class Camera;
+
+// Cascaded shadow maps for the first directional light, and one shadow map for each of the first spot lights,
+// all of them in tiles of a single depth atlas.
+// Rendering all the casters every frame is too expensive, so each tile keeps a copy with only the static casters.
+// It is only rendered again when the tile moves (the light moves, or the camera leaves the area of a cascade),
+// or when one of its static casters changes. Every frame, the static copy goes to the atlas and the dynamic casters
+// (see Renderer::AddModel) are drawn on top.
+// Casters come from the shadow caster collection of the renderer, with the models culled against the camera too,
+// and each tile keeps the ones inside its own bounds, so the cache doesn't depend on what the camera sees.
+// Shaders read the atlas as a sampler2DShadow, and the matrices from the "ShadowBlock" uniform block
+class ShadowMapRenderPass : public RenderPass
+{
+public:
+    static constexpr unsigned int MaxCascadeCount = 4;
+    static constexpr unsigned int MaxSpotLightCount = 4;
+
+    // Uniform buffer binding index of the shadow block
+    static constexpr GLuint ShadowBlockBinding = 1;
+
+    // Name of the atlas in the render graph
+    static const char* ShadowMapTextureName;
+
+    // Shadow data, as read by the shaders in the "ShadowBlock" uniform block (std140 layout)
+    struct ShadowData
+    {
+        // From world space to the clip space of each cascade, and the tile of the cascade in the atlas,
+        // as texture coordinates offset (xy) and scale (zw)
+        glm::mat4 cascadeMatrices[MaxCascadeCount];
+        glm::vec4 cascadeTiles[MaxCascadeCount];
+
+        // Same for the spot lights, with their position, so shaders can find the shadow of the light they shade
+        glm::mat4 spotLightMatrices[MaxSpotLightCount];
+        glm::vec4 spotLightTiles[MaxSpotLightCount];
+        glm::vec4 spotLightPositions[MaxSpotLightCount];
+
+        // View depth where each cascade ends
+        glm::vec4 cascadeSplits;
+
+        int cascadeCount;
+        int spotLightCount;
+        float padding[2];
+    };
+
+public:
+    ShadowMapRenderPass(int tileSize = 1024, unsigned int cascadeCount = MaxCascadeCount,
+        int drawcallCollectionIndex = Renderer::ShadowCasterCollectionIndex);
+
+    // Depth atlas with all the shadow maps, with comparison enabled for sampler2DShadow
+    inline std::shared_ptr<const Texture2DObject> GetShadowMap() const { return m_shadowMap; }
+    inline std::shared_ptr<Texture2DObject> GetShadowMap() { return m_shadowMap; }
+
+    // Cascades cover the camera view up to this distance. Default: 50
+    inline float GetMaxShadowDistance() const { return m_maxShadowDistance; }
+    inline void SetMaxShadowDistance(float maxShadowDistance) { m_maxShadowDistance = maxShadowDistance; }
+
+    // Depth bias applied when rendering the casters, as in glPolygonOffset. Default: 2, 4
+    inline void SetDepthBias(float slopeScale, float units) { m_depthBiasSlopeScale = slopeScale; m_depthBiasUnits = units; }
+
+    // If disabled, the static casters are rendered every frame, to compare the cost. Default: true
+    inline bool GetCachingEnabled() const { return m_cachingEnabled; }
+    inline void SetCachingEnabled(bool cachingEnabled) { m_cachingEnabled = cachingEnabled; }
+
+    // Tiles with a shadow map in the last frame, and how many of them rendered their static casters again
+    inline unsigned int GetActiveTileCount() const { return m_activeTileCount; }
+    inline unsigned int GetStaticRenderCount() const { return m_staticRenderCount; }
+
+    void Setup(RenderGraph::PassBuilder& builder) override;
+
+    void Render() override;
+
+private:
+    struct Tile
+    {
+        // Light view projection, and the viewport of the tile in the atlas
+        glm::mat4 viewProjMatrix;
+        GLint x, y;
+        bool active;
+
+        // Light space area of a cascade. It doesn't move while the camera stays inside, so the cache stays valid
+        glm::vec3 cascadeDirection;
+        glm::vec3 cascadeCenter;
+        float cascadeRadius;
+
+        // Static casters in the cache: light matrix and hash of the casters when they were rendered
+        bool staticValid;
+        glm::mat4 staticViewProjMatrix;
+        unsigned long long staticHash;
+
+        // The atlas tile has dynamic casters drawn on top of the static ones
+        bool hasDynamic;
+    };
+
+    // Compute the cascades of the directional light, fitted to slices of the camera view
+    void UpdateCascades(const Camera& camera, const glm::vec3& lightDirection);
+
+    // Compute the tiles of the spot lights, and return how many have a shadow
+    unsigned int UpdateSpotLights();
+
+    // Fill the static and dynamic casters of the tile, culled against its bounds.
+    // Returns the hash of the static instances inside the tile
+    unsigned long long CollectCasters(const Tile& tile);
+
+    // Draw the casters to the tile of the framebuffer currently bound
+    void RenderCasters(const Tile& tile, const std::vector<unsigned int>& casters);
+
+    // Hash of the VAO and world matrix of an instance. Added to the hash of the tile, so the order of the instances
+    // and how they are merged in drawcalls don't matter
+    static unsigned long long HashCaster(const VertexArrayObject& vao, const glm::mat4& worldMatrix);
+
+    // The world space AABB can be inside the clip space of the light. The near plane is ignored, casters behind it
+    // are clamped to it, as they can still project shadows
+    static bool IsCasterVisible(const glm::mat4& viewProjMatrix, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Atlas coordinates of the tile, as offset (xy) and scale (zw)
+    glm::vec4 GetTileCoordinates(const Tile& tile) const;
+
+private:
+    int m_drawcallCollectionIndex;
+
+    int m_tileSize;
+    unsigned int m_cascadeCount;
+
+    float m_maxShadowDistance;
+    float m_depthBiasSlopeScale;
+    float m_depthBiasUnits;
+    bool m_cachingEnabled;
+
+    // Cascades first, then spot lights
+    std::vector<Tile> m_tiles;
+
+    int m_atlasWidth;
+    int m_atlasHeight;
+
+    // Atlas read by the shaders, and the copy with only the static casters
+    std::shared_ptr<Texture2DObject> m_shadowMap;
+    Texture2DObject m_staticShadowMap;
+    FramebufferObject m_framebuffer;
+    FramebufferObject m_staticFramebuffer;
+
+    ShadowData m_shadowData;
+    UniformBufferObject m_shadowBuffer;
+
+    // Depth-only shader programs, with the light view projection in a uniform
+    DepthProgramCache m_depthPrograms;
+
+    // Casters of the current tile, as indices in the drawcall collection
+    std::vector<unsigned int> m_staticCasters;
+    std::vector<unsigned int> m_dynamicCasters;
+
+    unsigned int m_activeTileCount;
+    unsigned int m_staticRenderCount;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ituGL/texture/Texture2DObject.h>
+#include <memory>
+#include <vector>
+
+// Pool of 2D textures used as render targets, reused by matching size and format.
+// Textures that are not acquired for a few frames are destroyed, so old sizes don't stay alive after a resize
+class TexturePool
+{
+public:
+    struct TextureDesc
+    {
+        int width;
+        int height;
+        TextureObject::Format format;
+        TextureObject::InternalFormat internalFormat;
+
+        bool operator==(const TextureDesc& other) const = default;
+    };
+
+public:
+    TexturePool();
+
+    // Get a free texture with this description, creating it if there is none. Its content is undefined
+    std::shared_ptr<Texture2DObject> Acquire(const TextureDesc& desc);
+
+    // Return the texture to the pool. It can be acquired again in the same frame
+    void Release(const std::shared_ptr<Texture2DObject>& texture);
+
+    // Destroy the free textures that were not acquired in the last maxUnusedFrames frames. Call it once per frame
+    void EndFrame();
+
+    // Frames a free texture is kept alive without being acquired. Default: 3
+    inline unsigned int GetMaxUnusedFrames() const { return m_maxUnusedFrames; }
+    inline void SetMaxUnusedFrames(unsigned int maxUnusedFrames) { m_maxUnusedFrames = maxUnusedFrames; }
+
+    // Number of textures owned by the pool, acquired or free, and their estimated memory in bytes
+    unsigned int GetTextureCount() const;
+    size_t GetMemorySize() const;
+
+    // Bytes per pixel of the internal format, for the formats used as render targets. 4 if unknown
+    static unsigned int GetPixelSize(TextureObject::InternalFormat internalFormat);
+
+private:
+    struct Entry
+    {
+        TextureDesc desc;
+        std::shared_ptr<Texture2DObject> texture;
+        bool acquired;
+        unsigned long long lastUsedFrame;
+    };
+
+    std::vector<Entry> m_entries;
+
+    unsigned long long m_frame;
+    unsigned int m_maxUnusedFrames;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <string>
+
+// Draws a texture of the render graph to the current framebuffer, reading only the render viewport of the renderer.
+// It is the last pass when rendering at a dynamic resolution, see Renderer::SetRenderScale.
+// Uses "shaders/renderer/upscale.vert" and "shaders/renderer/upscale.frag"
+class UpscaleRenderPass : public RenderPass
+{
+public:
+    enum class Filter
+    {
+        // Plain bilinear filter
+        Bilinear,
+        // Bilinear, sharpened with its neighbors. The result is clamped to the neighbors, so edges don't get halos
+        EdgeAware,
+    };
+
+public:
+    // The texture is scaled to width x height, the size of the output
+    UpscaleRenderPass(const std::string& textureName, int width, int height);
+
+    void SetSize(int width, int height);
+
+    // Default: EdgeAware
+    inline Filter GetFilter() const { return m_filter; }
+    inline void SetFilter(Filter filter) { m_filter = filter; }
+
+    // Amount of sharpening of the EdgeAware filter, from 0 to 1. Default: 0.5
+    inline float GetSharpness() const { return m_sharpness; }
+    inline void SetSharpness(float sharpness) { m_sharpness = sharpness; }
+
+    // Reads the texture, and draws to the current framebuffer
+    void Setup(RenderGraph::PassBuilder& builder) override;
+
+    void Render() override;
+
+private:
+    std::string m_textureName;
+
+    int m_width;
+    int m_height;
+
+    Filter m_filter;
+    float m_sharpness;
+
+    ShaderProgram m_shaderProgram;
+    ShaderProgram::Location m_sourceTextureLocation;
+    ShaderProgram::Location m_sourceScaleLocation;
+    ShaderProgram::Location m_sharpnessLocation;
+};
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <array>
+#include <cassert>
+
+class Camera;
 
 class Bounds
 {
@@ -103,21 +109,34 @@ private:
     glm::vec3 m_size;
 };
 
-class FrustumBounds : public RotatedBounds
+// Volume visible through a view-projection matrix, defined by 6 planes pointing inside
+class FrustumBounds : public Bounds
 {
 public:
-    FrustumBounds(const glm::vec3& center, const glm::vec3& size);
+    enum Plane
+    {
+        Left, Right, Bottom, Top, Near, Far,
+        PlaneCount
+    };
+
+public:
+    FrustumBounds(const glm::mat4& viewProjMatrix);
+    FrustumBounds(const Camera& camera);
 
     inline Type GetType() const override { return Type::Frustum; }
 
+    // Plane as (normal, distance), with normalized normal. A point p is inside if dot(normal, p) + distance >= 0
+    inline const glm::vec4& GetPlane(int plane) const { return m_planes[plane]; }
+
 private:
+    std::array<glm::vec4, PlaneCount> m_planes;
 };
 
 
 template<typename T>
 bool Bounds::Intersects(const T& other) const
 {
-    Bounds::Intersects(this, other);
+    return Bounds::Intersects(*this, other);
 }
 
 template<typename TA, typename TB>
@@ -144,6 +163,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const TB& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <span>
+
+class AabbBounds;
+
+// Occlusion culling on the CPU: a few big occluders (walls, floors...) are rasterized in a small depth buffer,
+// and the bounds of the other models are tested against it. Everything runs on the CPU, without OpenGL,
+// with integer edge functions, so the results are exactly the same on every run.
+// The edge functions of 8 pixels are evaluated at once with AVX2 (CMake option ITUGL_AVX2), or 4 with SSE2,
+// with the same results as the scalar path.
+// Usage, every frame: Begin with the camera, AddOccluder for each occluder, End, and then IsVisible for each model.
+// IsVisible is const, so it can be called from several threads once End has been called
+class OcclusionCuller
+{
+public:
+    OcclusionCuller(int width = 256, int height = 128);
+
+    inline int GetWidth() const { return m_width; }
+    inline int GetHeight() const { return m_height; }
+
+    // If the SIMD rasterizer was compiled in, for this instruction set
+    static bool IsSimdSupported();
+
+    // Rasterize with SIMD, if it is supported. Disable it to compare with the scalar path. Default: true
+    inline bool GetSimdEnabled() const { return m_simdEnabled; }
+    inline void SetSimdEnabled(bool simdEnabled) { m_simdEnabled = simdEnabled && IsSimdSupported(); }
+
+    // Clear the depth buffer, and set the camera used by the occluders and the tests
+    void Begin(const glm::mat4& viewProjMatrix);
+
+    // Rasterize the triangles of an occluder, with indices in groups of 3. Both faces are rasterized
+    void AddOccluder(std::span<const glm::vec3> positions, std::span<const unsigned int> indices, const glm::mat4& worldMatrix);
+
+    // Rasterize a box occluder, from localMin to localMax in the local space of the world matrix
+    void AddOccluderBox(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& worldMatrix);
+
+    // Build the hierarchical depth from the depth buffer. Call it after adding the occluders, before the tests
+    void End();
+
+    // Returns false if the world space AABB is completely behind the occluders. Size is half the extents, as in AabbBounds
+    bool IsVisible(const glm::vec3& center, const glm::vec3& size) const;
+    bool IsVisible(const AabbBounds& bounds) const;
+
+    // Depth in the [0, 1] range, 1 where there are no occluders. Each level halves the size of the previous one,
+    // storing the max depth of the 2x2 pixels it covers
+    inline unsigned int GetLevelCount() const { return static_cast<unsigned int>(m_levels.size()); }
+    float GetDepth(int x, int y, unsigned int level = 0) const;
+
+    // Number of occluder triangles rasterized since Begin, after clipping
+    inline unsigned int GetTriangleCount() const { return m_triangleCount; }
+
+private:
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<float> depths;
+    };
+
+    // Clip the triangle against the near plane and the guard band, then rasterize the resulting polygon
+    void ClipAndRasterize(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2);
+
+    // Rasterize a triangle with vertices in pixel coordinates and depth in [0, 1]
+    void RasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+
+    // Convert clip space to pixel coordinates and depth
+    glm::vec3 ToScreen(const glm::vec4& clip) const;
+
+private:
+    int m_width;
+    int m_height;
+
+    bool m_simdEnabled;
+
+    glm::mat4 m_viewProjMatrix;
+
+    // Level 0 is the depth buffer
+    std::vector<Level> m_levels;
+
+    unsigned int m_triangleCount;
+};
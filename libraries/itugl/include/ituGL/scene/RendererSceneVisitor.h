@@ -1,27 +1,108 @@
 #pragma once
 
 #include <ituGL/scene/SceneVisitor.h>
+#include <glm/mat4x4.hpp>
+#include <vector>
 
 class Renderer;
+class RenderCommandList;
+class FrustumBounds;
 class SceneCamera;
 class SceneLight;
 class SceneModel;
 class Transform;
+class Model;
+class ThreadPool;
+class OcclusionCuller;
 
 class RendererSceneVisitor : public SceneVisitor
 {
 public:
     RendererSceneVisitor(Renderer& renderer);
+    ~RendererSceneVisitor();
 
     void VisitCamera(SceneCamera& sceneCamera) override;
 
     void VisitLight(SceneLight& sceneLight) override;
 
+    // Models are collected and added to the renderer in SubmitModels
     void VisitModel(SceneModel& sceneModel) override;
 
+    // Cull the visited models against the camera frustum and add the visible ones to the renderer
+    // Call it after visiting the scene, so the camera is known
+    void SubmitModels();
+
+    // If set, the visited models are split in contiguous ranges that are culled and recorded in parallel,
+    // each one in its own command list, and then merged in the renderer in order. Default: none
+    inline ThreadPool* GetThreadPool() const { return m_threadPool; }
+    inline void SetThreadPool(ThreadPool* threadPool) { m_threadPool = threadPool; }
+
+    // If enabled, models outside of the camera frustum are not added to the renderer. Default: true
+    inline bool GetFrustumCullingEnabled() const { return m_frustumCullingEnabled; }
+    inline void SetFrustumCullingEnabled(bool enabled) { m_frustumCullingEnabled = enabled; }
+
+    // If set, models inside the frustum are also tested against the occluders of the culler, and the hidden ones
+    // are not added to the renderer. The culler must be ready (End called) before SubmitModels. Default: none
+    inline const OcclusionCuller* GetOcclusionCuller() const { return m_occlusionCuller; }
+    inline void SetOcclusionCuller(const OcclusionCuller* occlusionCuller) { m_occlusionCuller = occlusionCuller; }
+
+    // If enabled, the culled models are still added to the renderer as shadow casters, see Renderer::AddShadowCaster.
+    // Enable it when the renderer has a ShadowMapRenderPass, so models out of the view keep casting shadows. Default: false
+    inline bool GetShadowCastersEnabled() const { return m_shadowCastersEnabled; }
+    inline void SetShadowCastersEnabled(bool enabled) { m_shadowCastersEnabled = enabled; }
+
+    // Number of models added to the renderer and discarded by culling in the last SubmitModels
+    inline unsigned int GetVisibleModelCount() const { return m_visibleModelCount; }
+    inline unsigned int GetCulledModelCount() const { return m_culledModelCount; }
+
+    // Number of models, among the culled ones, that were inside the frustum but hidden by occluders
+    inline unsigned int GetOccludedModelCount() const { return m_occludedModelCount; }
+
 private:
     void VisitTransform(Transform& transform);
 
+    // Compute the world space AABB of the models in the range, filling the SoA bounds
+    void ComputeBounds(unsigned int begin, unsigned int end);
+
+    // Test the bounds of the models in the range against the frustum planes, filling m_visible
+    void CullModels(const FrustumBounds& frustum, unsigned int begin, unsigned int end);
+
+    // Test the models of the range still visible against the occlusion culler. Returns the number of occluded models
+    unsigned int OccludeModels(unsigned int begin, unsigned int end);
+
+    // Add the visible models of the range to the command list, and the culled ones as shadow casters if enabled.
+    // Returns the number of visible models
+    unsigned int RecordModels(RenderCommandList& commandList, unsigned int begin, unsigned int end);
+
 private:
     Renderer& m_renderer;
+
+    bool m_frustumCullingEnabled;
+
+    bool m_shadowCastersEnabled;
+
+    ThreadPool* m_threadPool;
+
+    const OcclusionCuller* m_occlusionCuller;
+
+    // Collected models, with their world matrix
+    std::vector<const Model*> m_models;
+    std::vector<glm::mat4> m_worldMatrices;
+
+    // World space AABB of each model, in SoA layout so the culling loop can be vectorized
+    std::vector<float> m_centersX, m_centersY, m_centersZ;
+    std::vector<float> m_sizesX, m_sizesY, m_sizesZ;
+
+    // Result of the culling, one per model
+    std::vector<unsigned char> m_visible;
+
+    // Visible models recorded by each task
+    std::vector<unsigned int> m_taskVisibleCounts;
+
+    // Models hidden by occluders in each task
+    std::vector<unsigned int> m_taskOccludedCounts;
+
+    unsigned int m_visibleModelCount;
+    unsigned int m_culledModelCount;
+    unsigned int m_occludedModelCount;
 };
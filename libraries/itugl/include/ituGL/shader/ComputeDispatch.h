@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <glm/vec3.hpp>
+#include <memory>
+
+class BufferObject;
+
+// Runs the work groups of a compute shader program, and keeps track of the memory barriers that its writes need.
+// The barriers of a dispatch are issued lazily: before the next dispatch, or when calling Barrier(),
+// so consecutive passes over the same buffers are always in order without a glMemoryBarrier after each one.
+// Requires OpenGL 4.3
+class ComputeDispatch
+{
+public:
+    // The barriers are how the results will be used later, GL_SHADER_STORAGE_BARRIER_BIT by default
+    ComputeDispatch(std::shared_ptr<const ShaderProgram> shaderProgram, GLbitfield barriers = GL_SHADER_STORAGE_BARRIER_BIT);
+
+    inline std::shared_ptr<const ShaderProgram> GetShaderProgram() const { return m_shaderProgram; }
+
+    // Local size declared in the shader
+    inline const glm::uvec3& GetWorkGroupSize() const { return m_workGroupSize; }
+
+    // Barriers needed by the commands that use what this program writes
+    inline GLbitfield GetBarriers() const { return m_barriers; }
+    inline void SetBarriers(GLbitfield barriers) { m_barriers = barriers; }
+
+    // Run a number of work groups. The shader program must be in use, with its uniforms set
+    void Dispatch(unsigned int groupCountX, unsigned int groupCountY = 1, unsigned int groupCountZ = 1) const;
+
+    // Run at least a number of invocations, rounding up to whole work groups. The shader has to skip the extra ones
+    void DispatchInvocations(unsigned int countX, unsigned int countY = 1, unsigned int countZ = 1) const;
+
+    // Run the number of work groups stored in the buffer at an offset, 3 uints that can be written by another shader
+    void DispatchIndirect(const BufferObject& buffer, size_t offset = 0) const;
+
+    // Issue the pending barriers of the previous dispatches, before using their results outside compute shaders
+    static void Barrier();
+
+private:
+    // Issue the pending barriers before the dispatch, and add the ones of this dispatch after it
+    void BeginDispatch() const;
+    void EndDispatch() const;
+
+private:
+    std::shared_ptr<const ShaderProgram> m_shaderProgram;
+
+    glm::uvec3 m_workGroupSize;
+
+    GLbitfield m_barriers;
+
+    // Barriers of the dispatches that have not been issued yet
+    static GLbitfield s_pendingBarriers;
+};
@@ -16,7 +16,8 @@ public:
         NoOverride = 0,
         OverrideBlend = 1 << 0,
         OverrideDepthTest = 1 << 1,
-        OverrideStencilTest = 1 << 2
+        OverrideStencilTest = 1 << 2,
+        OverrideShaderProgram = 1 << 3
     };
 
     // Different conditions for depth and stencil tests
@@ -53,6 +54,11 @@ public:
     bool GetDepthWrite() const;
     void SetDepthWrite(bool depthWrite);
 
+    // If the depth can be rendered first by a depth pre-pass, see ForwardRenderPass::SetDepthPrePassEnabled.
+    // Only for vertex shaders that compute the position exactly like the depth programs of the pre-pass. Default: false
+    bool GetDepthPrePass() const;
+    void SetDepthPrePass(bool depthPrePass);
+
 
     // Set the test function to use for stencil, front and back
     // refValue: the value we compare against
@@ -103,7 +109,7 @@ public:
 
 
     // Use the shader program, set all uniforms, set depth properties, stencil properties, and blending
-    // You can skip depth, stencil or blending using the override flags
+    // You can skip depth, stencil, blending or the shader program (if already in use) using the override flags
     void Use(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
 
 private:
@@ -126,6 +132,9 @@ private:
     // If it should write to depth or not. Default: True
     bool m_depthWrite;
 
+    // If the depth pre-pass can render it. Default: False
+    bool m_depthPrePass;
+
     // Test functions for front and back stencil. Default: Never
     std::array<TestFunction, 2> m_stencilTestFunctions;
 
@@ -90,6 +90,13 @@ public:
     // Get information about a specific uniform
     void GetUniformInfo(unsigned int index, int& size, GLenum& glType, std::span<char> uniformName) const;
 
+    // Find a uniform block index by name. Returns GL_INVALID_INDEX if the block doesn't exist
+    GLuint GetUniformBlockIndex(const char* name) const;
+
+    // Read the uniform block from the uniform buffer bound to the binding index (see UniformBufferObject)
+    // Returns false if the block doesn't exist
+    bool SetUniformBlockBinding(const char* name, GLuint binding) const;
+
     // Template method combinations to simplify getting uniforms
     template<typename T>
     void GetUniform(Location location, T& value) const;
@@ -30,8 +30,18 @@ public:
 
     void SetDrawBuffers(std::span<const Attachment> attachments);
 
-private:
+    // Copy a region from the framebuffer bound to Target::Read to the one bound to Target::Draw
+    // The mask selects the buffers to copy: GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT and/or GL_STENCIL_BUFFER_BIT
+    // Depth and stencil formats must be the same in both framebuffers
+    static void Blit(GLint x, GLint y, GLsizei width, GLsizei height, GLbitfield mask);
+
+    // Framebuffer bound by Unbind, instead of the one of the window. Set it to render everything offscreen,
+    // or nullptr to go back to the window. It must stay alive while it is the default
+    static void SetDefault(const FramebufferObject* framebuffer);
 
+private:
+    // Handle bound by Unbind
+    static Handle s_defaultHandle;
 };
 
 enum class FramebufferObject::Target : GLenum
@@ -44,6 +54,7 @@ enum class FramebufferObject::Target : GLenum
 enum class FramebufferObject::Attachment : GLenum
 {
     Depth = GL_DEPTH_ATTACHMENT,
+    DepthStencil = GL_DEPTH_STENCIL_ATTACHMENT,
     Color0 = GL_COLOR_ATTACHMENT0,
     Color1 = GL_COLOR_ATTACHMENT1,
     Color2 = GL_COLOR_ATTACHMENT2,
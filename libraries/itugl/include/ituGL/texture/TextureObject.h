@@ -127,8 +127,10 @@ protected:
 #endif
 };
 
+#ifndef NDEBUG
 template<TextureObject::Target T>
 Object::Handle TextureObjectBase<T>::s_boundHandle = Object::NullHandle;
+#endif
 
 template<TextureObject::Target T>
 void TextureObjectBase<T>::Bind() const
@@ -267,6 +269,8 @@ enum class TextureObject::ParameterEnum : GLenum
     SwizzleBlue = GL_TEXTURE_SWIZZLE_B,  // GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO, GL_ONE
     SwizzleAlpha = GL_TEXTURE_SWIZZLE_A, // GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO, GL_ONE
     DepthStencilMode = GL_DEPTH_STENCIL_TEXTURE_MODE, // GL_DEPTH_COMPONENT, GL_STENCIL_INDEX
+    CompareMode = GL_TEXTURE_COMPARE_MODE, // GL_NONE, GL_COMPARE_REF_TO_TEXTURE
+    CompareFunction = GL_TEXTURE_COMPARE_FUNC, // GL_LEQUAL, GL_GEQUAL, GL_LESS, GL_GREATER, GL_EQUAL, GL_NOTEQUAL, GL_ALWAYS, GL_NEVER
 };
 
 enum class TextureObject::ParameterEnumVector : GLenum
@@ -1,5 +1,14 @@
 #include <ituGL/application/Application.h>
 
+#include <ituGL/core/Profiler.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/texture/Texture2DObject.h>
+// For the headless frame statistics
+#include <algorithm>
+#include <numeric>
+// For reading the headless settings
+#include <cstdlib>
+#include <cstring>
 // For breaking execution in debug when an unexpected condition is found
 #include <cassert>
 // For accurate application time
@@ -7,9 +16,14 @@
 // For error messages
 #include <iostream>
 
+int Application::s_headlessFrameCount = -1;
+
 // DeviceGL and main Window are constructed in the correct order because they were declared like that!
 Application::Application(int width, int height, const char* title)
-    : m_mainWindow(width, height, title), m_currentTime(0), m_deltaTime(0), m_exitCode(0)
+    : m_headlessFrameCount(GetHeadlessFrameCount())
+    , m_mainWindow(width, height, title, !m_headlessFrameCount, m_headlessFrameCount ? GetHeadlessContextAPI() : Window::ContextAPI::Native)
+    , m_currentTime(0), m_deltaTime(0), m_fixedDeltaTime(0), m_pipelineEnabled(false)
+    , m_simulationUpdateRequested(false), m_simulationStopping(false), m_exitCode(0)
 {
     // If the main window is not valid, exit with error
     if (!m_mainWindow.IsValid())
@@ -26,10 +40,26 @@ Application::Application(int width, int height, const char* title)
         Terminate(-2, "Failed to initialize OpenGL with GLAD");
         return;
     }
+
+    if (const char* fixedDeltaTime = std::getenv("ITUGL_FIXED_DELTA_TIME"))
+    {
+        m_fixedDeltaTime = std::strtof(fixedDeltaTime, nullptr);
+    }
+    if (const char* seed = std::getenv("ITUGL_SEED"))
+    {
+        m_random.SetSeed(std::strtoull(seed, nullptr, 0));
+    }
+
+    if (IsHeadless())
+    {
+        InitializeHeadless();
+    }
 }
 
 Application::~Application()
 {
+    StopSimulationThread();
+
     // If something didn't go as expected, display an error message
     if (m_exitCode)
     {
@@ -42,25 +72,104 @@ int Application::Run()
     // If the application is not in error state, run
     if (!m_exitCode)
     {
-        Initialize();
+        Profiler::SetThreadName("Main");
+
+        // Before Initialize, that may already use the seed and the time step of the log
+        InitializeInputLog();
+
+        {
+            ITUGL_ZONE("Initialize");
+            Initialize();
+        }
 
         // current time when the application started
         auto startTime = std::chrono::steady_clock::now();
 
+        // In pipelined mode, the frame to render was updated and submitted in the previous iteration
+        bool frameSubmitted = false;
+
+        // Input of the first frame
+        UpdateInput();
+
         // Main loop
         while (IsRunning())
         {
-            // set current time relative to start time
-            std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
-            UpdateTime(duration.count());
+            ITUGL_ZONE("Frame");
 
-            Update();
+            auto frameStartTime = std::chrono::steady_clock::now();
 
-            Render();
+            // In serial mode, and the first pipelined frame, update the frame before rendering it
+            if (!frameSubmitted)
+            {
+                // set current time relative to start time
+                std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
+                UpdateTime(duration.count());
+
+                {
+                    ITUGL_ZONE("Update");
+                    Update();
+                }
+                SubmitFrame();
+            }
+
+            // In pipelined mode, update the next frame while this one renders
+            bool pipelined = m_pipelineEnabled;
+            if (pipelined)
+            {
+                std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
+                UpdateTime(duration.count());
+                BeginSimulationUpdate();
+            }
+
+            {
+                ITUGL_ZONE("Render");
+                Render();
+            }
 
             // Swap buffers and poll events at the end of the frame
-            m_mainWindow.SwapBuffers();
+            // Headless frames are not presented. Waiting for the GPU instead makes the frame time include the GPU work
+            {
+                ITUGL_ZONE("SwapBuffers");
+                if (IsHeadless())
+                {
+                    glFinish();
+                }
+                else
+                {
+                    m_mainWindow.SwapBuffers();
+                }
+            }
+
+            // Events are polled and the next frame is submitted while the simulation thread is waiting
+            if (pipelined)
+            {
+                ITUGL_ZONE("WaitUpdate");
+                EndSimulationUpdate();
+            }
             m_device.PollEvents();
+            UpdateInput();
+            if (pipelined)
+            {
+                SubmitFrame();
+            }
+            frameSubmitted = pipelined;
+
+            if (IsHeadless())
+            {
+                std::chrono::duration<float> frameTime = std::chrono::steady_clock::now() - frameStartTime;
+                EndHeadlessFrame(frameTime.count());
+            }
+        }
+
+        StopSimulationThread();
+
+        m_mainWindow.SetReplayInputState(nullptr);
+        m_inputLog.Stop();
+
+        if (IsHeadless())
+        {
+            std::chrono::duration<float> totalTime = std::chrono::steady_clock::now() - startTime;
+            PrintHeadlessStatistics(totalTime.count());
         }
 
         Cleanup();
@@ -82,6 +191,10 @@ void Application::Update()
     }
 }
 
+void Application::SubmitFrame()
+{
+}
+
 void Application::Render()
 {
 }
@@ -112,10 +225,235 @@ void Application::Terminate(int exitCode, const char* errorMessage)
 
 void Application::UpdateTime(float newCurrentTime)
 {
+    // With a fixed time step, the real time is ignored
+    if (m_fixedDeltaTime > 0.0f)
+    {
+        newCurrentTime = m_currentTime + m_fixedDeltaTime;
+    }
+
     m_deltaTime = newCurrentTime - m_currentTime;
     m_currentTime = newCurrentTime;
 }
 
+void Application::BeginSimulationUpdate()
+{
+    if (!m_simulationThread.joinable())
+    {
+        m_simulationThread = std::thread(&Application::SimulationLoop, this);
+    }
+
+    std::lock_guard<std::mutex> lock(m_simulationMutex);
+    m_simulationUpdateRequested = true;
+    m_simulationCondition.notify_all();
+}
+
+void Application::EndSimulationUpdate()
+{
+    std::unique_lock<std::mutex> lock(m_simulationMutex);
+    m_simulationCondition.wait(lock, [this]() { return !m_simulationUpdateRequested; });
+}
+
+void Application::StopSimulationThread()
+{
+    if (!m_simulationThread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_simulationMutex);
+        m_simulationStopping = true;
+        m_simulationCondition.notify_all();
+    }
+    m_simulationThread.join();
+    m_simulationStopping = false;
+}
+
+void Application::SimulationLoop()
+{
+    Profiler::SetThreadName("Simulation");
+
+    std::unique_lock<std::mutex> lock(m_simulationMutex);
+    while (true)
+    {
+        // A requested update always runs, so EndSimulationUpdate doesn't wait forever
+        m_simulationCondition.wait(lock, [this]() { return m_simulationUpdateRequested || m_simulationStopping; });
+        if (!m_simulationUpdateRequested)
+        {
+            break;
+        }
+
+        lock.unlock();
+        {
+            ITUGL_ZONE("Update");
+            Update();
+        }
+        lock.lock();
+
+        m_simulationUpdateRequested = false;
+        m_simulationCondition.notify_all();
+    }
+}
+
+void Application::SetHeadless(bool headless, unsigned int frameCount)
+{
+    s_headlessFrameCount = headless ? static_cast<int>(std::max(frameCount, 1u)) : 0;
+}
+
+void Application::InitializeInputLog()
+{
+    if (const char* path = std::getenv("ITUGL_REPLAY_INPUT"))
+    {
+        InputLog::Header header;
+        if (!m_inputLog.StartReplay(path, header))
+        {
+            std::cout << "Error: failed to open the input log " << path << std::endl;
+            return;
+        }
+
+        // Same random numbers and frame times as the recording
+        m_random.SetSeed(header.seed);
+        m_fixedDeltaTime = header.deltaTime;
+        std::cout << "Replaying input from " << path << std::endl;
+    }
+    else if (const char* path = std::getenv("ITUGL_RECORD_INPUT"))
+    {
+        // Recorded frames are only meaningful with the same time step
+        if (m_fixedDeltaTime <= 0.0f)
+        {
+            m_fixedDeltaTime = DefaultFixedDeltaTime;
+        }
+
+        if (!m_inputLog.StartRecording(path, InputLog::Header{ m_random.GetSeed(), m_fixedDeltaTime }))
+        {
+            std::cout << "Error: failed to create the input log " << path << std::endl;
+            return;
+        }
+        std::cout << "Recording input to " << path << std::endl;
+    }
+}
+
+void Application::UpdateInput()
+{
+    // Cursor changes made by Update, that couldn't call GLFW
+    m_mainWindow.ApplyInputChanges();
+
+    // Real input, instead of the state of the last frame
+    m_mainWindow.SetReplayInputState(nullptr);
+
+    if (m_inputLog.IsReplaying())
+    {
+        if (!m_inputLog.ReplayFrame(m_inputState))
+        {
+            std::cout << "Replayed " << m_inputLog.GetFrameCount() << " frames of input" << std::endl;
+            Close();
+        }
+        m_mainWindow.GetDimensions(m_inputState.width, m_inputState.height);
+    }
+    else
+    {
+        m_mainWindow.GetInputState(m_inputState);
+
+        // Update reads the same state that is recorded, so replaying the log runs exactly the same frames
+        if (m_inputLog.IsRecording())
+        {
+            m_inputLog.RecordFrame(m_inputState);
+        }
+    }
+
+    // GLFW can only be used from the main thread. In pipelined mode, Update runs in the simulation thread
+    // while this thread polls the events, so it reads the input of the frame from this copy
+    m_mainWindow.SetReplayInputState(&m_inputState);
+}
+
+unsigned int Application::GetHeadlessFrameCount()
+{
+    if (s_headlessFrameCount >= 0)
+    {
+        return s_headlessFrameCount;
+    }
+
+    const char* value = std::getenv("ITUGL_HEADLESS");
+    if (!value || !*value)
+    {
+        return 0;
+    }
+
+    // Any value that is not a number, like "on", enables it with the default frame count
+    char* end;
+    unsigned long frameCount = std::strtoul(value, &end, 10);
+    return *end ? DefaultHeadlessFrameCount : static_cast<unsigned int>(frameCount);
+}
+
+Window::ContextAPI Application::GetHeadlessContextAPI()
+{
+    const char* value = std::getenv("ITUGL_HEADLESS_CONTEXT");
+    if (value && std::strcmp(value, "egl") == 0)
+    {
+        return Window::ContextAPI::EGL;
+    }
+    else if (value && std::strcmp(value, "osmesa") == 0)
+    {
+        return Window::ContextAPI::OSMesa;
+    }
+    return Window::ContextAPI::Native;
+}
+
+void Application::InitializeHeadless()
+{
+    int width, height;
+    m_mainWindow.GetDimensions(width, height);
+
+    // Same formats as the window, so blits to the default framebuffer still work
+    m_offscreenColorTexture = std::make_unique<Texture2DObject>();
+    m_offscreenColorTexture->Bind();
+    m_offscreenColorTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8);
+    m_offscreenDepthTexture = std::make_unique<Texture2DObject>();
+    m_offscreenDepthTexture->Bind();
+    m_offscreenDepthTexture->SetImage(0, width, height, TextureObject::FormatDepthStencil, TextureObject::InternalFormatDepth24Stencil8);
+    Texture2DObject::Unbind();
+
+    m_offscreenFramebuffer = std::make_unique<FramebufferObject>();
+    m_offscreenFramebuffer->Bind();
+    m_offscreenFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_offscreenColorTexture);
+    m_offscreenFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::DepthStencil, *m_offscreenDepthTexture);
+    assert(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    // Everything that draws to the window draws here instead
+    FramebufferObject::SetDefault(m_offscreenFramebuffer.get());
+    m_device.SetViewport(0, 0, width, height);
+
+    m_headlessFrameTimes.reserve(m_headlessFrameCount);
+    std::cout << "Headless: rendering " << m_headlessFrameCount << " frames of " << width << "x" << height << std::endl;
+}
+
+void Application::EndHeadlessFrame(float frameTime)
+{
+    m_headlessFrameTimes.push_back(frameTime);
+    if (m_headlessFrameTimes.size() >= m_headlessFrameCount)
+    {
+        Close();
+    }
+}
+
+void Application::PrintHeadlessStatistics(float totalTime) const
+{
+    if (m_headlessFrameTimes.empty())
+    {
+        return;
+    }
+
+    std::vector<float> frameTimes = m_headlessFrameTimes;
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&](float p) { return frameTimes[static_cast<size_t>(p * (frameTimes.size() - 1) + 0.5f)] * 1000.0f; };
+    float mean = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0f) / frameTimes.size() * 1000.0f;
+
+    std::cout << "Headless: " << frameTimes.size() << " frames in " << totalTime << " s (" << frameTimes.size() / totalTime << " fps)" << std::endl;
+    std::cout << "Frame time (ms): mean " << mean << ", min " << frameTimes.front() * 1000.0f
+        << ", median " << percentile(0.5f) << ", p95 " << percentile(0.95f) << ", p99 " << percentile(0.99f)
+        << ", max " << frameTimes.back() * 1000.0f << std::endl;
+}
+
 bool Application::IsRunning() const
 {
     // Run while the window is valid and it has not been requested to close
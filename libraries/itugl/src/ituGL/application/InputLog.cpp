@@ -0,0 +1,212 @@
+#include <ituGL/application/InputLog.h>
+
+#include <cassert>
+#include <vector>
+
+namespace
+{
+    // "ITIL" in the file, and version of the format
+    constexpr std::uint32_t Magic = 0x4c495449u;
+    constexpr std::uint32_t Version = 1;
+}
+
+InputLog::InputLog() : m_frameCount(0)
+{
+}
+
+bool InputLog::StartRecording(const char* path, const Header& header)
+{
+    Stop();
+
+    m_output.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_output)
+    {
+        return false;
+    }
+
+    Write(Magic);
+    Write(Version);
+    Write(header.seed);
+    Write(header.deltaTime);
+    return true;
+}
+
+bool InputLog::StartReplay(const char* path, Header& header)
+{
+    Stop();
+
+    m_input.open(path, std::ios::binary);
+    std::uint32_t magic = 0, version = 0;
+    if (!m_input || !Read(magic) || !Read(version) || magic != Magic || version != Version
+        || !Read(header.seed) || !Read(header.deltaTime))
+    {
+        m_input.close();
+        return false;
+    }
+    return true;
+}
+
+void InputLog::Stop()
+{
+    m_output.close();
+    m_input.close();
+    m_state = Window::InputState();
+    m_frameCount = 0;
+}
+
+void InputLog::RecordFrame(const Window::InputState& state)
+{
+    assert(IsRecording());
+
+    // Keys and buttons are rarely more than a few at a time, so we just write the ones that changed
+    std::vector<std::uint16_t> changedKeys;
+    for (std::size_t keyCode = 0; keyCode < state.keys.size(); ++keyCode)
+    {
+        if (state.keys[keyCode] != m_state.keys[keyCode])
+        {
+            changedKeys.push_back(static_cast<std::uint16_t>(keyCode));
+        }
+    }
+    std::vector<std::uint8_t> changedButtons;
+    for (std::size_t button = 0; button < state.mouseButtons.size(); ++button)
+    {
+        if (state.mouseButtons[button] != m_state.mouseButtons[button])
+        {
+            changedButtons.push_back(static_cast<std::uint8_t>(button));
+        }
+    }
+    bool mouseMoved = state.mousePosition != m_state.mousePosition;
+
+    WriteCount(static_cast<unsigned int>(changedKeys.size() + changedButtons.size() + (mouseMoved ? 1 : 0)));
+    for (std::uint16_t keyCode : changedKeys)
+    {
+        Write(state.keys[keyCode] ? EventType::KeyPressed : EventType::KeyReleased);
+        Write(keyCode);
+    }
+    for (std::uint8_t button : changedButtons)
+    {
+        Write(state.mouseButtons[button] ? EventType::MouseButtonPressed : EventType::MouseButtonReleased);
+        Write(button);
+    }
+    if (mouseMoved)
+    {
+        Write(EventType::MouseMoved);
+        Write(state.mousePosition.x);
+        Write(state.mousePosition.y);
+    }
+
+    m_state = state;
+    ++m_frameCount;
+}
+
+bool InputLog::ReplayFrame(Window::InputState& inputState)
+{
+    assert(IsReplaying());
+
+    bool replayed = ReadFrame();
+
+    // The last state keeps being replayed, even after the end of the log
+    inputState.keys = m_state.keys;
+    inputState.mouseButtons = m_state.mouseButtons;
+    inputState.mousePosition = m_state.mousePosition;
+    return replayed;
+}
+
+bool InputLog::ReadFrame()
+{
+    unsigned int eventCount;
+    if (!ReadCount(eventCount))
+    {
+        return false;
+    }
+
+    for (unsigned int eventIndex = 0; eventIndex < eventCount; ++eventIndex)
+    {
+        EventType type;
+        if (!Read(type))
+        {
+            return false;
+        }
+
+        bool valid = false;
+        switch (type)
+        {
+        case EventType::KeyReleased:
+        case EventType::KeyPressed:
+        {
+            std::uint16_t keyCode;
+            valid = Read(keyCode) && keyCode < m_state.keys.size();
+            if (valid)
+            {
+                m_state.keys.set(keyCode, type == EventType::KeyPressed);
+            }
+            break;
+        }
+        case EventType::MouseButtonReleased:
+        case EventType::MouseButtonPressed:
+        {
+            std::uint8_t button;
+            valid = Read(button) && button < m_state.mouseButtons.size();
+            if (valid)
+            {
+                m_state.mouseButtons.set(button, type == EventType::MouseButtonPressed);
+            }
+            break;
+        }
+        case EventType::MouseMoved:
+            valid = Read(m_state.mousePosition.x) && Read(m_state.mousePosition.y);
+            break;
+        }
+
+        // Stop at the first corrupted event, instead of replaying garbage
+        if (!valid)
+        {
+            return false;
+        }
+    }
+
+    ++m_frameCount;
+    return true;
+}
+
+// Values are written in the byte order of the machine. Logs are meant to be replayed where they were recorded
+template<typename T>
+void InputLog::Write(const T& value)
+{
+    m_output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool InputLog::Read(T& value)
+{
+    return static_cast<bool>(m_input.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void InputLog::WriteCount(unsigned int count)
+{
+    while (count >= 0x80)
+    {
+        Write(static_cast<std::uint8_t>(count | 0x80));
+        count >>= 7;
+    }
+    Write(static_cast<std::uint8_t>(count));
+}
+
+bool InputLog::ReadCount(unsigned int& count)
+{
+    count = 0;
+    for (unsigned int shift = 0; shift < 32; shift += 7)
+    {
+        std::uint8_t byte;
+        if (!Read(byte))
+        {
+            return false;
+        }
+        count |= static_cast<unsigned int>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,15 +1,26 @@
 #include <ituGL/application/Window.h>
 
 // Create the internal GLFW window. We provide some hints about it to OpenGL
-Window::Window(int width, int height, const char* title) : m_window(nullptr)
+Window::Window(int width, int height, const char* title, bool visible, ContextAPI contextAPI) : m_window(nullptr), m_replayInputState(nullptr)
+    , m_cursorMode(GLFW_CURSOR_NORMAL), m_cursorModeChanged(false), m_cursorPosition(0.0f), m_cursorPositionChanged(false)
 {
     // Set some hints for window creation
+    // Ask for OpenGL 4.3, needed for compute shaders and shader storage buffers
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, static_cast<int>(contextAPI));
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
     m_window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+
+    // Some platforms (macOS) stop at OpenGL 4.1. Features that require 4.3 will not be available there
+    if (!m_window)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        m_window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    }
 }
 
 // If we have an internal GLFW window, destroy it
@@ -24,6 +35,12 @@ Window::~Window()
 // Get the current dimensions (width and height) of the window
 void Window::GetDimensions(int& width, int& height) const
 {
+    if (m_replayInputState)
+    {
+        width = m_replayInputState->width;
+        height = m_replayInputState->height;
+        return;
+    }
     glfwGetWindowSize(m_window, &width, &height);
 }
 
@@ -55,30 +72,50 @@ void Window::SwapBuffers()
 
 Window::PressedState Window::GetKeyState(int keyCode) const
 {
+    if (m_replayInputState)
+    {
+        return m_replayInputState->keys.test(keyCode) ? PressedState::Pressed : PressedState::Released;
+    }
     return static_cast<PressedState>(glfwGetKey(m_window, keyCode));
 }
 
 Window::PressedState Window::GetMouseButtonState(MouseButton button) const
 {
+    if (m_replayInputState)
+    {
+        return m_replayInputState->mouseButtons.test(static_cast<int>(button)) ? PressedState::Pressed : PressedState::Released;
+    }
     return static_cast<PressedState>(glfwGetMouseButton(m_window, static_cast<int>(button)));
 }
 
 bool Window::IsMouseVisible() const
 {
-    return glfwGetInputMode(m_window, GLFW_CURSOR) == GLFW_CURSOR_NORMAL;
+    return m_cursorMode == GLFW_CURSOR_NORMAL;
 }
 
 void Window::SetMouseVisible(bool visible) const
 {
-    glfwSetInputMode(m_window, GLFW_CURSOR, visible ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+    m_cursorMode = visible ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED;
+    m_cursorModeChanged = true;
+    if (!m_replayInputState)
+    {
+        ApplyInputChanges();
+    }
 }
 
 glm::vec2 Window::GetMousePosition(bool normalized) const
 {
-    double x, y;
-    glfwGetCursorPos(m_window, &x, &y);
-
-    glm::vec2 mousePosition(static_cast<float>(x), static_cast<float>(y));
+    glm::vec2 mousePosition;
+    if (m_replayInputState)
+    {
+        mousePosition = m_replayInputState->mousePosition;
+    }
+    else
+    {
+        double x, y;
+        glfwGetCursorPos(m_window, &x, &y);
+        mousePosition = glm::vec2(static_cast<float>(x), static_cast<float>(y));
+    }
 
     if (normalized)
     {
@@ -100,5 +137,47 @@ void Window::SetMousePosition(glm::vec2 mousePosition, bool normalized) const
         mousePosition.y = (mousePosition.y * 0.5f - 0.5f) * -height;
     }
 
-    glfwSetCursorPos(m_window, mousePosition.x, mousePosition.y);
+    m_cursorPosition = mousePosition;
+    m_cursorPositionChanged = true;
+    if (!m_replayInputState)
+    {
+        ApplyInputChanges();
+    }
+}
+
+void Window::ApplyInputChanges() const
+{
+    if (m_cursorModeChanged)
+    {
+        glfwSetInputMode(m_window, GLFW_CURSOR, m_cursorMode);
+        m_cursorModeChanged = false;
+    }
+
+    // The replayed state is not changed: recorded positions already include the changes made while recording
+    if (m_cursorPositionChanged)
+    {
+        glfwSetCursorPos(m_window, m_cursorPosition.x, m_cursorPosition.y);
+        m_cursorPositionChanged = false;
+    }
+}
+
+void Window::GetInputState(InputState& inputState) const
+{
+    // glfwGetKey only accepts the key codes from GLFW_KEY_SPACE, lower ones are not keys
+    inputState.keys.reset();
+    for (int keyCode = GLFW_KEY_SPACE; keyCode <= GLFW_KEY_LAST; ++keyCode)
+    {
+        inputState.keys.set(keyCode, glfwGetKey(m_window, keyCode) == GLFW_PRESS);
+    }
+
+    for (int button = 0; button <= GLFW_MOUSE_BUTTON_LAST; ++button)
+    {
+        inputState.mouseButtons.set(button, glfwGetMouseButton(m_window, button) == GLFW_PRESS);
+    }
+
+    double x, y;
+    glfwGetCursorPos(m_window, &x, &y);
+    inputState.mousePosition = glm::vec2(static_cast<float>(x), static_cast<float>(y));
+
+    glfwGetWindowSize(m_window, &inputState.width, &inputState.height);
 }
@@ -3,6 +3,7 @@
 #include <ituGL/geometry/VertexFormat.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/core/Profiler.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -39,6 +40,16 @@ void ModelLoader::SetCreateMaterials(bool createMaterials)
     m_createMaterials = createMaterials;
 }
 
+std::shared_ptr<GeometryPool> ModelLoader::GetGeometryPool() const
+{
+    return m_geometryPool;
+}
+
+void ModelLoader::SetGeometryPool(std::shared_ptr<GeometryPool> geometryPool)
+{
+    m_geometryPool = geometryPool;
+}
+
 Texture2DLoader& ModelLoader::GetTexture2DLoader()
 {
     return m_textureLoader;
@@ -75,12 +86,13 @@ bool ModelLoader::SetMaterialProperty(MaterialProperty materialProperty, const c
 
 Model ModelLoader::Load(const char* path)
 {
+    ITUGL_ZONE("ModelLoader::Load");
     Model model;
 
     // Read the file using Assimp importer
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path,
-        aiProcess_CalcTangentSpace | aiProcess_GenNormals | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
+        aiProcess_CalcTangentSpace | aiProcess_GenNormals | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType | aiProcess_GenBoundingBoxes);
 
     m_baseFolder = path;
     m_baseFolder.resize(m_baseFolder.rfind('/') + 1);
@@ -95,6 +107,9 @@ Model ModelLoader::Load(const char* path)
             aiMesh& meshData = *scene->mMeshes[meshIndex];
             GenerateSubmesh(mesh, meshData);
 
+            const aiAABB& bounds = meshData.mAABB;
+            mesh.AddBounds(glm::vec3(bounds.mMin.x, bounds.mMin.y, bounds.mMin.z), glm::vec3(bounds.mMax.x, bounds.mMax.y, bounds.mMax.z));
+
             std::shared_ptr<Material> material = m_referenceMaterial;
             if (m_createMaterials)
             {
@@ -114,24 +129,42 @@ void ModelLoader::GenerateSubmesh(Mesh& mesh, const aiMesh& meshData)
     VertexFormat vertexFormat;
     bool interleaved = true;
     std::vector<GLubyte> vertexData = CollectVertexData(meshData, vertexFormat, interleaved);
-    int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
 
-    // Collect element data
-    Data::Type elementType;
+    // Collect element data. The pool needs its own element type
+    Data::Type elementType = m_geometryPool ? m_geometryPool->GetElementType() : Data::Type::None;
     std::vector<Drawcall::Primitive> primitives;
     std::vector<int> elementCounts;
     std::vector<GLubyte> elementData = CollectElementData(meshData, elementType, primitives, elementCounts);
-    int eboIndex = mesh.AddElementData<GLubyte>(elementData);
+    int elementSize = Data::GetTypeSize(elementType);
 
-    // Add submeshes
-    int start = 0;
+    // Add submeshes. Element counts are in bytes
     assert(primitives.size() == elementCounts.size());
-    for (int i = 0; i < primitives.size(); ++i)
+    if (m_geometryPool)
     {
-        Drawcall::Primitive primitive = primitives[i];
-        int end = elementCounts[i];
-        mesh.AddSubmesh(primitive, start, end - start, elementType, eboIndex, vboIndex, vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
-        start = end;
+        GeometryPool::Handle handle = mesh.AddPoolData(m_geometryPool, vertexFormat, m_materialAttributeMap,
+            Data::GetBytes(std::span<const GLubyte>(vertexData)), Data::GetBytes(std::span<const GLubyte>(elementData)));
+
+        int start = 0;
+        for (unsigned int i = 0; i < primitives.size(); ++i)
+        {
+            int end = elementCounts[i];
+            mesh.AddPoolSubmesh(handle, primitives[i], start / elementSize, (end - start) / elementSize);
+            start = end;
+        }
+    }
+    else
+    {
+        int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
+        int eboIndex = mesh.AddElementData<GLubyte>(elementData);
+
+        int start = 0;
+        for (unsigned int i = 0; i < primitives.size(); ++i)
+        {
+            Drawcall::Primitive primitive = primitives[i];
+            int end = elementCounts[i];
+            mesh.AddSubmesh(primitive, start, (end - start) / elementSize, elementType, vboIndex, eboIndex, vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
+            start = end;
+        }
     }
 }
 
@@ -258,7 +291,10 @@ std::vector<GLubyte> ModelLoader::CollectElementData(const aiMesh& meshData, Dat
 {
     std::vector<GLubyte> elementData;
 
-    elementType = ElementBufferObject::GetSmallestType(meshData.mNumVertices);
+    if (elementType == Data::Type::None)
+    {
+        elementType = ElementBufferObject::GetSmallestType(meshData.mNumVertices);
+    }
     int elementSize = Data::GetTypeSize(elementType);
 
     //Reserve max possible size
@@ -1,5 +1,6 @@
 #include <ituGL/asset/ShaderLoader.h>
 
+#include <ituGL/core/Profiler.h>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -75,6 +76,7 @@ bool ShaderLoader::LoadInto(Shader& shader, std::span<const char*> paths)
 
 void ShaderLoader::Compile(Shader& shader)
 {
+    ITUGL_ZONE("ShaderLoader::Compile");
     if (!shader.Compile())
     {
         std::array<char, 512> infoLog;
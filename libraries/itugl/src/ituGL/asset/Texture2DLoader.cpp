@@ -1,4 +1,5 @@
 #include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/core/Profiler.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -16,6 +17,7 @@ Texture2DLoader::Texture2DLoader(TextureObject::Format format, TextureObject::In
 
 Texture2DObject Texture2DLoader::Load(const char* path)
 {
+    ITUGL_ZONE("Texture2DLoader::Load");
     Texture2DObject texture2D;
 
     // Set flip vertical on load if needed
@@ -1,5 +1,6 @@
 #include <ituGL/core/BufferObject.h>
 
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 // Create the object initially null, get object handle and generate 1 buffer
@@ -13,6 +14,10 @@ BufferObject::BufferObject() : Object(NullHandle)
 BufferObject::~BufferObject()
 {
     Handle& handle = GetHandle();
+    if (handle != NullHandle && DeviceGL::GetInstancePointer())
+    {
+        DeviceGL::GetInstance().ForgetBuffer(handle);
+    }
     glDeleteBuffers(1, &handle);
 }
 
@@ -30,14 +35,28 @@ BufferObject& BufferObject::operator = (BufferObject&& bufferObject) noexcept
 void BufferObject::Bind(Target target) const
 {
     Handle handle = GetHandle();
-    glBindBuffer(target, handle);
+    DeviceGL::GetInstance().BindBuffer(target, handle);
 }
 
 // Bind the null handle to the specific target
 void BufferObject::Unbind(Target target)
 {
     Handle handle = NullHandle;
-    glBindBuffer(target, handle);
+    DeviceGL::GetInstance().BindBuffer(target, handle);
+}
+
+// Bind the buffer handle to the indexed binding point of the target
+void BufferObject::BindBase(GLuint index) const
+{
+    Handle handle = GetHandle();
+    DeviceGL::GetInstance().BindBufferBase(GetTarget(), index, handle);
+}
+
+// Bind the buffer handle to the indexed binding point of the other target
+void BufferObject::BindBase(Target target, GLuint index) const
+{
+    Handle handle = GetHandle();
+    DeviceGL::GetInstance().BindBufferBase(target, index, handle);
 }
 
 // Get buffer Target and allocate buffer data
@@ -56,6 +75,31 @@ void BufferObject::AllocateData(std::span<const std::byte> data, Usage usage)
     glBufferData(target, data.size_bytes(), data.data(), usage);
 }
 
+// Get buffer Target and allocate immutable storage
+void BufferObject::AllocateStorage(size_t size, GLbitfield flags)
+{
+    assert(IsBound());
+    assert(GLAD_GL_VERSION_4_4);
+    Target target = GetTarget();
+    glBufferStorage(target, size, nullptr, flags);
+}
+
+// Get buffer Target and map the range
+void* BufferObject::MapRange(size_t offset, size_t size, GLbitfield access)
+{
+    assert(IsBound());
+    Target target = GetTarget();
+    return glMapBufferRange(target, offset, size, access);
+}
+
+// Get buffer Target and unmap it
+void BufferObject::Unmap()
+{
+    assert(IsBound());
+    Target target = GetTarget();
+    glUnmapBuffer(target);
+}
+
 // Get buffer Target and set buffer subdata
 void BufferObject::UpdateData(std::span<const std::byte> data, size_t offset)
 {
@@ -63,3 +107,12 @@ void BufferObject::UpdateData(std::span<const std::byte> data, size_t offset)
     Target target = GetTarget();
     glBufferSubData(target, offset, data.size_bytes(), data.data());
 }
+
+// Bind the buffers to the copy targets, so no other target is modified
+void BufferObject::CopyData(const BufferObject& srcBuffer, size_t srcOffset, BufferObject& dstBuffer, size_t dstOffset, size_t size)
+{
+    DeviceGL& device = DeviceGL::GetInstance();
+    device.BindBuffer(GL_COPY_READ_BUFFER, srcBuffer.GetHandle());
+    device.BindBuffer(GL_COPY_WRITE_BUFFER, dstBuffer.GetHandle());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffset, dstOffset, size);
+}
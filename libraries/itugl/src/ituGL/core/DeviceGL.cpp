@@ -31,6 +31,9 @@ void DeviceGL::SetCurrentWindow(Window& window)
     // Load required GL libraries and initialize the context
     m_contextLoaded = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
 
+    // New context, nothing is known about its state
+    InvalidateState();
+
     if (m_contextLoaded)
     {
         // Set callback to be called when the window is resized
@@ -41,7 +44,18 @@ void DeviceGL::SetCurrentWindow(Window& window)
 // Set the dimensions of the viewport
 void DeviceGL::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 {
-    glViewport(0, 0, width, height);
+    glViewport(x, y, width, height);
+}
+
+// Get the dimensions of the viewport
+void DeviceGL::GetViewport(GLint& x, GLint& y, GLsizei& width, GLsizei& height) const
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    x = viewport[0];
+    y = viewport[1];
+    width = viewport[2];
+    height = viewport[3];
 }
 
 // Poll the events in the window event queue
@@ -85,12 +99,20 @@ void DeviceGL::Clear(bool clearColor, const Color& color, bool clearDepth, GLdou
 // Get if a feature is enabled
 bool DeviceGL::IsFeatureEnabled(GLenum feature) const
 {
-    return glIsEnabled(feature);
+    auto itFind = m_features.find(feature);
+    return itFind != m_features.end() ? itFind->second : glIsEnabled(feature);
 }
 
 // enable / disable a feature
 void DeviceGL::SetFeatureEnabled(GLenum feature, bool enabled)
 {
+    auto [it, inserted] = m_features.try_emplace(feature, enabled);
+    if (!inserted && it->second == enabled)
+    {
+        return;
+    }
+    it->second = enabled;
+
     if (enabled)
     {
         glEnable(feature);
@@ -112,3 +134,290 @@ void DeviceGL::SetVSyncEnabled(bool enabled)
 {
     glfwSwapInterval(enabled ? 1 : 0);
 }
+
+// Set the shader program in use
+void DeviceGL::UseShaderProgram(GLuint shaderProgram)
+{
+    if (m_shaderProgram != shaderProgram)
+    {
+        glUseProgram(shaderProgram);
+        m_shaderProgram = shaderProgram;
+    }
+}
+
+// Bind a vertex array. It also changes the element array buffer binding
+void DeviceGL::BindVertexArray(GLuint vertexArray)
+{
+    if (m_vertexArray != vertexArray)
+    {
+        glBindVertexArray(vertexArray);
+        m_vertexArray = vertexArray;
+
+        // The element array buffer is part of the vertex array state
+        m_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+}
+
+// Bind a buffer to the target
+void DeviceGL::BindBuffer(GLenum target, GLuint buffer)
+{
+    auto [it, inserted] = m_buffers.try_emplace(target, buffer);
+    if (inserted || it->second != buffer)
+    {
+        glBindBuffer(target, buffer);
+        it->second = buffer;
+    }
+}
+
+// Bind a buffer to an indexed binding point of the target. It also changes the binding of the target
+void DeviceGL::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    unsigned long long key = (static_cast<unsigned long long>(index) << 32) | target;
+    auto [it, inserted] = m_indexedBuffers.try_emplace(key, buffer);
+    if (inserted || it->second != buffer)
+    {
+        glBindBufferBase(target, index, buffer);
+        it->second = buffer;
+        m_buffers[target] = buffer;
+    }
+}
+
+// Set the active texture unit, as an index starting at 0
+void DeviceGL::SetActiveTextureUnit(GLint textureUnit)
+{
+    if (m_activeTextureUnit != textureUnit)
+    {
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        m_activeTextureUnit = textureUnit;
+    }
+}
+
+// Bind a texture to the target of the active texture unit
+void DeviceGL::BindTexture(GLenum target, GLuint texture)
+{
+    // If we don't know the active unit, we can't know what is bound
+    if (!m_activeTextureUnit)
+    {
+        glBindTexture(target, texture);
+        return;
+    }
+
+    unsigned long long key = (static_cast<unsigned long long>(*m_activeTextureUnit) << 32) | target;
+    auto [it, inserted] = m_textures.try_emplace(key, texture);
+    if (inserted || it->second != texture)
+    {
+        glBindTexture(target, texture);
+        it->second = texture;
+    }
+}
+
+// Set the depth test function
+void DeviceGL::SetDepthFunction(GLenum function)
+{
+    if (m_depthFunction != function)
+    {
+        glDepthFunc(function);
+        m_depthFunction = function;
+    }
+}
+
+// Enable / disable writing to the depth buffer
+void DeviceGL::SetDepthWrite(bool depthWrite)
+{
+    if (m_depthWrite != depthWrite)
+    {
+        glDepthMask(depthWrite ? GL_TRUE : GL_FALSE);
+        m_depthWrite = depthWrite;
+    }
+}
+
+// Enable / disable writing to the color buffer, all components at once
+void DeviceGL::SetColorWrite(bool colorWrite)
+{
+    if (m_colorWrite != colorWrite)
+    {
+        GLboolean mask = colorWrite ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+        m_colorWrite = colorWrite;
+    }
+}
+
+// Set the faces culled when GL_CULL_FACE is enabled
+void DeviceGL::SetCullFace(GLenum face)
+{
+    if (m_cullFace != face)
+    {
+        glCullFace(face);
+        m_cullFace = face;
+    }
+}
+
+// Set the stencil test function. Face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+void DeviceGL::SetStencilFunction(GLenum face, GLenum function, GLint refValue, GLuint mask)
+{
+    StencilFunction stencilFunction{ function, refValue, mask };
+    bool front = face != GL_BACK && m_stencilFunctions[0] != stencilFunction;
+    bool back = face != GL_FRONT && m_stencilFunctions[1] != stencilFunction;
+
+    if (front && back)
+    {
+        glStencilFunc(function, refValue, mask);
+    }
+    else if (front || back)
+    {
+        glStencilFuncSeparate(front ? GL_FRONT : GL_BACK, function, refValue, mask);
+    }
+
+    if (front)
+    {
+        m_stencilFunctions[0] = stencilFunction;
+    }
+    if (back)
+    {
+        m_stencilFunctions[1] = stencilFunction;
+    }
+}
+
+// Set the stencil operations. Face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+void DeviceGL::SetStencilOperations(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+    StencilOperations stencilOperations{ stencilFail, depthFail, depthPass };
+    bool front = face != GL_BACK && m_stencilOperations[0] != stencilOperations;
+    bool back = face != GL_FRONT && m_stencilOperations[1] != stencilOperations;
+
+    if (front && back)
+    {
+        glStencilOp(stencilFail, depthFail, depthPass);
+    }
+    else if (front || back)
+    {
+        glStencilOpSeparate(front ? GL_FRONT : GL_BACK, stencilFail, depthFail, depthPass);
+    }
+
+    if (front)
+    {
+        m_stencilOperations[0] = stencilOperations;
+    }
+    if (back)
+    {
+        m_stencilOperations[1] = stencilOperations;
+    }
+}
+
+// Set the blend equations for color and alpha
+void DeviceGL::SetBlendEquation(GLenum equationColor, GLenum equationAlpha)
+{
+    std::array<GLenum, 2> blendEquations = { equationColor, equationAlpha };
+    if (m_blendEquations != blendEquations)
+    {
+        if (equationColor == equationAlpha)
+        {
+            glBlendEquation(equationColor);
+        }
+        else
+        {
+            glBlendEquationSeparate(equationColor, equationAlpha);
+        }
+        m_blendEquations = blendEquations;
+    }
+}
+
+// Set the blend parameters, different for color and alpha
+void DeviceGL::SetBlendFunction(GLenum sourceColor, GLenum destColor, GLenum sourceAlpha, GLenum destAlpha)
+{
+    std::array<GLenum, 4> blendFunction = { sourceColor, destColor, sourceAlpha, destAlpha };
+    if (m_blendFunction != blendFunction)
+    {
+        if (sourceColor == sourceAlpha && destColor == destAlpha)
+        {
+            glBlendFunc(sourceColor, destColor);
+        }
+        else
+        {
+            glBlendFuncSeparate(sourceColor, destColor, sourceAlpha, destAlpha);
+        }
+        m_blendFunction = blendFunction;
+    }
+}
+
+// Set the color used by the constant color and constant alpha blend parameters
+void DeviceGL::SetBlendColor(const Color& color)
+{
+    glm::vec4 blendColor(color);
+    if (m_blendColor != blendColor)
+    {
+        glBlendColor(blendColor.r, blendColor.g, blendColor.b, blendColor.a);
+        m_blendColor = blendColor;
+    }
+}
+
+// Forget all the cached states, so the next calls will reach GL
+void DeviceGL::InvalidateState()
+{
+    m_shaderProgram.reset();
+    m_vertexArray.reset();
+    m_buffers.clear();
+    m_indexedBuffers.clear();
+    m_activeTextureUnit.reset();
+    m_textures.clear();
+    m_features.clear();
+    m_depthFunction.reset();
+    m_depthWrite.reset();
+    m_colorWrite.reset();
+    m_cullFace.reset();
+    m_stencilFunctions.fill(std::nullopt);
+    m_stencilOperations.fill(std::nullopt);
+    m_blendEquations.reset();
+    m_blendFunction.reset();
+    m_blendColor.reset();
+}
+
+// Deleting the program in use doesn't change the current program, but GL could reuse the name once it is released
+void DeviceGL::ForgetShaderProgram(GLuint shaderProgram)
+{
+    if (m_shaderProgram == shaderProgram)
+    {
+        m_shaderProgram.reset();
+    }
+}
+
+// Deleting the bound vertex array reverts the binding to 0
+void DeviceGL::ForgetVertexArray(GLuint vertexArray)
+{
+    if (m_vertexArray == vertexArray)
+    {
+        m_vertexArray = 0;
+        m_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+}
+
+// Deleting a bound buffer reverts the binding to 0
+void DeviceGL::ForgetBuffer(GLuint buffer)
+{
+    for (auto& [target, boundBuffer] : m_buffers)
+    {
+        if (boundBuffer == buffer)
+        {
+            boundBuffer = 0;
+        }
+    }
+    for (auto& [key, boundBuffer] : m_indexedBuffers)
+    {
+        if (boundBuffer == buffer)
+        {
+            boundBuffer = 0;
+        }
+    }
+}
+
+// Deleting a bound texture reverts the binding to 0
+void DeviceGL::ForgetTexture(GLuint texture)
+{
+    for (auto& [key, boundTexture] : m_textures)
+    {
+        if (boundTexture == texture)
+        {
+            boundTexture = 0;
+        }
+    }
+}
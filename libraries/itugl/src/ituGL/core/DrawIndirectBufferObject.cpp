@@ -0,0 +1,6 @@
+#include <ituGL/core/DrawIndirectBufferObject.h>
+
+DrawIndirectBufferObject::DrawIndirectBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
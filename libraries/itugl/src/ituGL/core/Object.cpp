@@ -1,5 +1,7 @@
 #include <ituGL/core/Object.h>
 
+#include <utility>
+
 // The constructor only assigns the handle
 Object::Object(Handle handle) : m_handle(handle)
 {
@@ -15,10 +17,10 @@ Object::Object(Object&& object) noexcept : m_handle(object.m_handle)
     object.m_handle = NullHandle;
 }
 
+// Swap the handles, so the old one is deleted by the destructor of the moved object.
+// Calling the destructor here would leave this object with the vtable of Object, breaking the virtual methods
 Object& Object::operator = (Object&& object) noexcept
 {
-    this->~Object();
-    m_handle = object.m_handle;
-    object.m_handle = NullHandle;
+    std::swap(m_handle, object.m_handle);
     return *this;
 }
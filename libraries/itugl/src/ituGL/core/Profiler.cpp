@@ -0,0 +1,183 @@
+#include <ituGL/core/Profiler.h>
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+
+std::atomic<bool> Profiler::s_enabled(true);
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        unsigned long long start;
+        unsigned long long end;
+    };
+
+    // Ring buffer written only by its thread. The write index is published after the event is written,
+    // so the reader can copy the events up to it while the thread keeps writing
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Event[]> events;
+        std::atomic<unsigned long long> writeIndex;
+        unsigned long long readIndex;
+        unsigned int threadId;
+        std::string threadName;
+    };
+
+    // Buffers are registered the first time a thread adds a zone, and live until the end of the program,
+    // so a thread can finish while its zones are still not written
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Interned zone names. Elements of an unordered_set don't move when it grows, so the pointers stay valid
+    struct NameTable
+    {
+        std::mutex mutex;
+        std::unordered_set<std::string> names;
+    };
+
+    NameTable& GetNameTable()
+    {
+        static NameTable nameTable;
+        return nameTable;
+    }
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        thread_local ThreadBuffer* threadBuffer = nullptr;
+        if (!threadBuffer)
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+            buffer->events = std::make_unique<Event[]>(Profiler::ThreadCapacity);
+            buffer->writeIndex = 0;
+            buffer->readIndex = 0;
+            buffer->threadId = static_cast<unsigned int>(registry.buffers.size());
+            buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+            threadBuffer = buffer.get();
+            registry.buffers.push_back(std::move(buffer));
+        }
+        return *threadBuffer;
+    }
+
+    // Zone names are usually literals, escape them anyway so the file is always valid JSON
+    void WriteJsonString(std::ofstream& file, const char* text)
+    {
+        file << '"';
+        for (const char* c = text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                file << '\\';
+            }
+            file << *c;
+        }
+        file << '"';
+    }
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+    buffer.threadName = name;
+}
+
+const char* Profiler::InternName(std::string_view name)
+{
+    NameTable& nameTable = GetNameTable();
+    std::lock_guard<std::mutex> lock(nameTable.mutex);
+    return nameTable.names.emplace(name).first->c_str();
+}
+
+unsigned long long Profiler::GetTime()
+{
+    static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Profiler::AddEvent(const char* name, unsigned long long start, unsigned long long end)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    unsigned long long writeIndex = buffer.writeIndex.load(std::memory_order_relaxed);
+    buffer.events[writeIndex % ThreadCapacity] = Event{ name, start, end };
+    buffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+bool Profiler::WriteChromeTrace(const char* path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::vector<Event> events;
+    bool first = true;
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+    {
+        // Copy the events not read yet, or the last ThreadCapacity if the ring wrapped around
+        unsigned long long writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+        unsigned long long beginIndex = std::max(buffer->readIndex, writeIndex > ThreadCapacity ? writeIndex - ThreadCapacity : 0);
+        events.clear();
+        for (unsigned long long index = beginIndex; index < writeIndex; ++index)
+        {
+            events.push_back(buffer->events[index % ThreadCapacity]);
+        }
+        buffer->readIndex = writeIndex;
+
+        // The thread could have overwritten the oldest events while we were copying them, discard those.
+        // It could also be writing the next one, at newWriteIndex - ThreadCapacity, so that one could be torn too
+        unsigned long long newWriteIndex = buffer->writeIndex.load(std::memory_order_acquire);
+        unsigned long long writingEndIndex = newWriteIndex + 1;
+        size_t overwrittenCount = writingEndIndex > beginIndex + ThreadCapacity ? writingEndIndex - beginIndex - ThreadCapacity : 0;
+        overwrittenCount = std::min(overwrittenCount, events.size());
+
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":";
+        WriteJsonString(file, buffer->threadName.c_str());
+        file << "}}";
+        first = false;
+
+        // Complete events, with time in microseconds
+        for (size_t i = overwrittenCount; i < events.size(); ++i)
+        {
+            const Event& event = events[i];
+            file << ",\n{\"name\":";
+            WriteJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,55 @@
+#include <ituGL/core/QueryObject.h>
+
+#include <utility>
+
+// Create the object initially null, get object handle and generate 1 query
+QueryObject::QueryObject() : Object(NullHandle)
+{
+    Handle& handle = GetHandle();
+    glGenQueries(1, &handle);
+}
+
+// Get object handle and delete 1 query
+QueryObject::~QueryObject()
+{
+    Handle& handle = GetHandle();
+    glDeleteQueries(1, &handle);
+}
+
+QueryObject::QueryObject(QueryObject&& queryObject) noexcept : Object(std::move(queryObject))
+{
+}
+
+QueryObject& QueryObject::operator = (QueryObject&& queryObject) noexcept
+{
+    Object::operator=(std::move(queryObject));
+    return *this;
+}
+
+void QueryObject::Bind() const
+{
+}
+
+void QueryObject::Begin(Target target)
+{
+    glBeginQuery(target, GetHandle());
+}
+
+void QueryObject::End(Target target)
+{
+    glEndQuery(target);
+}
+
+bool QueryObject::IsResultAvailable() const
+{
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(GetHandle(), GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+}
+
+GLuint64 QueryObject::GetResult() const
+{
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(GetHandle(), GL_QUERY_RESULT, &result);
+    return result;
+}
@@ -0,0 +1,47 @@
+#include <ituGL/core/Random.h>
+
+namespace
+{
+    // Constants of the PCG32 reference implementation
+    constexpr std::uint64_t Multiplier = 6364136223846793005ull;
+    constexpr std::uint64_t Increment = 1442695040888963407ull;
+}
+
+Random::Random(std::uint64_t seed) : m_seed(seed), m_state(0)
+{
+    SetSeed(seed);
+}
+
+void Random::SetSeed(std::uint64_t seed)
+{
+    // Same initialization as the reference, so the seed is mixed before the first number
+    m_seed = seed;
+    m_state = 0;
+    NextUInt();
+    m_state += seed;
+    NextUInt();
+}
+
+std::uint32_t Random::NextUInt()
+{
+    // Advance the LCG, and output a permutation of the old state: xorshift, then a rotation chosen by the top bits
+    std::uint64_t state = m_state;
+    m_state = state * Multiplier + Increment;
+    std::uint32_t xorShifted = static_cast<std::uint32_t>(((state >> 18u) ^ state) >> 27u);
+    std::uint32_t rotation = static_cast<std::uint32_t>(state >> 59u);
+    return (xorShifted >> rotation) | (xorShifted << ((32u - rotation) & 31u));
+}
+
+float Random::Next01()
+{
+    // 24 bits, all the precision of a float in [0, 1), so it never rounds up to 1
+    return (NextUInt() >> 8) * (1.0f / 16777216.0f);
+}
+
+Color Random::NextColor()
+{
+    float r = Next01();
+    float g = Next01();
+    float b = Next01();
+    return Color(r, g, b);
+}
@@ -0,0 +1,134 @@
+#include <ituGL/core/ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(unsigned int workerCount) : m_task(nullptr), m_taskCount(0), m_generation(0), m_stopping(false)
+    , m_activeWorkerCount(0), m_nextTask(0), m_finishedTaskCount(0)
+{
+    if (workerCount == 0)
+    {
+        // hardware_concurrency can return 0 if it is unknown
+        workerCount = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    }
+
+    m_workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Run(unsigned int taskCount, const TaskFunction& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    // Not worth waking up the workers for a single task
+    if (taskCount == 1 || m_workers.empty())
+    {
+        for (unsigned int taskIndex = 0; taskIndex < taskCount; ++taskIndex)
+        {
+            task(taskIndex);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(!m_task); // Run is not reentrant
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        m_finishedTaskCount = 0;
+        m_generation++;
+    }
+    m_jobCondition.notify_all();
+
+    RunTasks(task, taskCount);
+
+    // Wait for the tasks taken by the workers. The job is cleared under the lock, so no worker can start it again
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [&] { return m_finishedTaskCount == taskCount && m_activeWorkerCount == 0; });
+    m_task = nullptr;
+    m_taskCount = 0;
+}
+
+unsigned int ThreadPool::ParallelFor(unsigned int count, unsigned int minRangeSize, const RangeFunction& function)
+{
+    minRangeSize = std::max(minRangeSize, 1u);
+    unsigned int taskCount = std::min(GetThreadCount(), (count + minRangeSize - 1) / minRangeSize);
+
+    // Distribute the remainder among the first ranges, so their sizes differ at most by one
+    Run(taskCount, [&](unsigned int taskIndex)
+        {
+            unsigned int rangeSize = count / taskCount;
+            unsigned int remainder = count % taskCount;
+            unsigned int begin = taskIndex * rangeSize + std::min(taskIndex, remainder);
+            unsigned int end = begin + rangeSize + (taskIndex < remainder ? 1 : 0);
+            function(taskIndex, begin, end);
+        });
+
+    return taskCount;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    unsigned int generation = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_jobCondition.wait(lock, [&] { return m_stopping || (m_task && m_generation != generation); });
+        if (m_stopping)
+        {
+            return;
+        }
+        generation = m_generation;
+
+        const TaskFunction& task = *m_task;
+        unsigned int taskCount = m_taskCount;
+        m_activeWorkerCount++;
+
+        lock.unlock();
+        RunTasks(task, taskCount);
+        lock.lock();
+
+        m_activeWorkerCount--;
+        if (m_activeWorkerCount == 0)
+        {
+            m_doneCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunTasks(const TaskFunction& task, unsigned int taskCount)
+{
+    unsigned int taskIndex;
+    while ((taskIndex = m_nextTask.fetch_add(1)) < taskCount)
+    {
+        task(taskIndex);
+
+        if (m_finishedTaskCount.fetch_add(1) + 1 == taskCount)
+        {
+            // Lock so the notification can't be missed between the check and the wait in Run
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_doneCondition.notify_one();
+        }
+    }
+}
@@ -5,7 +5,7 @@
 #include <cassert>
 
 Drawcall::Drawcall()
-    : m_primitive(Primitive::Invalid), m_first(0), m_count(0), m_eboType(Data::Type::None)
+    : m_primitive(Primitive::Invalid), m_first(0), m_count(0), m_eboType(Data::Type::None), m_baseVertex(0)
 {
 }
 
@@ -14,12 +14,13 @@ Drawcall::Drawcall(Primitive primitive, GLsizei count, GLint first)
 {
 }
 
-Drawcall::Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first)
-    : m_primitive(primitive), m_first(first), m_count(count), m_eboType(eboType)
+Drawcall::Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first, GLint baseVertex)
+    : m_primitive(primitive), m_first(first), m_count(count), m_eboType(eboType), m_baseVertex(baseVertex)
 {
     assert(primitive != Primitive::Invalid);
     assert(first >= 0);
     assert(count > 0);
+    assert(baseVertex == 0 || eboType != Data::Type::None);
 }
 
 // Execute the drawcall
@@ -39,6 +40,84 @@ void Drawcall::Draw() const
         // If there is an EBO, use glDrawElements
         assert(ElementBufferObject::IsSupportedType(m_eboType));
         const char* basePointer = nullptr; // Actual element pointer is in VAO
-        glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first);
+        if (m_baseVertex != 0)
+        {
+            glDrawElementsBaseVertex(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, m_baseVertex);
+        }
+        else
+        {
+            glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first);
+        }
     }
 }
+
+// Execute the drawcall, rendering instanceCount instances of the geometry
+void Drawcall::DrawInstanced(GLsizei instanceCount, GLuint baseInstance) const
+{
+    assert(IsValid());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(instanceCount > 0);
+    assert(baseInstance == 0 || GLAD_GL_VERSION_4_2);
+
+    GLenum primitive = static_cast<GLenum>(m_primitive);
+    if (m_eboType == Data::Type::None)
+    {
+        // If no EBO is present, use glDrawArraysInstanced
+        if (baseInstance != 0)
+        {
+            glDrawArraysInstancedBaseInstance(primitive, m_first, m_count, instanceCount, baseInstance);
+        }
+        else
+        {
+            glDrawArraysInstanced(primitive, m_first, m_count, instanceCount);
+        }
+    }
+    else
+    {
+        // If there is an EBO, use glDrawElementsInstanced
+        assert(ElementBufferObject::IsSupportedType(m_eboType));
+        const char* basePointer = nullptr; // Actual element pointer is in VAO
+        if (baseInstance != 0)
+        {
+            glDrawElementsInstancedBaseVertexBaseInstance(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first,
+                instanceCount, m_baseVertex, baseInstance);
+        }
+        else if (m_baseVertex != 0)
+        {
+            glDrawElementsInstancedBaseVertex(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, instanceCount, m_baseVertex);
+        }
+        else
+        {
+            glDrawElementsInstanced(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, instanceCount);
+        }
+    }
+}
+
+// Get the indirect command that executes this drawcall
+Drawcall::ElementsIndirectCommand Drawcall::GetIndirectCommand(GLuint instanceCount, GLuint baseInstance) const
+{
+    assert(IsValid());
+    assert(HasElements());
+
+    ElementsIndirectCommand command;
+    command.count = m_count;
+    command.instanceCount = instanceCount;
+    // m_first is in bytes for elements, the command needs an index
+    command.firstIndex = m_first / Data::GetTypeSize(m_eboType);
+    command.baseVertex = m_baseVertex;
+    command.baseInstance = baseInstance;
+    return command;
+}
+
+// Execute drawCount commands from the bound draw indirect buffer
+void Drawcall::MultiDrawIndirect(size_t offsetBytes, GLsizei drawCount) const
+{
+    assert(IsValid());
+    assert(HasElements());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(drawCount > 0);
+
+    GLenum primitive = static_cast<GLenum>(m_primitive);
+    const char* basePointer = nullptr; // Actual command pointer is in the bound draw indirect buffer
+    glMultiDrawElementsIndirect(primitive, static_cast<GLenum>(m_eboType), basePointer + offsetBytes, drawCount, sizeof(ElementsIndirectCommand));
+}
@@ -0,0 +1,372 @@
+#include <ituGL/geometry/GeometryPool.h>
+
+#include <algorithm>
+#include <cassert>
+
+GeometryPool::GeometryPool(Data::Type elementType, unsigned int vertexCapacity, unsigned int elementCapacity)
+    : m_elementType(elementType), m_initialVertexCapacity(vertexCapacity), m_initialElementCapacity(elementCapacity)
+    , m_generation(0), m_instanceLocation(-1), m_instanceBuffer(nullptr)
+{
+    assert(ElementBufferObject::IsSupportedType(elementType));
+}
+
+GeometryPool::Handle GeometryPool::Allocate(const VertexFormat& vertexFormat, const SemanticMap& locations,
+    std::span<const std::byte> vertices, std::span<const std::byte> elements)
+{
+    size_t vertexSize = vertexFormat.GetSize();
+    size_t elementSize = Data::GetTypeSize(m_elementType);
+    assert(vertices.size() % vertexSize == 0);
+    assert(elements.size() % elementSize == 0);
+
+    unsigned int vertexCount = static_cast<unsigned int>(vertices.size() / vertexSize);
+    unsigned int elementCount = static_cast<unsigned int>(elements.size() / elementSize);
+
+    unsigned int bufferSetIndex = GetBufferSet(vertexFormat, locations);
+
+    // Reserve the ranges. If they don't fit, grow the buffers, at least doubling them to amortize the copies
+    Allocation allocation;
+    allocation.bufferSetIndex = bufferSetIndex;
+    allocation.vertices.count = vertexCount;
+    allocation.elements.count = elementCount;
+    allocation.used = true;
+    {
+        BufferSet& bufferSet = *m_bufferSets[bufferSetIndex];
+        if (!AllocateRange(bufferSet.freeVertices, vertexCount, allocation.vertices.first)
+            || !AllocateRange(bufferSet.freeElements, elementCount, allocation.elements.first))
+        {
+            // The rebuild only keeps the existing allocations, so the vertex range is released if it was reserved
+            RebuildBufferSet(bufferSetIndex,
+                std::max(bufferSet.vertexCapacity * 2, bufferSet.vertexCapacity + vertexCount),
+                std::max(bufferSet.elementCapacity * 2, bufferSet.elementCapacity + elementCount));
+
+            bool allocated = AllocateRange(bufferSet.freeVertices, vertexCount, allocation.vertices.first)
+                && AllocateRange(bufferSet.freeElements, elementCount, allocation.elements.first);
+            assert(allocated);
+        }
+    }
+
+    // Upload the data. No VAO can be bound, or it would take the EBO
+    BufferSet& bufferSet = *m_bufferSets[bufferSetIndex];
+    VertexArrayObject::Unbind();
+
+    bufferSet.vbo.Bind();
+    bufferSet.vbo.UpdateData(vertices, allocation.vertices.first * vertexSize);
+    VertexBufferObject::Unbind();
+
+    bufferSet.ebo.Bind();
+    static_cast<BufferObject&>(bufferSet.ebo).UpdateData(elements, allocation.elements.first * elementSize);
+    ElementBufferObject::Unbind();
+
+    // Reuse a released handle, if any
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_allocations[handle] = allocation;
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_allocations.size());
+        m_allocations.push_back(allocation);
+    }
+    return handle;
+}
+
+void GeometryPool::Free(Handle handle)
+{
+    Allocation& allocation = m_allocations[handle];
+    assert(allocation.used);
+
+    BufferSet& bufferSet = *m_bufferSets[allocation.bufferSetIndex];
+    FreeRange(bufferSet.freeVertices, allocation.vertices);
+    FreeRange(bufferSet.freeElements, allocation.elements);
+
+    allocation.used = false;
+    m_freeHandles.push_back(handle);
+}
+
+const VertexArrayObject& GeometryPool::GetVertexArray(Handle handle) const
+{
+    const Allocation& allocation = m_allocations[handle];
+    assert(allocation.used);
+    return m_bufferSets[allocation.bufferSetIndex]->vao;
+}
+
+const VertexBufferObject& GeometryPool::GetVertexBuffer(Handle handle) const
+{
+    const Allocation& allocation = m_allocations[handle];
+    assert(allocation.used);
+    return m_bufferSets[allocation.bufferSetIndex]->vbo;
+}
+
+const ElementBufferObject& GeometryPool::GetElementBuffer(Handle handle) const
+{
+    const Allocation& allocation = m_allocations[handle];
+    assert(allocation.used);
+    return m_bufferSets[allocation.bufferSetIndex]->ebo;
+}
+
+Drawcall GeometryPool::GetDrawcall(Handle handle, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount) const
+{
+    const Allocation& allocation = m_allocations[handle];
+    assert(allocation.used);
+
+    if (elementCount == 0)
+    {
+        elementCount = allocation.elements.count - firstElement;
+    }
+    assert(firstElement + elementCount <= allocation.elements.count);
+
+    // Drawcall takes the first element as an offset in bytes
+    GLint first = (allocation.elements.first + firstElement) * Data::GetTypeSize(m_elementType);
+    return Drawcall(primitive, elementCount, m_elementType, first, allocation.vertices.first);
+}
+
+void GeometryPool::Defragment()
+{
+    for (unsigned int bufferSetIndex = 0; bufferSetIndex < m_bufferSets.size(); ++bufferSetIndex)
+    {
+        const BufferSet& bufferSet = *m_bufferSets[bufferSetIndex];
+
+        // Already compact if there is no free range, or only one at the end
+        bool compactVertices = bufferSet.freeVertices.empty()
+            || (bufferSet.freeVertices.size() == 1 && bufferSet.freeVertices[0].first + bufferSet.freeVertices[0].count == bufferSet.vertexCapacity);
+        bool compactElements = bufferSet.freeElements.empty()
+            || (bufferSet.freeElements.size() == 1 && bufferSet.freeElements[0].first + bufferSet.freeElements[0].count == bufferSet.elementCapacity);
+        if (!compactVertices || !compactElements)
+        {
+            RebuildBufferSet(bufferSetIndex, bufferSet.vertexCapacity, bufferSet.elementCapacity);
+        }
+    }
+}
+
+unsigned int GeometryPool::GetBufferSet(const VertexFormat& vertexFormat, const SemanticMap& locations)
+{
+    for (unsigned int bufferSetIndex = 0; bufferSetIndex < m_bufferSets.size(); ++bufferSetIndex)
+    {
+        const BufferSet& bufferSet = *m_bufferSets[bufferSetIndex];
+        if (IsSameFormat(bufferSet.vertexFormat, vertexFormat) && bufferSet.locations == locations)
+        {
+            return bufferSetIndex;
+        }
+    }
+
+    unsigned int bufferSetIndex = static_cast<unsigned int>(m_bufferSets.size());
+    std::unique_ptr<BufferSet> bufferSet = std::make_unique<BufferSet>();
+    bufferSet->vertexFormat = vertexFormat;
+    bufferSet->locations = locations;
+    bufferSet->vertexCapacity = 0;
+    bufferSet->elementCapacity = 0;
+    m_bufferSets.push_back(std::move(bufferSet));
+
+    RebuildBufferSet(bufferSetIndex, m_initialVertexCapacity, m_initialElementCapacity);
+    SetupInstanceAttribute(*m_bufferSets[bufferSetIndex]);
+
+    return bufferSetIndex;
+}
+
+void GeometryPool::RebuildBufferSet(unsigned int bufferSetIndex, unsigned int vertexCapacity, unsigned int elementCapacity)
+{
+    BufferSet& bufferSet = *m_bufferSets[bufferSetIndex];
+    size_t vertexSize = bufferSet.vertexFormat.GetSize();
+    size_t elementSize = Data::GetTypeSize(m_elementType);
+
+    VertexArrayObject::Unbind();
+
+    VertexBufferObject vbo;
+    vbo.Bind();
+    vbo.AllocateData(vertexCapacity * vertexSize, BufferObject::Usage::StaticDraw);
+    VertexBufferObject::Unbind();
+
+    ElementBufferObject ebo;
+    ebo.Bind();
+    static_cast<BufferObject&>(ebo).AllocateData(elementCapacity * elementSize, BufferObject::Usage::StaticDraw);
+    ElementBufferObject::Unbind();
+
+    // Copy the allocations one after the other, in the same order they had
+    std::vector<Handle> handles;
+    for (Handle handle = 0; handle < m_allocations.size(); ++handle)
+    {
+        const Allocation& allocation = m_allocations[handle];
+        if (allocation.used && allocation.bufferSetIndex == bufferSetIndex)
+        {
+            handles.push_back(handle);
+        }
+    }
+    std::sort(handles.begin(), handles.end(),
+        [&](Handle a, Handle b) { return m_allocations[a].vertices.first < m_allocations[b].vertices.first; });
+
+    unsigned int vertexCount = 0;
+    unsigned int elementCount = 0;
+    for (Handle handle : handles)
+    {
+        Allocation& allocation = m_allocations[handle];
+        if (allocation.vertices.count > 0)
+        {
+            BufferObject::CopyData(bufferSet.vbo, allocation.vertices.first * vertexSize, vbo, vertexCount * vertexSize,
+                allocation.vertices.count * vertexSize);
+        }
+        if (allocation.elements.count > 0)
+        {
+            BufferObject::CopyData(bufferSet.ebo, allocation.elements.first * elementSize, ebo, elementCount * elementSize,
+                allocation.elements.count * elementSize);
+        }
+        allocation.vertices.first = vertexCount;
+        allocation.elements.first = elementCount;
+        vertexCount += allocation.vertices.count;
+        elementCount += allocation.elements.count;
+    }
+    assert(vertexCount <= vertexCapacity && elementCount <= elementCapacity);
+
+    // The free space is all at the end now
+    bufferSet.freeVertices.clear();
+    if (vertexCount < vertexCapacity)
+    {
+        bufferSet.freeVertices.push_back(Range{ vertexCount, vertexCapacity - vertexCount });
+    }
+    bufferSet.freeElements.clear();
+    if (elementCount < elementCapacity)
+    {
+        bufferSet.freeElements.push_back(Range{ elementCount, elementCapacity - elementCount });
+    }
+
+    bufferSet.vbo = std::move(vbo);
+    bufferSet.ebo = std::move(ebo);
+    bufferSet.vertexCapacity = vertexCapacity;
+    bufferSet.elementCapacity = elementCapacity;
+
+    SetupVertexArray(bufferSet);
+
+    m_generation++;
+}
+
+void GeometryPool::SetupVertexArray(BufferSet& bufferSet)
+{
+    VertexArrayObject& vao = bufferSet.vao;
+    vao.Bind();
+
+    // Vertices are interleaved, so the layout doesn't depend on the vertex count
+    bufferSet.vbo.Bind();
+    GLuint location = 0;
+    for (auto it = bufferSet.vertexFormat.LayoutBegin(bufferSet.vertexCapacity, true), itEnd = bufferSet.vertexFormat.LayoutEnd(); it != itEnd; it++)
+    {
+        const VertexAttribute& attribute = it->GetAttribute();
+
+        auto itLocation = bufferSet.locations.find(attribute.GetSemantic());
+        if (itLocation != bufferSet.locations.end())
+        {
+            location = itLocation->second;
+        }
+
+        vao.SetAttribute(location, attribute, it->GetOffset(), it->GetStride());
+        location += attribute.GetLocationSize();
+    }
+
+    // The EBO binding is stored in the VAO
+    bufferSet.ebo.Bind();
+
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+    ElementBufferObject::Unbind();
+}
+
+void GeometryPool::SetInstanceAttribute(GLuint location, const VertexBufferObject& instanceBuffer)
+{
+    m_instanceLocation = location;
+    m_instanceBuffer = &instanceBuffer;
+    for (std::unique_ptr<BufferSet>& bufferSet : m_bufferSets)
+    {
+        SetupInstanceAttribute(*bufferSet);
+    }
+}
+
+// Rebuilding the buffers keeps the VAO, so the instance attribute only has to be set once
+void GeometryPool::SetupInstanceAttribute(BufferSet& bufferSet)
+{
+    if (m_instanceLocation < 0)
+    {
+        return;
+    }
+
+    bufferSet.vao.Bind();
+    m_instanceBuffer->Bind();
+    bufferSet.vao.SetInstanceMatrixAttribute(m_instanceLocation);
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+}
+
+bool GeometryPool::AllocateRange(std::vector<Range>& freeList, unsigned int count, unsigned int& first)
+{
+    if (count == 0)
+    {
+        first = 0;
+        return true;
+    }
+
+    for (auto it = freeList.begin(); it != freeList.end(); ++it)
+    {
+        if (it->count >= count)
+        {
+            first = it->first;
+            it->first += count;
+            it->count -= count;
+            if (it->count == 0)
+            {
+                freeList.erase(it);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void GeometryPool::FreeRange(std::vector<Range>& freeList, Range range)
+{
+    if (range.count == 0)
+    {
+        return;
+    }
+
+    // Insert sorted, then merge with the next and the previous ranges if they are adjacent
+    auto it = std::lower_bound(freeList.begin(), freeList.end(), range,
+        [](const Range& a, const Range& b) { return a.first < b.first; });
+    it = freeList.insert(it, range);
+
+    auto itNext = it + 1;
+    if (itNext != freeList.end() && it->first + it->count == itNext->first)
+    {
+        it->count += itNext->count;
+        it = freeList.erase(itNext) - 1;
+    }
+
+    if (it != freeList.begin())
+    {
+        auto itPrevious = it - 1;
+        if (itPrevious->first + itPrevious->count == it->first)
+        {
+            itPrevious->count += it->count;
+            freeList.erase(it);
+        }
+    }
+}
+
+bool GeometryPool::IsSameFormat(const VertexFormat& a, const VertexFormat& b)
+{
+    if (a.GetAttributeCount() != b.GetAttributeCount())
+    {
+        return false;
+    }
+
+    for (int i = 0; i < a.GetAttributeCount(); ++i)
+    {
+        VertexAttribute attributeA = a.GetAttribute(i);
+        VertexAttribute attributeB = b.GetAttribute(i);
+        if (attributeA.GetType() != attributeB.GetType() || attributeA.GetComponents() != attributeB.GetComponents()
+            || attributeA.IsNormalized() != attributeB.IsNormalized() || attributeA.GetSemantic() != attributeB.GetSemantic())
+        {
+            return false;
+        }
+    }
+    return true;
+}
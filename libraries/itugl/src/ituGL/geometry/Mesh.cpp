@@ -1,7 +1,32 @@
 #include <ituGL/geometry/Mesh.h>
 
+#include <glm/common.hpp>
+#include <limits>
+#include <cassert>
+
 Mesh::Mesh()
+    : m_poolGeneration(0)
+    , m_boundsMin(std::numeric_limits<float>::max())
+    , m_boundsMax(std::numeric_limits<float>::lowest())
+{
+}
+
+Mesh::~Mesh()
+{
+    // Moved meshes don't have the pool anymore
+    if (m_geometryPool)
+    {
+        for (GeometryPool::Handle handle : m_poolHandles)
+        {
+            m_geometryPool->Free(handle);
+        }
+    }
+}
+
+void Mesh::AddBounds(const glm::vec3& min, const glm::vec3& max)
 {
+    m_boundsMin = glm::min(m_boundsMin, min);
+    m_boundsMax = glm::max(m_boundsMax, max);
 }
 
 unsigned int Mesh::AddVertexData(size_t size)
@@ -26,9 +51,69 @@ unsigned int Mesh::AddSubmesh(unsigned int vaoIndex, const Drawcall& drawcall)
     Submesh& submesh = m_submeshes.emplace_back();
     submesh.vaoIndex = vaoIndex;
     submesh.drawcall = drawcall;
+    submesh.poolHandle = GeometryPool::InvalidHandle;
     return submeshIndex;
 }
 
+GeometryPool::Handle Mesh::AddPoolData(std::shared_ptr<GeometryPool> geometryPool, const VertexFormat& vertexFormat, const SemanticMap& locations,
+    std::span<const std::byte> vertices, std::span<const std::byte> elements)
+{
+    assert(geometryPool);
+    assert(!m_geometryPool || m_geometryPool == geometryPool);
+    m_geometryPool = geometryPool;
+
+    GeometryPool::Handle handle = geometryPool->Allocate(vertexFormat, locations, vertices, elements);
+    m_poolHandles.push_back(handle);
+    return handle;
+}
+
+unsigned int Mesh::AddPoolSubmesh(GeometryPool::Handle handle, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount)
+{
+    assert(m_geometryPool);
+
+    // Update the existing drawcalls first, so the generation is valid for all of them
+    UpdatePoolDrawcalls();
+
+    unsigned int submeshIndex = GetSubmeshCount();
+    Submesh& submesh = m_submeshes.emplace_back();
+    submesh.vaoIndex = 0;
+    submesh.drawcall = m_geometryPool->GetDrawcall(handle, primitive, firstElement, elementCount);
+    submesh.poolHandle = handle;
+    submesh.primitive = primitive;
+    submesh.firstElement = firstElement;
+    submesh.elementCount = elementCount;
+    return submeshIndex;
+}
+
+const VertexArrayObject& Mesh::GetSubmeshVertexArray(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    return submesh.poolHandle != GeometryPool::InvalidHandle ? m_geometryPool->GetVertexArray(submesh.poolHandle) : m_vaos[submesh.vaoIndex];
+}
+
+const Drawcall& Mesh::GetSubmeshDrawcall(unsigned int submeshIndex) const
+{
+    UpdatePoolDrawcalls();
+    return GetSubmesh(submeshIndex).drawcall;
+}
+
+void Mesh::UpdatePoolDrawcalls() const
+{
+    if (!m_geometryPool || m_poolGeneration == m_geometryPool->GetGeneration())
+    {
+        return;
+    }
+
+    for (Submesh& submesh : m_submeshes)
+    {
+        if (submesh.poolHandle != GeometryPool::InvalidHandle)
+        {
+            submesh.drawcall = m_geometryPool->GetDrawcall(submesh.poolHandle, submesh.primitive, submesh.firstElement, submesh.elementCount);
+        }
+    }
+    m_poolGeneration = m_geometryPool->GetGeneration();
+}
+
 unsigned int Mesh::AddSubmesh(unsigned int vaoIndex,
     Drawcall::Primitive primitive, GLint first, GLsizei count, Data::Type eboType)
 {
@@ -38,13 +123,29 @@ unsigned int Mesh::AddSubmesh(unsigned int vaoIndex,
 // Bind the VAO and render the drawcall of the submesh
 void Mesh::DrawSubmesh(int submeshIndex) const
 {
-    const Submesh& submesh = GetSubmesh(submeshIndex);
-    const VertexArrayObject& vao = GetVertexArray(submesh.vaoIndex);
+    const VertexArrayObject& vao = GetSubmeshVertexArray(submeshIndex);
     vao.Bind();
-    submesh.drawcall.Draw();
+    GetSubmeshDrawcall(submeshIndex).Draw();
     //VertexArrayObject::Unbind(); // No need to unbind
 }
 
+void Mesh::SetInstanceAttribute(GLuint location, const VertexBufferObject& instanceBuffer)
+{
+    for (VertexArrayObject& vao : m_vaos)
+    {
+        vao.Bind();
+        instanceBuffer.Bind();
+        vao.SetInstanceMatrixAttribute(location);
+    }
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+
+    if (m_geometryPool)
+    {
+        m_geometryPool->SetInstanceAttribute(location, instanceBuffer);
+    }
+}
+
 void Mesh::SetupVertexAttribute(VertexArrayObject& vao, const VertexAttribute::Layout& attributeLayout, GLuint& location, const SemanticMap& locations)
 {
     const VertexAttribute& attribute = attributeLayout.GetAttribute();
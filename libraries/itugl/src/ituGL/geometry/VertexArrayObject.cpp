@@ -1,6 +1,7 @@
 #include <ituGL/geometry/VertexArrayObject.h>
 
 #include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 #ifndef NDEBUG
@@ -20,6 +21,10 @@ VertexArrayObject::VertexArrayObject() : Object(NullHandle)
 VertexArrayObject::~VertexArrayObject()
 {
     Handle& handle = GetHandle();
+    if (handle != NullHandle && DeviceGL::GetInstancePointer())
+    {
+        DeviceGL::GetInstance().ForgetVertexArray(handle);
+    }
     glDeleteVertexArrays(1, &handle);
 }
 
@@ -37,7 +42,7 @@ VertexArrayObject& VertexArrayObject::operator = (VertexArrayObject&& vao) noexc
 void VertexArrayObject::Bind() const
 {
     Handle handle = GetHandle();
-    glBindVertexArray(handle);
+    DeviceGL::GetInstance().BindVertexArray(handle);
 #ifndef NDEBUG
     s_boundHandle = handle;
 #endif
@@ -47,7 +52,7 @@ void VertexArrayObject::Bind() const
 void VertexArrayObject::Unbind()
 {
     Handle handle = NullHandle;
-    glBindVertexArray(handle);
+    DeviceGL::GetInstance().BindVertexArray(handle);
 #ifndef NDEBUG
     s_boundHandle = handle;
 #endif
@@ -74,3 +79,23 @@ void VertexArrayObject::SetAttribute(GLuint location, const VertexAttribute& att
     // Finally, we enable the VertexAttribute in this location
     glEnableVertexAttribArray(location);
 }
+
+// Sets how often the attribute in location advances: 0 per vertex (default), N every N instances
+void VertexArrayObject::SetAttributeDivisor(GLuint location, GLuint divisor)
+{
+    assert(IsBound());
+
+    glVertexAttribDivisor(location, divisor);
+}
+
+// Sets the 4 columns of the matrix as consecutive vec4 attributes, with the stride of the whole matrix
+void VertexArrayObject::SetInstanceMatrixAttribute(GLuint location, GLint offset)
+{
+    VertexAttribute columnAttribute(Data::Type::Float, 4);
+    GLsizei stride = 4 * columnAttribute.GetSize();
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        SetAttribute(location + column, columnAttribute, offset + column * columnAttribute.GetSize(), stride);
+        SetAttributeDivisor(location + column, 1);
+    }
+}
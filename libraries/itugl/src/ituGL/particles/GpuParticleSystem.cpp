@@ -0,0 +1,181 @@
+#include <ituGL/particles/GpuParticleSystem.h>
+
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/shader/Shader.h>
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    // Must match gpu_simulate.comp and gpu_begin.comp
+    constexpr unsigned int SimulateGroupSize = 256;
+
+    // Must match the StateBuffer block of the shaders
+    struct State
+    {
+        unsigned int groupCountX;
+        unsigned int groupCountY;
+        unsigned int groupCountZ;
+        unsigned int aliveCount;
+        unsigned int emitCount;
+    };
+
+    // Same layout as the commands of glDrawArraysIndirect
+    struct DrawArraysCommand
+    {
+        unsigned int count;
+        unsigned int instanceCount;
+        unsigned int first;
+        unsigned int baseInstance;
+    };
+
+    std::shared_ptr<ShaderProgram> LoadComputeProgram(const char* path)
+    {
+        Shader computeShader = ShaderLoader(Shader::ComputeShader).Load(path);
+        std::shared_ptr<ShaderProgram> shaderProgram = std::make_shared<ShaderProgram>();
+        shaderProgram->Build(computeShader);
+        return shaderProgram;
+    }
+}
+
+GpuParticleSystem::GpuParticleSystem(unsigned int capacity)
+    : m_capacity(capacity), m_gravity(0.0f), m_drag(0.0f)
+    , m_emitCount(0), m_seed(0), m_aliveListIndex(0)
+    , m_emitRequestLocation(-1), m_seedLocation(-1), m_emitterPositionLocation(-1), m_emitterRadiusLocation(-1)
+    , m_emitterVelocityLocation(-1), m_velocitySpreadLocation(-1), m_lifetimeRangeLocation(-1), m_sizeRangeLocation(-1)
+    , m_emitterColorLocation(-1), m_deltaTimeLocation(-1), m_gravityLocation(-1), m_dragLocation(-1)
+{
+    assert(GLAD_GL_VERSION_4_3);
+    InitializeBuffers();
+    InitializePrograms();
+}
+
+void GpuParticleSystem::InitializeBuffers()
+{
+    // Particles are only read and written by the GPU
+    m_particleBuffer.Bind();
+    m_particleBuffer.AllocateData(m_capacity * sizeof(Particle), BufferObject::Usage::DynamicCopy);
+
+    // At the beginning, all the particles are dead. The dead list is the count followed by the indices
+    std::vector<unsigned int> deadList(m_capacity + 1);
+    deadList[0] = m_capacity;
+    std::iota(deadList.begin() + 1, deadList.end(), 0u);
+    m_deadListBuffer.Bind();
+    m_deadListBuffer.AllocateData(std::span<const unsigned int>(deadList), BufferObject::Usage::DynamicCopy);
+
+    for (ShaderStorageBufferObject& aliveListBuffer : m_aliveListBuffers)
+    {
+        aliveListBuffer.Bind();
+        aliveListBuffer.AllocateData(m_capacity * sizeof(unsigned int), BufferObject::Usage::DynamicCopy);
+    }
+
+    State state = { 0, 1, 1, 0, 0 };
+    m_stateBuffer.Bind();
+    m_stateBuffer.AllocateData(std::span<const State>(&state, 1), BufferObject::Usage::DynamicCopy);
+    ShaderStorageBufferObject::Unbind();
+
+    DrawArraysCommand drawCommand = { 0, 1, 0, 0 };
+    m_drawBuffer.Bind();
+    m_drawBuffer.AllocateData(std::span<const DrawArraysCommand>(&drawCommand, 1), BufferObject::Usage::DynamicCopy);
+    DrawIndirectBufferObject::Unbind();
+}
+
+void GpuParticleSystem::InitializePrograms()
+{
+    // The begin pass writes the work groups of the simulation, and resets the atomic counter of the draw
+    std::shared_ptr<ShaderProgram> beginProgram = LoadComputeProgram("shaders/particles/gpu_begin.comp");
+    m_beginDispatch = std::make_unique<ComputeDispatch>(beginProgram,
+        GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    m_emitRequestLocation = beginProgram->GetUniformLocation("EmitRequest");
+
+    std::shared_ptr<ShaderProgram> emitProgram = LoadComputeProgram("shaders/particles/gpu_emit.comp");
+    m_emitDispatch = std::make_unique<ComputeDispatch>(emitProgram, GL_SHADER_STORAGE_BARRIER_BIT);
+    m_seedLocation = emitProgram->GetUniformLocation("Seed");
+    m_emitterPositionLocation = emitProgram->GetUniformLocation("EmitterPosition");
+    m_emitterRadiusLocation = emitProgram->GetUniformLocation("EmitterRadius");
+    m_emitterVelocityLocation = emitProgram->GetUniformLocation("EmitterVelocity");
+    m_velocitySpreadLocation = emitProgram->GetUniformLocation("VelocitySpread");
+    m_lifetimeRangeLocation = emitProgram->GetUniformLocation("LifetimeRange");
+    m_sizeRangeLocation = emitProgram->GetUniformLocation("SizeRange");
+    m_emitterColorLocation = emitProgram->GetUniformLocation("EmitterColor");
+
+    // The simulation writes the particles for the vertex shader, and the atomic counter is the vertex count of the draw
+    std::shared_ptr<ShaderProgram> simulateProgram = LoadComputeProgram("shaders/particles/gpu_simulate.comp");
+    m_simulateDispatch = std::make_unique<ComputeDispatch>(simulateProgram,
+        GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    m_deltaTimeLocation = simulateProgram->GetUniformLocation("DeltaTime");
+    m_gravityLocation = simulateProgram->GetUniformLocation("Gravity");
+    m_dragLocation = simulateProgram->GetUniformLocation("Drag");
+
+    assert(m_simulateDispatch->GetWorkGroupSize().x == SimulateGroupSize);
+}
+
+void GpuParticleSystem::Emit(const Emitter& emitter, unsigned int count)
+{
+    m_emitter = emitter;
+    m_emitCount += count;
+}
+
+void GpuParticleSystem::Update(float deltaTime)
+{
+    // Bind all the buffers. The alive lists swap every update
+    m_particleBuffer.BindBase(ParticleBinding);
+    m_deadListBuffer.BindBase(DeadListBinding);
+    m_aliveListBuffers[m_aliveListIndex].BindBase(AliveListBinding);
+    m_aliveListBuffers[1 - m_aliveListIndex].BindBase(NextAliveListBinding);
+    m_stateBuffer.BindBase(StateBinding);
+    m_drawBuffer.BindBase(BufferObject::ShaderStorageBuffer, DrawBinding);
+    m_drawBuffer.BindBase(BufferObject::AtomicCounterBuffer, DrawCounterBinding);
+
+    // Take the survivors of the last update as the alive list, and as many dead particles as we can emit
+    unsigned int emitCount = std::min(m_emitCount, m_capacity);
+    std::shared_ptr<const ShaderProgram> beginProgram = m_beginDispatch->GetShaderProgram();
+    beginProgram->Use();
+    beginProgram->SetUniform(m_emitRequestLocation, emitCount);
+    m_beginDispatch->Dispatch(1);
+
+    // Initialize the new particles, and append them to the alive list
+    if (emitCount > 0)
+    {
+        std::shared_ptr<const ShaderProgram> emitProgram = m_emitDispatch->GetShaderProgram();
+        emitProgram->Use();
+        emitProgram->SetUniform(m_seedLocation, m_seed++);
+        emitProgram->SetUniform(m_emitterPositionLocation, m_emitter.position);
+        emitProgram->SetUniform(m_emitterRadiusLocation, m_emitter.radius);
+        emitProgram->SetUniform(m_emitterVelocityLocation, m_emitter.velocity);
+        emitProgram->SetUniform(m_velocitySpreadLocation, m_emitter.velocitySpread);
+        emitProgram->SetUniform(m_lifetimeRangeLocation, glm::vec2(m_emitter.minLifetime, m_emitter.maxLifetime));
+        emitProgram->SetUniform(m_sizeRangeLocation, glm::vec2(m_emitter.minSize, m_emitter.maxSize));
+        emitProgram->SetUniform(m_emitterColorLocation, static_cast<glm::vec4>(m_emitter.color));
+        m_emitDispatch->DispatchInvocations(emitCount);
+        m_emitCount = 0;
+    }
+
+    // Simulate the alive list, with as many work groups as the begin pass found
+    std::shared_ptr<const ShaderProgram> simulateProgram = m_simulateDispatch->GetShaderProgram();
+    simulateProgram->Use();
+    simulateProgram->SetUniform(m_deltaTimeLocation, deltaTime);
+    simulateProgram->SetUniform(m_gravityLocation, m_gravity);
+    simulateProgram->SetUniform(m_dragLocation, m_drag);
+    m_simulateDispatch->DispatchIndirect(m_stateBuffer);
+
+    // The survivors are in the next alive list now
+    m_aliveListIndex = 1 - m_aliveListIndex;
+}
+
+void GpuParticleSystem::Draw() const
+{
+    // Wait for the simulation, before reading the particles and the draw command
+    ComputeDispatch::Barrier();
+
+    m_particleBuffer.BindBase(ParticleBinding);
+    m_aliveListBuffers[m_aliveListIndex].BindBase(AliveListBinding);
+
+    m_vao.Bind();
+    m_drawBuffer.Bind();
+    glDrawArraysIndirect(GL_POINTS, nullptr);
+    DrawIndirectBufferObject::Unbind();
+    VertexArrayObject::Unbind();
+}
@@ -0,0 +1,137 @@
+#include <ituGL/particles/ParticleEmitterBuffer.h>
+
+#include <algorithm>
+
+ParticleEmitterBuffer::ParticleEmitterBuffer(size_t particleSize, unsigned int capacity)
+    : m_particleSize(particleSize), m_capacity(capacity), m_emittedCount(0)
+    , m_mappedData(nullptr), m_fences{}, m_frameIndex(0)
+{
+    assert(particleSize > 0 && capacity > 0);
+
+    // Updated every frame, but only by the GPU copies when using the staging ring
+    m_vertexBuffer.Bind();
+    m_vertexBuffer.AllocateData(m_capacity * m_particleSize, BufferObject::Usage::DynamicDraw);
+    VertexBufferObject::Unbind();
+
+    if (GLAD_GL_VERSION_4_4)
+    {
+        InitializeStagingBuffer();
+    }
+}
+
+ParticleEmitterBuffer::~ParticleEmitterBuffer()
+{
+    for (GLsync fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+
+    if (m_mappedData)
+    {
+        m_stagingBuffer.Bind();
+        m_stagingBuffer.Unmap();
+        VertexBufferObject::Unbind();
+    }
+}
+
+void ParticleEmitterBuffer::InitializeStagingBuffer()
+{
+    // A frame never copies more than m_capacity particles, the older ones would be replaced anyway
+    size_t size = FrameCount * m_capacity * m_particleSize;
+
+    // Coherent, so the writes are visible to the copies without flushing the mapped ranges
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    m_stagingBuffer.Bind();
+    m_stagingBuffer.AllocateStorage(size, flags);
+    m_mappedData = static_cast<std::byte*>(m_stagingBuffer.MapRange(0, size, flags));
+    VertexBufferObject::Unbind();
+}
+
+unsigned int ParticleEmitterBuffer::GetParticleCount() const
+{
+    return static_cast<unsigned int>(std::min<unsigned long long>(m_emittedCount, m_capacity));
+}
+
+void ParticleEmitterBuffer::Emit(std::span<const std::byte> particle)
+{
+    assert(particle.size() == m_particleSize);
+    m_pendingData.insert(m_pendingData.end(), particle.begin(), particle.end());
+}
+
+void ParticleEmitterBuffer::Flush()
+{
+    unsigned int pendingCount = GetPendingCount();
+    if (pendingCount == 0)
+    {
+        return;
+    }
+
+    // Only the newest m_capacity particles survive, skip the ones that would be replaced in this same flush
+    unsigned int skippedCount = pendingCount > m_capacity ? pendingCount - m_capacity : 0;
+    unsigned int count = pendingCount - skippedCount;
+    m_emittedCount += skippedCount;
+    const std::byte* data = m_pendingData.data() + skippedCount * m_particleSize;
+
+    if (m_mappedData)
+    {
+        // Write to the part of the ring of this frame, once the GPU finished copying from it FrameCount frames ago
+        WaitFrame(m_frameIndex);
+        std::memcpy(m_mappedData + m_frameIndex * m_capacity * m_particleSize, data, count * m_particleSize);
+    }
+
+    // Copy up to the end of the circular buffer, and the rest from the beginning
+    unsigned int index = static_cast<unsigned int>(m_emittedCount % m_capacity);
+    unsigned int firstCount = std::min(count, m_capacity - index);
+    CopyParticles(data, 0, index, firstCount);
+    if (firstCount < count)
+    {
+        CopyParticles(data, firstCount * m_particleSize, 0, count - firstCount);
+    }
+
+    if (m_mappedData)
+    {
+        // Signaled when the copies are done, and this part of the ring can be written again
+        m_fences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_frameIndex = (m_frameIndex + 1) % FrameCount;
+    }
+
+    m_emittedCount += count;
+    m_pendingData.clear();
+}
+
+void ParticleEmitterBuffer::WaitFrame(unsigned int frameIndex)
+{
+    GLsync& fence = m_fences[frameIndex];
+    if (fence)
+    {
+        // Flush the commands the first time, or the fence could never be signaled
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+        {
+            flags = 0;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void ParticleEmitterBuffer::CopyParticles(const std::byte* data, size_t dataOffset, unsigned int index, unsigned int count)
+{
+    size_t offset = index * m_particleSize;
+    size_t size = count * m_particleSize;
+    if (m_mappedData)
+    {
+        // GPU copy from the staging ring. It is ordered after the draws of the previous frames that read the vertex buffer
+        size_t stagingOffset = m_frameIndex * m_capacity * m_particleSize + dataOffset;
+        BufferObject::CopyData(m_stagingBuffer, stagingOffset, m_vertexBuffer, offset, size);
+    }
+    else
+    {
+        m_vertexBuffer.Bind();
+        m_vertexBuffer.UpdateData(std::span<const std::byte>(data + dataOffset, size), offset);
+        VertexBufferObject::Unbind();
+    }
+}
@@ -0,0 +1,353 @@
+#include <ituGL/particles/ParticleSystem.h>
+
+#include <ituGL/core/ThreadPool.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__AVX__)
+#define ITUGL_PARTICLES_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ITUGL_PARTICLES_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Minimum number of particles per task. Smaller ranges cost more to schedule than to simulate
+    constexpr unsigned int MinRangeSize = 4096;
+
+    // PCG hash, a good and cheap random number generator when each particle needs its own state
+    unsigned int Hash(unsigned int value)
+    {
+        unsigned int state = value * 747796405u + 2891336453u;
+        unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
+    }
+
+    // Random float in [0, 1), advancing the state
+    float Random01(unsigned int& state)
+    {
+        state = Hash(state);
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Random point inside the sphere of radius 1, uniformly distributed
+    glm::vec3 RandomInSphere(unsigned int& state)
+    {
+        float z = Random01(state) * 2.0f - 1.0f;
+        float angle = Random01(state) * glm::two_pi<float>();
+        float radius = std::cbrt(Random01(state));
+        float radiusXY = std::sqrt(1.0f - z * z);
+        return radius * glm::vec3(radiusXY * std::cos(angle), radiusXY * std::sin(angle), z);
+    }
+
+    // Integrate Width consecutive particles. Used for the last particles, and for the blocks without SSE or AVX.
+    // The arrays never overlap, so the compiler can keep the values in registers and vectorize the loops
+    template<unsigned int Width>
+    void IntegrateBlock(float* __restrict positionX, float* __restrict positionY, float* __restrict positionZ,
+        float* __restrict velocityX, float* __restrict velocityY, float* __restrict velocityZ, float* __restrict age,
+        const glm::vec3& gravity, std::span<const ParticleSystem::Attractor> attractors, float drag, float deltaTime)
+    {
+        float accelerationX[Width], accelerationY[Width], accelerationZ[Width];
+        for (unsigned int i = 0; i < Width; ++i)
+        {
+            accelerationX[i] = gravity.x;
+            accelerationY[i] = gravity.y;
+            accelerationZ[i] = gravity.z;
+        }
+
+        for (const ParticleSystem::Attractor& attractor : attractors)
+        {
+            for (unsigned int i = 0; i < Width; ++i)
+            {
+                float x = attractor.position.x - positionX[i];
+                float y = attractor.position.y - positionY[i];
+                float z = attractor.position.z - positionZ[i];
+                float distance2 = x * x + y * y + z * z + ParticleSystem::AttractorSoftening;
+                float factor = attractor.strength / (distance2 * std::sqrt(distance2));
+                accelerationX[i] += x * factor;
+                accelerationY[i] += y * factor;
+                accelerationZ[i] += z * factor;
+            }
+        }
+
+        // Semi-implicit Euler: velocity first, then position with the new velocity
+        for (unsigned int i = 0; i < Width; ++i)
+        {
+            velocityX[i] = (velocityX[i] + accelerationX[i] * deltaTime) * drag;
+            velocityY[i] = (velocityY[i] + accelerationY[i] * deltaTime) * drag;
+            velocityZ[i] = (velocityZ[i] + accelerationZ[i] * deltaTime) * drag;
+            positionX[i] += velocityX[i] * deltaTime;
+            positionY[i] += velocityY[i] * deltaTime;
+            positionZ[i] += velocityZ[i] * deltaTime;
+            age[i] += deltaTime;
+        }
+    }
+
+#if defined(ITUGL_PARTICLES_AVX) || defined(ITUGL_PARTICLES_SSE2)
+#if defined(ITUGL_PARTICLES_AVX)
+    using FloatVector = __m256;
+    constexpr unsigned int VectorWidth = 8;
+
+    inline FloatVector Load(const float* values) { return _mm256_loadu_ps(values); }
+    inline void Store(float* values, FloatVector vector) { _mm256_storeu_ps(values, vector); }
+    inline FloatVector Set(float value) { return _mm256_set1_ps(value); }
+    inline FloatVector Add(FloatVector a, FloatVector b) { return _mm256_add_ps(a, b); }
+    inline FloatVector Sub(FloatVector a, FloatVector b) { return _mm256_sub_ps(a, b); }
+    inline FloatVector Mul(FloatVector a, FloatVector b) { return _mm256_mul_ps(a, b); }
+    inline FloatVector Div(FloatVector a, FloatVector b) { return _mm256_div_ps(a, b); }
+    inline FloatVector Sqrt(FloatVector a) { return _mm256_sqrt_ps(a); }
+#else
+    using FloatVector = __m128;
+    constexpr unsigned int VectorWidth = 4;
+
+    inline FloatVector Load(const float* values) { return _mm_loadu_ps(values); }
+    inline void Store(float* values, FloatVector vector) { _mm_storeu_ps(values, vector); }
+    inline FloatVector Set(float value) { return _mm_set1_ps(value); }
+    inline FloatVector Add(FloatVector a, FloatVector b) { return _mm_add_ps(a, b); }
+    inline FloatVector Sub(FloatVector a, FloatVector b) { return _mm_sub_ps(a, b); }
+    inline FloatVector Mul(FloatVector a, FloatVector b) { return _mm_mul_ps(a, b); }
+    inline FloatVector Div(FloatVector a, FloatVector b) { return _mm_div_ps(a, b); }
+    inline FloatVector Sqrt(FloatVector a) { return _mm_sqrt_ps(a); }
+#endif
+
+    static_assert(ParticleSystem::SimdWidth % VectorWidth == 0, "Blocks must be made of whole vectors");
+
+    // Same as IntegrateBlock<SimdWidth>, with SSE or AVX intrinsics. The operations are the same and in the same order,
+    // and the division and square root are exact, so the results are the same as the scalar path
+    void IntegrateBlockSimd(float* __restrict positionX, float* __restrict positionY, float* __restrict positionZ,
+        float* __restrict velocityX, float* __restrict velocityY, float* __restrict velocityZ, float* __restrict age,
+        const glm::vec3& gravity, std::span<const ParticleSystem::Attractor> attractors, float drag, float deltaTime)
+    {
+        const FloatVector deltaTimes = Set(deltaTime);
+        const FloatVector drags = Set(drag);
+        const FloatVector softening = Set(ParticleSystem::AttractorSoftening);
+
+        for (unsigned int i = 0; i < ParticleSystem::SimdWidth; i += VectorWidth)
+        {
+            FloatVector px = Load(positionX + i);
+            FloatVector py = Load(positionY + i);
+            FloatVector pz = Load(positionZ + i);
+
+            FloatVector ax = Set(gravity.x);
+            FloatVector ay = Set(gravity.y);
+            FloatVector az = Set(gravity.z);
+            for (const ParticleSystem::Attractor& attractor : attractors)
+            {
+                FloatVector x = Sub(Set(attractor.position.x), px);
+                FloatVector y = Sub(Set(attractor.position.y), py);
+                FloatVector z = Sub(Set(attractor.position.z), pz);
+                FloatVector distance2 = Add(Add(Add(Mul(x, x), Mul(y, y)), Mul(z, z)), softening);
+                FloatVector factor = Div(Set(attractor.strength), Mul(distance2, Sqrt(distance2)));
+                ax = Add(ax, Mul(x, factor));
+                ay = Add(ay, Mul(y, factor));
+                az = Add(az, Mul(z, factor));
+            }
+
+            // Semi-implicit Euler: velocity first, then position with the new velocity
+            FloatVector vx = Mul(Add(Load(velocityX + i), Mul(ax, deltaTimes)), drags);
+            FloatVector vy = Mul(Add(Load(velocityY + i), Mul(ay, deltaTimes)), drags);
+            FloatVector vz = Mul(Add(Load(velocityZ + i), Mul(az, deltaTimes)), drags);
+            Store(velocityX + i, vx);
+            Store(velocityY + i, vy);
+            Store(velocityZ + i, vz);
+            Store(positionX + i, Add(px, Mul(vx, deltaTimes)));
+            Store(positionY + i, Add(py, Mul(vy, deltaTimes)));
+            Store(positionZ + i, Add(pz, Mul(vz, deltaTimes)));
+            Store(age + i, Add(Load(age + i), deltaTimes));
+        }
+    }
+#endif
+}
+
+ParticleSystem::ParticleSystem(unsigned int capacity)
+    : m_capacity(capacity), m_particleCount(0), m_threadPool(nullptr)
+    , m_gravity(0.0f), m_drag(0.0f)
+    , m_positionX(capacity), m_positionY(capacity), m_positionZ(capacity)
+    , m_velocityX(capacity), m_velocityY(capacity), m_velocityZ(capacity)
+    , m_age(capacity), m_lifetime(capacity), m_size(capacity), m_color(capacity)
+{
+}
+
+unsigned int ParticleSystem::Emit(const Emitter& emitter, unsigned int count, unsigned int seed)
+{
+    count = std::min(count, m_capacity - m_particleCount);
+    unsigned int first = m_particleCount;
+    ForEachRange(count, [&](unsigned int, unsigned int begin, unsigned int end)
+        {
+            EmitRange(emitter, first, begin, end, seed);
+        });
+    m_particleCount += count;
+    return count;
+}
+
+void ParticleSystem::Update(float deltaTime)
+{
+    // Each task integrates its range and compacts it while it is still in the cache
+    m_ranges.resize(m_threadPool ? m_threadPool->GetThreadCount() : 1);
+    unsigned int rangeCount = ForEachRange(m_particleCount, [&](unsigned int taskIndex, unsigned int begin, unsigned int end)
+        {
+            IntegrateRange(begin, end, deltaTime);
+            m_ranges[taskIndex] = Range{ begin, CompactRange(begin, end) - begin };
+        });
+
+    // Pack the live particles of the ranges together. The ranges are in order, so they only move down
+    unsigned int particleCount = 0;
+    for (unsigned int rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex)
+    {
+        const Range& range = m_ranges[rangeIndex];
+        MoveParticles(range.begin, particleCount, range.count);
+        particleCount += range.count;
+    }
+    m_particleCount = particleCount;
+}
+
+void ParticleSystem::Clear()
+{
+    m_particleCount = 0;
+}
+
+unsigned int ParticleSystem::WriteVertices(std::span<Vertex> vertices) const
+{
+    assert(vertices.size() >= m_particleCount);
+    ForEachRange(m_particleCount, [&](unsigned int, unsigned int begin, unsigned int end)
+        {
+            WriteVerticesRange(vertices, begin, end);
+        });
+    return m_particleCount;
+}
+
+unsigned int ParticleSystem::UpdateVertexBuffer(VertexBufferObject& vertexBuffer)
+{
+    m_vertices.resize(m_particleCount);
+    WriteVertices(m_vertices);
+
+    // Allocating again every frame lets the driver give us new memory, instead of waiting for the previous draw
+    vertexBuffer.Bind();
+    vertexBuffer.AllocateData(std::span<const Vertex>(m_vertices), BufferObject::Usage::StreamDraw);
+    VertexBufferObject::Unbind();
+
+    return m_particleCount;
+}
+
+template<typename F>
+unsigned int ParticleSystem::ForEachRange(unsigned int count, F&& function) const
+{
+    if (!m_threadPool || count <= MinRangeSize)
+    {
+        function(0, 0, count);
+        return 1;
+    }
+
+    // Split in blocks of SimdWidth particles, so only the last range has an incomplete block
+    unsigned int blockCount = (count + SimdWidth - 1) / SimdWidth;
+    return m_threadPool->ParallelFor(blockCount, MinRangeSize / SimdWidth, [&](unsigned int taskIndex, unsigned int begin, unsigned int end)
+        {
+            function(taskIndex, begin * SimdWidth, std::min(end * SimdWidth, count));
+        });
+}
+
+void ParticleSystem::IntegrateRange(unsigned int begin, unsigned int end, float deltaTime)
+{
+    float drag = std::max(1.0f - m_drag * deltaTime, 0.0f);
+
+    unsigned int index = begin;
+    for (; index + SimdWidth <= end; index += SimdWidth)
+    {
+#if defined(ITUGL_PARTICLES_AVX) || defined(ITUGL_PARTICLES_SSE2)
+        IntegrateBlockSimd(&m_positionX[index], &m_positionY[index], &m_positionZ[index],
+            &m_velocityX[index], &m_velocityY[index], &m_velocityZ[index], &m_age[index], m_gravity, m_attractors, drag, deltaTime);
+#else
+        IntegrateBlock<SimdWidth>(&m_positionX[index], &m_positionY[index], &m_positionZ[index],
+            &m_velocityX[index], &m_velocityY[index], &m_velocityZ[index], &m_age[index], m_gravity, m_attractors, drag, deltaTime);
+#endif
+    }
+    for (; index < end; ++index)
+    {
+        IntegrateBlock<1>(&m_positionX[index], &m_positionY[index], &m_positionZ[index],
+            &m_velocityX[index], &m_velocityY[index], &m_velocityZ[index], &m_age[index], m_gravity, m_attractors, drag, deltaTime);
+    }
+}
+
+unsigned int ParticleSystem::CompactRange(unsigned int begin, unsigned int end)
+{
+    // Stream compaction without branches: every particle is copied to the write index,
+    // but the write index only advances for the live ones
+    unsigned int write = begin;
+    for (unsigned int read = begin; read < end; ++read)
+    {
+        unsigned int alive = m_age[read] < m_lifetime[read] ? 1 : 0;
+        m_positionX[write] = m_positionX[read];
+        m_positionY[write] = m_positionY[read];
+        m_positionZ[write] = m_positionZ[read];
+        m_velocityX[write] = m_velocityX[read];
+        m_velocityY[write] = m_velocityY[read];
+        m_velocityZ[write] = m_velocityZ[read];
+        m_age[write] = m_age[read];
+        m_lifetime[write] = m_lifetime[read];
+        m_size[write] = m_size[read];
+        m_color[write] = m_color[read];
+        write += alive;
+    }
+    return write;
+}
+
+void ParticleSystem::EmitRange(const Emitter& emitter, unsigned int first, unsigned int begin, unsigned int end, unsigned int seed)
+{
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        // The state depends only on the seed and the index in this emission
+        unsigned int state = Hash(seed ^ Hash(i));
+
+        glm::vec3 position = emitter.position + emitter.radius * RandomInSphere(state);
+        glm::vec3 velocity = emitter.velocity + emitter.velocitySpread * RandomInSphere(state);
+
+        unsigned int index = first + i;
+        m_positionX[index] = position.x;
+        m_positionY[index] = position.y;
+        m_positionZ[index] = position.z;
+        m_velocityX[index] = velocity.x;
+        m_velocityY[index] = velocity.y;
+        m_velocityZ[index] = velocity.z;
+        m_age[index] = 0.0f;
+        m_lifetime[index] = emitter.minLifetime + (emitter.maxLifetime - emitter.minLifetime) * Random01(state);
+        m_size[index] = emitter.minSize + (emitter.maxSize - emitter.minSize) * Random01(state);
+        m_color[index] = emitter.color;
+    }
+}
+
+void ParticleSystem::WriteVerticesRange(std::span<Vertex> vertices, unsigned int begin, unsigned int end) const
+{
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        Vertex& vertex = vertices[i];
+        vertex.position = glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+        vertex.size = m_size[i];
+        vertex.color = m_color[i];
+    }
+}
+
+void ParticleSystem::MoveParticles(unsigned int source, unsigned int destination, unsigned int count)
+{
+    assert(destination <= source);
+    if (destination == source || count == 0)
+    {
+        return;
+    }
+
+    auto move = [=](auto& array) { std::copy(array.begin() + source, array.begin() + source + count, array.begin() + destination); };
+    move(m_positionX);
+    move(m_positionY);
+    move(m_positionZ);
+    move(m_velocityX);
+    move(m_velocityY);
+    move(m_velocityZ);
+    move(m_age);
+    move(m_lifetime);
+    move(m_size);
+    move(m_color);
+}
@@ -6,18 +6,180 @@
 #include <ituGL/camera/Camera.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/asset/ShaderLoader.h>
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <vector>
+#include <cmath>
 
 DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material)
-    : m_material(material)
+    : RenderPass("Deferred"), m_material(material)
+    , m_lightingMode(LightingMode::PerLight)
+    , m_lightVolumesEnabled(true), m_depthStencilFramebuffer(nullptr), m_width(0), m_height(0)
+    , m_stencilWorldViewProjMatrixLocation(-1)
+    , m_tileCountX(0), m_tileCountY(0)
+    , m_cullingDepthTextureLocation(-1), m_cullingViewMatrixLocation(-1), m_cullingInvProjMatrixLocation(-1)
+    , m_cullingLightCountLocation(-1), m_cullingViewportSizeLocation(-1), m_tileCountXLocation(-1)
+    , m_outputWidth(0), m_outputHeight(0)
 {
     InitializeMeshes();
 }
 
+DeferredRenderPass::LightingMode DeferredRenderPass::GetLightingMode() const
+{
+    return m_lightingMode;
+}
+
+void DeferredRenderPass::SetLightingMode(LightingMode lightingMode)
+{
+    m_lightingMode = lightingMode;
+}
+
+void DeferredRenderPass::SetTiledLighting(std::shared_ptr<Material> tiledMaterial, std::shared_ptr<ShaderProgram> lightCullingProgram,
+    const std::string& depthTextureName, int width, int height)
+{
+    assert(tiledMaterial && lightCullingProgram);
+
+    m_tiledMaterial = tiledMaterial;
+    m_lightCullingProgram = lightCullingProgram;
+    m_depthTextureName = depthTextureName;
+
+    // Round up, the tiles on the right and top borders can be partially outside of the screen
+    m_tileCountX = (width + TileSize - 1) / TileSize;
+    m_tileCountY = (height + TileSize - 1) / TileSize;
+
+    // Get the uniform locations of the light culling shader
+    m_cullingDepthTextureLocation = m_lightCullingProgram->GetUniformLocation("DepthTexture");
+    m_cullingViewMatrixLocation = m_lightCullingProgram->GetUniformLocation("ViewMatrix");
+    m_cullingInvProjMatrixLocation = m_lightCullingProgram->GetUniformLocation("InvProjMatrix");
+    m_cullingLightCountLocation = m_lightCullingProgram->GetUniformLocation("LightCount");
+    m_cullingViewportSizeLocation = m_lightCullingProgram->GetUniformLocation("ViewportSize");
+
+    // The tiled material needs to know how many tiles there are in a row to find its tile
+    m_tileCountXLocation = m_tiledMaterial->GetShaderProgram()->GetUniformLocation("TileCountX");
+
+    // Allocate the tile lights. They are written and read only by the GPU
+    size_t tileCount = static_cast<size_t>(m_tileCountX) * m_tileCountY;
+    m_tileLightBuffer.Bind();
+    m_tileLightBuffer.AllocateData(tileCount * (MaxLightsPerTile + 1) * sizeof(unsigned int), BufferObject::Usage::DynamicCopy);
+    ShaderStorageBufferObject::Unbind();
+}
+
+void DeferredRenderPass::SetLightVolumes(const FramebufferObject& depthStencilFramebuffer, int width, int height)
+{
+    m_depthStencilFramebuffer = &depthStencilFramebuffer;
+    m_width = width;
+    m_height = height;
+
+    // Load the shaders of the stencil pass, the first time
+    if (!m_stencilProgram.IsLinked())
+    {
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load("shaders/renderer/light_volume.vert");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load("shaders/renderer/light_volume.frag");
+        m_stencilProgram.Build(vertexShader, fragmentShader);
+
+        m_stencilWorldViewProjMatrixLocation = m_stencilProgram.GetUniformLocation("WorldViewProjMatrix");
+    }
+}
+
+bool DeferredRenderPass::GetLightVolumesEnabled() const
+{
+    return m_lightVolumesEnabled;
+}
+
+void DeferredRenderPass::SetLightVolumesEnabled(bool enabled)
+{
+    m_lightVolumesEnabled = enabled;
+}
+
+void DeferredRenderPass::SetOutputTexture(const std::string& outputTextureName, int width, int height)
+{
+    m_outputTextureName = outputTextureName;
+    m_outputDepthTextureName = outputTextureName.empty() ? std::string() : outputTextureName + "Depth";
+    m_outputWidth = width;
+    m_outputHeight = height;
+}
+
+void DeferredRenderPass::Setup(RenderGraph::PassBuilder& builder)
+{
+    if (m_outputTextureName.empty())
+    {
+        // Draws to the current framebuffer
+        RenderPass::Setup(builder);
+    }
+    else
+    {
+        // HDR color, read by a later pass. Depth and stencil only for the light volumes, in the same format as the gbuffer
+        builder.CreateTexture(m_outputTextureName, { m_outputWidth, m_outputHeight, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA16F });
+        builder.CreateTexture(m_outputDepthTextureName, { m_outputWidth, m_outputHeight, TextureObject::FormatDepthStencil, TextureObject::InternalFormatDepth24Stencil8 });
+    }
+
+    // The light culling shader reads the depth directly, not through the material
+    if (m_tiledMaterial)
+    {
+        builder.Read(m_depthTextureName);
+    }
+}
+
 void DeferredRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
 
+    bool hasOutput = !m_outputTextureName.empty();
+    if (hasOutput)
+    {
+        UpdateOutputFramebuffer();
+        m_outputFramebuffer.Bind();
+    }
+
+    // The gbuffer only has the scene in the render viewport
+    renderer.SetRenderViewport();
+
+    if (hasOutput)
+    {
+        // Outside of the render viewport is never read, but clear it all as a new texture could have any content
+        renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), false, 1.0);
+    }
+
+    // Tiled lighting needs compute shaders and shader storage buffers
+    if (m_lightingMode == LightingMode::Tiled && m_tiledMaterial && GLAD_GL_VERSION_4_3)
+    {
+        RenderTiled();
+    }
+    else
+    {
+        RenderPerLight();
+    }
+
+    if (hasOutput)
+    {
+        FramebufferObject::Unbind();
+    }
+}
+
+void DeferredRenderPass::UpdateOutputFramebuffer()
+{
+    std::shared_ptr<Texture2DObject> outputTexture = GetGraphTexture(m_outputTextureName);
+    std::shared_ptr<Texture2DObject> outputDepthTexture = GetGraphTexture(m_outputDepthTextureName);
+
+    // The pool usually returns the same textures every frame, so the framebuffer is rarely updated
+    if (outputTexture != m_outputTexture || outputDepthTexture != m_outputDepthTexture)
+    {
+        m_outputTexture = outputTexture;
+        m_outputDepthTexture = outputDepthTexture;
+
+        m_outputFramebuffer.Bind();
+        m_outputFramebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::DepthStencil, *m_outputDepthTexture);
+        m_outputFramebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_outputTexture);
+        FramebufferObject::Unbind();
+    }
+}
+
+void DeferredRenderPass::RenderPerLight()
+{
+    Renderer& renderer = GetRenderer();
+
     const Camera& camera = renderer.GetCurrentCamera();
 
     assert(m_material);
@@ -28,6 +190,19 @@ void DeferredRenderPass::Render()
     // Use the inverse view proj matrix to cancel view projection from the camera
     glm::mat4 fullscreenMatrix = glm::inverse(camera.GetViewProjectionMatrix());
 
+    DeviceGL& device = renderer.GetDevice();
+
+    // Copy the scene depth to test the light volumes against it. Stencil starts at 0 and each light volume leaves it at 0
+    bool lightVolumes = m_lightVolumesEnabled && m_depthStencilFramebuffer;
+    if (lightVolumes)
+    {
+        m_depthStencilFramebuffer->Bind(FramebufferObject::Target::Read);
+        FramebufferObject::Blit(0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT);
+        FramebufferObject::Unbind(FramebufferObject::Target::Read);
+
+        device.Clear(false, Color(), false, 1.0, true, 0);
+    }
+
     bool first = true;
     unsigned int lightIndex = 0;
     const auto& lights = renderer.GetLights();
@@ -39,18 +214,242 @@ void DeferredRenderPass::Render()
         const Mesh* mesh = &renderer.GetFullscreenMesh();
         glm::mat4 worldMatrix = fullscreenMatrix;
 
-        // TODO: select different meshes depending on the type
+        // The first light also adds the ambient light, so it always covers the full screen
+        bool lightVolume = lightVolumes && !first && GetLightVolume(*light, mesh, worldMatrix);
+        if (lightVolume)
+        {
+            RenderLightVolumeStencil(*mesh, camera.GetViewProjectionMatrix() * worldMatrix);
+
+            // Back to the lighting shader program. The uniforms keep their values
+            shaderProgram->Use();
+        }
 
         // Set the render states for the first and additional lights
         renderer.SetLightingRenderStates(first);
 
-        renderer.UpdateTransforms(shaderProgram, fullscreenMatrix, first);
+        if (lightVolumes)
+        {
+            // The scene depth is in the depth buffer now, so the depth test can't be used with the fullscreen triangle.
+            // The light volumes are tested with the stencil instead
+            device.DisableFeature(GL_DEPTH_TEST);
+        }
+        if (lightVolume)
+        {
+            // Draw only the back faces, so it works with the camera inside the volume. Reset the stencil to 0 on the way
+            device.SetColorWrite(true);
+            device.SetCullFace(GL_FRONT);
+            device.SetStencilFunction(GL_FRONT_AND_BACK, GL_NOTEQUAL, 0, 0xFF);
+            device.SetStencilOperations(GL_FRONT_AND_BACK, GL_KEEP, GL_ZERO, GL_ZERO);
+        }
+        else
+        {
+            device.DisableFeature(GL_STENCIL_TEST);
+        }
+
+        renderer.UpdateTransforms(shaderProgram, worldMatrix, first);
         mesh->DrawSubmesh(0);
         first = false;
     }
+
+    // Restore default values
+    if (lightVolumes)
+    {
+        device.EnableFeature(GL_DEPTH_TEST);
+        device.DisableFeature(GL_STENCIL_TEST);
+        device.SetCullFace(GL_BACK);
+        device.SetColorWrite(true);
+    }
+}
+
+bool DeferredRenderPass::GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix) const
+{
+    // Lights without range reach the full screen
+    float range = light.GetAttenuation().y;
+    if (range <= 0.0f)
+    {
+        return false;
+    }
+
+    glm::vec3 position = light.GetPosition();
+    switch (light.GetType())
+    {
+    case Light::Type::Point:
+        mesh = &m_sphereMesh;
+        worldMatrix = glm::translate(position) * glm::scale(glm::vec3(range));
+        return true;
+    case Light::Type::Spot:
+    {
+        // Wide cones are much larger than the spheres, and too wide if over 90 degrees
+        float angle = light.GetAttenuation().w;
+        if (angle > glm::radians(75.0f))
+        {
+            mesh = &m_sphereMesh;
+            worldMatrix = glm::translate(position) * glm::scale(glm::vec3(range));
+            return true;
+        }
+
+        // The light direction points to the light, the cone opens in the opposite direction (local Z axis)
+        glm::vec3 axisZ = -light.GetDirection();
+        glm::vec3 up = std::abs(axisZ.y) < 0.99f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+        glm::vec3 axisX = glm::normalize(glm::cross(up, axisZ));
+        glm::vec3 axisY = glm::cross(axisZ, axisX);
+        glm::mat4 rotationMatrix(glm::vec4(axisX, 0), glm::vec4(axisY, 0), glm::vec4(axisZ, 0), glm::vec4(0, 0, 0, 1));
+
+        float radius = range * std::tan(angle);
+        mesh = &m_coneMesh;
+        worldMatrix = glm::translate(position) * rotationMatrix * glm::scale(glm::vec3(radius, radius, range));
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void DeferredRenderPass::RenderLightVolumeStencil(const Mesh& mesh, const glm::mat4& worldViewProjMatrix)
+{
+    DeviceGL& device = GetRenderer().GetDevice();
+
+    m_stencilProgram.Use();
+    m_stencilProgram.SetUniform(m_stencilWorldViewProjMatrixLocation, worldViewProjMatrix);
+
+    // Only stencil is written. Depth is tested to find where the scene is between the front and back faces
+    device.SetColorWrite(false);
+    device.EnableFeature(GL_DEPTH_TEST);
+    device.SetDepthFunction(GL_LESS);
+    device.SetDepthWrite(false);
+    device.DisableFeature(GL_BLEND);
+    device.DisableFeature(GL_CULL_FACE);
+
+    // Back faces behind the scene increment, front faces behind the scene decrement.
+    // The pixels that end up different from 0 have the scene inside the volume
+    device.EnableFeature(GL_STENCIL_TEST);
+    device.SetStencilFunction(GL_FRONT_AND_BACK, GL_ALWAYS, 0, 0xFF);
+    device.SetStencilOperations(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+    device.SetStencilOperations(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+
+    mesh.DrawSubmesh(0);
+
+    device.EnableFeature(GL_CULL_FACE);
+}
+
+void DeferredRenderPass::RenderTiled()
+{
+    Renderer& renderer = GetRenderer();
+
+    const Camera& camera = renderer.GetCurrentCamera();
+
+    m_tileLightBuffer.BindBase(1);
+
+    // Only the tiles in the render viewport have pixels of the scene. Their rows are also shorter
+    int viewportWidth, viewportHeight;
+    renderer.GetRenderViewport(viewportWidth, viewportHeight);
+    if (viewportWidth <= 0 || viewportHeight <= 0)
+    {
+        viewportWidth = m_tileCountX * TileSize;
+        viewportHeight = m_tileCountY * TileSize;
+    }
+    unsigned int tileCountX = std::min((viewportWidth + TileSize - 1) / TileSize, m_tileCountX);
+    unsigned int tileCountY = std::min((viewportHeight + TileSize - 1) / TileSize, m_tileCountY);
+
+    // Bin the lights in screen tiles, one work group per tile
+    m_lightCullingProgram->Use();
+    m_lightCullingProgram->SetTexture(m_cullingDepthTextureLocation, 0, *GetGraphTexture(m_depthTextureName));
+    m_lightCullingProgram->SetUniform(m_cullingViewMatrixLocation, camera.GetViewMatrix());
+    m_lightCullingProgram->SetUniform(m_cullingInvProjMatrixLocation, glm::inverse(camera.GetProjectionMatrix()));
+    m_lightCullingProgram->SetUniform(m_cullingLightCountLocation, static_cast<unsigned int>(renderer.GetLights().size()));
+    m_lightCullingProgram->SetUniform(m_cullingViewportSizeLocation, glm::ivec2(viewportWidth, viewportHeight));
+    glDispatchCompute(tileCountX, tileCountY, 1);
+
+    // The tile lights must be written before the fragment shader reads them
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    m_tiledMaterial->Use();
+    std::shared_ptr<const ShaderProgram> shaderProgram = m_tiledMaterial->GetShaderProgram();
+    shaderProgram->SetUniform(m_tileCountXLocation, tileCountX);
+
+    // Ambient and other per-frame lighting uniforms are set as if it was the first light, but without lights
+    unsigned int lightIndex = 0;
+    renderer.UpdateLights(shaderProgram, std::span<const Light* const>(), lightIndex);
+
+    // Single opaque draw, as the first light in PerLight mode
+    renderer.SetLightingRenderStates(true);
+
+    // Our fullscreen triangle is directly in clip coordinates.
+    // Use the inverse view proj matrix to cancel view projection from the camera
+    glm::mat4 fullscreenMatrix = glm::inverse(camera.GetViewProjectionMatrix());
+    renderer.UpdateTransforms(shaderProgram, fullscreenMatrix, true);
+
+    renderer.GetFullscreenMesh().DrawSubmesh(0);
 }
 
 void DeferredRenderPass::InitializeMeshes()
 {
-    //TODO: Create meshes for spot and point lights
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+
+    // The faces of a low-poly mesh are inside the shape it approximates. Push the vertices out so the faces contain it
+    const unsigned int segments = 16;
+    const unsigned int rings = 8;
+    const float scale = 1.0f / (std::cos(glm::pi<float>() / segments) * std::cos(glm::pi<float>() / (2 * rings)));
+
+    // Triangles are added with counterclockwise winding, seen from outside
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned short> indices;
+    auto addTriangle = [&](unsigned int a, unsigned int b, unsigned int c, const glm::vec3& inside)
+    {
+        glm::vec3 normal = glm::cross(vertices[b] - vertices[a], vertices[c] - vertices[a]);
+        bool outwards = glm::dot(normal, vertices[a] - inside) > 0.0f;
+        indices.push_back(static_cast<unsigned short>(a));
+        indices.push_back(static_cast<unsigned short>(outwards ? b : c));
+        indices.push_back(static_cast<unsigned short>(outwards ? c : b));
+    };
+
+    // Sphere of radius 1: top and bottom poles, and rings of vertices in between
+    vertices.emplace_back(0.0f, scale, 0.0f);
+    vertices.emplace_back(0.0f, -scale, 0.0f);
+    for (unsigned int ring = 1; ring < rings; ++ring)
+    {
+        float polarAngle = glm::pi<float>() * ring / rings;
+        for (unsigned int segment = 0; segment < segments; ++segment)
+        {
+            float azimuthAngle = glm::two_pi<float>() * segment / segments;
+            vertices.emplace_back(scale * std::sin(polarAngle) * std::cos(azimuthAngle), scale * std::cos(polarAngle),
+                scale * std::sin(polarAngle) * std::sin(azimuthAngle));
+        }
+    }
+    auto ringVertex = [=](unsigned int ring, unsigned int segment) { return 2 + (ring - 1) * segments + segment % segments; };
+    for (unsigned int segment = 0; segment < segments; ++segment)
+    {
+        addTriangle(0, ringVertex(1, segment), ringVertex(1, segment + 1), glm::vec3(0.0f));
+        addTriangle(1, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1), glm::vec3(0.0f));
+        for (unsigned int ring = 1; ring < rings - 1; ++ring)
+        {
+            addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment), ringVertex(ring + 1, segment + 1), glm::vec3(0.0f));
+            addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment + 1), ringVertex(ring, segment + 1), glm::vec3(0.0f));
+        }
+    }
+    m_sphereMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles,
+        vertices, indices, vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+
+    // Cone with the apex at the origin and a base of radius 1 at Z = 1
+    vertices.clear();
+    indices.clear();
+    const float coneScale = 1.0f / std::cos(glm::pi<float>() / segments);
+    const glm::vec3 coneInside(0.0f, 0.0f, 0.5f);
+    vertices.emplace_back(0.0f, 0.0f, 0.0f);
+    vertices.emplace_back(0.0f, 0.0f, 1.0f);
+    for (unsigned int segment = 0; segment < segments; ++segment)
+    {
+        float azimuthAngle = glm::two_pi<float>() * segment / segments;
+        vertices.emplace_back(coneScale * std::cos(azimuthAngle), coneScale * std::sin(azimuthAngle), 1.0f);
+    }
+    for (unsigned int segment = 0; segment < segments; ++segment)
+    {
+        unsigned int current = 2 + segment;
+        unsigned int next = 2 + (segment + 1) % segments;
+        addTriangle(0, current, next, coneInside);
+        addTriangle(1, current, next, coneInside);
+    }
+    m_coneMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles,
+        vertices, indices, vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
 }
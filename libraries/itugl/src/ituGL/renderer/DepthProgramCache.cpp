@@ -0,0 +1,116 @@
+#include <ituGL/renderer/DepthProgramCache.h>
+
+#include <ituGL/shader/Shader.h>
+#include <ituGL/renderer/Renderer.h>
+#include <fstream>
+#include <sstream>
+#include <array>
+#include <cassert>
+
+DepthProgramCache::DepthProgramCache(bool viewProjUniform) : m_viewProjUniform(viewProjUniform)
+{
+}
+
+bool DepthProgramCache::LoadFrameBlock(const char* path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::stringstream stringStream;
+    stringStream << file.rdbuf();
+    m_frameBlockSource = stringStream.str();
+
+    // Programs built without the frame block are built again
+    m_depthPrograms.clear();
+    m_materialDepthPrograms.clear();
+    return true;
+}
+
+const DepthProgramCache::DepthProgram* DepthProgramCache::GetDepthProgram(const ShaderProgram& materialShaderProgram)
+{
+    auto itMaterial = m_materialDepthPrograms.find(&materialShaderProgram);
+    if (itMaterial != m_materialDepthPrograms.end())
+    {
+        return itMaterial->second;
+    }
+
+    // The VAO attributes were set up for the locations of the material shader program, so the depth program reads the same ones
+    ShaderProgram::Location positionLocation = materialShaderProgram.GetAttributeLocation("VertexPosition");
+    ShaderProgram::Location instanceWorldMatrixLocation = materialShaderProgram.GetAttributeLocation("InstanceWorldMatrix");
+
+    const DepthProgram* depthProgram = nullptr;
+    if (positionLocation >= 0 && (m_viewProjUniform || !m_frameBlockSource.empty()))
+    {
+        auto key = std::make_pair(positionLocation, instanceWorldMatrixLocation);
+        auto itDepth = m_depthPrograms.find(key);
+        if (itDepth == m_depthPrograms.end())
+        {
+            itDepth = m_depthPrograms.emplace(key, CreateDepthProgram(positionLocation, instanceWorldMatrixLocation)).first;
+        }
+        depthProgram = &itDepth->second;
+    }
+
+    m_materialDepthPrograms[&materialShaderProgram] = depthProgram;
+    return depthProgram;
+}
+
+DepthProgramCache::DepthProgram DepthProgramCache::CreateDepthProgram(ShaderProgram::Location positionLocation, ShaderProgram::Location instanceWorldMatrixLocation) const
+{
+    // The position is computed with the same operations as the forward shaders, and declared invariant in both,
+    // so the compiler can't optimize them differently and the depth matches exactly in a GL_EQUAL test
+    std::string headerSource = "#version 330 core\n";
+    headerSource += "layout (location = " + std::to_string(positionLocation) + ") in vec3 VertexPosition;\n";
+    if (instanceWorldMatrixLocation >= 0)
+    {
+        headerSource += "layout (location = " + std::to_string(instanceWorldMatrixLocation) + ") in mat4 InstanceWorldMatrix;\n";
+    }
+    if (m_viewProjUniform)
+    {
+        headerSource += "uniform mat4 ViewProjMatrix;\n";
+    }
+
+    std::string vertexSource =
+        "\nuniform mat4 WorldMatrix;\n"
+        "invariant gl_Position;\n"
+        "void main()\n"
+        "{\n";
+    vertexSource += instanceWorldMatrixLocation >= 0 ? "    mat4 worldMatrix = InstanceWorldMatrix;\n" : "    mat4 worldMatrix = WorldMatrix;\n";
+    vertexSource +=
+        "    vec3 worldPosition = (worldMatrix * vec4(VertexPosition, 1.0)).xyz;\n"
+        "    gl_Position = ViewProjMatrix * vec4(worldPosition, 1.0);\n"
+        "}\n";
+
+    const char* fragmentSource =
+        "#version 330 core\n"
+        "void main()\n"
+        "{\n"
+        "}\n";
+
+    // Same frame block as the material shaders, between the header and the main function
+    std::array<const char*, 3> vertexSources = { headerSource.c_str(), m_viewProjUniform ? "" : m_frameBlockSource.c_str(), vertexSource.c_str() };
+    Shader vertexShader(Shader::VertexShader);
+    vertexShader.SetSource(vertexSources);
+    vertexShader.Compile();
+
+    Shader fragmentShader(Shader::FragmentShader);
+    fragmentShader.SetSource(fragmentSource);
+    fragmentShader.Compile();
+
+    DepthProgram depthProgram;
+    depthProgram.shaderProgram = std::make_shared<ShaderProgram>();
+    depthProgram.shaderProgram->Build(vertexShader, fragmentShader);
+    assert(depthProgram.shaderProgram->IsLinked());
+
+    if (!m_viewProjUniform)
+    {
+        depthProgram.shaderProgram->SetUniformBlockBinding("FrameBlock", Renderer::FrameBlockBinding);
+    }
+    depthProgram.worldMatrixLocation = depthProgram.shaderProgram->GetUniformLocation("WorldMatrix");
+    depthProgram.instanceWorldMatrixLocation = instanceWorldMatrixLocation >= 0
+        ? depthProgram.shaderProgram->GetAttributeLocation("InstanceWorldMatrix") : -1;
+    depthProgram.viewProjMatrixLocation = m_viewProjUniform
+        ? depthProgram.shaderProgram->GetUniformLocation("ViewProjMatrix") : -1;
+    return depthProgram;
+}
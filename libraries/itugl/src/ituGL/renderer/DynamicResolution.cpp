@@ -0,0 +1,78 @@
+#include <ituGL/renderer/DynamicResolution.h>
+
+#include <ituGL/renderer/RenderPassTimer.h>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+DynamicResolution::DynamicResolution(float targetFrameTime, float minScale, float maxScale)
+    : m_targetFrameTime(targetFrameTime), m_minScale(minScale), m_maxScale(maxScale)
+    , m_proportionalGain(0.15f), m_integralGain(0.1f), m_derivativeGain(0.0f)
+    , m_area(maxScale * maxScale), m_lastError(0.0f), m_lastLastError(0.0f), m_readFrameCount(0)
+{
+    assert(targetFrameTime > 0.0f);
+    assert(minScale > 0.0f && minScale <= maxScale && maxScale <= 1.0f);
+}
+
+void DynamicResolution::SetTargetFrameTime(float targetFrameTime)
+{
+    assert(targetFrameTime > 0.0f);
+    m_targetFrameTime = targetFrameTime;
+}
+
+void DynamicResolution::SetScaleRange(float minScale, float maxScale)
+{
+    assert(minScale > 0.0f && minScale <= maxScale && maxScale <= 1.0f);
+    m_minScale = minScale;
+    m_maxScale = maxScale;
+    m_area = std::clamp(m_area, minScale * minScale, maxScale * maxScale);
+}
+
+void DynamicResolution::SetGains(float proportional, float integral, float derivative)
+{
+    m_proportionalGain = proportional;
+    m_integralGain = integral;
+    m_derivativeGain = derivative;
+}
+
+float DynamicResolution::GetScale() const
+{
+    float scale = std::round(std::sqrt(m_area) * 64.0f) / 64.0f;
+    return std::clamp(scale, m_minScale, m_maxScale);
+}
+
+float DynamicResolution::Update(float frameTime)
+{
+    // Positive if there is time left. Relative, so the same gains work for any target
+    float error = (m_targetFrameTime - frameTime) / m_targetFrameTime;
+
+    // Incremental form: the output changes by the PID of the error. Clamping the output is enough to avoid windup,
+    // so after a long spike at the min scale it goes up as soon as there is time left
+    float delta = m_proportionalGain * (error - m_lastError)
+        + m_integralGain * error
+        + m_derivativeGain * (error - 2.0f * m_lastError + m_lastLastError);
+    m_area = std::clamp(m_area + delta, m_minScale * m_minScale, m_maxScale * m_maxScale);
+
+    m_lastLastError = m_lastError;
+    m_lastError = error;
+
+    return GetScale();
+}
+
+float DynamicResolution::Update(const RenderPassTimer& timer)
+{
+    // The timer reads one frame per frame, usually. Frames that were not read can't be used twice
+    if (timer.GetReadFrameCount() != m_readFrameCount)
+    {
+        m_readFrameCount = timer.GetReadFrameCount();
+        Update(timer.GetLastFrameTime());
+    }
+    return GetScale();
+}
+
+void DynamicResolution::Reset()
+{
+    m_area = m_maxScale * m_maxScale;
+    m_lastError = 0.0f;
+    m_lastLastError = 0.0f;
+}
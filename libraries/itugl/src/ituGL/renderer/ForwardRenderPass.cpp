@@ -3,7 +3,11 @@
 #include <ituGL/camera/Camera.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/lighting/Light.h>
 #include <ituGL/renderer/Renderer.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
 
 ForwardRenderPass::ForwardRenderPass()
     : ForwardRenderPass(0)
@@ -11,26 +15,93 @@ ForwardRenderPass::ForwardRenderPass()
 }
 
 ForwardRenderPass::ForwardRenderPass(int drawcallCollectionIndex)
-    : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    : RenderPass("Forward"), m_drawcallCollectionIndex(drawcallCollectionIndex), m_maxLightsPerObject(32)
+    , m_depthPrePassEnabled(false)
 {
 }
 
+unsigned int ForwardRenderPass::GetMaxLightsPerObject() const
+{
+    return m_maxLightsPerObject;
+}
+
+void ForwardRenderPass::SetMaxLightsPerObject(unsigned int maxLightsPerObject)
+{
+    m_maxLightsPerObject = maxLightsPerObject;
+}
+
+bool ForwardRenderPass::GetDepthPrePassEnabled() const
+{
+    return m_depthPrePassEnabled;
+}
+
+void ForwardRenderPass::SetDepthPrePassEnabled(bool depthPrePassEnabled)
+{
+    m_depthPrePassEnabled = depthPrePassEnabled;
+}
+
+bool ForwardRenderPass::LoadFrameBlock(const char* path)
+{
+    return m_depthPrograms.LoadFrameBlock(path);
+}
+
 void ForwardRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    m_depthPrePassed.assign(renderer.GetDrawcalls(m_drawcallCollectionIndex).size(), false);
+    if (m_depthPrePassEnabled)
+    {
+        RenderDepthPrePass();
+    }
 
     const Camera& camera = renderer.GetCurrentCamera();
     const auto& lights = renderer.GetLights();
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
+    // Shader programs with a light array that already have the per-frame lighting uniforms
+    std::vector<const ShaderProgram*> lightArrayPrograms;
+
     // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    for (unsigned int drawcallIndex = 0; drawcallIndex < drawcallCollection.size(); ++drawcallIndex)
     {
+        const Renderer::DrawcallInfo& drawcallInfo = drawcallCollection[drawcallIndex];
+
         // Prepare drawcall states
         renderer.PrepareDrawcall(drawcallInfo);
 
+        // The depth is already there, only the closest surface passes the test. The material may be unchanged,
+        // so the depth write is always set, as it would be left by the previous drawcall
+        bool depthPrePassed = m_depthPrePassed[drawcallIndex];
+        device.SetDepthWrite(depthPrePassed ? false : drawcallInfo.material.GetDepthWrite());
+
         std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.material.GetShaderProgram();
 
+        // Single pass: all the lights are read from the light buffer (requires OpenGL 4.3)
+        if (GLAD_GL_VERSION_4_3 && renderer.HasLightArray(shaderProgram))
+        {
+            // Ambient and other per-frame lighting uniforms are set as if it was the first light, but without lights
+            if (std::find(lightArrayPrograms.begin(), lightArrayPrograms.end(), shaderProgram.get()) == lightArrayPrograms.end())
+            {
+                unsigned int lightIndex = 0;
+                renderer.UpdateLights(shaderProgram, std::span<const Light* const>(), lightIndex);
+                lightArrayPrograms.push_back(shaderProgram.get());
+            }
+
+            SelectLights(drawcallInfo, std::min(m_maxLightsPerObject, renderer.GetLightArraySize(shaderProgram)));
+            renderer.SetLightArray(shaderProgram, m_lightIndices);
+
+            renderer.SetLightingRenderStates(true);
+            if (m_depthPrePassEnabled)
+            {
+                device.SetDepthFunction(depthPrePassed ? GL_EQUAL : GL_LEQUAL);
+            }
+
+            drawcallInfo.Draw();
+            continue;
+        }
+
         //for all lights
         bool first = true;
         unsigned int lightIndex = 0;
@@ -38,11 +109,113 @@ void ForwardRenderPass::Render()
         {
             // Set the renderstates
             renderer.SetLightingRenderStates(first);
+            if (depthPrePassed)
+            {
+                device.SetDepthFunction(GL_EQUAL);
+            }
+            else if (first && m_depthPrePassEnabled)
+            {
+                device.SetDepthFunction(GL_LEQUAL);
+            }
 
             // Draw
-            drawcallInfo.drawcall.Draw();
+            drawcallInfo.Draw();
 
             first = false;
         }
     }
+
+    // Depth writes are also needed to clear the depth buffer
+    device.SetDepthWrite(true);
+}
+
+void ForwardRenderPass::RenderDepthPrePass()
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+    const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
+
+    // Depth only, same test as the first light
+    device.SetColorWrite(false);
+    device.SetDepthWrite(true);
+    device.SetDepthFunction(GL_LESS);
+    device.SetFeatureEnabled(GL_BLEND, false);
+
+    for (unsigned int drawcallIndex = 0; drawcallIndex < drawcallCollection.size(); ++drawcallIndex)
+    {
+        const Renderer::DrawcallInfo& drawcallInfo = drawcallCollection[drawcallIndex];
+        const Material& material = drawcallInfo.material;
+
+        // Translucent drawcalls, the ones that don't write depth and the materials that didn't opt in keep the normal depth test
+        bool translucent = material.GetBlendEquationColor() != Material::BlendEquation::None
+            || material.GetBlendEquationAlpha() != Material::BlendEquation::None;
+        if (translucent || !material.GetDepthWrite() || !material.GetDepthPrePass())
+        {
+            continue;
+        }
+
+        const DepthProgramCache::DepthProgram* depthProgram = m_depthPrograms.GetDepthProgram(*material.GetShaderProgram());
+        if (!depthProgram)
+        {
+            continue;
+        }
+
+        // Instanced drawcalls need the instance attribute in the depth program, at the same location
+        if (drawcallInfo.instanceCount > 0 && depthProgram->instanceWorldMatrixLocation < 0)
+        {
+            continue;
+        }
+
+        renderer.PrepareDrawcall(drawcallInfo, *depthProgram->shaderProgram,
+            depthProgram->worldMatrixLocation, depthProgram->instanceWorldMatrixLocation);
+        drawcallInfo.Draw();
+
+        m_depthPrePassed[drawcallIndex] = true;
+    }
+
+    device.SetColorWrite(true);
+}
+
+void ForwardRenderPass::SelectLights(const Renderer::DrawcallInfo& drawcallInfo, unsigned int maxLightCount)
+{
+    const Renderer& renderer = GetRenderer();
+    const auto& lights = renderer.GetLights();
+
+    glm::vec3 boundsMin, boundsMax;
+    bool hasBounds = renderer.GetDrawcallBounds(drawcallInfo, boundsMin, boundsMax);
+
+    m_lightDistances.clear();
+    for (int lightIndex = 0; lightIndex < static_cast<int>(lights.size()); ++lightIndex)
+    {
+        const Light& light = *lights[lightIndex];
+
+        // Directional lights have no range and always affect the drawcall
+        float distance = 0.0f;
+        if (hasBounds && light.GetType() != Light::Type::Directional)
+        {
+            glm::vec3 position = light.GetPosition();
+            distance = glm::distance(position, glm::clamp(position, boundsMin, boundsMax));
+
+            // Attenuation y is the distance where the light reaches zero. If it is 0, the light has no range limit
+            float range = light.GetAttenuation().y;
+            if (range > 0.0f && distance > range)
+            {
+                continue;
+            }
+        }
+        m_lightDistances.emplace_back(distance, lightIndex);
+    }
+
+    // Keep the closest lights if there are too many
+    if (m_lightDistances.size() > maxLightCount)
+    {
+        std::nth_element(m_lightDistances.begin(), m_lightDistances.begin() + maxLightCount, m_lightDistances.end());
+        m_lightDistances.resize(maxLightCount);
+    }
+
+    m_lightIndices.clear();
+    for (const auto& [distance, lightIndex] : m_lightDistances)
+    {
+        m_lightIndices.push_back(lightIndex);
+    }
 }
@@ -6,17 +6,50 @@
 #include <ituGL/renderer/Renderer.h>
 
 GBufferRenderPass::GBufferRenderPass(int width, int height, int drawcallCollectionIndex)
-    : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    : RenderPass("GBuffer"), m_drawcallCollectionIndex(drawcallCollectionIndex), m_width(width), m_height(height)
 {
-    InitTextures(width, height);
-    InitFramebuffer();
+}
+
+void GBufferRenderPass::SetSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+}
+
+void GBufferRenderPass::Setup(RenderGraph::PassBuilder& builder)
+{
+    // Depth and stencil, so they can be copied to a framebuffer with the same format (like the default one)
+    builder.CreateTexture(DepthTextureName, { m_width, m_height, TextureObject::FormatDepthStencil, TextureObject::InternalFormatDepth24Stencil8 });
+    builder.CreateTexture(AlbedoTextureName, { m_width, m_height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8 });
+    builder.CreateTexture(NormalTextureName, { m_width, m_height, TextureObject::FormatRG, TextureObject::InternalFormatRG16F });
+    builder.CreateTexture(OthersTextureName, { m_width, m_height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8 });
+}
+
+void GBufferRenderPass::UpdateTextures()
+{
+    std::shared_ptr<Texture2DObject> depthTexture = GetGraphTexture(DepthTextureName);
+    std::shared_ptr<Texture2DObject> albedoTexture = GetGraphTexture(AlbedoTextureName);
+    std::shared_ptr<Texture2DObject> normalTexture = GetGraphTexture(NormalTextureName);
+    std::shared_ptr<Texture2DObject> othersTexture = GetGraphTexture(OthersTextureName);
+
+    // The pool usually returns the same textures every frame, so the framebuffer is rarely updated
+    if (depthTexture != m_depthTexture || albedoTexture != m_albedoTexture
+        || normalTexture != m_normalTexture || othersTexture != m_othersTexture)
+    {
+        m_depthTexture = depthTexture;
+        m_albedoTexture = albedoTexture;
+        m_normalTexture = normalTexture;
+        m_othersTexture = othersTexture;
+        InitFramebuffer();
+    }
 }
 
 void GBufferRenderPass::InitFramebuffer()
 {
     m_framebuffer.Bind();
 
-    m_framebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_depthTexture);
+    // Depth and stencil, so they can be copied to a framebuffer with the same format (like the default one)
+    m_framebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::DepthStencil, *m_depthTexture);
 
     // Set the albedo texture as color attachment 0
     m_framebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_albedoTexture);
@@ -38,39 +71,6 @@ void GBufferRenderPass::InitFramebuffer()
     FramebufferObject::Unbind();
 }
 
-void GBufferRenderPass::InitTextures(int width, int height)
-{
-    // (todo) 07.4: Depth: Set the min and magfilter as nearest
-    m_depthTexture = std::make_shared<Texture2DObject>();
-    m_depthTexture->Bind();
-    m_depthTexture->SetImage(0, width, height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth);
-    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    // Albedo: Bind the newly created texture, set the image, and the min and magfilter as nearest
-    m_albedoTexture = std::make_shared<Texture2DObject>();
-    m_albedoTexture->Bind();
-    m_albedoTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8);
-    m_albedoTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_albedoTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    // Normal: Bind the newly created texture, set the image and the min and magfilter as nearest
-    m_normalTexture = std::make_shared<Texture2DObject>();
-    m_normalTexture->Bind();
-    m_normalTexture->SetImage(0, width, height, TextureObject::FormatRG, TextureObject::InternalFormatRG16F);
-    m_normalTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_normalTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    // Others: Bind the newly created texture, set the image and the min and magfilter as nearest
-    m_othersTexture = std::make_shared<Texture2DObject>();
-    m_othersTexture->Bind();
-    m_othersTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8);
-    m_othersTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_othersTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    Texture2DObject::Unbind();
-}
-
 void GBufferRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
@@ -79,8 +79,11 @@ void GBufferRenderPass::Render()
     const auto& lights = renderer.GetLights();
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
-    // Bind the framebuffer with the render targets
+    UpdateTextures();
+
+    // Bind the framebuffer with the render targets, drawing only to the render viewport with dynamic resolution
     m_framebuffer.Bind();
+    renderer.SetRenderViewport();
 
     renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
 
@@ -95,7 +98,7 @@ void GBufferRenderPass::Render()
         renderer.PrepareDrawcall(drawcallInfo);
 
         // Render drawcall
-        drawcallInfo.drawcall.Draw();
+        drawcallInfo.Draw();
     }
 
     // Unbind the framebuffer
@@ -0,0 +1,47 @@
+#include <ituGL/renderer/RenderCommandList.h>
+
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/camera/Camera.h>
+
+RenderCommandList::RenderCommandList() : m_camera(nullptr)
+{
+}
+
+void RenderCommandList::Reset(const Camera* camera)
+{
+    m_camera = camera;
+    m_worldMatrices.clear();
+    m_worldBounds.clear();
+    m_worldDepths.clear();
+    m_worldDynamic.clear();
+    m_drawcalls.clear();
+    m_shadowCasterDrawcalls.clear();
+}
+
+void RenderCommandList::AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic)
+{
+    AddModel(model, worldMatrix, dynamic, m_drawcalls);
+}
+
+void RenderCommandList::AddShadowCaster(const Model& model, const glm::mat4& worldMatrix, bool dynamic)
+{
+    AddModel(model, worldMatrix, dynamic, m_shadowCasterDrawcalls);
+}
+
+void RenderCommandList::AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic, std::vector<Renderer::DrawcallInfo>& drawcalls)
+{
+    unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
+    m_worldMatrices.push_back(worldMatrix);
+
+    const Mesh& mesh = model.GetMesh();
+    m_worldBounds.push_back(Renderer::ComputeWorldBounds(mesh, worldMatrix));
+    m_worldDepths.push_back(m_camera ? Renderer::ComputeViewDepth(*m_camera, worldMatrix) : -1.0f);
+    m_worldDynamic.push_back(dynamic);
+
+    for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+    {
+        drawcalls.emplace_back(model.GetMaterial(submeshIndex), worldMatrixIndex,
+            mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+    }
+}
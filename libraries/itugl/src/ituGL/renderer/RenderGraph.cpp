@@ -0,0 +1,268 @@
+#include <ituGL/renderer/RenderGraph.h>
+
+#include <ituGL/renderer/RenderPass.h>
+#include <algorithm>
+#include <cassert>
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, unsigned int passIndex) : m_graph(graph), m_passIndex(passIndex)
+{
+}
+
+RenderGraph::ResourceId RenderGraph::PassBuilder::CreateTexture(const std::string& name, const TextureDesc& desc)
+{
+    assert(m_graph.FindResource(name) == InvalidResource); // Resource names must be unique in the frame
+    ResourceId resourceId = static_cast<ResourceId>(m_graph.m_resources.size());
+    m_graph.m_resources.push_back(Resource{ name, desc, false, false, nullptr, 0, -1, -1 });
+    m_graph.m_passes[m_passIndex].creates.push_back(resourceId);
+    return resourceId;
+}
+
+RenderGraph::ResourceId RenderGraph::PassBuilder::ImportTexture(const std::string& name, std::shared_ptr<Texture2DObject> texture)
+{
+    return m_graph.ImportTexture(name, texture);
+}
+
+RenderGraph::ResourceId RenderGraph::PassBuilder::Read(const std::string& name)
+{
+    ResourceId resourceId = m_graph.FindResource(name);
+    if (resourceId != InvalidResource)
+    {
+        m_graph.m_passes[m_passIndex].reads.push_back(resourceId);
+    }
+    return resourceId;
+}
+
+RenderGraph::ResourceId RenderGraph::PassBuilder::Write(const std::string& name)
+{
+    ResourceId resourceId = m_graph.FindResource(name);
+    if (resourceId != InvalidResource)
+    {
+        m_graph.m_passes[m_passIndex].writes.push_back(resourceId);
+    }
+    return resourceId;
+}
+
+void RenderGraph::PassBuilder::SetSideEffect()
+{
+    m_graph.m_passes[m_passIndex].sideEffect = true;
+}
+
+RenderGraph::RenderGraph(TexturePool& texturePool) : m_texturePool(texturePool)
+    , m_transientResourceCount(0), m_transientTextureCount(0)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+}
+
+void RenderGraph::Reset()
+{
+    // Transient textures were released to the pool in Compile, except the outputs
+    for (const Resource& resource : m_resources)
+    {
+        if (!resource.imported && resource.output && resource.firstPass >= 0)
+        {
+            m_texturePool.Release(resource.texture);
+        }
+    }
+
+    m_passes.clear();
+    m_resources.clear();
+}
+
+RenderGraph::ResourceId RenderGraph::ImportTexture(const std::string& name, std::shared_ptr<Texture2DObject> texture)
+{
+    assert(FindResource(name) == InvalidResource);
+    ResourceId resourceId = static_cast<ResourceId>(m_resources.size());
+    TextureDesc desc = { 0, 0, TextureObject::FormatInvalid, TextureObject::InternalFormatInvalid };
+    m_resources.push_back(Resource{ name, desc, true, false, texture, 0, -1, -1 });
+    return resourceId;
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(RenderPass& pass)
+{
+    unsigned int passIndex = static_cast<unsigned int>(m_passes.size());
+    m_passes.push_back(Pass{ &pass, {}, {}, {}, false, 0, false });
+    return PassBuilder(*this, passIndex);
+}
+
+void RenderGraph::MarkOutput(const std::string& name)
+{
+    ResourceId resourceId = FindResource(name);
+    if (resourceId != InvalidResource)
+    {
+        m_resources[resourceId].output = true;
+    }
+}
+
+void RenderGraph::Compile()
+{
+    CullPasses();
+    ComputeLifetimes();
+    AssignTextures();
+}
+
+RenderGraph::ResourceId RenderGraph::FindResource(const std::string& name) const
+{
+    // Only a few resources per frame, a linear search is enough
+    for (unsigned int resourceId = 0; resourceId < m_resources.size(); ++resourceId)
+    {
+        if (m_resources[resourceId].name == name)
+        {
+            return static_cast<ResourceId>(resourceId);
+        }
+    }
+    return InvalidResource;
+}
+
+std::shared_ptr<Texture2DObject> RenderGraph::GetTexture(ResourceId resourceId) const
+{
+    return resourceId != InvalidResource ? m_resources[resourceId].texture : nullptr;
+}
+
+std::shared_ptr<Texture2DObject> RenderGraph::GetTexture(const std::string& name) const
+{
+    return GetTexture(FindResource(name));
+}
+
+void RenderGraph::CullPasses()
+{
+    // Resources are referenced by their readers, and passes by the resources they produce
+    for (Resource& resource : m_resources)
+    {
+        resource.readerCount = (resource.imported || resource.output) ? 1 : 0;
+    }
+    for (Pass& pass : m_passes)
+    {
+        pass.referenceCount = static_cast<unsigned int>(pass.writes.size() + pass.creates.size());
+        pass.culled = false;
+        for (ResourceId resourceId : pass.reads)
+        {
+            m_resources[resourceId].readerCount++;
+        }
+    }
+
+    std::vector<ResourceId> unusedResources;
+    auto cullPass = [&](Pass& pass)
+    {
+        pass.culled = true;
+        for (ResourceId resourceId : pass.reads)
+        {
+            if (--m_resources[resourceId].readerCount == 0)
+            {
+                unusedResources.push_back(resourceId);
+            }
+        }
+    };
+
+    for (ResourceId resourceId = 0; resourceId < static_cast<ResourceId>(m_resources.size()); ++resourceId)
+    {
+        if (m_resources[resourceId].readerCount == 0)
+        {
+            unusedResources.push_back(resourceId);
+        }
+    }
+
+    // Passes without outputs or side effects are not needed
+    for (Pass& pass : m_passes)
+    {
+        if (pass.referenceCount == 0 && !pass.sideEffect)
+        {
+            cullPass(pass);
+        }
+    }
+
+    // Nobody reads these resources, so their producers lose a reference. Culling a producer can leave its inputs unused too
+    while (!unusedResources.empty())
+    {
+        ResourceId resourceId = unusedResources.back();
+        unusedResources.pop_back();
+
+        for (Pass& pass : m_passes)
+        {
+            if (pass.culled)
+            {
+                continue;
+            }
+            bool produces = std::find(pass.creates.begin(), pass.creates.end(), resourceId) != pass.creates.end()
+                || std::find(pass.writes.begin(), pass.writes.end(), resourceId) != pass.writes.end();
+            if (produces && --pass.referenceCount == 0 && !pass.sideEffect)
+            {
+                cullPass(pass);
+            }
+        }
+    }
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+    for (Resource& resource : m_resources)
+    {
+        resource.firstPass = -1;
+        resource.lastPass = -1;
+    }
+
+    for (int passIndex = 0; passIndex < static_cast<int>(m_passes.size()); ++passIndex)
+    {
+        const Pass& pass = m_passes[passIndex];
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        for (const std::vector<ResourceId>* resourceIds : { &pass.creates, &pass.reads, &pass.writes })
+        {
+            for (ResourceId resourceId : *resourceIds)
+            {
+                Resource& resource = m_resources[resourceId];
+                if (resource.firstPass < 0)
+                {
+                    resource.firstPass = passIndex;
+                }
+                resource.lastPass = std::max(resource.lastPass, passIndex);
+            }
+        }
+    }
+}
+
+void RenderGraph::AssignTextures()
+{
+    m_transientResourceCount = 0;
+    m_transientTextureCount = 0;
+    std::vector<const Texture2DObject*> distinctTextures;
+
+    // Walk the passes in order: textures are acquired before the first use, and released after the last one,
+    // so a later resource with the same description can reuse them in the same frame
+    for (int passIndex = 0; passIndex < static_cast<int>(m_passes.size()); ++passIndex)
+    {
+        if (m_passes[passIndex].culled)
+        {
+            continue;
+        }
+
+        for (Resource& resource : m_resources)
+        {
+            if (!resource.imported && resource.firstPass == passIndex)
+            {
+                resource.texture = m_texturePool.Acquire(resource.desc);
+                m_transientResourceCount++;
+                if (std::find(distinctTextures.begin(), distinctTextures.end(), resource.texture.get()) == distinctTextures.end())
+                {
+                    distinctTextures.push_back(resource.texture.get());
+                }
+            }
+        }
+
+        for (Resource& resource : m_resources)
+        {
+            // Outputs are read after the graph, so they are not released until the next frame
+            if (!resource.imported && !resource.output && resource.lastPass == passIndex)
+            {
+                m_texturePool.Release(resource.texture);
+            }
+        }
+    }
+
+    m_transientTextureCount = static_cast<unsigned int>(distinctTextures.size());
+}
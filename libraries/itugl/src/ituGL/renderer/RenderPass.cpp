@@ -1,9 +1,11 @@
 #include <ituGL/renderer/RenderPass.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/core/Profiler.h>
 #include <cassert>
 
-RenderPass::RenderPass() : m_renderer(nullptr)
+RenderPass::RenderPass(const std::string& name) : m_renderer(nullptr), m_name(name), m_zoneName(nullptr)
 {
 }
 
@@ -11,9 +13,33 @@ RenderPass::~RenderPass()
 {
 }
 
+void RenderPass::Setup(RenderGraph::PassBuilder& builder)
+{
+    builder.SetSideEffect();
+}
+
+void RenderPass::AddInputTexture(const std::string& resourceName, std::shared_ptr<Material> material, const char* uniformName)
+{
+    assert(material);
+    ShaderProgram::Location location = material->GetUniformLocation(uniformName);
+    assert(location >= 0);
+    m_inputTextures.push_back(InputTexture{ resourceName, material, location });
+}
+
+void RenderPass::SetName(const std::string& name)
+{
+    m_name = name;
+    if (m_renderer)
+    {
+        m_zoneName = Profiler::InternName(m_name);
+    }
+}
+
 void RenderPass::SetRenderer(Renderer* renderer)
 {
     m_renderer = renderer;
+    // Interned once here instead of every frame, so the zones don't lock the name table
+    m_zoneName = Profiler::InternName(m_name);
 }
 
 Renderer& RenderPass::GetRenderer()
@@ -27,3 +53,24 @@ const Renderer& RenderPass::GetRenderer() const
     assert(m_renderer);
     return *m_renderer;
 }
+
+std::shared_ptr<Texture2DObject> RenderPass::GetGraphTexture(const std::string& resourceName) const
+{
+    return GetRenderer().GetRenderGraph().GetTexture(resourceName);
+}
+
+void RenderPass::SetupInputTextures(RenderGraph::PassBuilder& builder)
+{
+    for (const InputTexture& inputTexture : m_inputTextures)
+    {
+        builder.Read(inputTexture.resourceName);
+    }
+}
+
+void RenderPass::BindInputTextures()
+{
+    for (const InputTexture& inputTexture : m_inputTextures)
+    {
+        inputTexture.material->SetUniformValue(inputTexture.location, GetGraphTexture(inputTexture.resourceName));
+    }
+}
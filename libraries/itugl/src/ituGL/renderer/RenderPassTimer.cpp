@@ -0,0 +1,200 @@
+#include <ituGL/renderer/RenderPassTimer.h>
+
+#include <ituGL/utils/DearImGui.h>
+#include <imgui.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <cassert>
+
+RenderPassTimer::RenderPassTimer(unsigned int windowSize) : m_frames{}, m_currentFrame(0)
+    , m_windowSize(std::max(windowSize, 1u)), m_droppedFrameCount(0)
+    , m_lastFrameTime(0.0f), m_readFrameCount(0), m_passActive(false)
+{
+}
+
+void RenderPassTimer::SetWindowSize(unsigned int windowSize)
+{
+    m_windowSize = std::max(windowSize, 1u);
+    for (PassSamples& pass : m_passes)
+    {
+        pass.samples.clear();
+        pass.nextSample = 0;
+    }
+}
+
+void RenderPassTimer::BeginFrame()
+{
+    assert(!m_passActive);
+
+    // Read the older frames first, so the samples are in order
+    for (unsigned int i = 1; i <= FrameLatency; ++i)
+    {
+        ReadResults((m_currentFrame + i) % FrameLatency);
+    }
+
+    // The queries of the oldest frame are reused for the new one. If they are still not ready, they are discarded
+    m_currentFrame = (m_currentFrame + 1) % FrameLatency;
+    Frame& frame = m_frames[m_currentFrame];
+    if (frame.pending)
+    {
+        m_droppedFrameCount++;
+    }
+    frame.queryCount = 0;
+    frame.passIndices.clear();
+    frame.pending = true;
+}
+
+void RenderPassTimer::BeginPass(unsigned int passIndex, const std::string& name)
+{
+    assert(!m_passActive);
+
+    if (passIndex >= m_passes.size())
+    {
+        m_passes.resize(passIndex + 1, PassSamples{ "", {}, 0 });
+    }
+    m_passes[passIndex].name = name;
+
+    Frame& frame = m_frames[m_currentFrame];
+    if (frame.queryCount == frame.queries.size())
+    {
+        frame.queries.emplace_back();
+    }
+    frame.queries[frame.queryCount++].Begin(QueryObject::TimeElapsed);
+    frame.passIndices.push_back(passIndex);
+    m_passActive = true;
+}
+
+void RenderPassTimer::EndPass()
+{
+    assert(m_passActive);
+    QueryObject::End(QueryObject::TimeElapsed);
+    m_passActive = false;
+}
+
+void RenderPassTimer::ReadResults(unsigned int frameIndex)
+{
+    Frame& frame = m_frames[frameIndex];
+    if (!frame.pending || frameIndex == m_currentFrame)
+    {
+        return;
+    }
+
+    // Queries finish in order, if the last one is ready all of them are
+    if (frame.queryCount > 0 && !frame.queries[frame.queryCount - 1].IsResultAvailable())
+    {
+        return;
+    }
+
+    float frameTime = 0.0f;
+    for (unsigned int queryIndex = 0; queryIndex < frame.queryCount; ++queryIndex)
+    {
+        PassSamples& pass = m_passes[frame.passIndices[queryIndex]];
+        float milliseconds = static_cast<float>(frame.queries[queryIndex].GetResult()) * 1.0e-6f;
+        frameTime += milliseconds;
+        if (pass.samples.size() < m_windowSize)
+        {
+            pass.samples.push_back(milliseconds);
+        }
+        else
+        {
+            pass.samples[pass.nextSample] = milliseconds;
+        }
+        pass.nextSample = (pass.nextSample + 1) % m_windowSize;
+    }
+    frame.pending = false;
+
+    m_lastFrameTime = frameTime;
+    m_readFrameCount++;
+}
+
+const std::string& RenderPassTimer::GetPassName(unsigned int passIndex) const
+{
+    return m_passes[passIndex].name;
+}
+
+RenderPassTimer::Statistics RenderPassTimer::GetStatistics(unsigned int passIndex) const
+{
+    const PassSamples& pass = m_passes[passIndex];
+
+    Statistics statistics = { 0.0f, 0.0f, 0.0f, 0.0f, static_cast<unsigned int>(pass.samples.size()) };
+    if (pass.samples.empty())
+    {
+        return statistics;
+    }
+
+    float sum = 0.0f;
+    statistics.min = std::numeric_limits<float>::max();
+    for (float sample : pass.samples)
+    {
+        statistics.min = std::min(statistics.min, sample);
+        sum += sample;
+    }
+    statistics.avg = sum / pass.samples.size();
+    statistics.last = pass.samples[(pass.nextSample + pass.samples.size() - 1) % pass.samples.size()];
+
+    // Nearest rank percentile
+    std::vector<float> sorted(pass.samples);
+    size_t rank = (sorted.size() * 99 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    statistics.p99 = sorted[rank];
+
+    return statistics;
+}
+
+bool RenderPassTimer::WriteCsv(const char* path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "pass,name,min_ms,avg_ms,p99_ms,last_ms,samples\n";
+    for (unsigned int passIndex = 0; passIndex < GetPassCount(); ++passIndex)
+    {
+        Statistics statistics = GetStatistics(passIndex);
+        file << passIndex << ',' << GetPassName(passIndex) << ',' << statistics.min << ',' << statistics.avg << ','
+            << statistics.p99 << ',' << statistics.last << ',' << statistics.sampleCount << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+void RenderPassTimer::DrawGUI(DearImGui& imGui, const char* csvPath)
+{
+    if (auto window = imGui.UseWindow("GPU timings"))
+    {
+        if (ImGui::BeginTable("Passes", 5))
+        {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("Min (ms)");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableSetupColumn("P99 (ms)");
+            ImGui::TableSetupColumn("Last (ms)");
+            ImGui::TableHeadersRow();
+
+            for (unsigned int passIndex = 0; passIndex < GetPassCount(); ++passIndex)
+            {
+                Statistics statistics = GetStatistics(passIndex);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%u: %s", passIndex, GetPassName(passIndex).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.min);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.avg);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.p99);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.last);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::Text("Dropped frames: %u", m_droppedFrameCount);
+        if (ImGui::Button("Save CSV"))
+        {
+            WriteCsv(csvPath);
+        }
+    }
+}
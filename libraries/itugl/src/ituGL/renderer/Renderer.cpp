@@ -6,14 +6,39 @@
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/VertexAttribute.h>
 #include <ituGL/lighting/Light.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/RenderCommandList.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/core/Profiler.h>
+#include <glm/common.hpp>
+#include <glm/matrix.hpp>
 #include <span>
+#include <cstring>
+#include <limits>
+#include <cmath>
 #include <algorithm>
+#include <bit>
+#include <map>
+#include <tuple>
 #include <cassert>
 
-Renderer::Renderer(DeviceGL& device) : m_device(device), m_currentCamera(nullptr), m_drawcallCollections(1)
+Renderer::Renderer(DeviceGL& device) : m_device(device), m_submitFrame(&m_frames[0]), m_renderFrame(&m_frames[0])
+    , m_currentMaterial(nullptr), m_currentShaderProgram(nullptr), m_currentVao(nullptr), m_currentWorldMatrixIndex(0)
+    , m_skippedBindCount(0), m_lastSkippedBindCount(0), m_sortDrawcalls(true)
+    , m_commandListCount(0), m_instancingEnabled(true), m_multiDrawEnabled(true), m_lastDrawcallCount(0)
+    , m_renderGraph(m_texturePool), m_passTimingEnabled(true)
+    , m_renderWidth(0), m_renderHeight(0), m_renderScale(1.0f)
 {
+    for (FrameSubmission& frame : m_frames)
+    {
+        frame.camera = nullptr;
+        frame.time = 0.0f;
+        frame.deltaTime = 0.0f;
+        frame.drawcallCollections.resize(ShadowCasterCollectionIndex + 1);
+    }
+
     InitializeFullscreenMesh();
 
     device.EnableFeature(GL_FRAMEBUFFER_SRGB);
@@ -23,19 +48,125 @@ Renderer::Renderer(DeviceGL& device) : m_device(device), m_currentCamera(nullptr
     device.SetVSyncEnabled(true);
 }
 
+Renderer::~Renderer()
+{
+}
+
+void Renderer::SetFrameTime(float time, float deltaTime)
+{
+    m_submitFrame->time = time;
+    m_submitFrame->deltaTime = deltaTime;
+}
+
+void Renderer::GetRenderSize(int& width, int& height) const
+{
+    width = m_renderWidth;
+    height = m_renderHeight;
+}
+
+void Renderer::SetRenderSize(int width, int height)
+{
+    m_renderWidth = width;
+    m_renderHeight = height;
+}
+
+float Renderer::GetRenderScale() const
+{
+    return m_renderScale;
+}
+
+void Renderer::SetRenderScale(float renderScale)
+{
+    m_renderScale = std::clamp(renderScale, std::numeric_limits<float>::min(), 1.0f);
+}
+
+void Renderer::GetRenderViewport(int& width, int& height) const
+{
+    // At least one pixel, if there is a render size
+    width = std::min(static_cast<int>(std::ceil(m_renderWidth * m_renderScale)), m_renderWidth);
+    height = std::min(static_cast<int>(std::ceil(m_renderHeight * m_renderScale)), m_renderHeight);
+}
+
+void Renderer::SetRenderViewport()
+{
+    if (m_renderWidth > 0 && m_renderHeight > 0)
+    {
+        int width, height;
+        GetRenderViewport(width, height);
+        m_device.SetViewport(0, 0, width, height);
+    }
+}
+
 bool Renderer::HasCamera() const
 {
-    return m_currentCamera;
+    return m_renderFrame->camera;
 }
 
 const Camera& Renderer::GetCurrentCamera() const
 {
-    return *m_currentCamera;
+    return *m_renderFrame->camera;
+}
+
+bool Renderer::HasSubmittedCamera() const
+{
+    return m_submitFrame->camera;
+}
+
+const Camera& Renderer::GetSubmittedCamera() const
+{
+    return *m_submitFrame->camera;
 }
 
 void Renderer::SetCurrentCamera(const Camera& camera)
 {
-    m_currentCamera = &camera;
+    m_submitFrame->camera = &camera;
+}
+
+void Renderer::SubmitFrame()
+{
+    ITUGL_ZONE("Renderer::SubmitFrame");
+
+    // The frame rendered last is empty after Reset, so it takes the next submission
+    assert(m_commandListCount == 0);
+    m_submitFrame->CopyCameraAndLights();
+    FrameSubmission* nextFrame = m_submitFrame == &m_frames[0] ? &m_frames[1] : &m_frames[0];
+    m_renderFrame = m_submitFrame;
+    m_submitFrame = nextFrame;
+    m_submitFrame->time = m_renderFrame->time;
+    m_submitFrame->deltaTime = m_renderFrame->deltaTime;
+}
+
+void Renderer::FrameSubmission::CopyCameraAndLights()
+{
+    if (camera)
+    {
+        cameraCopy = *camera;
+        camera = &cameraCopy;
+    }
+
+    // Reserve first, so the pointers to the copies stay valid
+    size_t lightCount = lights.size();
+    directionalLightCopies.clear();
+    pointLightCopies.clear();
+    spotLightCopies.clear();
+    directionalLightCopies.reserve(lightCount);
+    pointLightCopies.reserve(lightCount);
+    spotLightCopies.reserve(lightCount);
+    for (const Light*& light : lights)
+    {
+        switch (light->GetType())
+        {
+        case Light::Type::Directional:
+            light = &directionalLightCopies.emplace_back(static_cast<const DirectionalLight&>(*light));
+            break;
+        case Light::Type::Point:
+            light = &pointLightCopies.emplace_back(static_cast<const PointLight&>(*light));
+            break;
+        case Light::Type::Spot:
+            light = &spotLightCopies.emplace_back(static_cast<const SpotLight&>(*light));
+            break;
+        }
+    }
 }
 
 const Mesh& Renderer::GetFullscreenMesh() const
@@ -45,11 +176,53 @@ const Mesh& Renderer::GetFullscreenMesh() const
 
 void Renderer::Render()
 {
-    assert(m_currentCamera);
+    ITUGL_ZONE("Renderer::Render");
+    assert(m_renderFrame->camera);
 
-    for (auto& pass : m_passes)
+    if (m_sortDrawcalls)
+    {
+        SortDrawcalls();
+    }
+
+    BuildInstances();
+
+    BuildMultiDraws();
+
+    UpdateFrameBuffer();
+    UpdateLightBuffer();
+
+    BuildRenderGraph();
+
+    if (m_passTimingEnabled)
     {
-        pass->Render();
+        m_passTimer.BeginFrame();
+    }
+
+    for (unsigned int passIndex = 0; passIndex < m_renderGraph.GetPassCount(); ++passIndex)
+    {
+        if (m_renderGraph.IsPassCulled(passIndex))
+        {
+            continue;
+        }
+
+        // Passes can set their own states, so the cached ones are not valid anymore
+        InvalidateDrawcallStates();
+
+        RenderPass& pass = m_renderGraph.GetPass(passIndex);
+        // The pass can be renamed or destroyed before the trace is written, so the zone uses the interned copy of the name
+        ITUGL_ZONE(pass.GetZoneName());
+        if (m_passTimingEnabled)
+        {
+            m_passTimer.BeginPass(passIndex, pass.GetName());
+        }
+
+        pass.BindInputTextures();
+        pass.Render();
+
+        if (m_passTimingEnabled)
+        {
+            m_passTimer.EndPass();
+        }
     }
 
     Reset();
@@ -57,14 +230,84 @@ void Renderer::Render()
 
 void Renderer::Reset()
 {
-    m_lights.clear();
+    FrameSubmission& frame = *m_renderFrame;
 
-    for (auto& collection : m_drawcallCollections)
+    frame.lights.clear();
+
+    frame.worldMatrices.clear();
+    frame.worldBounds.clear();
+    frame.worldDepths.clear();
+    frame.worldDynamic.clear();
+
+    // The shadow casters repeat the drawcalls of the other collections, they are counted by the shadow pass
+    m_lastDrawcallCount = 0;
+    for (unsigned int collectionIndex = 0; collectionIndex < frame.drawcallCollections.size(); ++collectionIndex)
     {
+        DrawcallCollection& collection = frame.drawcallCollections[collectionIndex];
+        if (collectionIndex != ShadowCasterCollectionIndex)
+        {
+            m_lastDrawcallCount += static_cast<unsigned int>(collection.size());
+        }
         collection.clear();
     }
 
-    m_currentCamera = nullptr;
+    frame.camera = nullptr;
+
+    InvalidateDrawcallStates();
+
+    m_lastSkippedBindCount = m_skippedBindCount;
+    m_skippedBindCount = 0;
+}
+
+void Renderer::BuildRenderGraph()
+{
+    // The outputs of the last frame go back to the pool, and the unused textures are destroyed
+    m_renderGraph.Reset();
+    m_texturePool.EndFrame();
+
+    for (auto& pass : m_passes)
+    {
+        RenderGraph::PassBuilder builder = m_renderGraph.AddPass(*pass);
+        pass->SetupInputTextures(builder);
+        pass->Setup(builder);
+    }
+
+    m_renderGraph.Compile();
+}
+
+const RenderGraph& Renderer::GetRenderGraph() const
+{
+    return m_renderGraph;
+}
+
+const TexturePool& Renderer::GetTexturePool() const
+{
+    return m_texturePool;
+}
+
+TexturePool& Renderer::GetTexturePool()
+{
+    return m_texturePool;
+}
+
+bool Renderer::GetPassTimingEnabled() const
+{
+    return m_passTimingEnabled;
+}
+
+void Renderer::SetPassTimingEnabled(bool passTimingEnabled)
+{
+    m_passTimingEnabled = passTimingEnabled;
+}
+
+const RenderPassTimer& Renderer::GetPassTimer() const
+{
+    return m_passTimer;
+}
+
+RenderPassTimer& Renderer::GetPassTimer()
+{
+    return m_passTimer;
 }
 
 int Renderer::AddRenderPass(std::unique_ptr<RenderPass> renderPass)
@@ -91,12 +334,45 @@ void Renderer::RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shader
     {
         m_updateLightsFunctions[shaderProgramPtr] = updateLightsFunction;
     }
+
+    // Shader programs that read the world matrix from a per-instance attribute are always drawn instanced
+    ShaderProgram::Location instanceWorldMatrixLocation = shaderProgramPtr->GetAttributeLocation("InstanceWorldMatrix");
+    if (instanceWorldMatrixLocation >= 0)
+    {
+        m_instanceWorldMatrixLocations[shaderProgramPtr] = instanceWorldMatrixLocation;
+    }
+
+    // The frame block is shared by all the shader programs, always at the same binding index
+    shaderProgramPtr->SetUniformBlockBinding("FrameBlock", FrameBlockBinding);
+
+    // Shader programs with a light array get the list of lights of each drawcall
+    LightArrayInfo lightArrayInfo;
+    lightArrayInfo.lightCountLocation = shaderProgramPtr->GetUniformLocation("LightCount");
+    lightArrayInfo.lightIndicesLocation = shaderProgramPtr->GetUniformLocation("LightIndices");
+    lightArrayInfo.size = 0;
+    if (lightArrayInfo.lightCountLocation >= 0 && lightArrayInfo.lightIndicesLocation >= 0)
+    {
+        // The array size is only available from the uniform info
+        for (unsigned int i = 0; i < shaderProgramPtr->GetUniformCount(); ++i)
+        {
+            int size;
+            GLenum glType;
+            char uniformName[256];
+            shaderProgramPtr->GetUniformInfo(i, size, glType, std::span(uniformName, sizeof(uniformName)));
+            if (std::strcmp(uniformName, "LightIndices[0]") == 0 || std::strcmp(uniformName, "LightIndices") == 0)
+            {
+                lightArrayInfo.size = static_cast<unsigned int>(size);
+                break;
+            }
+        }
+        m_lightArrays[shaderProgramPtr] = lightArrayInfo;
+    }
 }
 
 void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged) const
 {
-    const glm::mat4& worldMatrix = m_worldMatrices[worldMatrixIndex];
-    UpdateTransforms(shaderProgramPtr, worldMatrix);
+    const glm::mat4& worldMatrix = m_renderFrame->worldMatrices[worldMatrixIndex];
+    UpdateTransforms(shaderProgramPtr, worldMatrix, cameraChanged);
 }
 
 void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged) const
@@ -104,7 +380,7 @@ void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgr
     const auto& itFind = m_updateTransformsFunctions.find(shaderProgramPtr);
     if (itFind != m_updateTransformsFunctions.end())
     {
-        itFind->second(*shaderProgramPtr, worldMatrix, *m_currentCamera, cameraChanged);
+        itFind->second(*shaderProgramPtr, worldMatrix, *m_renderFrame->camera, cameraChanged);
     }
 }
 
@@ -154,54 +430,662 @@ bool Renderer::UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPt
     return false;
 }
 
+bool Renderer::HasLightArray(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const
+{
+    return m_lightArrays.contains(shaderProgramPtr);
+}
+
+unsigned int Renderer::GetLightArraySize(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const
+{
+    const auto& itFind = m_lightArrays.find(shaderProgramPtr);
+    return itFind != m_lightArrays.end() ? itFind->second.size : 0;
+}
+
+void Renderer::SetLightArray(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const int> lightIndices) const
+{
+    const LightArrayInfo& lightArrayInfo = m_lightArrays.at(shaderProgramPtr);
+
+    unsigned int lightCount = std::min(static_cast<unsigned int>(lightIndices.size()), lightArrayInfo.size);
+    shaderProgramPtr->SetUniform(lightArrayInfo.lightCountLocation, static_cast<int>(lightCount));
+    if (lightCount > 0)
+    {
+        shaderProgramPtr->SetUniforms(lightArrayInfo.lightIndicesLocation, lightIndices.first(lightCount));
+    }
+}
+
 std::span<const Light* const> Renderer::GetLights() const
 {
-    return m_lights;
+    return m_renderFrame->lights;
 }
 
 void Renderer::AddLight(const Light& light)
 {
-    m_lights.push_back(&light);
+    m_submitFrame->lights.push_back(&light);
 }
 
 std::span<const Renderer::DrawcallInfo> Renderer::GetDrawcalls(unsigned int collectionIndex) const
 {
-    return m_drawcallCollections[collectionIndex];
+    return m_renderFrame->drawcallCollections[collectionIndex];
+}
+
+bool Renderer::GetDrawcallBounds(const DrawcallInfo& drawcallInfo, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+    std::span<const WorldBounds> bounds = GetDrawcallWorldBounds(drawcallInfo);
+
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const WorldBounds& worldBounds : bounds)
+    {
+        if (worldBounds.min.x > worldBounds.max.x)
+        {
+            return false;
+        }
+        boundsMin = glm::min(boundsMin, worldBounds.min);
+        boundsMax = glm::max(boundsMax, worldBounds.max);
+    }
+    return true;
+}
+
+std::span<const Renderer::WorldBounds> Renderer::GetDrawcallWorldBounds(const DrawcallInfo& drawcallInfo) const
+{
+    return drawcallInfo.instanceCount > 0
+        ? std::span<const WorldBounds>(m_instanceBounds).subspan(drawcallInfo.firstInstance, drawcallInfo.instanceCount)
+        : std::span<const WorldBounds>(m_renderFrame->worldBounds).subspan(drawcallInfo.worldMatrixIndex, 1);
+}
+
+std::span<const glm::mat4> Renderer::GetDrawcallWorldMatrices(const DrawcallInfo& drawcallInfo) const
+{
+    return drawcallInfo.instanceCount > 0
+        ? std::span<const glm::mat4>(m_instanceWorldMatrices).subspan(drawcallInfo.firstInstance, drawcallInfo.instanceCount)
+        : std::span<const glm::mat4>(m_renderFrame->worldMatrices).subspan(drawcallInfo.worldMatrixIndex, 1);
+}
+
+bool Renderer::IsDrawcallDynamic(const DrawcallInfo& drawcallInfo) const
+{
+    // Instances and multi-draws only merge models with the same flag, so the first one is enough
+    return m_renderFrame->worldDynamic[drawcallInfo.worldMatrixIndex];
+}
+
+void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic)
+{
+    AddModel(model, worldMatrix, dynamic, false);
+}
+
+void Renderer::AddShadowCaster(const Model& model, const glm::mat4& worldMatrix, bool dynamic)
+{
+    AddModel(model, worldMatrix, dynamic, true);
 }
 
-void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix)
+void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix, bool dynamic, bool shadowCasterOnly)
 {
-    unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
-    m_worldMatrices.push_back(worldMatrix);
+    FrameSubmission& frame = *m_submitFrame;
+
+    unsigned int worldMatrixIndex = static_cast<unsigned int>(frame.worldMatrices.size());
+    frame.worldMatrices.push_back(worldMatrix);
 
     const Mesh& mesh = model.GetMesh();
+    frame.worldBounds.push_back(ComputeWorldBounds(mesh, worldMatrix));
+
+    // The camera may not be set yet, the depth is computed in SortDrawcalls
+    frame.worldDepths.push_back(-1.0f);
+
+    frame.worldDynamic.push_back(dynamic);
+
     for (int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
     {
         DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), worldMatrixIndex,
             mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
 
-        for (DrawcallCollection& collection : m_drawcallCollections)
+        if (shadowCasterOnly)
+        {
+            frame.drawcallCollections[ShadowCasterCollectionIndex].push_back(drawcallInfo);
+            continue;
+        }
+        for (DrawcallCollection& collection : frame.drawcallCollections)
         {
             collection.push_back(drawcallInfo);
         }
     }
 }
 
+void Renderer::BeginCommandLists(unsigned int count)
+{
+    while (m_commandLists.size() < count)
+    {
+        m_commandLists.push_back(std::make_unique<RenderCommandList>());
+    }
+
+    m_commandListCount = count;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        m_commandLists[i]->Reset(m_submitFrame->camera);
+    }
+}
+
+RenderCommandList& Renderer::GetCommandList(unsigned int index)
+{
+    assert(index < m_commandListCount);
+    return *m_commandLists[index];
+}
+
+void Renderer::MergeCommandLists()
+{
+    ITUGL_ZONE("Renderer::MergeCommandLists");
+    FrameSubmission& frame = *m_submitFrame;
+    for (unsigned int i = 0; i < m_commandListCount; ++i)
+    {
+        RenderCommandList& commandList = *m_commandLists[i];
+
+        // The world matrices of the list go after the ones already in the renderer
+        unsigned int firstWorldMatrix = static_cast<unsigned int>(frame.worldMatrices.size());
+        frame.worldMatrices.insert(frame.worldMatrices.end(), commandList.m_worldMatrices.begin(), commandList.m_worldMatrices.end());
+        frame.worldBounds.insert(frame.worldBounds.end(), commandList.m_worldBounds.begin(), commandList.m_worldBounds.end());
+        frame.worldDepths.insert(frame.worldDepths.end(), commandList.m_worldDepths.begin(), commandList.m_worldDepths.end());
+        frame.worldDynamic.insert(frame.worldDynamic.end(), commandList.m_worldDynamic.begin(), commandList.m_worldDynamic.end());
+
+        for (DrawcallCollection& collection : frame.drawcallCollections)
+        {
+            collection.reserve(collection.size() + commandList.m_drawcalls.size());
+            for (const DrawcallInfo& drawcallInfo : commandList.m_drawcalls)
+            {
+                collection.emplace_back(drawcallInfo.material, firstWorldMatrix + drawcallInfo.worldMatrixIndex,
+                    drawcallInfo.vao, drawcallInfo.drawcall);
+            }
+        }
+
+        DrawcallCollection& shadowCasters = frame.drawcallCollections[ShadowCasterCollectionIndex];
+        for (const DrawcallInfo& drawcallInfo : commandList.m_shadowCasterDrawcalls)
+        {
+            shadowCasters.emplace_back(drawcallInfo.material, firstWorldMatrix + drawcallInfo.worldMatrixIndex,
+                drawcallInfo.vao, drawcallInfo.drawcall);
+        }
+
+        commandList.Reset(nullptr);
+    }
+    m_commandListCount = 0;
+}
+
 void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo)
 {
-    std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.material.GetShaderProgram();
+    const Material& material = drawcallInfo.material;
+    std::shared_ptr<const ShaderProgram> shaderProgram = material.GetShaderProgram();
 
-    // TODO: Room for optimization here, caching current material, current worldMatrixIndex and current VAO
+    // Setup material, only if it changed. Skip the shader program if it is already in use
+    bool materialChanged = &material != m_currentMaterial;
+    if (materialChanged)
+    {
+        if (shaderProgram.get() != m_currentShaderProgram)
+        {
+            material.Use();
+            m_currentShaderProgram = shaderProgram.get();
+        }
+        else
+        {
+            material.Use(Material::OverrideShaderProgram);
+            m_skippedBindCount++;
+        }
+        m_currentMaterial = &material;
+    }
+    else
+    {
+        // Shader program and material properties are already set
+        m_skippedBindCount += 2;
+    }
+
+    // Setup world matrix, only if it changed or the material overwrote the uniforms
+    // Setup camera, only if the material overwrote the uniforms
+    if (materialChanged || drawcallInfo.worldMatrixIndex != m_currentWorldMatrixIndex)
+    {
+        UpdateTransforms(shaderProgram, drawcallInfo.worldMatrixIndex, materialChanged);
+        m_currentWorldMatrixIndex = drawcallInfo.worldMatrixIndex;
+    }
+    else
+    {
+        m_skippedBindCount++;
+    }
+
+    // Setup VAO, only if it changed
+    if (&drawcallInfo.vao != m_currentVao)
+    {
+        drawcallInfo.vao.Bind();
+        m_currentVao = &drawcallInfo.vao;
+    }
+    else
+    {
+        m_skippedBindCount++;
+    }
+
+    // The instances are selected by the base instance of the draw, see SetupInstancing
+    assert(drawcallInfo.instanceCount == 0 || IsInstancingSetup(m_instanceWorldMatrixLocations.at(shaderProgram)));
+
+    // The indirect commands are read from the buffer bound when drawing
+    if (drawcallInfo.commandCount > 0)
+    {
+        m_indirectBuffer.Bind();
+    }
+}
+
+void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, const ShaderProgram& shaderProgram,
+    GLint worldMatrixLocation, GLint instanceWorldMatrixLocation)
+{
+    // No material, the next PrepareDrawcall with a material must set it again
+    bool shaderProgramChanged = &shaderProgram != m_currentShaderProgram;
+    if (shaderProgramChanged)
+    {
+        shaderProgram.Use();
+        m_currentShaderProgram = &shaderProgram;
+        m_currentMaterial = nullptr;
+    }
+    else
+    {
+        m_skippedBindCount++;
+    }
+
+    // Setup world matrix, from the uniform if not instanced
+    if (drawcallInfo.instanceCount > 0)
+    {
+        assert(instanceWorldMatrixLocation >= 0);
+    }
+    else if (shaderProgramChanged || drawcallInfo.worldMatrixIndex != m_currentWorldMatrixIndex)
+    {
+        shaderProgram.SetUniform(worldMatrixLocation, m_renderFrame->worldMatrices[drawcallInfo.worldMatrixIndex]);
+        m_currentWorldMatrixIndex = drawcallInfo.worldMatrixIndex;
+    }
+    else
+    {
+        m_skippedBindCount++;
+    }
+
+    // Setup VAO, only if it changed
+    if (&drawcallInfo.vao != m_currentVao)
+    {
+        drawcallInfo.vao.Bind();
+        m_currentVao = &drawcallInfo.vao;
+    }
+    else
+    {
+        m_skippedBindCount++;
+    }
+
+    assert(drawcallInfo.instanceCount == 0 || IsInstancingSetup(instanceWorldMatrixLocation));
+
+    if (drawcallInfo.commandCount > 0)
+    {
+        m_indirectBuffer.Bind();
+    }
+}
+
+void Renderer::SetupInstancing(Mesh& mesh) const
+{
+    assert(!m_instanceWorldMatrixLocations.empty());
+
+    GLint location = m_instanceWorldMatrixLocations.begin()->second;
+    assert(std::all_of(m_instanceWorldMatrixLocations.begin(), m_instanceWorldMatrixLocations.end(),
+        [location](const auto& entry) { return entry.second == location; }));
+
+    mesh.SetInstanceAttribute(location, m_instanceBuffer);
+}
+
+#ifndef NDEBUG
+// Check that the bound VAO reads the instance attribute from the instance buffer, per instance
+bool Renderer::IsInstancingSetup(GLint location) const
+{
+    GLint buffer = 0, divisor = 0;
+    glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+    glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+    return static_cast<Object::Handle>(buffer) == m_instanceBuffer.GetHandle() && divisor == 1;
+}
+#endif
+
+void Renderer::InvalidateDrawcallStates()
+{
+    m_currentMaterial = nullptr;
+    m_currentShaderProgram = nullptr;
+    m_currentVao = nullptr;
+}
+
+unsigned int Renderer::GetSkippedBindCount() const
+{
+    return m_lastSkippedBindCount;
+}
+
+bool Renderer::GetInstancingEnabled() const
+{
+    return m_instancingEnabled;
+}
+
+void Renderer::SetInstancingEnabled(bool instancingEnabled)
+{
+    m_instancingEnabled = instancingEnabled;
+}
+
+bool Renderer::GetMultiDrawEnabled() const
+{
+    return m_multiDrawEnabled;
+}
+
+void Renderer::SetMultiDrawEnabled(bool multiDrawEnabled)
+{
+    m_multiDrawEnabled = multiDrawEnabled;
+}
+
+unsigned int Renderer::GetDrawcallCount() const
+{
+    return m_lastDrawcallCount;
+}
+
+bool Renderer::GetSortDrawcalls() const
+{
+    return m_sortDrawcalls;
+}
+
+void Renderer::SetSortDrawcalls(bool sortDrawcalls)
+{
+    m_sortDrawcalls = sortDrawcalls;
+}
+
+void Renderer::SortDrawcalls()
+{
+    // View space depth of each world matrix origin, shared by all the submeshes of the model.
+    // Command lists compute them while recording, only the missing ones are computed here
+    FrameSubmission& frame = *m_renderFrame;
+    for (unsigned int worldMatrixIndex = 0; worldMatrixIndex < frame.worldMatrices.size(); ++worldMatrixIndex)
+    {
+        if (frame.worldDepths[worldMatrixIndex] < 0.0f)
+        {
+            frame.worldDepths[worldMatrixIndex] = ComputeViewDepth(*frame.camera, frame.worldMatrices[worldMatrixIndex]);
+        }
+    }
+    const std::vector<float>& depths = frame.worldDepths;
+
+    // Small ids for the materials, in order of appearance
+    std::unordered_map<const Material*, unsigned int> materialIds;
+
+    std::vector<std::pair<unsigned long long, unsigned int>> sortKeys;
+    DrawcallCollection sortedCollection;
+
+    for (unsigned int collectionIndex = 0; collectionIndex < frame.drawcallCollections.size(); ++collectionIndex)
+    {
+        DrawcallCollection& collection = frame.drawcallCollections[collectionIndex];
+
+        sortKeys.clear();
+        sortKeys.reserve(collection.size());
+        for (unsigned int drawcallIndex = 0; drawcallIndex < collection.size(); ++drawcallIndex)
+        {
+            const DrawcallInfo& drawcallInfo = collection[drawcallIndex];
+            const Material& material = drawcallInfo.material;
+
+            bool translucent = material.GetBlendEquationColor() != Material::BlendEquation::None
+                || material.GetBlendEquationAlpha() != Material::BlendEquation::None;
+            unsigned int materialId = materialIds.emplace(&material, static_cast<unsigned int>(materialIds.size())).first->second;
+
+            unsigned long long sortKey = ComputeSortKey(collectionIndex, translucent, material.GetShaderProgram()->GetHandle(),
+                materialId, drawcallInfo.vao.GetHandle(), depths[drawcallInfo.worldMatrixIndex]);
+            sortKeys.emplace_back(sortKey, drawcallIndex);
+        }
+
+        // Stable sort, so drawcalls with the same key keep the order in which they were added
+        std::stable_sort(sortKeys.begin(), sortKeys.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
 
-    // Setup material
-    drawcallInfo.material.Use();
+        // DrawcallInfo holds references and can't be assigned, so we build a new collection and swap them
+        sortedCollection.clear();
+        sortedCollection.reserve(collection.size());
+        for (const auto& [sortKey, drawcallIndex] : sortKeys)
+        {
+            sortedCollection.push_back(collection[drawcallIndex]);
+        }
+        collection.swap(sortedCollection);
+    }
+}
+
+void Renderer::BuildInstances()
+{
+    m_instanceWorldMatrices.clear();
+    m_instanceBounds.clear();
+    if (m_instanceWorldMatrixLocations.empty())
+    {
+        return;
+    }
+
+    // A batch is a group of drawcalls that will be rendered as one instanced drawcall
+    std::map<std::tuple<const Material*, const VertexArrayObject*, const Drawcall*, bool>, unsigned int> batchIndices;
+    std::vector<int> drawcallBatches;
+    std::vector<unsigned int> batchFirstDrawcall, batchInstanceCount, batchFirstInstance, batchNextInstance;
+    DrawcallCollection instancedCollection;
+
+    for (DrawcallCollection& collection : m_renderFrame->drawcallCollections)
+    {
+        batchIndices.clear();
+        drawcallBatches.assign(collection.size(), -1);
+        batchFirstDrawcall.clear();
+        batchInstanceCount.clear();
+
+        // Assign each drawcall to a batch. Sorted collections keep the order of the first drawcall of each batch
+        for (unsigned int drawcallIndex = 0; drawcallIndex < collection.size(); ++drawcallIndex)
+        {
+            const DrawcallInfo& drawcallInfo = collection[drawcallIndex];
+            const Material& material = drawcallInfo.material;
+            if (!m_instanceWorldMatrixLocations.contains(material.GetShaderProgram()))
+            {
+                continue;
+            }
+
+            // Translucent drawcalls keep their own batch, to preserve the blending order
+            bool translucent = material.GetBlendEquationColor() != Material::BlendEquation::None
+                || material.GetBlendEquationAlpha() != Material::BlendEquation::None;
+
+            unsigned int batchIndex = static_cast<unsigned int>(batchFirstDrawcall.size());
+            if (m_instancingEnabled && !translucent)
+            {
+                bool dynamic = m_renderFrame->worldDynamic[drawcallInfo.worldMatrixIndex];
+                auto key = std::make_tuple(&material, &drawcallInfo.vao, &drawcallInfo.drawcall, dynamic);
+                batchIndex = batchIndices.try_emplace(key, batchIndex).first->second;
+            }
+
+            if (batchIndex == batchFirstDrawcall.size())
+            {
+                batchFirstDrawcall.push_back(drawcallIndex);
+                batchInstanceCount.push_back(0);
+            }
+            batchInstanceCount[batchIndex]++;
+            drawcallBatches[drawcallIndex] = batchIndex;
+        }
+
+        if (batchFirstDrawcall.empty())
+        {
+            continue;
+        }
+
+        // Reserve consecutive world matrices for the instances of each batch
+        batchFirstInstance.resize(batchFirstDrawcall.size());
+        unsigned int instanceCount = static_cast<unsigned int>(m_instanceWorldMatrices.size());
+        for (unsigned int batchIndex = 0; batchIndex < batchFirstDrawcall.size(); ++batchIndex)
+        {
+            batchFirstInstance[batchIndex] = instanceCount;
+            instanceCount += batchInstanceCount[batchIndex];
+        }
+        batchNextInstance = batchFirstInstance;
+        m_instanceWorldMatrices.resize(instanceCount);
+        m_instanceBounds.resize(instanceCount);
+
+        // Copy the world matrices and replace each batch with a single instanced drawcall
+        instancedCollection.clear();
+        for (unsigned int drawcallIndex = 0; drawcallIndex < collection.size(); ++drawcallIndex)
+        {
+            const DrawcallInfo& drawcallInfo = collection[drawcallIndex];
+            int batchIndex = drawcallBatches[drawcallIndex];
+            if (batchIndex < 0)
+            {
+                instancedCollection.push_back(drawcallInfo);
+                continue;
+            }
+
+            unsigned int instanceIndex = batchNextInstance[batchIndex]++;
+            m_instanceWorldMatrices[instanceIndex] = m_renderFrame->worldMatrices[drawcallInfo.worldMatrixIndex];
+            m_instanceBounds[instanceIndex] = m_renderFrame->worldBounds[drawcallInfo.worldMatrixIndex];
+
+            // The first drawcall of the batch takes its place in the collection
+            if (batchFirstDrawcall[batchIndex] == drawcallIndex)
+            {
+                instancedCollection.emplace_back(drawcallInfo.material, drawcallInfo.worldMatrixIndex,
+                    drawcallInfo.vao, drawcallInfo.drawcall, batchFirstInstance[batchIndex], batchInstanceCount[batchIndex]);
+            }
+        }
+        collection.swap(instancedCollection);
+    }
+
+    // Upload all the instances at once
+    if (!m_instanceWorldMatrices.empty())
+    {
+        m_instanceBuffer.Bind();
+        m_instanceBuffer.AllocateData(std::span<const glm::mat4>(m_instanceWorldMatrices), BufferObject::Usage::StreamDraw);
+        VertexBufferObject::Unbind();
+    }
+}
+
+void Renderer::BuildMultiDraws()
+{
+    m_indirectCommands.clear();
+    if (!m_multiDrawEnabled || !GLAD_GL_VERSION_4_3)
+    {
+        return;
+    }
+
+    // Drawcalls can be merged if they draw from the same VAO with the same states
+    auto canMerge = [this](const DrawcallInfo& first, const DrawcallInfo& drawcallInfo)
+    {
+        return &first.material == &drawcallInfo.material && &first.vao == &drawcallInfo.vao
+            && first.drawcall.IsMultiDrawCompatible(drawcallInfo.drawcall)
+            && m_renderFrame->worldDynamic[first.worldMatrixIndex] == m_renderFrame->worldDynamic[drawcallInfo.worldMatrixIndex];
+    };
+
+    DrawcallCollection multiDrawCollection;
+
+    for (DrawcallCollection& collection : m_renderFrame->drawcallCollections)
+    {
+        multiDrawCollection.clear();
+
+        unsigned int drawcallIndex = 0;
+        while (drawcallIndex < collection.size())
+        {
+            // Only instanced drawcalls read the world matrix per instance, so each command can select its own.
+            // Translucent drawcalls are kept apart, they have to be drawn in order
+            const DrawcallInfo& first = collection[drawcallIndex];
+            const Material& material = first.material;
+            bool translucent = material.GetBlendEquationColor() != Material::BlendEquation::None
+                || material.GetBlendEquationAlpha() != Material::BlendEquation::None;
+            if (first.instanceCount == 0 || translucent || !first.drawcall.HasElements())
+            {
+                multiDrawCollection.push_back(first);
+                drawcallIndex++;
+                continue;
+            }
+
+            // Find the run of drawcalls, with consecutive instances, that can be merged with the first one
+            unsigned int runEnd = drawcallIndex + 1;
+            unsigned int instanceCount = first.instanceCount;
+            while (runEnd < collection.size())
+            {
+                const DrawcallInfo& drawcallInfo = collection[runEnd];
+                if (!canMerge(first, drawcallInfo) || drawcallInfo.firstInstance != first.firstInstance + instanceCount)
+                {
+                    break;
+                }
+                instanceCount += drawcallInfo.instanceCount;
+                runEnd++;
+            }
 
-    // Setup world matrix
-    // Setup camera
-    UpdateTransforms(shaderProgram, drawcallInfo.worldMatrixIndex);
+            // A single drawcall doesn't need to be indirect
+            if (runEnd - drawcallIndex == 1)
+            {
+                multiDrawCollection.push_back(first);
+                drawcallIndex++;
+                continue;
+            }
 
-    // Setup VAO
-    drawcallInfo.vao.Bind();
+            // One command per drawcall, each one with its own instances
+            unsigned int firstCommand = static_cast<unsigned int>(m_indirectCommands.size());
+            for (unsigned int runIndex = drawcallIndex; runIndex < runEnd; ++runIndex)
+            {
+                const DrawcallInfo& drawcallInfo = collection[runIndex];
+                m_indirectCommands.push_back(drawcallInfo.drawcall.GetIndirectCommand(drawcallInfo.instanceCount,
+                    drawcallInfo.firstInstance));
+            }
+
+            multiDrawCollection.emplace_back(first.material, first.worldMatrixIndex, first.vao, first.drawcall,
+                first.firstInstance, instanceCount, firstCommand, runEnd - drawcallIndex);
+            drawcallIndex = runEnd;
+        }
+        collection.swap(multiDrawCollection);
+    }
+
+    // Upload all the commands at once
+    if (!m_indirectCommands.empty())
+    {
+        m_indirectBuffer.Bind();
+        m_indirectBuffer.AllocateData(std::span<const Drawcall::ElementsIndirectCommand>(m_indirectCommands), BufferObject::Usage::StreamDraw);
+        DrawIndirectBufferObject::Unbind();
+    }
+}
+
+Renderer::WorldBounds Renderer::ComputeWorldBounds(const Mesh& mesh, const glm::mat4& worldMatrix)
+{
+    WorldBounds worldBounds;
+    if (mesh.HasBounds())
+    {
+        // The center is transformed, and the extents are projected on each world axis
+        glm::vec3 center = 0.5f * (mesh.GetBoundsMin() + mesh.GetBoundsMax());
+        glm::vec3 extents = 0.5f * (mesh.GetBoundsMax() - mesh.GetBoundsMin());
+        glm::vec3 worldCenter = glm::vec3(worldMatrix * glm::vec4(center, 1.0f));
+        glm::vec3 worldExtents = glm::abs(glm::vec3(worldMatrix[0])) * extents.x
+            + glm::abs(glm::vec3(worldMatrix[1])) * extents.y
+            + glm::abs(glm::vec3(worldMatrix[2])) * extents.z;
+        worldBounds.min = worldCenter - worldExtents;
+        worldBounds.max = worldCenter + worldExtents;
+    }
+    else
+    {
+        worldBounds.min = glm::vec3(1.0f);
+        worldBounds.max = glm::vec3(-1.0f);
+    }
+    return worldBounds;
+}
+
+float Renderer::ComputeViewDepth(const Camera& camera, const glm::mat4& worldMatrix)
+{
+    glm::vec4 viewPosition = camera.GetViewMatrix() * worldMatrix[3];
+    return std::max(-viewPosition.z, 0.0f);
+}
+
+// Layout, from most to least significant bits:
+// Opaque:      collection (6) | 0 | shader program (12) | material (14) | VAO (15) | depth (16)
+// Translucent: collection (6) | 1 | inverted depth (16) | shader program (12) | material (14) | VAO (15)
+unsigned long long Renderer::ComputeSortKey(unsigned int collectionIndex, bool translucent, unsigned int shaderProgramId,
+    unsigned int materialId, unsigned int vaoId, float depth)
+{
+    // Positive floats keep their order when compared as integers. We keep the 16 most significant bits
+    unsigned long long depthBits = std::bit_cast<unsigned int>(depth) >> 16;
+
+    unsigned long long stateBits = (static_cast<unsigned long long>(shaderProgramId & 0xFFF) << 29)
+        | (static_cast<unsigned long long>(materialId & 0x3FFF) << 15)
+        | static_cast<unsigned long long>(vaoId & 0x7FFF);
+
+    unsigned long long sortKey = static_cast<unsigned long long>(collectionIndex & 0x3F) << 58;
+    if (translucent)
+    {
+        // Back to front first, to blend correctly
+        sortKey |= 1ull << 57;
+        sortKey |= (0xFFFFull - depthBits) << 41;
+        sortKey |= stateBits;
+    }
+    else
+    {
+        // State first, to minimize changes, then front to back, to reduce overdraw
+        sortKey |= stateBits << 16;
+        sortKey |= depthBits;
+    }
+    return sortKey;
 }
 
 void Renderer::SetLightingRenderStates(bool firstPass)
@@ -209,8 +1093,70 @@ void Renderer::SetLightingRenderStates(bool firstPass)
     // Set the render states for the first and additional lights
     m_device.SetFeatureEnabled(GL_BLEND, !firstPass);
     // TODO: This should not be hardcoded here
-    glDepthFunc(firstPass ? GL_LESS : GL_EQUAL);
-    glBlendFunc(GL_ONE, GL_ONE);
+    m_device.SetDepthFunction(firstPass ? GL_LESS : GL_EQUAL);
+    m_device.SetBlendFunction(GL_ONE, GL_ONE);
+}
+
+void Renderer::UpdateFrameBuffer()
+{
+    FrameData frameData;
+    frameData.viewMatrix = m_renderFrame->camera->GetViewMatrix();
+    frameData.projMatrix = m_renderFrame->camera->GetProjectionMatrix();
+    frameData.viewProjMatrix = m_renderFrame->camera->GetViewProjectionMatrix();
+    frameData.invViewMatrix = glm::inverse(frameData.viewMatrix);
+    frameData.invProjMatrix = glm::inverse(frameData.projMatrix);
+    frameData.cameraPosition = m_renderFrame->camera->ExtractTranslation();
+    frameData.time = m_renderFrame->time;
+    frameData.deltaTime = m_renderFrame->deltaTime;
+    frameData.padding = 0.0f;
+    frameData.renderScale = glm::vec2(1.0f);
+    if (m_renderWidth > 0 && m_renderHeight > 0)
+    {
+        int width, height;
+        GetRenderViewport(width, height);
+        frameData.renderScale = glm::vec2(width, height) / glm::vec2(m_renderWidth, m_renderHeight);
+    }
+
+    // Reallocate every frame, so the driver doesn't need to wait for the previous frame to finish
+    m_frameBuffer.Bind();
+    m_frameBuffer.AllocateData(std::span<const FrameData>(&frameData, 1), BufferObject::Usage::StreamDraw);
+    UniformBufferObject::Unbind();
+
+    m_frameBuffer.BindBase(FrameBlockBinding);
+}
+
+void Renderer::UpdateLightBuffer()
+{
+    // Shader storage buffers require OpenGL 4.3
+    if (!GLAD_GL_VERSION_4_3)
+    {
+        return;
+    }
+
+    m_lightData.clear();
+    for (const Light* light : m_renderFrame->lights)
+    {
+        LightData& lightData = m_lightData.emplace_back();
+        lightData.color = glm::vec4(light->GetColor() * light->GetIntensity(), 1.0f);
+        lightData.position = glm::vec4(light->GetPosition(), 1.0f);
+        lightData.direction = glm::vec4(light->GetDirection(), 0.0f);
+        lightData.attenuation = light->GetAttenuation();
+    }
+
+    // Reallocate every frame, so the driver doesn't need to wait for the previous frame to finish
+    m_lightBuffer.Bind();
+    if (m_lightData.empty())
+    {
+        // Avoid binding an empty buffer
+        m_lightBuffer.AllocateData(sizeof(LightData), BufferObject::Usage::StreamDraw);
+    }
+    else
+    {
+        m_lightBuffer.AllocateData(std::span<const LightData>(m_lightData), BufferObject::Usage::StreamDraw);
+    }
+    ShaderStorageBufferObject::Unbind();
+
+    m_lightBuffer.BindBase(LightBufferBinding);
 }
 
 void Renderer::InitializeFullscreenMesh()
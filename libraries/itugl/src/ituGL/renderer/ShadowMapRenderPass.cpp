@@ -0,0 +1,430 @@
+#include <ituGL/renderer/ShadowMapRenderPass.h>
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/lighting/Light.h>
+#include <ituGL/lighting/SpotLight.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+const char* ShadowMapRenderPass::ShadowMapTextureName = "ShadowMap";
+
+// Tiles per row in the atlas
+static constexpr unsigned int AtlasColumns = 4;
+
+// Extra size of each cascade around the camera slice. The camera can move this much before the cascade moves
+static constexpr float CascadeMargin = 0.25f;
+
+ShadowMapRenderPass::ShadowMapRenderPass(int tileSize, unsigned int cascadeCount, int drawcallCollectionIndex)
+    : RenderPass("ShadowMap"), m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_tileSize(tileSize), m_cascadeCount(std::min(cascadeCount, MaxCascadeCount))
+    , m_maxShadowDistance(50.0f), m_depthBiasSlopeScale(2.0f), m_depthBiasUnits(4.0f), m_cachingEnabled(true)
+    , m_shadowData{}, m_depthPrograms(true), m_activeTileCount(0), m_staticRenderCount(0)
+{
+    unsigned int tileCount = m_cascadeCount + MaxSpotLightCount;
+    m_tiles.resize(tileCount);
+    for (unsigned int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+    {
+        Tile& tile = m_tiles[tileIndex];
+        tile.x = (tileIndex % AtlasColumns) * tileSize;
+        tile.y = (tileIndex / AtlasColumns) * tileSize;
+        tile.active = false;
+        tile.cascadeRadius = 0.0f;
+        tile.staticValid = false;
+        tile.staticHash = 0;
+        tile.hasDynamic = false;
+    }
+    m_atlasWidth = AtlasColumns * tileSize;
+    m_atlasHeight = ((tileCount + AtlasColumns - 1) / AtlasColumns) * tileSize;
+
+    // Atlas read with hardware comparison and bilinear filtering, for smoother edges
+    m_shadowMap = std::make_shared<Texture2DObject>();
+    m_shadowMap->Bind();
+    m_shadowMap->SetImage(0, m_atlasWidth, m_atlasHeight, TextureObject::FormatDepth, TextureObject::InternalFormatDepth24);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::WrapS, GL_CLAMP_TO_EDGE);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::WrapT, GL_CLAMP_TO_EDGE);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::CompareMode, GL_COMPARE_REF_TO_TEXTURE);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::CompareFunction, GL_LEQUAL);
+
+    // Same format, so it can be copied with a blit
+    m_staticShadowMap.Bind();
+    m_staticShadowMap.SetImage(0, m_atlasWidth, m_atlasHeight, TextureObject::FormatDepth, TextureObject::InternalFormatDepth24);
+    m_staticShadowMap.SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_staticShadowMap.SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    Texture2DObject::Unbind();
+
+    // Depth only framebuffers
+    m_framebuffer.Bind();
+    m_framebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_shadowMap);
+    m_framebuffer.SetDrawBuffers(std::span<const FramebufferObject::Attachment>());
+    m_staticFramebuffer.Bind();
+    m_staticFramebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, m_staticShadowMap);
+    m_staticFramebuffer.SetDrawBuffers(std::span<const FramebufferObject::Attachment>());
+    FramebufferObject::Unbind();
+}
+
+void ShadowMapRenderPass::Setup(RenderGraph::PassBuilder& builder)
+{
+    // Persistent texture, passes that read it are rendered after this one
+    builder.ImportTexture(ShadowMapTextureName, m_shadowMap);
+    builder.Write(ShadowMapTextureName);
+}
+
+void ShadowMapRenderPass::Render()
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    // The first directional light gets the cascades
+    const Light* directionalLight = nullptr;
+    for (const Light* light : renderer.GetLights())
+    {
+        if (light->GetType() == Light::Type::Directional)
+        {
+            directionalLight = light;
+            break;
+        }
+    }
+
+    m_shadowData.cascadeCount = 0;
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        m_tiles[cascadeIndex].active = directionalLight != nullptr;
+    }
+    if (directionalLight)
+    {
+        UpdateCascades(renderer.GetCurrentCamera(), glm::normalize(directionalLight->GetDirection()));
+        m_shadowData.cascadeCount = m_cascadeCount;
+    }
+    m_shadowData.spotLightCount = UpdateSpotLights();
+
+    // Save the states that are changed
+    GLint viewportX, viewportY;
+    GLsizei viewportWidth, viewportHeight;
+    device.GetViewport(viewportX, viewportY, viewportWidth, viewportHeight);
+
+    device.SetColorWrite(false);
+    device.SetDepthWrite(true);
+    device.SetDepthFunction(GL_LESS);
+    device.SetFeatureEnabled(GL_BLEND, false);
+    device.SetFeatureEnabled(GL_SCISSOR_TEST, true);
+    device.SetFeatureEnabled(GL_DEPTH_CLAMP, true);
+    device.SetFeatureEnabled(GL_POLYGON_OFFSET_FILL, true);
+    glPolygonOffset(m_depthBiasSlopeScale, m_depthBiasUnits);
+
+    m_activeTileCount = 0;
+    m_staticRenderCount = 0;
+    for (Tile& tile : m_tiles)
+    {
+        if (!tile.active)
+        {
+            continue;
+        }
+        m_activeTileCount++;
+
+        device.SetViewport(tile.x, tile.y, m_tileSize, m_tileSize);
+        glScissor(tile.x, tile.y, m_tileSize, m_tileSize);
+
+        unsigned long long staticHash = CollectCasters(tile);
+
+        // Render the static casters again only if something changed
+        bool staticChanged = !m_cachingEnabled || !tile.staticValid
+            || tile.staticViewProjMatrix != tile.viewProjMatrix || tile.staticHash != staticHash;
+        if (staticChanged)
+        {
+            m_staticFramebuffer.Bind();
+            device.Clear(false, Color(), true, 1.0f);
+            RenderCasters(tile, m_staticCasters);
+
+            tile.staticValid = true;
+            tile.staticViewProjMatrix = tile.viewProjMatrix;
+            tile.staticHash = staticHash;
+            m_staticRenderCount++;
+        }
+
+        // The atlas tile is still valid if it didn't change and it has no dynamic casters, now or in the last frame
+        bool hasDynamic = !m_dynamicCasters.empty();
+        if (staticChanged || hasDynamic || tile.hasDynamic)
+        {
+            // Blit is limited by the scissor test, so only this tile is copied
+            m_staticFramebuffer.Bind(FramebufferObject::Target::Read);
+            m_framebuffer.Bind(FramebufferObject::Target::Draw);
+            FramebufferObject::Blit(tile.x, tile.y, m_tileSize, m_tileSize, GL_DEPTH_BUFFER_BIT);
+
+            m_framebuffer.Bind();
+            RenderCasters(tile, m_dynamicCasters);
+        }
+        tile.hasDynamic = hasDynamic;
+    }
+
+    FramebufferObject::Unbind();
+
+    device.SetColorWrite(true);
+    device.SetFeatureEnabled(GL_SCISSOR_TEST, false);
+    device.SetFeatureEnabled(GL_DEPTH_CLAMP, false);
+    device.SetFeatureEnabled(GL_POLYGON_OFFSET_FILL, false);
+    device.SetViewport(viewportX, viewportY, viewportWidth, viewportHeight);
+
+    // Matrices and tiles for the shaders
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        m_shadowData.cascadeMatrices[cascadeIndex] = m_tiles[cascadeIndex].viewProjMatrix;
+        m_shadowData.cascadeTiles[cascadeIndex] = GetTileCoordinates(m_tiles[cascadeIndex]);
+    }
+    for (unsigned int spotIndex = 0; spotIndex < MaxSpotLightCount; ++spotIndex)
+    {
+        const Tile& tile = m_tiles[m_cascadeCount + spotIndex];
+        m_shadowData.spotLightMatrices[spotIndex] = tile.viewProjMatrix;
+        m_shadowData.spotLightTiles[spotIndex] = GetTileCoordinates(tile);
+    }
+
+    m_shadowBuffer.Bind();
+    m_shadowBuffer.AllocateData(std::span<const ShadowData>(&m_shadowData, 1), BufferObject::Usage::StreamDraw);
+    UniformBufferObject::Unbind();
+
+    m_shadowBuffer.BindBase(ShadowBlockBinding);
+}
+
+void ShadowMapRenderPass::UpdateCascades(const Camera& camera, const glm::vec3& lightDirection)
+{
+    // Near and far planes, and field of view, of the perspective projection
+    const glm::mat4& projMatrix = camera.GetProjectionMatrix();
+    float nearPlane = projMatrix[3][2] / (projMatrix[2][2] - 1.0f);
+    float farPlane = std::min(projMatrix[3][2] / (projMatrix[2][2] + 1.0f), m_maxShadowDistance);
+    float tanHalfX = 1.0f / projMatrix[0][0];
+    float tanHalfY = 1.0f / projMatrix[1][1];
+    float tanHalfSquared = tanHalfX * tanHalfX + tanHalfY * tanHalfY;
+
+    glm::mat4 invViewMatrix = glm::inverse(camera.GetViewMatrix());
+
+    glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightViewMatrix = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+    float sliceNear = nearPlane;
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        Tile& tile = m_tiles[cascadeIndex];
+
+        // Mix of logarithmic and uniform splits, more resolution close to the camera
+        float t = static_cast<float>(cascadeIndex + 1) / m_cascadeCount;
+        float sliceFar = glm::mix(nearPlane + (farPlane - nearPlane) * t, nearPlane * std::pow(farPlane / nearPlane, t), 0.75f);
+        m_shadowData.cascadeSplits[cascadeIndex] = sliceFar;
+
+        // Smallest sphere around the slice. Its center is on the view axis, so the radius only depends on the projection,
+        // and it doesn't change when the camera rotates. Rounded up, to hide the precision errors
+        float centerDistance = 0.5f * (sliceNear + sliceFar) * (1.0f + tanHalfSquared);
+        float radius;
+        if (centerDistance < sliceFar)
+        {
+            radius = std::sqrt((centerDistance - sliceNear) * (centerDistance - sliceNear) + sliceNear * sliceNear * tanHalfSquared);
+        }
+        else
+        {
+            centerDistance = sliceFar;
+            radius = sliceFar * std::sqrt(tanHalfSquared);
+        }
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        glm::vec3 center(lightViewMatrix * invViewMatrix * glm::vec4(0.0f, 0.0f, -centerDistance, 1.0f));
+
+        // Keep the cascade where it is while the sphere stays inside
+        float cascadeRadius = radius * (1.0f + CascadeMargin);
+        glm::vec3 offset = glm::abs(center - tile.cascadeCenter);
+        bool keep = tile.cascadeDirection == lightDirection && tile.cascadeRadius == cascadeRadius
+            && std::max(std::max(offset.x, offset.y), offset.z) + radius <= cascadeRadius;
+        if (!keep)
+        {
+            // Snap to whole texels, so the static casters are always rasterized the same way
+            float texelSize = 2.0f * cascadeRadius / m_tileSize;
+            tile.cascadeCenter = glm::vec3(glm::floor(glm::vec2(center) / texelSize) * texelSize, center.z);
+            tile.cascadeDirection = lightDirection;
+            tile.cascadeRadius = cascadeRadius;
+        }
+
+        // Light looks towards -Z. Casters between the light and the cascade are clamped to the near plane (depth clamp)
+        const glm::vec3& c = tile.cascadeCenter;
+        float r = tile.cascadeRadius;
+        glm::mat4 projection = glm::ortho(c.x - r, c.x + r, c.y - r, c.y + r, -(c.z + 2.0f * r), -(c.z - r));
+        tile.viewProjMatrix = projection * lightViewMatrix;
+
+        sliceNear = sliceFar;
+    }
+    for (unsigned int cascadeIndex = m_cascadeCount; cascadeIndex < MaxCascadeCount; ++cascadeIndex)
+    {
+        m_shadowData.cascadeSplits[cascadeIndex] = 0.0f;
+    }
+}
+
+unsigned int ShadowMapRenderPass::UpdateSpotLights()
+{
+    const Renderer& renderer = GetRenderer();
+
+    unsigned int spotLightCount = 0;
+    for (const Light* light : renderer.GetLights())
+    {
+        if (spotLightCount == MaxSpotLightCount)
+        {
+            break;
+        }
+        if (light->GetType() != Light::Type::Spot)
+        {
+            continue;
+        }
+
+        const SpotLight& spotLight = static_cast<const SpotLight&>(*light);
+        Tile& tile = m_tiles[m_cascadeCount + spotLightCount];
+
+        // The shadow reaches as far as the light
+        glm::vec3 position = spotLight.GetPosition();
+        glm::vec3 direction = glm::normalize(spotLight.GetDirection());
+        float range = spotLight.GetDistanceAttenuation().y;
+        if (range <= 0.0f)
+        {
+            range = m_maxShadowDistance;
+        }
+        float fov = std::min(2.0f * spotLight.GetAngle(), glm::radians(170.0f));
+
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 viewMatrix = glm::lookAt(position, position + direction, up);
+        glm::mat4 projMatrix = glm::perspective(fov, 1.0f, std::max(0.05f, range * 0.01f), range);
+
+        tile.viewProjMatrix = projMatrix * viewMatrix;
+        tile.active = true;
+        m_shadowData.spotLightPositions[spotLightCount] = glm::vec4(position, 1.0f);
+        spotLightCount++;
+    }
+
+    for (unsigned int spotIndex = spotLightCount; spotIndex < MaxSpotLightCount; ++spotIndex)
+    {
+        m_tiles[m_cascadeCount + spotIndex].active = false;
+        m_shadowData.spotLightPositions[spotIndex] = glm::vec4(0.0f);
+    }
+    return spotLightCount;
+}
+
+unsigned long long ShadowMapRenderPass::CollectCasters(const Tile& tile)
+{
+    const Renderer& renderer = GetRenderer();
+    const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
+
+    m_staticCasters.clear();
+    m_dynamicCasters.clear();
+
+    unsigned long long staticHash = 0;
+    for (unsigned int drawcallIndex = 0; drawcallIndex < drawcallCollection.size(); ++drawcallIndex)
+    {
+        const Renderer::DrawcallInfo& drawcallInfo = drawcallCollection[drawcallIndex];
+        const Material& material = drawcallInfo.material;
+
+        // Only opaque drawcalls cast shadows
+        bool translucent = material.GetBlendEquationColor() != Material::BlendEquation::None
+            || material.GetBlendEquationAlpha() != Material::BlendEquation::None;
+        if (translucent || !material.GetDepthWrite())
+        {
+            continue;
+        }
+
+        // Drawcalls without bounds are always in
+        glm::vec3 boundsMin, boundsMax;
+        if (renderer.GetDrawcallBounds(drawcallInfo, boundsMin, boundsMax)
+            && !IsCasterVisible(tile.viewProjMatrix, boundsMin, boundsMax))
+        {
+            continue;
+        }
+
+        if (renderer.IsDrawcallDynamic(drawcallInfo))
+        {
+            m_dynamicCasters.push_back(drawcallIndex);
+        }
+        else
+        {
+            m_staticCasters.push_back(drawcallIndex);
+
+            // Instances are merged in drawcalls differently every frame, only the ones inside the tile change its shadow
+            std::span<const glm::mat4> worldMatrices = renderer.GetDrawcallWorldMatrices(drawcallInfo);
+            std::span<const Renderer::WorldBounds> worldBounds = renderer.GetDrawcallWorldBounds(drawcallInfo);
+            for (size_t instanceIndex = 0; instanceIndex < worldMatrices.size(); ++instanceIndex)
+            {
+                const Renderer::WorldBounds& bounds = worldBounds[instanceIndex];
+                if (bounds.min.x > bounds.max.x || IsCasterVisible(tile.viewProjMatrix, bounds.min, bounds.max))
+                {
+                    staticHash += HashCaster(drawcallInfo.vao, worldMatrices[instanceIndex]);
+                }
+            }
+        }
+    }
+    return staticHash;
+}
+
+void ShadowMapRenderPass::RenderCasters(const Tile& tile, const std::vector<unsigned int>& casters)
+{
+    Renderer& renderer = GetRenderer();
+    const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
+
+    for (unsigned int drawcallIndex : casters)
+    {
+        const Renderer::DrawcallInfo& drawcallInfo = drawcallCollection[drawcallIndex];
+
+        const DepthProgramCache::DepthProgram* depthProgram = m_depthPrograms.GetDepthProgram(*drawcallInfo.material.GetShaderProgram());
+        if (!depthProgram || (drawcallInfo.instanceCount > 0 && depthProgram->instanceWorldMatrixLocation < 0))
+        {
+            continue;
+        }
+
+        renderer.PrepareDrawcall(drawcallInfo, *depthProgram->shaderProgram,
+            depthProgram->worldMatrixLocation, depthProgram->instanceWorldMatrixLocation);
+        depthProgram->shaderProgram->SetUniform(depthProgram->viewProjMatrixLocation, tile.viewProjMatrix);
+        drawcallInfo.Draw();
+    }
+}
+
+unsigned long long ShadowMapRenderPass::HashCaster(const VertexArrayObject& vao, const glm::mat4& worldMatrix)
+{
+    // FNV-1a of the VAO address and the matrix. The VAO identifies the mesh, the drawcalls of a VAO are always the same
+    unsigned long long hash = 14695981039346656037ull;
+    auto addBytes = [&hash](const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+
+    const VertexArrayObject* vaoAddress = &vao;
+    addBytes(&vaoAddress, sizeof(vaoAddress));
+    addBytes(&worldMatrix, sizeof(worldMatrix));
+    return hash;
+}
+
+bool ShadowMapRenderPass::IsCasterVisible(const glm::mat4& viewProjMatrix, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    // Outside if all the corners are outside of the same plane: left, right, bottom, top and far
+    int outsideCounts[5] = {};
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner(i & 1 ? boundsMax.x : boundsMin.x, i & 2 ? boundsMax.y : boundsMin.y, i & 4 ? boundsMax.z : boundsMin.z);
+        glm::vec4 clip = viewProjMatrix * glm::vec4(corner, 1.0f);
+        outsideCounts[0] += clip.x < -clip.w;
+        outsideCounts[1] += clip.x > clip.w;
+        outsideCounts[2] += clip.y < -clip.w;
+        outsideCounts[3] += clip.y > clip.w;
+        outsideCounts[4] += clip.z > clip.w;
+    }
+    return std::none_of(std::begin(outsideCounts), std::end(outsideCounts), [](int count) { return count == 8; });
+}
+
+glm::vec4 ShadowMapRenderPass::GetTileCoordinates(const Tile& tile) const
+{
+    return glm::vec4(static_cast<float>(tile.x) / m_atlasWidth, static_cast<float>(tile.y) / m_atlasHeight,
+        static_cast<float>(m_tileSize) / m_atlasWidth, static_cast<float>(m_tileSize) / m_atlasHeight);
+}
@@ -0,0 +1,113 @@
+#include <ituGL/renderer/TexturePool.h>
+
+#include <algorithm>
+#include <cassert>
+
+TexturePool::TexturePool() : m_frame(0), m_maxUnusedFrames(3)
+{
+}
+
+std::shared_ptr<Texture2DObject> TexturePool::Acquire(const TextureDesc& desc)
+{
+    // Most recently released first, it is more likely to still be in the GPU caches
+    auto it = std::find_if(m_entries.rbegin(), m_entries.rend(),
+        [&](const Entry& entry) { return !entry.acquired && entry.desc == desc; });
+    if (it != m_entries.rend())
+    {
+        it->acquired = true;
+        it->lastUsedFrame = m_frame;
+        return it->texture;
+    }
+
+    // Render targets are read per pixel, so they don't need mipmaps or filtering
+    std::shared_ptr<Texture2DObject> texture = std::make_shared<Texture2DObject>();
+    texture->Bind();
+    texture->SetImage(0, desc.width, desc.height, desc.format, desc.internalFormat);
+    texture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    texture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    Texture2DObject::Unbind();
+
+    m_entries.push_back(Entry{ desc, texture, true, m_frame });
+    return texture;
+}
+
+void TexturePool::Release(const std::shared_ptr<Texture2DObject>& texture)
+{
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+        [&](const Entry& entry) { return entry.texture == texture; });
+    assert(it != m_entries.end() && it->acquired);
+
+    // Move it to the back, so it is the first candidate in the next Acquire.
+    // It was in use until now, so the unused frames start counting from this one
+    Entry entry = std::move(*it);
+    m_entries.erase(it);
+    entry.acquired = false;
+    entry.lastUsedFrame = m_frame;
+    m_entries.push_back(std::move(entry));
+}
+
+void TexturePool::EndFrame()
+{
+    std::erase_if(m_entries, [&](const Entry& entry)
+        {
+            return !entry.acquired && m_frame - entry.lastUsedFrame >= m_maxUnusedFrames;
+        });
+    m_frame++;
+}
+
+unsigned int TexturePool::GetTextureCount() const
+{
+    return static_cast<unsigned int>(m_entries.size());
+}
+
+size_t TexturePool::GetMemorySize() const
+{
+    size_t size = 0;
+    for (const Entry& entry : m_entries)
+    {
+        size += static_cast<size_t>(entry.desc.width) * entry.desc.height * GetPixelSize(entry.desc.internalFormat);
+    }
+    return size;
+}
+
+unsigned int TexturePool::GetPixelSize(TextureObject::InternalFormat internalFormat)
+{
+    switch (internalFormat)
+    {
+    case TextureObject::InternalFormatR8:
+        return 1;
+    case TextureObject::InternalFormatRG8:
+    case TextureObject::InternalFormatR16:
+    case TextureObject::InternalFormatR16F:
+    case TextureObject::InternalFormatDepth16:
+        return 2;
+    case TextureObject::InternalFormatRGB8:
+    case TextureObject::InternalFormatSRGB8:
+    case TextureObject::InternalFormatDepth24:
+        return 3;
+    case TextureObject::InternalFormatRGBA8:
+    case TextureObject::InternalFormatSRGBA8:
+    case TextureObject::InternalFormatRG16:
+    case TextureObject::InternalFormatRG16F:
+    case TextureObject::InternalFormatR32F:
+    case TextureObject::InternalFormatR11G11B10:
+    case TextureObject::InternalFormatRGB10A2:
+    case TextureObject::InternalFormatDepth32:
+    case TextureObject::InternalFormatDepth32F:
+    case TextureObject::InternalFormatDepth24Stencil8:
+        return 4;
+    case TextureObject::InternalFormatRGB16F:
+        return 6;
+    case TextureObject::InternalFormatRGBA16:
+    case TextureObject::InternalFormatRGBA16F:
+    case TextureObject::InternalFormatRG32F:
+    case TextureObject::InternalFormatDepth32FStencil8:
+        return 8;
+    case TextureObject::InternalFormatRGB32F:
+        return 12;
+    case TextureObject::InternalFormatRGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
@@ -0,0 +1,83 @@
+#include <ituGL/renderer/UpscaleRenderPass.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/texture/Texture2DObject.h>
+
+UpscaleRenderPass::UpscaleRenderPass(const std::string& textureName, int width, int height)
+    : RenderPass("Upscale"), m_textureName(textureName), m_width(width), m_height(height)
+    , m_filter(Filter::EdgeAware), m_sharpness(0.5f)
+    , m_sourceTextureLocation(-1), m_sourceScaleLocation(-1), m_sharpnessLocation(-1)
+{
+    // Load shaders and build shader program
+    Shader vertexShader = ShaderLoader(Shader::VertexShader).Load("shaders/renderer/upscale.vert");
+    Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load("shaders/renderer/upscale.frag");
+    m_shaderProgram.Build(vertexShader, fragmentShader);
+
+    // Get uniform locations
+    m_sourceTextureLocation = m_shaderProgram.GetUniformLocation("SourceTexture");
+    m_sourceScaleLocation = m_shaderProgram.GetUniformLocation("SourceScale");
+    m_sharpnessLocation = m_shaderProgram.GetUniformLocation("Sharpness");
+}
+
+void UpscaleRenderPass::SetSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+}
+
+void UpscaleRenderPass::Setup(RenderGraph::PassBuilder& builder)
+{
+    // Draws to the current framebuffer
+    RenderPass::Setup(builder);
+
+    builder.Read(m_textureName);
+}
+
+void UpscaleRenderPass::Render()
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    std::shared_ptr<Texture2DObject> sourceTexture = GetGraphTexture(m_textureName);
+
+    // Part of the texture with the scene. The whole texture if the renderer has no render size
+    glm::vec2 sourceScale(1.0f);
+    int renderWidth, renderHeight;
+    renderer.GetRenderSize(renderWidth, renderHeight);
+    if (renderWidth > 0 && renderHeight > 0)
+    {
+        int viewportWidth, viewportHeight;
+        renderer.GetRenderViewport(viewportWidth, viewportHeight);
+        sourceScale = glm::vec2(viewportWidth, viewportHeight) / glm::vec2(renderWidth, renderHeight);
+    }
+
+    m_shaderProgram.Use();
+    m_shaderProgram.SetTexture(m_sourceTextureLocation, 0, *sourceTexture);
+    m_shaderProgram.SetUniform(m_sourceScaleLocation, sourceScale);
+    m_shaderProgram.SetUniform(m_sharpnessLocation, m_filter == Filter::EdgeAware ? m_sharpness : 0.0f);
+
+    // The scene textures are sampled with the bilinear filter. The texture comes from the pool of the render graph,
+    // so its filters are restored after the draw, for the passes that get it next
+    GLenum minFilter, magFilter;
+    sourceTexture->Bind();
+    sourceTexture->GetParameter(TextureObject::ParameterEnum::MinFilter, minFilter);
+    sourceTexture->GetParameter(TextureObject::ParameterEnum::MagFilter, magFilter);
+    sourceTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
+    sourceTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+
+    device.SetViewport(0, 0, m_width, m_height);
+    device.DisableFeature(GL_DEPTH_TEST);
+    device.DisableFeature(GL_BLEND);
+
+    renderer.GetFullscreenMesh().DrawSubmesh(0);
+
+    // Restore default value
+    device.EnableFeature(GL_DEPTH_TEST);
+
+    sourceTexture->Bind();
+    sourceTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, minFilter);
+    sourceTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, magFilter);
+    Texture2DObject::Unbind();
+}
@@ -1,5 +1,10 @@
 #include <ituGL/scene/Bounds.h>
 
+#include <ituGL/camera/Camera.h>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <cmath>
+
 SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_radius(0.0f)
 {
     switch (bounds.GetType())
@@ -8,10 +13,10 @@ SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m
         m_radius = static_cast<const SphereBounds&>(bounds).GetRadius();
         break;
     case Type::AABB:
-        m_radius = static_cast<const AabbBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const AabbBounds&>(bounds).GetSize());
         break;
     case Type::Box:
-        m_radius = static_cast<const BoxBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const BoxBounds&>(bounds).GetSize());
         break;
     default:
         assert(false);
@@ -30,10 +35,9 @@ AabbBounds::AabbBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_siz
         break;
     case Type::Box:
         {
+            // Each axis of the box adds its projection to the size
             glm::mat3 scaledMatrix = static_cast<const BoxBounds&>(bounds).GetScaledMatrix();
-            m_size = glm::abs(scaledMatrix[0]);
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[1]));
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[2]));
+            m_size = glm::abs(scaledMatrix[0]) + glm::abs(scaledMatrix[1]) + glm::abs(scaledMatrix[2]);
         }
         break;
     default:
@@ -42,6 +46,42 @@ AabbBounds::AabbBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_siz
     }
 }
 
+FrustumBounds::FrustumBounds(const glm::mat4& viewProjMatrix) : Bounds(glm::vec3(0.0f))
+{
+    // Extract the planes from the rows of the matrix (Gribb-Hartmann), for clip space -w <= x, y, z <= w
+    glm::vec4 rowX(viewProjMatrix[0][0], viewProjMatrix[1][0], viewProjMatrix[2][0], viewProjMatrix[3][0]);
+    glm::vec4 rowY(viewProjMatrix[0][1], viewProjMatrix[1][1], viewProjMatrix[2][1], viewProjMatrix[3][1]);
+    glm::vec4 rowZ(viewProjMatrix[0][2], viewProjMatrix[1][2], viewProjMatrix[2][2], viewProjMatrix[3][2]);
+    glm::vec4 rowW(viewProjMatrix[0][3], viewProjMatrix[1][3], viewProjMatrix[2][3], viewProjMatrix[3][3]);
+
+    m_planes[Left] = rowW + rowX;
+    m_planes[Right] = rowW - rowX;
+    m_planes[Bottom] = rowW + rowY;
+    m_planes[Top] = rowW - rowY;
+    m_planes[Near] = rowW + rowZ;
+    m_planes[Far] = rowW - rowZ;
+
+    // Normalize, so the plane equation returns distances
+    for (glm::vec4& plane : m_planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    // Center is the average of the 8 corners
+    glm::mat4 invViewProjMatrix = glm::inverse(viewProjMatrix);
+    glm::vec3 center(0.0f);
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec4 corner = invViewProjMatrix * glm::vec4(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1, 1.0f);
+        center += glm::vec3(corner) / corner.w;
+    }
+    m_center = center / 8.0f;
+}
+
+FrustumBounds::FrustumBounds(const Camera& camera) : FrustumBounds(camera.GetViewProjectionMatrix())
+{
+}
+
 BoxBounds::BoxBounds(const Bounds& bounds) : RotatedBounds(bounds.GetCenter(), glm::mat3(1.0f)), m_size(0.0f)
 {
     switch (bounds.GetType())
@@ -117,7 +157,7 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
 {
     glm::vec3 distance = boundsB.GetCenter() - boundsA.GetCenter();
     glm::mat3 mA = boundsA.GetScaledMatrix();
-    glm::mat3 mB = boundsA.GetScaledMatrix();
+    glm::mat3 mB = boundsB.GetScaledMatrix();
     return TestSeparationAxis(boundsA.GetXVector(), distance, mA, mB)
         && TestSeparationAxis(boundsA.GetYVector(), distance, mA, mB)
         && TestSeparationAxis(boundsA.GetZVector(), distance, mA, mB)
@@ -135,22 +175,45 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
         && TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetZVector()), distance, mA, mB);
 }
 
+// Conservative test: the bounds are outside only if they are completely behind one of the planes
+// projectedSize is the distance from the center to the furthest point of the bounds along each plane normal
+template<typename F>
+bool TestFrustumPlanes(const FrustumBounds& frustum, const glm::vec3& center, F projectedSize)
+{
+    for (int i = 0; i < FrustumBounds::PlaneCount; ++i)
+    {
+        const glm::vec4& plane = frustum.GetPlane(i);
+        glm::vec3 normal(plane);
+        if (glm::dot(normal, center) + plane.w < -projectedSize(normal))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const SphereBounds& boundsB)
 {
-    return true;
+    float radius = boundsB.GetRadius();
+    return TestFrustumPlanes(boundsA, boundsB.GetCenter(), [radius](const glm::vec3&) { return radius; });
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB)
 {
-    return true;
+    const glm::vec3& size = boundsB.GetSize();
+    return TestFrustumPlanes(boundsA, boundsB.GetCenter(), [&size](const glm::vec3& normal) { return glm::dot(glm::abs(normal), size); });
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB)
 {
-    return true;
+    glm::mat3 scaledMatrix = boundsB.GetScaledMatrix();
+    return TestFrustumPlanes(boundsA, boundsB.GetCenter(), [&scaledMatrix](const glm::vec3& normal)
+        {
+            return std::abs(glm::dot(normal, scaledMatrix[0])) + std::abs(glm::dot(normal, scaledMatrix[1])) + std::abs(glm::dot(normal, scaledMatrix[2]));
+        });
 }
 
 bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
@@ -163,6 +226,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
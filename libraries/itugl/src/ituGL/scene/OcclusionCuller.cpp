@@ -0,0 +1,471 @@
+#include <ituGL/scene/OcclusionCuller.h>
+
+#include <ituGL/scene/Bounds.h>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define ITUGL_OCCLUSION_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ITUGL_OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+// Number of bits used for the fractional part of the fixed point vertex coordinates
+static constexpr int SubpixelBits = 4;
+static constexpr int SubpixelScale = 1 << SubpixelBits;
+
+namespace
+{
+    // Edge functions at the first pixel of a row, and their increment per pixel
+    struct RowEdges
+    {
+        int64_t start[3];
+        int64_t stepX[3];
+    };
+
+    // Keep the min depth in the pixels of the row from begin to end that are inside the 3 edges
+    void RasterizeSpanScalar(const RowEdges& edges, float rowDepth, float depthStepX, float* depthRow, int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            int64_t e0 = edges.start[0] + edges.stepX[0] * i;
+            int64_t e1 = edges.start[1] + edges.stepX[1] * i;
+            int64_t e2 = edges.start[2] + edges.stepX[2] * i;
+            bool inside = (e0 | e1 | e2) >= 0;
+
+            float depth = std::max(rowDepth + depthStepX * i, 0.0f);
+            float current = depthRow[i];
+            depthRow[i] = inside && depth < current ? depth : current;
+        }
+    }
+
+#if defined(ITUGL_OCCLUSION_AVX2) || defined(ITUGL_OCCLUSION_SSE2)
+    // The edge functions need 64 bits for the whole screen, but inside a block of pixels they change less than 2^23
+    // (the step is at most 2^20 with 4096 pixels and 4 subpixel bits). The value at the start of the block is clamped
+    // to 32 bits, far enough from the limits that the sign of every pixel in the block is still exact
+    constexpr int64_t BlockEdgeLimit = int64_t(1) << 30;
+
+    inline int32_t ClampBlockEdge(int64_t edge)
+    {
+        return static_cast<int32_t>(std::clamp(edge, -BlockEdgeLimit, BlockEdgeLimit));
+    }
+#endif
+
+#if defined(ITUGL_OCCLUSION_AVX2)
+    constexpr int SimdWidth = 8;
+
+    // Same as RasterizeSpanScalar, for the blocks of 8 pixels from the start of the row. Returns the pixels done
+    int RasterizeSpanSimd(const RowEdges& edges, float rowDepth, float depthStepX, float* depthRow, int count)
+    {
+        const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i laneSteps[3];
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            laneSteps[edge] = _mm256_mullo_epi32(laneIndices, _mm256_set1_epi32(static_cast<int32_t>(edges.stepX[edge])));
+        }
+        const __m256 rowDepths = _mm256_set1_ps(rowDepth);
+        const __m256 depthSteps = _mm256_set1_ps(depthStepX);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256i minusOne = _mm256_set1_epi32(-1);
+
+        int i = 0;
+        for (; i + SimdWidth <= count; i += SimdWidth)
+        {
+            __m256i e0 = _mm256_add_epi32(_mm256_set1_epi32(ClampBlockEdge(edges.start[0] + edges.stepX[0] * i)), laneSteps[0]);
+            __m256i e1 = _mm256_add_epi32(_mm256_set1_epi32(ClampBlockEdge(edges.start[1] + edges.stepX[1] * i)), laneSteps[1]);
+            __m256i e2 = _mm256_add_epi32(_mm256_set1_epi32(ClampBlockEdge(edges.start[2] + edges.stepX[2] * i)), laneSteps[2]);
+            __m256i inside = _mm256_cmpgt_epi32(_mm256_or_si256(_mm256_or_si256(e0, e1), e2), minusOne);
+
+            // Same operations as the scalar path, so the depths are the same
+            __m256 pixels = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), laneIndices));
+            __m256 depth = _mm256_max_ps(_mm256_add_ps(rowDepths, _mm256_mul_ps(depthSteps, pixels)), zero);
+            __m256 current = _mm256_loadu_ps(depthRow + i);
+            __m256 write = _mm256_and_ps(_mm256_castsi256_ps(inside), _mm256_cmp_ps(depth, current, _CMP_LT_OQ));
+            _mm256_storeu_ps(depthRow + i, _mm256_blendv_ps(current, depth, write));
+        }
+        return i;
+    }
+#elif defined(ITUGL_OCCLUSION_SSE2)
+    constexpr int SimdWidth = 4;
+
+    // Same as RasterizeSpanScalar, for the blocks of 4 pixels from the start of the row. Returns the pixels done
+    int RasterizeSpanSimd(const RowEdges& edges, float rowDepth, float depthStepX, float* depthRow, int count)
+    {
+        // SSE2 has no 32-bit multiply, the steps of the lanes are set one by one
+        const __m128i laneIndices = _mm_setr_epi32(0, 1, 2, 3);
+        __m128i laneSteps[3];
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            int32_t step = static_cast<int32_t>(edges.stepX[edge]);
+            laneSteps[edge] = _mm_setr_epi32(0, step, step * 2, step * 3);
+        }
+        const __m128 rowDepths = _mm_set1_ps(rowDepth);
+        const __m128 depthSteps = _mm_set1_ps(depthStepX);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i minusOne = _mm_set1_epi32(-1);
+
+        int i = 0;
+        for (; i + SimdWidth <= count; i += SimdWidth)
+        {
+            __m128i e0 = _mm_add_epi32(_mm_set1_epi32(ClampBlockEdge(edges.start[0] + edges.stepX[0] * i)), laneSteps[0]);
+            __m128i e1 = _mm_add_epi32(_mm_set1_epi32(ClampBlockEdge(edges.start[1] + edges.stepX[1] * i)), laneSteps[1]);
+            __m128i e2 = _mm_add_epi32(_mm_set1_epi32(ClampBlockEdge(edges.start[2] + edges.stepX[2] * i)), laneSteps[2]);
+            __m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), minusOne);
+
+            // Same operations as the scalar path, so the depths are the same
+            __m128 pixels = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), laneIndices));
+            __m128 depth = _mm_max_ps(_mm_add_ps(rowDepths, _mm_mul_ps(depthSteps, pixels)), zero);
+            __m128 current = _mm_loadu_ps(depthRow + i);
+            __m128 write = _mm_and_ps(_mm_castsi128_ps(inside), _mm_cmplt_ps(depth, current));
+            _mm_storeu_ps(depthRow + i, _mm_or_ps(_mm_and_ps(write, depth), _mm_andnot_ps(write, current)));
+        }
+        return i;
+    }
+#endif
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : m_width(width), m_height(height), m_simdEnabled(IsSimdSupported()), m_viewProjMatrix(1.0f), m_triangleCount(0)
+{
+    // Keep the fixed point edge functions far away from overflowing
+    assert(width > 0 && height > 0);
+    assert(width <= 4096 && height <= 4096);
+
+    // Allocate all the levels once, down to 1x1
+    int levelWidth = width;
+    int levelHeight = height;
+    while (true)
+    {
+        m_levels.push_back(Level{ levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f) });
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+        levelWidth = std::max(1, (levelWidth + 1) / 2);
+        levelHeight = std::max(1, (levelHeight + 1) / 2);
+    }
+}
+
+bool OcclusionCuller::IsSimdSupported()
+{
+#if defined(ITUGL_OCCLUSION_AVX2) || defined(ITUGL_OCCLUSION_SSE2)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OcclusionCuller::Begin(const glm::mat4& viewProjMatrix)
+{
+    m_viewProjMatrix = viewProjMatrix;
+    m_triangleCount = 0;
+
+    std::fill(m_levels[0].depths.begin(), m_levels[0].depths.end(), 1.0f);
+}
+
+void OcclusionCuller::AddOccluder(std::span<const glm::vec3> positions, std::span<const unsigned int> indices, const glm::mat4& worldMatrix)
+{
+    assert(indices.size() % 3 == 0);
+
+    glm::mat4 worldViewProjMatrix = m_viewProjMatrix * worldMatrix;
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        assert(indices[i] < positions.size() && indices[i + 1] < positions.size() && indices[i + 2] < positions.size());
+
+        glm::vec4 clip0 = worldViewProjMatrix * glm::vec4(positions[indices[i]], 1.0f);
+        glm::vec4 clip1 = worldViewProjMatrix * glm::vec4(positions[indices[i + 1]], 1.0f);
+        glm::vec4 clip2 = worldViewProjMatrix * glm::vec4(positions[indices[i + 2]], 1.0f);
+
+        ClipAndRasterize(clip0, clip1, clip2);
+    }
+}
+
+void OcclusionCuller::AddOccluderBox(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& worldMatrix)
+{
+    const std::array<glm::vec3, 8> corners = {
+        glm::vec3(localMin.x, localMin.y, localMin.z),
+        glm::vec3(localMax.x, localMin.y, localMin.z),
+        glm::vec3(localMin.x, localMax.y, localMin.z),
+        glm::vec3(localMax.x, localMax.y, localMin.z),
+        glm::vec3(localMin.x, localMin.y, localMax.z),
+        glm::vec3(localMax.x, localMin.y, localMax.z),
+        glm::vec3(localMin.x, localMax.y, localMax.z),
+        glm::vec3(localMax.x, localMax.y, localMax.z),
+    };
+
+    static const std::array<unsigned int, 36> indices = {
+        0, 2, 1,  1, 2, 3,  // -Z
+        4, 5, 6,  5, 7, 6,  // +Z
+        0, 4, 2,  2, 4, 6,  // -X
+        1, 3, 5,  3, 7, 5,  // +X
+        0, 1, 4,  1, 5, 4,  // -Y
+        2, 6, 3,  3, 6, 7,  // +Y
+    };
+
+    AddOccluder(corners, indices, worldMatrix);
+}
+
+void OcclusionCuller::End()
+{
+    // Each texel keeps the farthest depth of the 2x2 texels below it, so testing against it is conservative
+    for (size_t levelIndex = 1; levelIndex < m_levels.size(); ++levelIndex)
+    {
+        const Level& source = m_levels[levelIndex - 1];
+        Level& target = m_levels[levelIndex];
+
+        for (int y = 0; y < target.height; ++y)
+        {
+            const float* row0 = &source.depths[std::min(y * 2, source.height - 1) * source.width];
+            const float* row1 = &source.depths[std::min(y * 2 + 1, source.height - 1) * source.width];
+            float* targetRow = &target.depths[y * target.width];
+
+            for (int x = 0; x < target.width; ++x)
+            {
+                int x0 = std::min(x * 2, source.width - 1);
+                int x1 = std::min(x * 2 + 1, source.width - 1);
+                targetRow[x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const glm::vec3& center, const glm::vec3& size) const
+{
+    glm::vec2 ndcMin(1.0f);
+    glm::vec2 ndcMax(-1.0f);
+    float minDepth = 1.0f;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner = center + size * glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+        glm::vec4 clip = m_viewProjMatrix * glm::vec4(corner, 1.0f);
+
+        // Crossing the near plane, it can't be occluded
+        if (clip.w <= 1e-5f || clip.z < -clip.w)
+        {
+            return true;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+        ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+        minDepth = std::min(minDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Completely outside of the screen
+    if (ndcMin.x > 1.0f || ndcMin.y > 1.0f || ndcMax.x < -1.0f || ndcMax.y < -1.0f)
+    {
+        return false;
+    }
+
+    ndcMin = glm::clamp(ndcMin, -1.0f, 1.0f) * 0.5f + 0.5f;
+    ndcMax = glm::clamp(ndcMax, -1.0f, 1.0f) * 0.5f + 0.5f;
+    int x0 = std::min(static_cast<int>(ndcMin.x * m_width), m_width - 1);
+    int y0 = std::min(static_cast<int>(ndcMin.y * m_height), m_height - 1);
+    int x1 = std::min(static_cast<int>(ndcMax.x * m_width), m_width - 1);
+    int y1 = std::min(static_cast<int>(ndcMax.y * m_height), m_height - 1);
+
+    // Go down the levels until the rectangle covers at most 4x4 texels
+    unsigned int levelIndex = 0;
+    while ((x1 - x0 > 3 || y1 - y0 > 3) && levelIndex + 1 < m_levels.size())
+    {
+        x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+        ++levelIndex;
+    }
+
+    const Level& level = m_levels[levelIndex];
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* row = &level.depths[y * level.width];
+        for (int x = x0; x <= x1; ++x)
+        {
+            if (minDepth <= row[x])
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool OcclusionCuller::IsVisible(const AabbBounds& bounds) const
+{
+    return IsVisible(bounds.GetCenter(), bounds.GetSize());
+}
+
+float OcclusionCuller::GetDepth(int x, int y, unsigned int level) const
+{
+    assert(level < m_levels.size());
+    assert(x >= 0 && x < m_levels[level].width && y >= 0 && y < m_levels[level].height);
+    return m_levels[level].depths[y * m_levels[level].width + x];
+}
+
+void OcclusionCuller::ClipAndRasterize(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2)
+{
+    // Clip planes as dot(plane, clip) >= 0: near, left, right, bottom and top. Far depths are clamped instead
+    static const std::array<glm::vec4, 5> planes = {
+        glm::vec4( 0.0f,  0.0f, 1.0f, 1.0f),
+        glm::vec4( 1.0f,  0.0f, 0.0f, 1.0f),
+        glm::vec4(-1.0f,  0.0f, 0.0f, 1.0f),
+        glm::vec4( 0.0f,  1.0f, 0.0f, 1.0f),
+        glm::vec4( 0.0f, -1.0f, 0.0f, 1.0f),
+    };
+
+    // Each plane adds at most one vertex
+    constexpr int MaxVertexCount = 3 + static_cast<int>(planes.size());
+    std::array<glm::vec4, MaxVertexCount> polygon = { clip0, clip1, clip2 };
+    std::array<glm::vec4, MaxVertexCount> clipped;
+    int vertexCount = 3;
+
+    for (const glm::vec4& plane : planes)
+    {
+        float d0 = glm::dot(plane, clip0);
+        float d1 = glm::dot(plane, clip1);
+        float d2 = glm::dot(plane, clip2);
+
+        // Completely outside one plane, nothing to draw
+        if (d0 < 0.0f && d1 < 0.0f && d2 < 0.0f)
+        {
+            return;
+        }
+    }
+
+    for (const glm::vec4& plane : planes)
+    {
+        int clippedCount = 0;
+        for (int i = 0; i < vertexCount; ++i)
+        {
+            const glm::vec4& current = polygon[i];
+            const glm::vec4& next = polygon[(i + 1) % vertexCount];
+            float currentDistance = glm::dot(plane, current);
+            float nextDistance = glm::dot(plane, next);
+
+            if (currentDistance >= 0.0f)
+            {
+                clipped[clippedCount++] = current;
+            }
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            {
+                float t = currentDistance / (currentDistance - nextDistance);
+                clipped[clippedCount++] = glm::mix(current, next, t);
+            }
+        }
+
+        polygon = clipped;
+        vertexCount = clippedCount;
+        if (vertexCount < 3)
+        {
+            return;
+        }
+    }
+
+    // Draw the convex polygon as a triangle fan
+    glm::vec3 screen0 = ToScreen(polygon[0]);
+    glm::vec3 screenPrevious = ToScreen(polygon[1]);
+    for (int i = 2; i < vertexCount; ++i)
+    {
+        glm::vec3 screenCurrent = ToScreen(polygon[i]);
+        RasterizeTriangle(screen0, screenPrevious, screenCurrent);
+        screenPrevious = screenCurrent;
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+    // Snap the vertices to the subpixel grid, so the coverage only depends on integer math
+    int64_t x0 = std::lround(v0.x * SubpixelScale), y0 = std::lround(v0.y * SubpixelScale);
+    int64_t x1 = std::lround(v1.x * SubpixelScale), y1 = std::lround(v1.y * SubpixelScale);
+    int64_t x2 = std::lround(v2.x * SubpixelScale), y2 = std::lround(v2.y * SubpixelScale);
+    float z0 = v0.z, z1 = v1.z, z2 = v2.z;
+
+    int64_t area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+    if (area == 0)
+    {
+        return;
+    }
+
+    // Both faces are occluders: flip clockwise triangles so the inside is always positive
+    if (area < 0)
+    {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+        std::swap(z1, z2);
+        area = -area;
+    }
+
+    // Pixels overlapped by the bounding box, clamped to the screen
+    int minX = std::max(0, static_cast<int>(std::min({ x0, x1, x2 }) >> SubpixelBits));
+    int minY = std::max(0, static_cast<int>(std::min({ y0, y1, y2 }) >> SubpixelBits));
+    int maxX = std::min(m_width - 1, static_cast<int>(std::max({ x0, x1, x2 }) >> SubpixelBits));
+    int maxY = std::min(m_height - 1, static_cast<int>(std::max({ y0, y1, y2 }) >> SubpixelBits));
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    ++m_triangleCount;
+
+    // Edge function from a to b, evaluated at the center of the first pixel. Pixels exactly on an edge only belong
+    // to the triangle if it is a top or left edge, so shared edges are never drawn twice
+    struct Edge
+    {
+        int64_t stepX, stepY, start;
+    };
+    auto setupEdge = [&](int64_t ax, int64_t ay, int64_t bx, int64_t by)
+    {
+        int64_t dx = bx - ax;
+        int64_t dy = by - ay;
+        int64_t px = (static_cast<int64_t>(minX) << SubpixelBits) + SubpixelScale / 2;
+        int64_t py = (static_cast<int64_t>(minY) << SubpixelBits) + SubpixelScale / 2;
+        bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+        return Edge{ -dy * SubpixelScale, dx * SubpixelScale, dx * (py - ay) - dy * (px - ax) - (topLeft ? 0 : 1) };
+    };
+    Edge edge0 = setupEdge(x1, y1, x2, y2);
+    Edge edge1 = setupEdge(x2, y2, x0, y0);
+    Edge edge2 = setupEdge(x0, y0, x1, y1);
+
+    // Depth plane equation in pixels
+    float invArea = static_cast<float>(SubpixelScale * SubpixelScale) / static_cast<float>(area);
+    float fx0 = static_cast<float>(x0) / SubpixelScale, fy0 = static_cast<float>(y0) / SubpixelScale;
+    float fx1 = static_cast<float>(x1) / SubpixelScale, fy1 = static_cast<float>(y1) / SubpixelScale;
+    float fx2 = static_cast<float>(x2) / SubpixelScale, fy2 = static_cast<float>(y2) / SubpixelScale;
+    float depthStepX = ((z1 - z0) * (fy2 - fy0) - (z2 - z0) * (fy1 - fy0)) * invArea;
+    float depthStepY = ((z2 - z0) * (fx1 - fx0) - (z1 - z0) * (fx2 - fx0)) * invArea;
+    float depthStart = z0 + depthStepX * (minX + 0.5f - fx0) + depthStepY * (minY + 0.5f - fy0);
+
+    std::vector<float>& depths = m_levels[0].depths;
+    RowEdges rowEdges = { {}, { edge0.stepX, edge1.stepX, edge2.stepX } };
+    int count = maxX - minX + 1;
+    for (int y = minY; y <= maxY; ++y)
+    {
+        int rowIndex = y - minY;
+        rowEdges.start[0] = edge0.start + edge0.stepY * rowIndex;
+        rowEdges.start[1] = edge1.start + edge1.stepY * rowIndex;
+        rowEdges.start[2] = edge2.start + edge2.stepY * rowIndex;
+        float rowDepth = depthStart + depthStepY * rowIndex;
+        float* depthRow = &depths[y * m_width + minX];
+
+        // Full SIMD blocks first, then the rest of the row one pixel at a time
+        int simdCount = 0;
+#if defined(ITUGL_OCCLUSION_AVX2) || defined(ITUGL_OCCLUSION_SSE2)
+        if (m_simdEnabled)
+        {
+            simdCount = RasterizeSpanSimd(rowEdges, rowDepth, depthStepX, depthRow, count);
+        }
+#endif
+        RasterizeSpanScalar(rowEdges, rowDepth, depthStepX, depthRow, simdCount, count);
+    }
+}
+
+glm::vec3 OcclusionCuller::ToScreen(const glm::vec4& clip) const
+{
+    glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    return glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, std::min(ndc.z * 0.5f + 0.5f, 1.0f));
+}
@@ -1,18 +1,35 @@
 #include <ituGL/scene/RendererSceneVisitor.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/RenderCommandList.h>
+#include <ituGL/core/ThreadPool.h>
+#include <ituGL/core/Profiler.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/SceneLight.h>
 #include <ituGL/scene/SceneModel.h>
 #include <ituGL/scene/Transform.h>
+#include <ituGL/scene/Bounds.h>
+#include <ituGL/scene/OcclusionCuller.h>
+#include <glm/common.hpp>
+#include <cmath>
+#include <cassert>
 
 RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer) : m_renderer(renderer)
+    , m_frustumCullingEnabled(true), m_shadowCastersEnabled(false), m_threadPool(nullptr), m_occlusionCuller(nullptr)
+    , m_visibleModelCount(0), m_culledModelCount(0), m_occludedModelCount(0)
 {
 }
 
+RendererSceneVisitor::~RendererSceneVisitor()
+{
+    assert(m_models.empty()); // SubmitModels was not called after visiting the scene
+}
+
 void RendererSceneVisitor::VisitCamera(SceneCamera& sceneCamera)
 {
-    assert(!m_renderer.HasCamera()); // Currently, only one camera per scene supported
+    assert(!m_renderer.HasSubmittedCamera()); // Currently, only one camera per scene supported
     m_renderer.SetCurrentCamera(*sceneCamera.GetCamera());
 }
 
@@ -24,5 +41,175 @@ void RendererSceneVisitor::VisitLight(SceneLight& sceneLight)
 void RendererSceneVisitor::VisitModel(SceneModel& sceneModel)
 {
     assert(sceneModel.GetTransform());
-    m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
+    const Model* model = sceneModel.GetModel().get();
+    m_models.push_back(model);
+
+    // Transforms and meshes cache some of their data when read, so they are read here, in a single thread
+    m_worldMatrices.push_back(sceneModel.GetTransform()->GetTransformMatrix());
+    model->GetMesh().UpdatePoolDrawcalls();
+}
+
+void RendererSceneVisitor::SubmitModels()
+{
+    const unsigned int count = static_cast<unsigned int>(m_models.size());
+    m_visible.assign(count, 1);
+    m_centersX.resize(count);
+    m_centersY.resize(count);
+    m_centersZ.resize(count);
+    m_sizesX.resize(count);
+    m_sizesY.resize(count);
+    m_sizesZ.resize(count);
+
+    bool cull = m_frustumCullingEnabled && m_renderer.HasSubmittedCamera();
+    FrustumBounds frustum = cull ? FrustumBounds(m_renderer.GetSubmittedCamera()) : FrustumBounds(glm::mat4(1.0f));
+
+    // Each task works on a contiguous range of models and records them in its own command list
+    unsigned int maxTaskCount = m_threadPool ? m_threadPool->GetThreadCount() : 1;
+    m_renderer.BeginCommandLists(maxTaskCount);
+    m_taskVisibleCounts.assign(maxTaskCount, 0);
+    m_taskOccludedCounts.assign(maxTaskCount, 0);
+
+    auto processModels = [&](unsigned int taskIndex, unsigned int begin, unsigned int end)
+    {
+        ITUGL_ZONE("RendererSceneVisitor::ProcessModels");
+        ComputeBounds(begin, end);
+        if (cull)
+        {
+            CullModels(frustum, begin, end);
+        }
+        if (m_occlusionCuller)
+        {
+            m_taskOccludedCounts[taskIndex] = OccludeModels(begin, end);
+        }
+        m_taskVisibleCounts[taskIndex] = RecordModels(m_renderer.GetCommandList(taskIndex), begin, end);
+    };
+
+    if (m_threadPool)
+    {
+        // Below this number of models per task, the overhead of waking up the workers is bigger than the gain
+        const unsigned int minModelsPerTask = 256;
+        m_threadPool->ParallelFor(count, minModelsPerTask, processModels);
+    }
+    else
+    {
+        processModels(0, 0, count);
+    }
+
+    // Merge in order of the ranges, so the drawcalls are added in the same order as without threads
+    m_renderer.MergeCommandLists();
+
+    m_visibleModelCount = 0;
+    for (unsigned int taskVisibleCount : m_taskVisibleCounts)
+    {
+        m_visibleModelCount += taskVisibleCount;
+    }
+    m_culledModelCount = count - m_visibleModelCount;
+
+    m_occludedModelCount = 0;
+    for (unsigned int taskOccludedCount : m_taskOccludedCounts)
+    {
+        m_occludedModelCount += taskOccludedCount;
+    }
+
+    m_models.clear();
+    m_worldMatrices.clear();
+    m_centersX.clear();
+    m_centersY.clear();
+    m_centersZ.clear();
+    m_sizesX.clear();
+    m_sizesY.clear();
+    m_sizesZ.clear();
+}
+
+void RendererSceneVisitor::ComputeBounds(unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        // Same as SceneModel::GetBoxBounds converted to AabbBounds, but from the world matrix we already have
+        glm::vec3 localCenter(0.0f);
+        glm::vec3 localSize(1.0f);
+        const Mesh& mesh = m_models[i]->GetMesh();
+        if (mesh.HasBounds())
+        {
+            localCenter = 0.5f * (mesh.GetBoundsMax() + mesh.GetBoundsMin());
+            localSize = 0.5f * (mesh.GetBoundsMax() - mesh.GetBoundsMin());
+        }
+
+        const glm::mat4& worldMatrix = m_worldMatrices[i];
+        glm::vec3 center(worldMatrix * glm::vec4(localCenter, 1.0f));
+        glm::vec3 size = glm::abs(glm::vec3(worldMatrix[0])) * localSize.x
+            + glm::abs(glm::vec3(worldMatrix[1])) * localSize.y
+            + glm::abs(glm::vec3(worldMatrix[2])) * localSize.z;
+
+        m_centersX[i] = center.x;
+        m_centersY[i] = center.y;
+        m_centersZ[i] = center.z;
+        m_sizesX[i] = size.x;
+        m_sizesY[i] = size.y;
+        m_sizesZ[i] = size.z;
+    }
+}
+
+void RendererSceneVisitor::CullModels(const FrustumBounds& frustum, unsigned int begin, unsigned int end)
+{
+    const float* centersX = m_centersX.data();
+    const float* centersY = m_centersY.data();
+    const float* centersZ = m_centersZ.data();
+    const float* sizesX = m_sizesX.data();
+    const float* sizesY = m_sizesY.data();
+    const float* sizesZ = m_sizesZ.data();
+    unsigned char* visible = m_visible.data();
+
+    // Same test as Bounds::Intersects(FrustumBounds, AabbBounds), one plane for all the models at a time
+    for (int planeIndex = 0; planeIndex < FrustumBounds::PlaneCount; ++planeIndex)
+    {
+        const glm::vec4& plane = frustum.GetPlane(planeIndex);
+        const float absX = std::abs(plane.x), absY = std::abs(plane.y), absZ = std::abs(plane.z);
+
+        // No branches in the inner loop, so the compiler can vectorize it
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            float distance = plane.x * centersX[i] + plane.y * centersY[i] + plane.z * centersZ[i] + plane.w;
+            float projectedSize = absX * sizesX[i] + absY * sizesY[i] + absZ * sizesZ[i];
+            visible[i] &= distance >= -projectedSize;
+        }
+    }
+}
+
+unsigned int RendererSceneVisitor::OccludeModels(unsigned int begin, unsigned int end)
+{
+    // The occlusion test is much more expensive than the frustum test, so only the models that passed it are tested
+    unsigned int occludedCount = 0;
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        if (m_visible[i])
+        {
+            glm::vec3 center(m_centersX[i], m_centersY[i], m_centersZ[i]);
+            glm::vec3 size(m_sizesX[i], m_sizesY[i], m_sizesZ[i]);
+            if (!m_occlusionCuller->IsVisible(center, size))
+            {
+                m_visible[i] = 0;
+                occludedCount++;
+            }
+        }
+    }
+    return occludedCount;
+}
+
+unsigned int RendererSceneVisitor::RecordModels(RenderCommandList& commandList, unsigned int begin, unsigned int end)
+{
+    unsigned int visibleCount = 0;
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        if (m_visible[i])
+        {
+            commandList.AddModel(*m_models[i], m_worldMatrices[i]);
+            visibleCount++;
+        }
+        else if (m_shadowCastersEnabled)
+        {
+            commandList.AddShadowCaster(*m_models[i], m_worldMatrices[i]);
+        }
+    }
+    return visibleCount;
 }
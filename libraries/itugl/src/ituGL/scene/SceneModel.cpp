@@ -4,7 +4,46 @@
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/scene/Transform.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <glm/geometric.hpp>
 #include <cassert>
+#include <cmath>
+
+namespace
+{
+    // Normalize the axes of the matrix, dividing them by their scale. Axes with zero scale can't be normalized,
+    // they are flattened, so any direction orthogonal to the other axes is valid
+    glm::mat3 GetRotationMatrix(const glm::mat3& matrix, const glm::vec3& scale)
+    {
+        glm::mat3 rotationMatrix(1.0f);
+        int validAxis = -1;
+        int validCount = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (scale[axis] > 0.0f)
+            {
+                rotationMatrix[axis] = matrix[axis] / scale[axis];
+                validAxis = axis;
+                validCount++;
+            }
+        }
+
+        // Rebuild the missing axes from the valid ones, keeping the handedness
+        if (validCount == 2)
+        {
+            int axis = scale.x > 0.0f ? (scale.y > 0.0f ? 2 : 1) : 0;
+            rotationMatrix[axis] = glm::normalize(glm::cross(rotationMatrix[(axis + 1) % 3], rotationMatrix[(axis + 2) % 3]));
+        }
+        else if (validCount == 1)
+        {
+            glm::vec3 normal = rotationMatrix[validAxis];
+            glm::vec3 other = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::vec3 tangent = glm::normalize(glm::cross(normal, other));
+            rotationMatrix[(validAxis + 1) % 3] = tangent;
+            rotationMatrix[(validAxis + 2) % 3] = glm::cross(normal, tangent);
+        }
+        return rotationMatrix;
+    }
+}
 
 SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneNode(name), m_model(model)
 {
@@ -57,7 +96,24 @@ BoxBounds SceneModel::GetBoxBounds() const
 {
     assert(m_transform);
     assert(m_model);
-    return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale() /* * m_model->GetSize()*/);
+
+    // Without mesh bounds, assume a box from -1 to 1
+    glm::vec3 localCenter(0.0f);
+    glm::vec3 localSize(1.0f);
+    const Mesh& mesh = m_model->GetMesh();
+    if (mesh.HasBounds())
+    {
+        localCenter = 0.5f * (mesh.GetBoundsMax() + mesh.GetBoundsMin());
+        localSize = 0.5f * (mesh.GetBoundsMax() - mesh.GetBoundsMin());
+    }
+
+    // Transform the local box to world space. The scale of each axis is moved from the matrix to the size
+    glm::mat4 worldMatrix = m_transform->GetTransformMatrix();
+    glm::vec3 scale(glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2])));
+    glm::mat3 rotationMatrix = GetRotationMatrix(glm::mat3(worldMatrix), scale);
+    glm::vec3 center(worldMatrix * glm::vec4(localCenter, 1.0f));
+
+    return BoxBounds(center, rotationMatrix, scale * localSize);
 }
 
 void SceneModel::AcceptVisitor(SceneVisitor& visitor)
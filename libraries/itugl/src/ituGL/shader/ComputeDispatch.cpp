@@ -0,0 +1,65 @@
+#include <ituGL/shader/ComputeDispatch.h>
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/DeviceGL.h>
+#include <cassert>
+
+GLbitfield ComputeDispatch::s_pendingBarriers = 0;
+
+ComputeDispatch::ComputeDispatch(std::shared_ptr<const ShaderProgram> shaderProgram, GLbitfield barriers)
+    : m_shaderProgram(shaderProgram), m_workGroupSize(1), m_barriers(barriers)
+{
+    assert(m_shaderProgram && m_shaderProgram->IsLinked());
+
+    GLint workGroupSize[3];
+    glGetProgramiv(m_shaderProgram->GetHandle(), GL_COMPUTE_WORK_GROUP_SIZE, workGroupSize);
+    m_workGroupSize = glm::uvec3(workGroupSize[0], workGroupSize[1], workGroupSize[2]);
+}
+
+void ComputeDispatch::Dispatch(unsigned int groupCountX, unsigned int groupCountY, unsigned int groupCountZ) const
+{
+    if (groupCountX == 0 || groupCountY == 0 || groupCountZ == 0)
+    {
+        return;
+    }
+
+    BeginDispatch();
+    glDispatchCompute(groupCountX, groupCountY, groupCountZ);
+    EndDispatch();
+}
+
+void ComputeDispatch::DispatchInvocations(unsigned int countX, unsigned int countY, unsigned int countZ) const
+{
+    Dispatch((countX + m_workGroupSize.x - 1) / m_workGroupSize.x,
+        (countY + m_workGroupSize.y - 1) / m_workGroupSize.y,
+        (countZ + m_workGroupSize.z - 1) / m_workGroupSize.z);
+}
+
+// Bind the buffer to the dispatch indirect target, so no other target is modified
+void ComputeDispatch::DispatchIndirect(const BufferObject& buffer, size_t offset) const
+{
+    BeginDispatch();
+    DeviceGL::GetInstance().BindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer.GetHandle());
+    glDispatchComputeIndirect(static_cast<GLintptr>(offset));
+    EndDispatch();
+}
+
+void ComputeDispatch::Barrier()
+{
+    if (s_pendingBarriers)
+    {
+        glMemoryBarrier(s_pendingBarriers);
+        s_pendingBarriers = 0;
+    }
+}
+
+void ComputeDispatch::BeginDispatch() const
+{
+    // The program reads what the previous dispatches wrote, most of the time
+    Barrier();
+}
+
+void ComputeDispatch::EndDispatch() const
+{
+    s_pendingBarriers |= m_barriers;
+}
@@ -10,6 +10,7 @@ Material::Material(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet&
     : ShaderUniformCollection(shaderProgram, filteredUniforms)
     , m_depthTestFunction(TestFunction::Less)
     , m_depthWrite(true)
+    , m_depthPrePass(false)
     , m_stencilTestFunctions{ TestFunction::Never, TestFunction::Never }
     , m_stencilRefValues{ 0, 0 }
     , m_stencilMasks{ ~0u, ~0u }
@@ -46,6 +47,16 @@ void Material::SetDepthWrite(bool depthWrite)
     m_depthWrite = depthWrite;
 }
 
+bool Material::GetDepthPrePass() const
+{
+    return m_depthPrePass;
+}
+
+void Material::SetDepthPrePass(bool depthPrePass)
+{
+    m_depthPrePass = depthPrePass;
+}
+
 void Material::SetStencilTestFunction(TestFunction function, int refValue, unsigned int mask)
 {
     SetStencilFrontTestFunction(function, refValue, mask);
@@ -174,8 +185,11 @@ void Material::Use(OverrideFlags overrideFlags) const
 {
     assert(m_shaderProgram);
 
-    // Set the shader program as the one currently in use
-    m_shaderProgram->Use();
+    // If not skipped, set the shader program as the one currently in use
+    if ((overrideFlags & OverrideFlags::OverrideShaderProgram) == 0)
+    {
+        m_shaderProgram->Use();
+    }
 
     // Set the value of all the uniforms stored as properties
     SetUniforms();
@@ -207,101 +221,89 @@ void Material::Use(OverrideFlags overrideFlags) const
 
 void Material::UseDepthTest() const
 {
+    DeviceGL& device = DeviceGL::GetInstance();
+
     // Depth function
-    glDepthFunc(static_cast<GLenum>(m_depthTestFunction));
+    device.SetDepthFunction(static_cast<GLenum>(m_depthTestFunction));
 
     // Depth write
-    glDepthMask(m_depthWrite ? GL_TRUE : GL_FALSE);
+    device.SetDepthWrite(m_depthWrite);
 }
 
 void Material::UseStencilTest() const
 {
+    DeviceGL& device = DeviceGL::GetInstance();
+
     // Stencil operations
     if (m_stencilFail[0] == m_stencilFail[1] && m_stencilDepthFail[0] == m_stencilDepthFail[1] && m_stencilDepthPass[0] == m_stencilDepthPass[1])
     {
         // Same for front and back
-        glStencilOp(static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
+        device.SetStencilOperations(GL_FRONT_AND_BACK, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
     }
     else
     {
         // Separate functions for front and back
-        glStencilOpSeparate(GL_FRONT, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
-        glStencilOpSeparate(GL_BACK, static_cast<GLenum>(m_stencilFail[1]), static_cast<GLenum>(m_stencilDepthFail[1]), static_cast<GLenum>(m_stencilDepthPass[1]));
+        device.SetStencilOperations(GL_FRONT, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
+        device.SetStencilOperations(GL_BACK, static_cast<GLenum>(m_stencilFail[1]), static_cast<GLenum>(m_stencilDepthFail[1]), static_cast<GLenum>(m_stencilDepthPass[1]));
     }
 
     // Stencil functions
     if (m_stencilTestFunctions[0] == m_stencilTestFunctions[1] && m_stencilRefValues[0] == m_stencilRefValues[1] && m_stencilMasks[0] == m_stencilMasks[1])
     {
         // Same for front and back
-        glStencilFunc(static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
+        device.SetStencilFunction(GL_FRONT_AND_BACK, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
     }
     else
     {
         // Separate functions for front and back
-        glStencilFuncSeparate(GL_FRONT, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
-        glStencilFuncSeparate(GL_BACK, static_cast<GLenum>(m_stencilTestFunctions[1]), m_stencilRefValues[1], m_stencilMasks[1]);
+        device.SetStencilFunction(GL_FRONT, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
+        device.SetStencilFunction(GL_BACK, static_cast<GLenum>(m_stencilTestFunctions[1]), m_stencilRefValues[1], m_stencilMasks[1]);
     }
 }
 
 void Material::UseBlend() const
 {
+    DeviceGL& device = DeviceGL::GetInstance();
+
     // If the blend equation is None for color and alpha, do nothing
     bool blending = m_blendEquations[0] != BlendEquation::None || m_blendEquations[1] != BlendEquation::None;
-    DeviceGL::GetInstance().SetFeatureEnabled(GL_BLEND, blending);
+    device.SetFeatureEnabled(GL_BLEND, blending);
     if (blending)
     {
         std::array<BlendParam, 4> blendParams = m_blendParams;
 
-        // Set blend equation
-        if (m_blendEquations[0] == m_blendEquations[1])
-        {
-            // Set the same blend equation for color and alpha
-            glBlendEquation(static_cast<GLenum>(m_blendEquations[0]));
-        }
-        else
-        {
-            GLenum blendEquationColor = static_cast<GLenum>(m_blendEquations[0]);
-            GLenum blendEquationAlpha = static_cast<GLenum>(m_blendEquations[1]);
-
-            // Because there is no "None" equation, we replace it with (Source * 1 + Dest * 0)
-            if (m_blendEquations[0] == BlendEquation::None)
-            {
-                blendEquationColor = GL_FUNC_ADD;
-                blendParams[0] = BlendParam::One;
-                blendParams[1] = BlendParam::Zero;
-            }
-            if (m_blendEquations[1] == BlendEquation::None)
-            {
-                blendEquationAlpha = GL_FUNC_ADD;
-                blendParams[2] = BlendParam::One;
-                blendParams[3] = BlendParam::Zero;
-            }
-
-            // Set separate blend equation for color and alpha
-            glBlendEquationSeparate(blendEquationColor, blendEquationAlpha);
-        }
+        GLenum blendEquationColor = static_cast<GLenum>(m_blendEquations[0]);
+        GLenum blendEquationAlpha = static_cast<GLenum>(m_blendEquations[1]);
 
-        // Set blend params
-        if (blendParams[0] == blendParams[2] && blendParams[1] == blendParams[3])
+        // Because there is no "None" equation, we replace it with (Source * 1 + Dest * 0)
+        if (m_blendEquations[0] == BlendEquation::None)
         {
-            // Set the same blend params for color and alpha
-            glBlendFunc(static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]));
+            blendEquationColor = GL_FUNC_ADD;
+            blendParams[0] = BlendParam::One;
+            blendParams[1] = BlendParam::Zero;
         }
-        else
+        if (m_blendEquations[1] == BlendEquation::None)
         {
-            // Set separate blend params for color and alpha
-            glBlendFuncSeparate(
-                static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]),
-                static_cast<GLenum>(blendParams[2]), static_cast<GLenum>(blendParams[3]));
+            blendEquationAlpha = GL_FUNC_ADD;
+            blendParams[2] = BlendParam::One;
+            blendParams[3] = BlendParam::Zero;
         }
 
+        // Set blend equation. The device uses a single call if color and alpha are the same
+        device.SetBlendEquation(blendEquationColor, blendEquationAlpha);
+
+        // Set blend params. The device uses a single call if color and alpha are the same
+        device.SetBlendFunction(
+            static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]),
+            static_cast<GLenum>(blendParams[2]), static_cast<GLenum>(blendParams[3]));
+
         // Set blend color only if one param is using constant color or constant alpha
         if (blendParams[0] == BlendParam::ConstantColor || blendParams[0] == BlendParam::ConstantAlpha ||
             blendParams[1] == BlendParam::ConstantColor || blendParams[1] == BlendParam::ConstantAlpha ||
             blendParams[2] == BlendParam::ConstantColor || blendParams[2] == BlendParam::ConstantAlpha ||
             blendParams[3] == BlendParam::ConstantColor || blendParams[3] == BlendParam::ConstantAlpha)
         {
-            glBlendColor(m_blendColor.GetRed(), m_blendColor.GetGreen(), m_blendColor.GetBlue(), m_blendColor.GetAlpha());
+            device.SetBlendColor(m_blendColor);
         }
     }
 }
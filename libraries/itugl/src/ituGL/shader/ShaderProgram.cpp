@@ -2,6 +2,7 @@
 
 #include <ituGL/shader/Shader.h>
 #include <ituGL/texture/TextureObject.h>
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 #ifndef NDEBUG
@@ -19,6 +20,10 @@ ShaderProgram::~ShaderProgram()
     if (IsValid())
     {
         Handle& handle = GetHandle();
+        if (DeviceGL::GetInstancePointer())
+        {
+            DeviceGL::GetInstance().ForgetShaderProgram(handle);
+        }
         glDeleteProgram(handle);
         handle = NullHandle;
     }
@@ -124,7 +129,7 @@ void ShaderProgram::Use() const
     assert(IsValid());
     assert(IsLinked());
     Handle handle = GetHandle();
-    glUseProgram(handle);
+    DeviceGL::GetInstance().UseShaderProgram(handle);
 #ifndef NDEBUG
     s_usedHandle = handle;
 #endif
@@ -160,6 +165,26 @@ void ShaderProgram::GetUniformInfo(unsigned int index, int& size, GLenum& glType
     glGetActiveUniform(GetHandle(), index, uniformName.size(), nullptr, &size, &glType, uniformName.data());
 }
 
+// Find a uniform block index by name
+GLuint ShaderProgram::GetUniformBlockIndex(const char* name) const
+{
+    assert(IsValid());
+    assert(IsLinked());
+    return glGetUniformBlockIndex(GetHandle(), name);
+}
+
+// Assign the uniform block to a uniform buffer binding index
+bool ShaderProgram::SetUniformBlockBinding(const char* name, GLuint binding) const
+{
+    GLuint blockIndex = GetUniformBlockIndex(name);
+    if (blockIndex == GL_INVALID_INDEX)
+    {
+        return false;
+    }
+    glUniformBlockBinding(GetHandle(), blockIndex, binding);
+    return true;
+}
+
 // All the different combinations of Get/SetUniform
 template<>
 void ShaderProgram::GetUniform<GLint>(Location location, std::span<GLint> value) const
@@ -85,9 +85,10 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
         if (filteredUniforms.contains(uniformName))
             continue;
 
-        // Get the uniform location
+        // Get the uniform location. Uniforms in blocks have no location, they are read from uniform buffers
         ShaderProgram::Location location = GetUniformLocation(uniformName);
-        assert(location >= 0);
+        if (location < 0)
+            continue;
 
         Data::Type type;
         UniformDimension dimension;
@@ -231,9 +232,11 @@ bool ShaderUniformCollection::IsTextureUniform(GLenum glType, TextureObject::Tar
         target = TextureObject::Target::Texture1DArray;
         break;
     case GL_SAMPLER_2D:
+    case GL_SAMPLER_2D_SHADOW:
         target = TextureObject::Target::Texture2D;
         break;
     case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
         target = TextureObject::Target::Texture2DArray;
         break;
     case GL_SAMPLER_2D_MULTISAMPLE:
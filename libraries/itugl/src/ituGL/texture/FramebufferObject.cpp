@@ -3,6 +3,8 @@
 #include <ituGL/texture/Texture2DObject.h>
 #include <cassert>
 
+FramebufferObject::Handle FramebufferObject::s_defaultHandle = NullHandle;
+
 FramebufferObject::FramebufferObject() : Object(NullHandle)
 {
     Handle& handle = GetHandle();
@@ -12,6 +14,10 @@ FramebufferObject::FramebufferObject() : Object(NullHandle)
 FramebufferObject::~FramebufferObject()
 {
     Handle& handle = GetHandle();
+    if (handle == s_defaultHandle)
+    {
+        s_defaultHandle = NullHandle;
+    }
     glDeleteFramebuffers(1, &handle);
 }
 
@@ -33,8 +39,7 @@ void FramebufferObject::Unbind()
 
 void FramebufferObject::Unbind(Target target)
 {
-    Handle handle = NullHandle;
-    glBindFramebuffer(static_cast<GLenum>(target), handle);
+    glBindFramebuffer(static_cast<GLenum>(target), s_defaultHandle);
 }
 
 void FramebufferObject::SetTexture(Target target, Attachment attachment, const Texture2DObject& texture, int level)
@@ -46,3 +51,15 @@ void FramebufferObject::SetDrawBuffers(std::span<const Attachment> attachments)
 {
     glDrawBuffers(attachments.size(), reinterpret_cast<const GLenum*>(attachments.data()));
 }
+
+void FramebufferObject::Blit(GLint x, GLint y, GLsizei width, GLsizei height, GLbitfield mask)
+{
+    // Same region in both framebuffers, no scaling, so nearest filter is enough
+    glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, mask, GL_NEAREST);
+}
+
+void FramebufferObject::SetDefault(const FramebufferObject* framebuffer)
+{
+    s_defaultHandle = framebuffer ? framebuffer->GetHandle() : NullHandle;
+    Unbind();
+}
@@ -18,5 +18,7 @@ void Texture2DObject::SetImage<std::byte>(GLint level, GLsizei width, GLsizei he
 
 void Texture2DObject::SetImage(GLint level, GLsizei width, GLsizei height, Format format, InternalFormat internalFormat)
 {
-    SetImage<float>(level, width, height, format, internalFormat, std::span<float>());
+    // There is no data, but the type must still be valid for the format
+    Data::Type type = format == FormatDepthStencil ? Data::Type::UInt24_8 : Data::Type::Float;
+    SetImage<std::byte>(level, width, height, format, internalFormat, std::span<const std::byte>(), type);
 }
@@ -1,5 +1,6 @@
 #include <ituGL/texture/TextureObject.h>
 
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 TextureObject::TextureObject() : Object(NullHandle)
@@ -11,6 +12,10 @@ TextureObject::TextureObject() : Object(NullHandle)
 TextureObject::~TextureObject()
 {
     Handle& handle = GetHandle();
+    if (handle != NullHandle && DeviceGL::GetInstancePointer())
+    {
+        DeviceGL::GetInstance().ForgetTexture(handle);
+    }
     glDeleteTextures(1, &handle);
 }
 
@@ -25,19 +30,19 @@ GLint TextureObject::GetActiveTexture()
 
 void TextureObject::SetActiveTexture(GLint textureUnit)
 {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    DeviceGL::GetInstance().SetActiveTextureUnit(textureUnit);
 }
 
 void TextureObject::Bind(Target target) const
 {
     Handle handle = GetHandle();
-    glBindTexture(target, handle);
+    DeviceGL::GetInstance().BindTexture(target, handle);
 }
 
 void TextureObject::Unbind(Target target)
 {
     Handle handle = NullHandle;
-    glBindTexture(target, handle);
+    DeviceGL::GetInstance().BindTexture(target, handle);
 }
 
 void TextureObject::GenerateMipmap()
@@ -168,6 +173,7 @@ bool TextureObject::IsValidFormat(Format format, InternalFormat internalFormat)
         return false;
     }
 }
+#endif
 
 int TextureObject::GetComponentCount(Format format)
 {
@@ -249,4 +255,3 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
         return 0;
     }
 }
-#endif
@@ -0,0 +1,219 @@
+#include "TestSuite.h"
+#include "MockGL.h"
+
+#include <ituGL/geometry/GeometryPool.h>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Vertices are a single float, and each mesh fills its vertices and elements with values derived from its id,
+    // so the contents of the buffers show where each mesh went
+    VertexFormat MakeVertexFormat()
+    {
+        VertexFormat vertexFormat;
+        vertexFormat.AddVertexAttribute<float>(1, VertexAttribute::Semantic::Position);
+        return vertexFormat;
+    }
+
+    struct Mesh
+    {
+        unsigned int id;
+        std::vector<float> vertices;
+        std::vector<unsigned int> elements;
+    };
+
+    Mesh MakeMesh(unsigned int id, unsigned int vertexCount, unsigned int elementCount)
+    {
+        Mesh mesh{ id };
+        for (unsigned int i = 0; i < vertexCount; ++i)
+        {
+            mesh.vertices.push_back(static_cast<float>(id * 1000 + i));
+        }
+        for (unsigned int i = 0; i < elementCount; ++i)
+        {
+            mesh.elements.push_back(i % vertexCount);
+        }
+        return mesh;
+    }
+
+    GeometryPool::Handle Allocate(GeometryPool& pool, const Mesh& mesh)
+    {
+        return pool.Allocate(MakeVertexFormat(), GeometryPool::SemanticMap(),
+            std::as_bytes(std::span(mesh.vertices)), std::as_bytes(std::span(mesh.elements)));
+    }
+
+    // Indirect command of the whole allocation, with the first element and vertex as indices
+    Drawcall::ElementsIndirectCommand GetCommand(const GeometryPool& pool, GeometryPool::Handle handle)
+    {
+        return pool.GetDrawcall(handle, Drawcall::Primitive::Triangles).GetIndirectCommand(1, 0);
+    }
+
+    // Check that the ranges of the allocation hold the data of the mesh
+    bool HasMeshData(const GeometryPool& pool, GeometryPool::Handle handle, const Mesh& mesh)
+    {
+        Drawcall::ElementsIndirectCommand command = GetCommand(pool, handle);
+        if (command.count != mesh.elements.size())
+        {
+            return false;
+        }
+
+        std::span<const std::byte> vertexData = MockGL::GetBufferData(pool.GetVertexBuffer(handle).GetHandle());
+        std::span<const std::byte> elementData = MockGL::GetBufferData(pool.GetElementBuffer(handle).GetHandle());
+        size_t vertexOffset = command.baseVertex * sizeof(float);
+        size_t elementOffset = command.firstIndex * sizeof(unsigned int);
+        if (vertexOffset + mesh.vertices.size() * sizeof(float) > vertexData.size()
+            || elementOffset + mesh.elements.size() * sizeof(unsigned int) > elementData.size())
+        {
+            return false;
+        }
+
+        return std::memcmp(vertexData.data() + vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(float)) == 0
+            && std::memcmp(elementData.data() + elementOffset, mesh.elements.data(), mesh.elements.size() * sizeof(unsigned int)) == 0;
+    }
+}
+
+void AddGeometryPoolTests(TestSuite& suite)
+{
+    suite.Add("geometry_pool/round_trip", []()
+        {
+            MockGL::Install();
+            GeometryPool pool(Data::Type::UInt, 64, 256);
+
+            Mesh meshA = MakeMesh(1, 10, 30);
+            Mesh meshB = MakeMesh(2, 20, 60);
+            GeometryPool::Handle handleA = Allocate(pool, meshA);
+            GeometryPool::Handle handleB = Allocate(pool, meshB);
+            ITUGL_CHECK(handleA != handleB);
+            ITUGL_CHECK(pool.GetBufferSetCount() == 1);
+
+            // Allocations are packed one after the other, and share the buffers of their format
+            ITUGL_CHECK(GetCommand(pool, handleB).baseVertex == 10 && GetCommand(pool, handleB).firstIndex == 30);
+            ITUGL_CHECK(&pool.GetVertexArray(handleA) == &pool.GetVertexArray(handleB));
+            ITUGL_CHECK(HasMeshData(pool, handleA, meshA));
+            ITUGL_CHECK(HasMeshData(pool, handleB, meshB));
+
+            // Partial drawcalls are relative to the first element of the allocation
+            Drawcall::ElementsIndirectCommand command = pool.GetDrawcall(handleB, Drawcall::Primitive::Triangles, 6, 9).GetIndirectCommand(1, 0);
+            ITUGL_CHECK(command.firstIndex == 36 && command.count == 9 && command.baseVertex == 10);
+
+            // A different format gets its own buffers
+            VertexFormat otherFormat;
+            otherFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+            std::vector<float> vertices(9, 0.0f);
+            std::vector<unsigned int> elements = { 0, 1, 2 };
+            GeometryPool::Handle handleC = pool.Allocate(otherFormat, GeometryPool::SemanticMap(),
+                std::as_bytes(std::span(vertices)), std::as_bytes(std::span(elements)));
+            ITUGL_CHECK(pool.GetBufferSetCount() == 2);
+            ITUGL_CHECK(GetCommand(pool, handleC).baseVertex == 0);
+            ITUGL_CHECK(HasMeshData(pool, handleA, meshA));
+        });
+
+    suite.Add("geometry_pool/free_list_first_fit", []()
+        {
+            MockGL::Install();
+            GeometryPool pool(Data::Type::UInt, 64, 256);
+
+            Mesh meshA = MakeMesh(1, 10, 30);
+            Mesh meshB = MakeMesh(2, 10, 30);
+            Mesh meshC = MakeMesh(3, 10, 30);
+            GeometryPool::Handle handleA = Allocate(pool, meshA);
+            GeometryPool::Handle handleB = Allocate(pool, meshB);
+            GeometryPool::Handle handleC = Allocate(pool, meshC);
+            unsigned int generation = pool.GetGeneration();
+
+            // The hole left by B is the first range large enough, and its handle is reused
+            pool.Free(handleB);
+            Mesh meshD = MakeMesh(4, 8, 24);
+            GeometryPool::Handle handleD = Allocate(pool, meshD);
+            ITUGL_CHECK(handleD == handleB);
+            ITUGL_CHECK(GetCommand(pool, handleD).baseVertex == 10 && GetCommand(pool, handleD).firstIndex == 30);
+
+            // The rest of the hole is too small, so the next one goes after C
+            Mesh meshE = MakeMesh(5, 4, 12);
+            GeometryPool::Handle handleE = Allocate(pool, meshE);
+            ITUGL_CHECK(GetCommand(pool, handleE).baseVertex == 30 && GetCommand(pool, handleE).firstIndex == 90);
+
+            // Nothing was moved
+            ITUGL_CHECK(pool.GetGeneration() == generation);
+            ITUGL_CHECK(HasMeshData(pool, handleA, meshA));
+            ITUGL_CHECK(HasMeshData(pool, handleC, meshC));
+            ITUGL_CHECK(HasMeshData(pool, handleD, meshD));
+            ITUGL_CHECK(HasMeshData(pool, handleE, meshE));
+        });
+
+    suite.Add("geometry_pool/free_ranges_coalesce", []()
+        {
+            MockGL::Install();
+            GeometryPool pool(Data::Type::UInt, 30, 90);
+
+            GeometryPool::Handle handleA = Allocate(pool, MakeMesh(1, 10, 30));
+            GeometryPool::Handle handleB = Allocate(pool, MakeMesh(2, 10, 30));
+            GeometryPool::Handle handleC = Allocate(pool, MakeMesh(3, 10, 30));
+            unsigned int generation = pool.GetGeneration();
+
+            // B is merged with both neighbours, so the whole buffer is a single free range again
+            pool.Free(handleA);
+            pool.Free(handleC);
+            pool.Free(handleB);
+
+            Mesh meshD = MakeMesh(4, 30, 90);
+            GeometryPool::Handle handleD = Allocate(pool, meshD);
+            ITUGL_CHECK(pool.GetGeneration() == generation);
+            ITUGL_CHECK(GetCommand(pool, handleD).baseVertex == 0 && GetCommand(pool, handleD).firstIndex == 0);
+            ITUGL_CHECK(HasMeshData(pool, handleD, meshD));
+        });
+
+    suite.Add("geometry_pool/growth_keeps_data", []()
+        {
+            MockGL::Install();
+            GeometryPool pool(Data::Type::UInt, 16, 48);
+
+            Mesh meshA = MakeMesh(1, 10, 30);
+            Mesh meshB = MakeMesh(2, 10, 30);
+            GeometryPool::Handle handleA = Allocate(pool, meshA);
+            unsigned int generation = pool.GetGeneration();
+            GLuint vertexBuffer = pool.GetVertexBuffer(handleA).GetHandle();
+
+            // B doesn't fit, the buffers are replaced by larger ones with A copied over
+            GeometryPool::Handle handleB = Allocate(pool, meshB);
+            ITUGL_CHECK(pool.GetGeneration() == generation + 1);
+            ITUGL_CHECK(pool.GetVertexBuffer(handleA).GetHandle() != vertexBuffer);
+            ITUGL_CHECK(MockGL::GetBufferData(pool.GetVertexBuffer(handleA).GetHandle()).size() >= 32 * sizeof(float));
+            ITUGL_CHECK(HasMeshData(pool, handleA, meshA));
+            ITUGL_CHECK(HasMeshData(pool, handleB, meshB));
+        });
+
+    suite.Add("geometry_pool/defragment_packs_allocations", []()
+        {
+            MockGL::Install();
+            GeometryPool pool(Data::Type::UInt, 64, 256);
+
+            Mesh meshA = MakeMesh(1, 10, 30);
+            Mesh meshC = MakeMesh(3, 5, 15);
+            GeometryPool::Handle handleA = Allocate(pool, meshA);
+            GeometryPool::Handle handleB = Allocate(pool, MakeMesh(2, 10, 30));
+            GeometryPool::Handle handleC = Allocate(pool, meshC);
+            pool.Free(handleB);
+            unsigned int generation = pool.GetGeneration();
+
+            // C moves down into the hole, keeping its handle and its data
+            pool.Defragment();
+            ITUGL_CHECK(pool.GetGeneration() == generation + 1);
+            ITUGL_CHECK(GetCommand(pool, handleA).baseVertex == 0 && GetCommand(pool, handleA).firstIndex == 0);
+            ITUGL_CHECK(GetCommand(pool, handleC).baseVertex == 10 && GetCommand(pool, handleC).firstIndex == 30);
+            ITUGL_CHECK(HasMeshData(pool, handleA, meshA));
+            ITUGL_CHECK(HasMeshData(pool, handleC, meshC));
+
+            // Already compact, nothing to move
+            pool.Defragment();
+            ITUGL_CHECK(pool.GetGeneration() == generation + 1);
+
+            // The free space is a single range after C
+            Mesh meshD = MakeMesh(4, 49, 211);
+            GeometryPool::Handle handleD = Allocate(pool, meshD);
+            ITUGL_CHECK(pool.GetGeneration() == generation + 1);
+            ITUGL_CHECK(GetCommand(pool, handleD).baseVertex == 15 && GetCommand(pool, handleD).firstIndex == 45);
+            ITUGL_CHECK(HasMeshData(pool, handleD, meshD));
+        });
+}
@@ -0,0 +1,171 @@
+#include "TestSuite.h"
+
+#include <ituGL/application/InputLog.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::string GetLogPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    bool IsSameInput(const Window::InputState& a, const Window::InputState& b)
+    {
+        return a.keys == b.keys && a.mouseButtons == b.mouseButtons && a.mousePosition == b.mousePosition;
+    }
+
+    // Frames with keys and buttons pressed and released, and the mouse moving, with some empty frames between them
+    std::vector<Window::InputState> MakeFrames()
+    {
+        std::vector<Window::InputState> frames;
+        Window::InputState state;
+        frames.push_back(state);
+
+        state.keys.set(GLFW_KEY_W);
+        state.keys.set(GLFW_KEY_LEFT_SHIFT);
+        frames.push_back(state);
+        frames.push_back(state);
+
+        state.mousePosition = glm::vec2(120.5f, -3.25f);
+        state.mouseButtons.set(GLFW_MOUSE_BUTTON_LEFT);
+        frames.push_back(state);
+
+        state.keys.reset(GLFW_KEY_W);
+        state.keys.set(GLFW_KEY_LAST);
+        state.mouseButtons.set(GLFW_MOUSE_BUTTON_LAST);
+        state.mousePosition = glm::vec2(0.0f, 1000.0f);
+        frames.push_back(state);
+
+        state.keys.reset();
+        state.mouseButtons.reset();
+        frames.push_back(state);
+        return frames;
+    }
+}
+
+void AddInputLogTests(TestSuite& suite)
+{
+    suite.Add("input_log/round_trip", []()
+        {
+            std::string path = GetLogPath("itugl_input_log_round_trip.bin");
+            std::vector<Window::InputState> frames = MakeFrames();
+
+            InputLog inputLog;
+            ITUGL_CHECK(inputLog.StartRecording(path.c_str(), InputLog::Header{ 0x123456789abcdefull, 1.0f / 60.0f }));
+            for (const Window::InputState& frame : frames)
+            {
+                inputLog.RecordFrame(frame);
+            }
+            ITUGL_CHECK(inputLog.GetFrameCount() == frames.size());
+            inputLog.Stop();
+
+            InputLog::Header header = {};
+            ITUGL_CHECK(inputLog.StartReplay(path.c_str(), header));
+            ITUGL_CHECK(header.seed == 0x123456789abcdefull && header.deltaTime == 1.0f / 60.0f);
+
+            // The window size is not part of the log, it is left as it is
+            Window::InputState state;
+            state.width = 640;
+            state.height = 480;
+            for (const Window::InputState& frame : frames)
+            {
+                ITUGL_CHECK(inputLog.ReplayFrame(state));
+                ITUGL_CHECK(IsSameInput(state, frame));
+            }
+            ITUGL_CHECK(inputLog.GetFrameCount() == frames.size());
+            ITUGL_CHECK(state.width == 640 && state.height == 480);
+
+            // Past the end, the last frame keeps being replayed
+            state.keys.set(GLFW_KEY_SPACE);
+            ITUGL_CHECK(!inputLog.ReplayFrame(state));
+            ITUGL_CHECK(IsSameInput(state, frames.back()));
+            ITUGL_CHECK(inputLog.GetFrameCount() == frames.size());
+            inputLog.Stop();
+
+            std::filesystem::remove(path);
+        });
+
+    suite.Add("input_log/only_changes_are_stored", []()
+        {
+            std::string path = GetLogPath("itugl_input_log_changes.bin");
+            const std::uintmax_t headerSize = 20;
+
+            InputLog inputLog;
+            ITUGL_CHECK(inputLog.StartRecording(path.c_str(), InputLog::Header{ 1, 0.01f }));
+
+            // A frame without changes is just its count
+            Window::InputState state;
+            for (int frame = 0; frame < 10; ++frame)
+            {
+                inputLog.RecordFrame(state);
+            }
+
+            // 200 changes don't fit in 7 bits, so the count takes two bytes, followed by the type and key code of each one
+            for (int keyCode = 0; keyCode < 200; ++keyCode)
+            {
+                state.keys.set(keyCode);
+            }
+            inputLog.RecordFrame(state);
+
+            // Holding keys is not a change
+            inputLog.RecordFrame(state);
+            inputLog.Stop();
+            ITUGL_CHECK(std::filesystem::file_size(path) == headerSize + 10 + (2 + 200 * 3) + 1);
+
+            InputLog::Header header;
+            Window::InputState replayedState;
+            ITUGL_CHECK(inputLog.StartReplay(path.c_str(), header));
+            unsigned int frameCount = 0;
+            while (inputLog.ReplayFrame(replayedState))
+            {
+                frameCount++;
+            }
+            ITUGL_CHECK(frameCount == 12);
+            ITUGL_CHECK(IsSameInput(replayedState, state));
+            inputLog.Stop();
+
+            std::filesystem::remove(path);
+        });
+
+    suite.Add("input_log/rejects_invalid_files", []()
+        {
+            std::string path = GetLogPath("itugl_input_log_invalid.bin");
+            InputLog inputLog;
+            InputLog::Header header;
+
+            std::filesystem::remove(path);
+            ITUGL_CHECK(!inputLog.StartReplay(path.c_str(), header));
+
+            {
+                std::ofstream file(path, std::ios::binary);
+                file << "not an input log, but long enough to have a header";
+            }
+            ITUGL_CHECK(!inputLog.StartReplay(path.c_str(), header));
+            ITUGL_CHECK(!inputLog.IsReplaying());
+
+            // A log cut in the middle of a frame stops at the last complete one
+            Window::InputState state;
+            ITUGL_CHECK(inputLog.StartRecording(path.c_str(), InputLog::Header{ 2, 0.02f }));
+            state.keys.set(GLFW_KEY_A);
+            inputLog.RecordFrame(state);
+            state.keys.set(GLFW_KEY_B);
+            state.mousePosition = glm::vec2(1.0f, 2.0f);
+            inputLog.RecordFrame(state);
+            inputLog.Stop();
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+            Window::InputState replayedState;
+            ITUGL_CHECK(inputLog.StartReplay(path.c_str(), header));
+            ITUGL_CHECK(inputLog.ReplayFrame(replayedState));
+            ITUGL_CHECK(replayedState.keys.test(GLFW_KEY_A) && replayedState.keys.count() == 1);
+            ITUGL_CHECK(!inputLog.ReplayFrame(replayedState));
+            ITUGL_CHECK(inputLog.GetFrameCount() == 1);
+            inputLog.Stop();
+
+            std::filesystem::remove(path);
+        });
+}
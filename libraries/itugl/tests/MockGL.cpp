@@ -0,0 +1,278 @@
+#include "MockGL.h"
+
+#include <ituGL/core/DeviceGL.h>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MockGL
+{
+    namespace
+    {
+        struct State
+        {
+            // Handles are never reused, not even after Install, so the bindings cached by the device are never stale
+            GLuint nextHandle = 1;
+
+            std::unordered_map<GLuint, std::vector<std::byte>> buffers;
+            std::unordered_map<GLenum, GLuint> boundBuffers;
+
+            // Textures have no storage, only the number of live ones is tracked
+            std::unordered_set<GLuint> textures;
+
+            CallCounts callCounts;
+            std::vector<CopyCall> copyCalls;
+
+            // Fences are fake pointers, they are never dereferenced
+            std::uintptr_t nextFence = 1;
+        };
+
+        State& GetState()
+        {
+            static State state;
+            return state;
+        }
+
+        std::vector<std::byte>& GetBoundBuffer(GLenum target)
+        {
+            State& state = GetState();
+            return state.buffers[state.boundBuffers[target]];
+        }
+
+        void APIENTRY GenObjects(GLsizei n, GLuint* handles)
+        {
+            State& state = GetState();
+            for (GLsizei i = 0; i < n; ++i)
+            {
+                handles[i] = state.nextHandle++;
+            }
+        }
+
+        void APIENTRY DeleteBuffers(GLsizei n, const GLuint* buffers)
+        {
+            State& state = GetState();
+            for (GLsizei i = 0; i < n; ++i)
+            {
+                state.buffers.erase(buffers[i]);
+
+                // Deleted buffers are unbound, like in OpenGL
+                for (auto& [target, buffer] : state.boundBuffers)
+                {
+                    buffer = buffer == buffers[i] ? 0 : buffer;
+                }
+            }
+        }
+
+        void APIENTRY DeleteObjects(GLsizei, const GLuint*)
+        {
+        }
+
+        void APIENTRY GenTextures(GLsizei n, GLuint* textures)
+        {
+            GenObjects(n, textures);
+            GetState().textures.insert(textures, textures + n);
+        }
+
+        void APIENTRY DeleteTextures(GLsizei n, const GLuint* textures)
+        {
+            for (GLsizei i = 0; i < n; ++i)
+            {
+                GetState().textures.erase(textures[i]);
+            }
+        }
+
+        void APIENTRY ActiveTexture(GLenum)
+        {
+        }
+
+        void APIENTRY BindTexture(GLenum, GLuint)
+        {
+        }
+
+        void APIENTRY TexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*)
+        {
+        }
+
+        void APIENTRY TexParameteri(GLenum, GLenum, GLint)
+        {
+        }
+
+        void APIENTRY TexParameterf(GLenum, GLenum, GLfloat)
+        {
+        }
+
+        void APIENTRY BindBuffer(GLenum target, GLuint buffer)
+        {
+            GetState().boundBuffers[target] = buffer;
+        }
+
+        void APIENTRY BindBufferBase(GLenum target, GLuint, GLuint buffer)
+        {
+            GetState().boundBuffers[target] = buffer;
+        }
+
+        void APIENTRY BindVertexArray(GLuint)
+        {
+        }
+
+        void APIENTRY BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+        {
+            GetState().callCounts.bufferData++;
+            std::vector<std::byte>& buffer = GetBoundBuffer(target);
+            buffer.assign(size, std::byte(0));
+            if (data)
+            {
+                std::memcpy(buffer.data(), data, size);
+            }
+        }
+
+        void APIENTRY BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+        {
+            GetState().callCounts.bufferSubData++;
+            std::vector<std::byte>& buffer = GetBoundBuffer(target);
+            if (offset + size <= static_cast<GLsizeiptr>(buffer.size()))
+            {
+                std::memcpy(buffer.data() + offset, data, size);
+            }
+        }
+
+        void APIENTRY BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield)
+        {
+            GetState().callCounts.bufferStorage++;
+            std::vector<std::byte>& buffer = GetBoundBuffer(target);
+            buffer.assign(size, std::byte(0));
+            if (data)
+            {
+                std::memcpy(buffer.data(), data, size);
+            }
+        }
+
+        // Storage is never reallocated while mapped, so the pointer stays valid like a persistent mapping
+        void* APIENTRY MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr, GLbitfield)
+        {
+            return GetBoundBuffer(target).data() + offset;
+        }
+
+        GLboolean APIENTRY UnmapBuffer(GLenum)
+        {
+            return GL_TRUE;
+        }
+
+        void APIENTRY CopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+        {
+            State& state = GetState();
+            state.callCounts.copyBufferSubData++;
+            state.copyCalls.push_back(CopyCall{ readOffset, writeOffset, size });
+
+            const std::vector<std::byte>& readBuffer = GetBoundBuffer(readTarget);
+            std::vector<std::byte>& writeBuffer = GetBoundBuffer(writeTarget);
+            if (readOffset + size <= static_cast<GLsizeiptr>(readBuffer.size()) && writeOffset + size <= static_cast<GLsizeiptr>(writeBuffer.size()))
+            {
+                std::memmove(writeBuffer.data() + writeOffset, readBuffer.data() + readOffset, size);
+            }
+        }
+
+        GLsync APIENTRY FenceSync(GLenum, GLbitfield)
+        {
+            State& state = GetState();
+            state.callCounts.fenceSync++;
+            return reinterpret_cast<GLsync>(state.nextFence++);
+        }
+
+        GLenum APIENTRY ClientWaitSync(GLsync, GLbitfield, GLuint64)
+        {
+            GetState().callCounts.clientWaitSync++;
+            return GL_ALREADY_SIGNALED;
+        }
+
+        void APIENTRY DeleteSync(GLsync)
+        {
+        }
+
+        void APIENTRY VertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*)
+        {
+        }
+
+        void APIENTRY EnableVertexAttribArray(GLuint)
+        {
+        }
+
+        void APIENTRY VertexAttribDivisor(GLuint, GLuint)
+        {
+        }
+
+        GLenum APIENTRY GetError()
+        {
+            return GL_NO_ERROR;
+        }
+    }
+
+    void Install(int majorVersion, int minorVersion)
+    {
+        glad_glGenBuffers = GenObjects;
+        glad_glDeleteBuffers = DeleteBuffers;
+        glad_glBindBuffer = BindBuffer;
+        glad_glBindBufferBase = BindBufferBase;
+        glad_glBufferData = BufferData;
+        glad_glBufferSubData = BufferSubData;
+        glad_glBufferStorage = BufferStorage;
+        glad_glMapBufferRange = MapBufferRange;
+        glad_glUnmapBuffer = UnmapBuffer;
+        glad_glCopyBufferSubData = CopyBufferSubData;
+        glad_glFenceSync = FenceSync;
+        glad_glClientWaitSync = ClientWaitSync;
+        glad_glDeleteSync = DeleteSync;
+        glad_glGenVertexArrays = GenObjects;
+        glad_glDeleteVertexArrays = DeleteObjects;
+        glad_glBindVertexArray = BindVertexArray;
+        glad_glVertexAttribPointer = VertexAttribPointer;
+        glad_glEnableVertexAttribArray = EnableVertexAttribArray;
+        glad_glVertexAttribDivisor = VertexAttribDivisor;
+        glad_glGenTextures = GenTextures;
+        glad_glDeleteTextures = DeleteTextures;
+        glad_glActiveTexture = ActiveTexture;
+        glad_glBindTexture = BindTexture;
+        glad_glTexImage2D = TexImage2D;
+        glad_glTexParameteri = TexParameteri;
+        glad_glTexParameterf = TexParameterf;
+        glad_glGetError = GetError;
+
+        int version = majorVersion * 10 + minorVersion;
+        GLAD_GL_VERSION_4_2 = version >= 42;
+        GLAD_GL_VERSION_4_3 = version >= 43;
+        GLAD_GL_VERSION_4_4 = version >= 44;
+        GLAD_GL_VERSION_4_5 = version >= 45;
+        GLAD_GL_VERSION_4_6 = version >= 46;
+
+        State& state = GetState();
+        state.buffers.clear();
+        state.textures.clear();
+        state.callCounts = CallCounts();
+        state.copyCalls.clear();
+
+        // Objects are bound through the device
+        static DeviceGL device;
+    }
+
+    const CallCounts& GetCallCounts()
+    {
+        return GetState().callCounts;
+    }
+
+    std::span<const CopyCall> GetCopyCalls()
+    {
+        return GetState().copyCalls;
+    }
+
+    std::span<const std::byte> GetBufferData(GLuint buffer)
+    {
+        return GetState().buffers[buffer];
+    }
+
+    unsigned int GetTextureCount()
+    {
+        return static_cast<unsigned int>(GetState().textures.size());
+    }
+}
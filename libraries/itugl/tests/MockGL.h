@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <span>
+
+// OpenGL replaced by an in-memory implementation, so the classes that manage buffers can be tested without a context.
+// Only buffers are emulated: their data is kept in CPU memory, and the copies and updates are counted.
+// Vertex arrays and textures only get handles, and fences are always signaled
+namespace MockGL
+{
+    // Number of calls to each function since the last Install
+    struct CallCounts
+    {
+        unsigned int bufferData = 0;
+        unsigned int bufferSubData = 0;
+        unsigned int bufferStorage = 0;
+        unsigned int copyBufferSubData = 0;
+        unsigned int fenceSync = 0;
+        unsigned int clientWaitSync = 0;
+    };
+
+    // Arguments of the last glCopyBufferSubData calls, oldest first
+    struct CopyCall
+    {
+        GLintptr readOffset;
+        GLintptr writeOffset;
+        GLsizeiptr size;
+    };
+
+    // Replace the OpenGL functions, forget all the buffers and reset the counters. The version sets GLAD_GL_VERSION_x_y
+    // up to it, so the code takes the paths of that version. It also creates the device, needed to bind objects
+    void Install(int majorVersion = 4, int minorVersion = 6);
+
+    const CallCounts& GetCallCounts();
+    std::span<const CopyCall> GetCopyCalls();
+
+    // Current data of the buffer
+    std::span<const std::byte> GetBufferData(GLuint buffer);
+
+    // Number of textures created and not deleted since the last Install
+    unsigned int GetTextureCount();
+}
@@ -0,0 +1,153 @@
+#include "TestSuite.h"
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/core/Random.h>
+#include <ituGL/scene/OcclusionCuller.h>
+#include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Camera at the origin looking down +Z
+    glm::mat4 GetViewProjMatrix()
+    {
+        Camera camera;
+        camera.SetViewMatrix(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        camera.SetPerspectiveProjectionMatrix(1.0f, 2.0f, 0.1f, 100.0f);
+        return camera.GetViewProjectionMatrix();
+    }
+
+    // Wall 8 units wide and tall, 10 units in front of the camera
+    void AddWall(OcclusionCuller& culler)
+    {
+        culler.AddOccluderBox(glm::vec3(-1.0f), glm::vec3(1.0f), glm::translate(glm::vec3(0.0f, 0.0f, 10.0f)) * glm::scale(glm::vec3(4.0f, 4.0f, 0.5f)));
+    }
+
+    // Run the test with the scalar rasterizer, and again with SIMD if it is supported
+    void ForEachRasterizer(const std::function<void(OcclusionCuller&)>& test)
+    {
+        OcclusionCuller scalarCuller;
+        scalarCuller.SetSimdEnabled(false);
+        test(scalarCuller);
+
+        if (OcclusionCuller::IsSimdSupported())
+        {
+            OcclusionCuller simdCuller;
+            ITUGL_CHECK(simdCuller.GetSimdEnabled());
+            test(simdCuller);
+        }
+    }
+
+    // Rasterize random triangles, some of them crossing the borders of the screen and the near plane
+    void RasterizeRandomTriangles(OcclusionCuller& culler, unsigned int seed)
+    {
+        Random random(seed);
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        for (unsigned int i = 0; i < 300; ++i)
+        {
+            glm::vec3 center(random.NextRange(-30.0f, 30.0f), random.NextRange(-15.0f, 15.0f), random.NextRange(0.0f, 60.0f));
+            for (int vertex = 0; vertex < 3; ++vertex)
+            {
+                glm::vec3 offset(random.NextRange(-8.0f, 8.0f), random.NextRange(-8.0f, 8.0f), random.NextRange(-4.0f, 4.0f));
+                indices.push_back(static_cast<unsigned int>(positions.size()));
+                positions.push_back(center + offset);
+            }
+        }
+
+        culler.Begin(GetViewProjMatrix());
+        culler.AddOccluder(positions, indices, glm::mat4(1.0f));
+        culler.End();
+    }
+
+    // All the levels of both depth buffers must be exactly the same
+    bool HasSameDepths(const OcclusionCuller& culler0, const OcclusionCuller& culler1)
+    {
+        int levelWidth = culler0.GetWidth();
+        int levelHeight = culler0.GetHeight();
+        for (unsigned int level = 0; level < culler0.GetLevelCount(); ++level)
+        {
+            for (int y = 0; y < levelHeight; ++y)
+            {
+                for (int x = 0; x < levelWidth; ++x)
+                {
+                    if (culler0.GetDepth(x, y, level) != culler1.GetDepth(x, y, level))
+                    {
+                        return false;
+                    }
+                }
+            }
+            levelWidth = std::max(1, (levelWidth + 1) / 2);
+            levelHeight = std::max(1, (levelHeight + 1) / 2);
+        }
+        return true;
+    }
+}
+
+void AddOcclusionCullerTests(TestSuite& suite)
+{
+    suite.Add("occlusion/occluder_hides_occludee", []()
+        {
+            ForEachRasterizer([](OcclusionCuller& culler)
+                {
+                    culler.Begin(GetViewProjMatrix());
+                    AddWall(culler);
+                    culler.End();
+
+                    ITUGL_CHECK(culler.GetTriangleCount() > 0);
+                    ITUGL_CHECK(!culler.IsVisible(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(1.0f)));
+                });
+        });
+
+    suite.Add("occlusion/partial_overlap", []()
+        {
+            ForEachRasterizer([](OcclusionCuller& culler)
+                {
+                    culler.Begin(GetViewProjMatrix());
+                    AddWall(culler);
+                    culler.End();
+
+                    // Half of the box is behind the wall, the other half sticks out on the right
+                    ITUGL_CHECK(culler.IsVisible(glm::vec3(8.0f, 0.0f, 20.0f), glm::vec3(2.0f)));
+                });
+        });
+
+    suite.Add("occlusion/occludee_in_front", []()
+        {
+            ForEachRasterizer([](OcclusionCuller& culler)
+                {
+                    culler.Begin(GetViewProjMatrix());
+                    AddWall(culler);
+                    culler.End();
+
+                    ITUGL_CHECK(culler.IsVisible(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(1.0f)));
+                });
+        });
+
+    suite.Add("occlusion/simd_matches_scalar", []()
+        {
+            if (!OcclusionCuller::IsSimdSupported())
+            {
+                return;
+            }
+
+            // Widths that are not multiples of the SIMD width, so the rows end with scalar pixels
+            const int sizes[][2] = { { 256, 128 }, { 101, 57 }, { 7, 5 } };
+            for (const auto& size : sizes)
+            {
+                for (unsigned int seed = 1; seed <= 8; ++seed)
+                {
+                    OcclusionCuller scalarCuller(size[0], size[1]);
+                    scalarCuller.SetSimdEnabled(false);
+                    RasterizeRandomTriangles(scalarCuller, seed);
+
+                    OcclusionCuller simdCuller(size[0], size[1]);
+                    RasterizeRandomTriangles(simdCuller, seed);
+
+                    ITUGL_CHECK(scalarCuller.GetTriangleCount() == simdCuller.GetTriangleCount());
+                    ITUGL_CHECK(HasSameDepths(scalarCuller, simdCuller));
+                }
+            }
+        });
+}
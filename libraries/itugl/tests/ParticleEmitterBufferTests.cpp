@@ -0,0 +1,115 @@
+#include "TestSuite.h"
+#include "MockGL.h"
+
+#include <ituGL/particles/ParticleEmitterBuffer.h>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Particles are the index of their emission, so the contents of the vertex buffer show where each one went
+    using Particle = unsigned int;
+
+    void EmitParticles(ParticleEmitterBuffer& particles, Particle first, unsigned int count)
+    {
+        for (Particle particle = first; particle < first + count; ++particle)
+        {
+            particles.Emit(particle);
+        }
+    }
+
+    std::vector<Particle> ReadVertexBuffer(const ParticleEmitterBuffer& particles)
+    {
+        std::span<const std::byte> data = MockGL::GetBufferData(particles.GetVertexBuffer().GetHandle());
+        std::vector<Particle> vertices(data.size() / sizeof(Particle));
+        std::memcpy(vertices.data(), data.data(), vertices.size() * sizeof(Particle));
+        return vertices;
+    }
+}
+
+void AddParticleEmitterBufferTests(TestSuite& suite)
+{
+    suite.Add("particle_emitter/wrap_splits_copy", []()
+        {
+            MockGL::Install(4, 4);
+            ParticleEmitterBuffer particles(sizeof(Particle), 8);
+            ITUGL_CHECK(particles.IsPersistentlyMapped());
+
+            EmitParticles(particles, 0, 6);
+            particles.Flush();
+            ITUGL_CHECK(MockGL::GetCallCounts().copyBufferSubData == 1);
+            ITUGL_CHECK(particles.GetParticleCount() == 6);
+
+            // Particles 6 and 7 fill the end of the buffer, 8 to 10 replace the oldest ones at the beginning
+            EmitParticles(particles, 6, 5);
+            particles.Flush();
+            ITUGL_CHECK(MockGL::GetCallCounts().copyBufferSubData == 3);
+            if (MockGL::GetCopyCalls().size() != 3)
+            {
+                return;
+            }
+            ITUGL_CHECK(particles.GetParticleCount() == 8);
+            ITUGL_CHECK(particles.GetEmittedCount() == 11);
+            ITUGL_CHECK(ReadVertexBuffer(particles) == std::vector<Particle>({ 8, 9, 10, 3, 4, 5, 6, 7 }));
+
+            // Both copies read from the part of the staging ring of the second frame, one after the other
+            std::span<const MockGL::CopyCall> copyCalls = MockGL::GetCopyCalls();
+            const GLintptr frameOffset = 8 * sizeof(Particle);
+            ITUGL_CHECK(copyCalls[1].readOffset == frameOffset && copyCalls[1].writeOffset == 6 * sizeof(Particle)
+                && copyCalls[1].size == 2 * sizeof(Particle));
+            ITUGL_CHECK(copyCalls[2].readOffset == frameOffset + 2 * sizeof(Particle) && copyCalls[2].writeOffset == 0
+                && copyCalls[2].size == 3 * sizeof(Particle));
+
+            // Each flush fences its part of the ring, and waits for it when the ring comes back to it
+            for (unsigned int frame = 0; frame < ParticleEmitterBuffer::FrameCount; ++frame)
+            {
+                EmitParticles(particles, 11 + frame, 1);
+                particles.Flush();
+            }
+            ITUGL_CHECK(MockGL::GetCallCounts().fenceSync == ParticleEmitterBuffer::FrameCount + 2);
+            ITUGL_CHECK(MockGL::GetCallCounts().clientWaitSync == 2);
+        });
+
+    suite.Add("particle_emitter/overflow_drops_oldest", []()
+        {
+            MockGL::Install(4, 4);
+            ParticleEmitterBuffer particles(sizeof(Particle), 8);
+
+            // Only the last 8 of the 20 survive, at the same place as if they were emitted in different frames
+            EmitParticles(particles, 0, 20);
+            particles.Flush();
+            ITUGL_CHECK(particles.GetEmittedCount() == 20);
+            ITUGL_CHECK(particles.GetParticleCount() == 8);
+            ITUGL_CHECK(particles.GetPendingCount() == 0);
+            ITUGL_CHECK(ReadVertexBuffer(particles) == std::vector<Particle>({ 16, 17, 18, 19, 12, 13, 14, 15 }));
+
+            // The skipped particles are not copied, the survivors are copied in two parts around the wrap
+            std::span<const MockGL::CopyCall> copyCalls = MockGL::GetCopyCalls();
+            ITUGL_CHECK(copyCalls.size() == 2);
+            ITUGL_CHECK(copyCalls.size() == 2 && copyCalls[0].size + copyCalls[1].size == 8 * sizeof(Particle));
+        });
+
+    suite.Add("particle_emitter/update_data_fallback", []()
+        {
+            // Without OpenGL 4.4 there is no glBufferStorage, the particles are uploaded directly
+            MockGL::Install(4, 3);
+            ParticleEmitterBuffer particles(sizeof(Particle), 8);
+            ITUGL_CHECK(!particles.IsPersistentlyMapped());
+            ITUGL_CHECK(MockGL::GetCallCounts().bufferStorage == 0);
+
+            EmitParticles(particles, 0, 6);
+            particles.Flush();
+            ITUGL_CHECK(MockGL::GetCallCounts().bufferSubData == 1);
+
+            EmitParticles(particles, 6, 5);
+            particles.Flush();
+            ITUGL_CHECK(MockGL::GetCallCounts().bufferSubData == 3);
+            ITUGL_CHECK(MockGL::GetCallCounts().copyBufferSubData == 0);
+            ITUGL_CHECK(MockGL::GetCallCounts().fenceSync == 0);
+            ITUGL_CHECK(ReadVertexBuffer(particles) == std::vector<Particle>({ 8, 9, 10, 3, 4, 5, 6, 7 }));
+
+            EmitParticles(particles, 11, 20);
+            particles.Flush();
+            ITUGL_CHECK(ReadVertexBuffer(particles) == std::vector<Particle>({ 24, 25, 26, 27, 28, 29, 30, 23 }));
+        });
+}
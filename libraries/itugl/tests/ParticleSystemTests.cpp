@@ -0,0 +1,191 @@
+#include "TestSuite.h"
+
+#include <ituGL/particles/ParticleSystem.h>
+#include <ituGL/core/ThreadPool.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // The kernels may be vectorized or contracted to FMA differently than the reference, so floats are compared with a tolerance
+    bool NearlyEqual(float a, float b)
+    {
+        return std::abs(a - b) <= 1e-5f * std::max(1.0f, std::max(std::abs(a), std::abs(b)));
+    }
+
+    // Emitter with random lifetimes in [0.5, 1.5], so about half of the particles die after one second
+    ParticleSystem::Emitter MakeMortalEmitter()
+    {
+        ParticleSystem::Emitter emitter;
+        emitter.radius = 2.0f;
+        emitter.velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+        emitter.velocitySpread = 1.0f;
+        emitter.minLifetime = 0.5f;
+        emitter.maxLifetime = 1.5f;
+        return emitter;
+    }
+}
+
+void AddParticleSystemTests(TestSuite& suite)
+{
+    suite.Add("particles/integrate_matches_scalar", []()
+        {
+            // Not a multiple of SimdWidth, so the last particles go through the scalar path
+            const unsigned int count = ParticleSystem::SimdWidth * 100 + 3;
+            const glm::vec3 gravity(0.0f, -9.8f, 0.0f);
+            const glm::vec3 initialVelocity(1.0f, 2.0f, -0.5f);
+            const float dragPerSecond = 0.3f;
+            const float deltaTime = 1.0f / 60.0f;
+
+            ParticleSystem particleSystem(count);
+            particleSystem.SetGravity(gravity);
+            particleSystem.SetDrag(dragPerSecond);
+            particleSystem.AddAttractor(ParticleSystem::Attractor{ glm::vec3(5.0f, 0.0f, 0.0f), 20.0f });
+            particleSystem.AddAttractor(ParticleSystem::Attractor{ glm::vec3(-3.0f, 1.0f, 2.0f), -8.0f });
+
+            // Same velocity for all, so the expected values only depend on the random positions
+            ParticleSystem::Emitter emitter;
+            emitter.radius = 4.0f;
+            emitter.velocity = initialVelocity;
+            emitter.minLifetime = emitter.maxLifetime = 10.0f;
+            ITUGL_CHECK(particleSystem.Emit(emitter, count, 7) == count);
+
+            std::vector<float> expectedX(particleSystem.GetPositionsX().begin(), particleSystem.GetPositionsX().end());
+            std::vector<float> expectedY(particleSystem.GetPositionsY().begin(), particleSystem.GetPositionsY().end());
+            std::vector<float> expectedZ(particleSystem.GetPositionsZ().begin(), particleSystem.GetPositionsZ().end());
+
+            // Scalar reference of the forces, drag and integration
+            float drag = std::max(1.0f - dragPerSecond * deltaTime, 0.0f);
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                glm::vec3 acceleration = gravity;
+                for (const ParticleSystem::Attractor& attractor : particleSystem.GetAttractors())
+                {
+                    glm::vec3 offset = attractor.position - glm::vec3(expectedX[i], expectedY[i], expectedZ[i]);
+                    float distance2 = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z + ParticleSystem::AttractorSoftening;
+                    acceleration += offset * (attractor.strength / (distance2 * std::sqrt(distance2)));
+                }
+                glm::vec3 velocity = (initialVelocity + acceleration * deltaTime) * drag;
+                expectedX[i] += velocity.x * deltaTime;
+                expectedY[i] += velocity.y * deltaTime;
+                expectedZ[i] += velocity.z * deltaTime;
+            }
+
+            // All the particles are still alive, so they keep their order
+            particleSystem.Update(deltaTime);
+            ITUGL_CHECK(particleSystem.GetParticleCount() == count);
+
+            unsigned int mismatchCount = 0;
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                bool match = NearlyEqual(particleSystem.GetPositionsX()[i], expectedX[i])
+                    && NearlyEqual(particleSystem.GetPositionsY()[i], expectedY[i])
+                    && NearlyEqual(particleSystem.GetPositionsZ()[i], expectedZ[i])
+                    && NearlyEqual(particleSystem.GetAges()[i], deltaTime);
+                mismatchCount += match ? 0 : 1;
+            }
+            ITUGL_CHECK(mismatchCount == 0);
+        });
+
+    suite.Add("particles/expired_particles_are_compacted", []()
+        {
+            const unsigned int count = ParticleSystem::SimdWidth * 50 + 5;
+            ParticleSystem particleSystem(count);
+            ITUGL_CHECK(particleSystem.Emit(MakeMortalEmitter(), count, 3) == count);
+
+            // A particle dies when its age reaches its lifetime. Without a thread pool there is one range,
+            // and the compaction keeps the order of the live particles
+            const float deltaTime = 1.0f;
+            std::vector<float> expectedLifetimes;
+            for (float lifetime : particleSystem.GetLifetimes())
+            {
+                if (deltaTime < lifetime)
+                {
+                    expectedLifetimes.push_back(lifetime);
+                }
+            }
+            ITUGL_CHECK(!expectedLifetimes.empty() && expectedLifetimes.size() < count);
+
+            particleSystem.Update(deltaTime);
+            ITUGL_CHECK(particleSystem.GetParticleCount() == expectedLifetimes.size());
+            ITUGL_CHECK(std::equal(expectedLifetimes.begin(), expectedLifetimes.end(),
+                particleSystem.GetLifetimes().begin(), particleSystem.GetLifetimes().end()));
+            for (float age : particleSystem.GetAges())
+            {
+                ITUGL_CHECK(NearlyEqual(age, deltaTime));
+            }
+
+            // Everything dies eventually, and the system can be filled again
+            particleSystem.Update(deltaTime);
+            ITUGL_CHECK(particleSystem.GetParticleCount() == 0);
+            ITUGL_CHECK(particleSystem.Emit(MakeMortalEmitter(), count, 4) == count);
+        });
+
+    suite.Add("particles/thread_pool_packs_ranges", []()
+        {
+            // Large enough to be split in several ranges, and not a multiple of SimdWidth
+            const unsigned int count = 100003;
+            ThreadPool threadPool(3);
+
+            ParticleSystem serialSystem(count);
+            ParticleSystem threadedSystem(count);
+            threadedSystem.SetThreadPool(&threadPool);
+            for (ParticleSystem* particleSystem : { &serialSystem, &threadedSystem })
+            {
+                particleSystem->SetGravity(glm::vec3(0.0f, -9.8f, 0.0f));
+                particleSystem->AddAttractor(ParticleSystem::Attractor{ glm::vec3(1.0f, 2.0f, 3.0f), 5.0f });
+                ITUGL_CHECK(particleSystem->Emit(MakeMortalEmitter(), count, 11) == count);
+            }
+
+            // Emission doesn't depend on the split
+            ITUGL_CHECK(std::equal(serialSystem.GetLifetimes().begin(), serialSystem.GetLifetimes().end(),
+                threadedSystem.GetLifetimes().begin(), threadedSystem.GetLifetimes().end()));
+
+            // Each range is compacted on its own and then packed after the previous ones, so the live particles
+            // end up contiguous and in the same order as with a single range
+            serialSystem.Update(1.0f);
+            threadedSystem.Update(1.0f);
+            ITUGL_CHECK(serialSystem.GetParticleCount() > 0 && serialSystem.GetParticleCount() < count);
+            ITUGL_CHECK(threadedSystem.GetParticleCount() == serialSystem.GetParticleCount());
+            if (threadedSystem.GetParticleCount() != serialSystem.GetParticleCount())
+            {
+                return;
+            }
+
+            unsigned int mismatchCount = 0;
+            for (unsigned int i = 0; i < serialSystem.GetParticleCount(); ++i)
+            {
+                bool match = threadedSystem.GetLifetimes()[i] == serialSystem.GetLifetimes()[i]
+                    && NearlyEqual(threadedSystem.GetAges()[i], serialSystem.GetAges()[i])
+                    && NearlyEqual(threadedSystem.GetPositionsX()[i], serialSystem.GetPositionsX()[i])
+                    && NearlyEqual(threadedSystem.GetPositionsY()[i], serialSystem.GetPositionsY()[i])
+                    && NearlyEqual(threadedSystem.GetPositionsZ()[i], serialSystem.GetPositionsZ()[i]);
+                mismatchCount += match ? 0 : 1;
+            }
+            ITUGL_CHECK(mismatchCount == 0);
+
+            unsigned int deadCount = 0;
+            for (unsigned int i = 0; i < threadedSystem.GetParticleCount(); ++i)
+            {
+                deadCount += threadedSystem.GetAges()[i] < threadedSystem.GetLifetimes()[i] ? 0 : 1;
+            }
+            ITUGL_CHECK(deadCount == 0);
+        });
+
+    suite.Add("particles/emit_clamps_to_capacity", []()
+        {
+            ParticleSystem particleSystem(100);
+            ParticleSystem::Emitter emitter;
+
+            ITUGL_CHECK(particleSystem.Emit(emitter, 60, 1) == 60);
+            ITUGL_CHECK(particleSystem.Emit(emitter, 60, 2) == 40);
+            ITUGL_CHECK(particleSystem.GetParticleCount() == particleSystem.GetCapacity());
+            ITUGL_CHECK(particleSystem.Emit(emitter, 1, 3) == 0);
+            ITUGL_CHECK(particleSystem.GetParticleCount() == 100);
+
+            particleSystem.Clear();
+            ITUGL_CHECK(particleSystem.GetParticleCount() == 0);
+            ITUGL_CHECK(particleSystem.Emit(emitter, 100, 4) == 100);
+        });
+}
@@ -0,0 +1,182 @@
+#include "TestSuite.h"
+#include "MockGL.h"
+
+#include <ituGL/renderer/RenderGraph.h>
+#include <ituGL/renderer/RenderPass.h>
+#include <vector>
+
+namespace
+{
+    // The graph only needs the passes to tell them apart, their resources are declared by the tests
+    class EmptyPass : public RenderPass
+    {
+    public:
+        void Render() override {}
+    };
+
+    const RenderGraph::TextureDesc ColorDesc = { 64, 32, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8 };
+    const RenderGraph::TextureDesc HalfColorDesc = { 32, 16, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8 };
+
+    // Three passes that each read the texture of the previous one, and a last one that writes the imported backbuffer
+    void AddChain(RenderGraph& graph, std::vector<EmptyPass>& passes, const RenderGraph::TextureDesc& lastDesc)
+    {
+        graph.ImportTexture("backbuffer", nullptr);
+
+        RenderGraph::PassBuilder builder0 = graph.AddPass(passes[0]);
+        builder0.CreateTexture("t1", ColorDesc);
+
+        RenderGraph::PassBuilder builder1 = graph.AddPass(passes[1]);
+        builder1.Read("t1");
+        builder1.CreateTexture("t2", ColorDesc);
+
+        RenderGraph::PassBuilder builder2 = graph.AddPass(passes[2]);
+        builder2.Read("t2");
+        builder2.CreateTexture("t3", lastDesc);
+
+        RenderGraph::PassBuilder builder3 = graph.AddPass(passes[3]);
+        builder3.Read("t3");
+        builder3.Write("backbuffer");
+    }
+}
+
+void AddRenderGraphTests(TestSuite& suite)
+{
+    suite.Add("render_graph/culls_unused_passes", []()
+        {
+            MockGL::Install();
+            TexturePool texturePool;
+            RenderGraph graph(texturePool);
+            std::vector<EmptyPass> passes(6);
+
+            graph.ImportTexture("backbuffer", nullptr);
+
+            RenderGraph::PassBuilder shadowBuilder = graph.AddPass(passes[0]);
+            shadowBuilder.CreateTexture("shadowMap", ColorDesc);
+
+            // Only read by a culled pass, so it is culled too
+            RenderGraph::PassBuilder debugBuilder = graph.AddPass(passes[1]);
+            debugBuilder.CreateTexture("debug", ColorDesc);
+
+            RenderGraph::PassBuilder debugViewBuilder = graph.AddPass(passes[2]);
+            debugViewBuilder.Read("debug");
+            debugViewBuilder.CreateTexture("debugView", ColorDesc);
+
+            RenderGraph::PassBuilder lightingBuilder = graph.AddPass(passes[3]);
+            lightingBuilder.Read("shadowMap");
+            ITUGL_CHECK(lightingBuilder.Write("backbuffer") != RenderGraph::InvalidResource);
+            ITUGL_CHECK(lightingBuilder.Read("missing") == RenderGraph::InvalidResource);
+
+            RenderGraph::PassBuilder overlayBuilder = graph.AddPass(passes[4]);
+            overlayBuilder.SetSideEffect();
+
+            RenderGraph::PassBuilder historyBuilder = graph.AddPass(passes[5]);
+            historyBuilder.CreateTexture("history", ColorDesc);
+            graph.MarkOutput("history");
+
+            graph.Compile();
+            ITUGL_CHECK(graph.GetPassCount() == 6);
+            ITUGL_CHECK(!graph.IsPassCulled(0));
+            ITUGL_CHECK(graph.IsPassCulled(1));
+            ITUGL_CHECK(graph.IsPassCulled(2));
+            ITUGL_CHECK(!graph.IsPassCulled(3));
+            ITUGL_CHECK(!graph.IsPassCulled(4));
+            ITUGL_CHECK(!graph.IsPassCulled(5));
+
+            // The resources of the culled passes get no texture
+            ITUGL_CHECK(graph.GetTexture("shadowMap") != nullptr);
+            ITUGL_CHECK(graph.GetTexture("history") != nullptr);
+            ITUGL_CHECK(graph.GetTexture("debug") == nullptr);
+            ITUGL_CHECK(graph.GetTexture("debugView") == nullptr);
+            ITUGL_CHECK(graph.GetTransientResourceCount() == 2);
+        });
+
+    suite.Add("render_graph/aliases_transient_textures", []()
+        {
+            MockGL::Install();
+            TexturePool texturePool;
+            RenderGraph graph(texturePool);
+            std::vector<EmptyPass> passes(4);
+
+            // t1 is released after the second pass, so t3, created in the third one, takes its texture
+            AddChain(graph, passes, ColorDesc);
+            graph.Compile();
+            ITUGL_CHECK(graph.GetTransientResourceCount() == 3);
+            ITUGL_CHECK(graph.GetTransientTextureCount() == 2);
+            ITUGL_CHECK(graph.GetTexture("t1") == graph.GetTexture("t3"));
+            ITUGL_CHECK(graph.GetTexture("t1") != graph.GetTexture("t2"));
+            ITUGL_CHECK(texturePool.GetTextureCount() == 2);
+            ITUGL_CHECK(MockGL::GetTextureCount() == 2);
+
+            // Textures with a different description are never shared, the other two are reused from the pool
+            graph.Reset();
+            AddChain(graph, passes, HalfColorDesc);
+            graph.Compile();
+            ITUGL_CHECK(graph.GetTransientResourceCount() == 3);
+            ITUGL_CHECK(graph.GetTransientTextureCount() == 3);
+            ITUGL_CHECK(graph.GetTexture("t1") != graph.GetTexture("t3"));
+            ITUGL_CHECK(graph.GetTexture("t2") != graph.GetTexture("t3"));
+            ITUGL_CHECK(texturePool.GetTextureCount() == 3);
+        });
+
+    suite.Add("render_graph/outputs_live_until_reset", []()
+        {
+            MockGL::Install();
+            TexturePool texturePool;
+            RenderGraph graph(texturePool);
+            EmptyPass pass;
+
+            RenderGraph::PassBuilder builder = graph.AddPass(pass);
+            builder.CreateTexture("history", ColorDesc);
+            graph.MarkOutput("history");
+            graph.Compile();
+
+            // The output is still acquired after Compile, so the pool can't give it away
+            std::shared_ptr<Texture2DObject> other = texturePool.Acquire(ColorDesc);
+            ITUGL_CHECK(other != graph.GetTexture("history"));
+
+            std::shared_ptr<Texture2DObject> history = graph.GetTexture("history");
+            texturePool.Release(other);
+            graph.Reset();
+            ITUGL_CHECK(texturePool.Acquire(ColorDesc) == history);
+        });
+
+    suite.Add("texture_pool/reuses_and_evicts", []()
+        {
+            MockGL::Install();
+            TexturePool texturePool;
+            texturePool.SetMaxUnusedFrames(2);
+
+            std::shared_ptr<Texture2DObject> textureA = texturePool.Acquire(ColorDesc);
+            std::shared_ptr<Texture2DObject> textureB = texturePool.Acquire(ColorDesc);
+            std::shared_ptr<Texture2DObject> textureC = texturePool.Acquire(HalfColorDesc);
+            ITUGL_CHECK(textureA != textureB);
+            ITUGL_CHECK(texturePool.GetTextureCount() == 3);
+            ITUGL_CHECK(texturePool.GetMemorySize() == (2 * 64 * 32 + 32 * 16) * 4);
+
+            // The last released texture with the same description is the first one reused
+            texturePool.Release(textureB);
+            texturePool.Release(textureA);
+            ITUGL_CHECK(texturePool.Acquire(ColorDesc) == textureA);
+            ITUGL_CHECK(texturePool.Acquire(HalfColorDesc) != textureC);
+            ITUGL_CHECK(texturePool.GetTextureCount() == 4);
+
+            // B is free and was last used in this frame, the others stay acquired
+            textureB.reset();
+            texturePool.EndFrame();
+            texturePool.EndFrame();
+            ITUGL_CHECK(texturePool.GetTextureCount() == 4);
+            texturePool.EndFrame();
+            ITUGL_CHECK(texturePool.GetTextureCount() == 3);
+            ITUGL_CHECK(MockGL::GetTextureCount() == 3);
+
+            // Holding a texture counts as using it, so the frames without use start when it is released
+            texturePool.Release(textureA);
+            textureA.reset();
+            texturePool.EndFrame();
+            texturePool.EndFrame();
+            ITUGL_CHECK(texturePool.GetTextureCount() == 3);
+            texturePool.EndFrame();
+            ITUGL_CHECK(texturePool.GetTextureCount() == 2);
+            ITUGL_CHECK(MockGL::GetTextureCount() == 2);
+        });
+}
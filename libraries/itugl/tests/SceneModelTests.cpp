@@ -0,0 +1,79 @@
+#include "TestSuite.h"
+#include "MockGL.h"
+
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <cmath>
+
+namespace
+{
+    bool IsFinite(const glm::vec3& v)
+    {
+        return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+    }
+
+    bool NearlyEqual(const glm::vec3& a, const glm::vec3& b)
+    {
+        return glm::length(a - b) <= 1e-5f;
+    }
+
+    // Rotation axes must stay unit length and orthogonal, with the same handedness as the transform
+    bool IsRotation(const glm::mat3& matrix)
+    {
+        return std::abs(glm::length(matrix[0]) - 1.0f) <= 1e-5f && std::abs(glm::length(matrix[1]) - 1.0f) <= 1e-5f
+            && std::abs(glm::dot(matrix[0], matrix[1])) <= 1e-5f && NearlyEqual(glm::cross(matrix[0], matrix[1]), matrix[2]);
+    }
+
+    // Model with a mesh from (-1, -2, -3) to (1, 2, 3)
+    SceneModel MakeSceneModel()
+    {
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+        mesh->AddBounds(glm::vec3(-1.0f, -2.0f, -3.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+        return SceneModel("model", std::make_shared<Model>(mesh), std::make_shared<Transform>());
+    }
+}
+
+void AddSceneModelTests(TestSuite& suite)
+{
+    suite.Add("scene_model/box_bounds_scale", []()
+        {
+            MockGL::Install();
+            SceneModel sceneModel = MakeSceneModel();
+            sceneModel.GetTransform()->SetTranslation(glm::vec3(10.0f, 0.0f, 0.0f));
+            sceneModel.GetTransform()->SetScale(glm::vec3(2.0f, 3.0f, 0.5f));
+
+            BoxBounds bounds = sceneModel.GetBoxBounds();
+            ITUGL_CHECK(NearlyEqual(bounds.GetCenter(), glm::vec3(10.0f, 0.0f, 0.0f)));
+            ITUGL_CHECK(NearlyEqual(bounds.GetSize(), glm::vec3(2.0f, 6.0f, 1.5f)));
+            ITUGL_CHECK(IsRotation(bounds.GetRotationMatrix()));
+        });
+
+    suite.Add("scene_model/box_bounds_zero_scale", []()
+        {
+            MockGL::Install();
+            SceneModel sceneModel = MakeSceneModel();
+            sceneModel.GetTransform()->SetTranslation(glm::vec3(0.0f, 5.0f, 0.0f));
+            sceneModel.GetTransform()->SetRotation(glm::vec3(0.3f, 0.7f, -0.2f));
+
+            // Flattened on one axis, on two axes, and collapsed to a point: the box is still finite and has a valid rotation
+            for (glm::vec3 scale : { glm::vec3(2.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(0.0f) })
+            {
+                sceneModel.GetTransform()->SetScale(scale);
+                BoxBounds bounds = sceneModel.GetBoxBounds();
+                ITUGL_CHECK(IsFinite(bounds.GetCenter()) && IsFinite(bounds.GetSize()));
+                ITUGL_CHECK(NearlyEqual(bounds.GetSize(), scale * glm::vec3(1.0f, 2.0f, 3.0f)));
+                ITUGL_CHECK(IsRotation(bounds.GetRotationMatrix()));
+
+                AabbBounds aabb = sceneModel.GetAabbBounds();
+                ITUGL_CHECK(IsFinite(aabb.GetMin()) && IsFinite(aabb.GetMax()));
+                ITUGL_CHECK(std::isfinite(sceneModel.GetSphereBounds().GetRadius()));
+            }
+
+            // A point still intersects the bounds that contain it
+            BoxBounds point = sceneModel.GetBoxBounds();
+            ITUGL_CHECK(Bounds::Intersects(point, SphereBounds(glm::vec3(0.0f, 5.0f, 0.0f), 0.1f)));
+            ITUGL_CHECK(!Bounds::Intersects(point, SphereBounds(glm::vec3(0.0f, 0.0f, 0.0f), 0.1f)));
+        });
+}
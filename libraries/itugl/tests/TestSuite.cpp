@@ -0,0 +1,42 @@
+#include "TestSuite.h"
+
+#include <cstdio>
+
+namespace
+{
+    // Failed checks of the test that is running
+    int s_failureCount = 0;
+}
+
+void TestSuite::Add(const std::string& name, TestFunction function)
+{
+    m_tests.push_back(Test{ name, std::move(function) });
+}
+
+int TestSuite::Run(const std::string& filter) const
+{
+    int failedTestCount = 0;
+    for (const Test& test : m_tests)
+    {
+        if (test.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        s_failureCount = 0;
+        test.function();
+
+        std::printf("%-48s %s\n", test.name.c_str(), s_failureCount == 0 ? "passed" : "FAILED");
+        if (s_failureCount > 0)
+        {
+            ++failedTestCount;
+        }
+    }
+    return failedTestCount;
+}
+
+void TestSuite::ReportFailure(const char* condition, const char* file, int line)
+{
+    std::printf("  %s:%d: check failed: %s\n", file, line, condition);
+    ++s_failureCount;
+}
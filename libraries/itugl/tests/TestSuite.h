@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal test runner: each test is a function that reports the failed checks with ITUGL_CHECK
+class TestSuite
+{
+public:
+    using TestFunction = std::function<void()>;
+
+    void Add(const std::string& name, TestFunction function);
+
+    // Run the tests whose name contains the filter. Returns the number of failed tests
+    int Run(const std::string& filter = "") const;
+
+    // Called by ITUGL_CHECK when the condition is false
+    static void ReportFailure(const char* condition, const char* file, int line);
+
+private:
+    struct Test
+    {
+        std::string name;
+        TestFunction function;
+    };
+
+    std::vector<Test> m_tests;
+};
+
+#define ITUGL_CHECK(condition) ((condition) ? (void)0 : TestSuite::ReportFailure(#condition, __FILE__, __LINE__))
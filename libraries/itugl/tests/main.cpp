@@ -0,0 +1,32 @@
+#include "TestSuite.h"
+
+#include <cstdio>
+
+void AddOcclusionCullerTests(TestSuite& suite);
+void AddParticleSystemTests(TestSuite& suite);
+void AddParticleEmitterBufferTests(TestSuite& suite);
+void AddGeometryPoolTests(TestSuite& suite);
+void AddRenderGraphTests(TestSuite& suite);
+void AddInputLogTests(TestSuite& suite);
+void AddSceneModelTests(TestSuite& suite);
+
+// Usage: itugl_tests [filter]
+int main(int argc, char* argv[])
+{
+    TestSuite suite;
+    AddOcclusionCullerTests(suite);
+    AddParticleSystemTests(suite);
+    AddParticleEmitterBufferTests(suite);
+    AddGeometryPoolTests(suite);
+    AddRenderGraphTests(suite);
+    AddInputLogTests(suite);
+    AddSceneModelTests(suite);
+
+    int failedTestCount = suite.Run(argc > 1 ? argv[1] : "");
+    if (failedTestCount > 0)
+    {
+        std::printf("%d tests failed\n", failedTestCount);
+        return 1;
+    }
+    return 0;
+}